@@ -8,7 +8,7 @@
  * @date 2017/07/13 11:23
  * @uses The framework all inlcudes.
  *       This group defines just can define one.
- *             group1: PF_OPEN_ICOP|PF_OPEN_EPOLL
+ *             group1: PF_OPEN_ICOP|PF_OPEN_EPOLL|PF_OPEN_IOURING
 */
 #ifndef PF_H_
 #define PF_H_
@@ -56,6 +56,9 @@
 /* net */
 #include "pf/net/connection/basic.h"
 #include "pf/net/connection/pool.h"
+#include "pf/net/connection/udp.h"
+#include "pf/net/connection/share.h"
+#include "pf/net/connection/executor.h"
 #include "pf/net/connection/manager/interface.h"
 #include "pf/net/connection/manager/connector.h"
 #include "pf/net/connection/manager/epoll.h"
@@ -64,6 +67,8 @@
 #include "pf/net/connection/manager/connector.h"
 #include "pf/net/connection/manager/listener.h"
 #include "pf/net/connection/manager/listener_factory.h"
+#include "pf/net/connection/manager/udp.h"
+#include "pf/net/connection/manager/share.h"
 #include "pf/net/packet/interface.h"
 #include "pf/net/packet/dynamic.h"
 #include "pf/net/packet/factory.h"
@@ -36,6 +36,8 @@
 #include <stdexcept>
 #include <list>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include <memory>
 #include <random>
 #include <atomic>
@@ -0,0 +1,138 @@
+/**
+ * PLAIN FRAMEWORK ( https://github.com/viticm/plainframework )
+ * $Id mpsc_queue.tcc
+ * @link https://github.com/viticm/plainframework for the canonical source repository
+ * @copyright Copyright (c) 2014- viticm( viticm.ti@gmail.com )
+ * @license
+ * @user viticm<viticm.ti@gmail.com>
+ * @date 2026/10/17 16:20
+ * @uses The bounded lock-free queue for multi producers and single consumer.
+ *       Every cell have a sequence, the producers claim the position with
+ *       CAS and publish the cell by the sequence, the consumer never lock.
+ *       The push failed when the queue is full(back pressure), the caller
+ *       keep the value.
+*/
+#ifndef PF_BASIC_MPSC_QUEUE_TCC_
+#define PF_BASIC_MPSC_QUEUE_TCC_
+
+#include "pf/basic/config.h"
+
+namespace pf_basic {
+
+template <typename T>
+class MpscQueue {
+
+ public:
+   MpscQueue() :
+     mask_{0},
+     enqueue_pos_{0},
+     dequeue_pos_{0},
+     high_water_{0},
+     full_count_{0} {};
+   ~MpscQueue() {};
+
+ public:
+   //The capacity will round up to the power of 2, not thread safe.
+   bool init(size_t capacity) {
+     size_t size = 2;
+     while (size < capacity) size <<= 1;
+     std::unique_ptr<cell_t[]> cells{new cell_t[size]};
+     if (is_null(cells)) return false;
+     for (size_t i = 0; i < size; ++i)
+       cells[i].sequence.store(i, std::memory_order_relaxed);
+     cells_ = std::move(cells);
+     mask_ = size - 1;
+     enqueue_pos_.store(0, std::memory_order_relaxed);
+     dequeue_pos_.store(0, std::memory_order_relaxed);
+     high_water_.store(0, std::memory_order_relaxed);
+     full_count_.store(0, std::memory_order_relaxed);
+     return true;
+   };
+
+   //Any thread, the value moved only if success.
+   bool push(T &&value) {
+     if (is_null(cells_)) return false;
+     cell_t *cell{nullptr};
+     size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+     for (;;) {
+       cell = &cells_[pos & mask_];
+       size_t sequence = cell->sequence.load(std::memory_order_acquire);
+       intptr_t diff =
+         static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+       if (0 == diff) {
+         if (enqueue_pos_.compare_exchange_weak(
+               pos, pos + 1, std::memory_order_relaxed)) break;
+       } else if (diff < 0) {
+         full_count_.fetch_add(1, std::memory_order_relaxed);
+         return false;
+       } else {
+         pos = enqueue_pos_.load(std::memory_order_relaxed);
+       }
+     }
+     cell->data = std::move(value);
+     cell->sequence.store(pos + 1, std::memory_order_release);
+     //The high water mark.
+     size_t head = dequeue_pos_.load(std::memory_order_relaxed);
+     size_t count = pos + 1 > head ? pos + 1 - head : 0;
+     size_t water = high_water_.load(std::memory_order_relaxed);
+     while (count > water &&
+            !high_water_.compare_exchange_weak(
+              water, count, std::memory_order_relaxed)) {}
+     return true;
+   };
+
+   //Only the consumer thread.
+   bool pop(T &value) {
+     if (is_null(cells_)) return false;
+     size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+     cell_t &cell = cells_[pos & mask_];
+     size_t sequence = cell.sequence.load(std::memory_order_acquire);
+     if (static_cast<intptr_t>(sequence) -
+         static_cast<intptr_t>(pos + 1) < 0) return false;
+     value = std::move(cell.data);
+     cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+     dequeue_pos_.store(pos + 1, std::memory_order_release);
+     return true;
+   };
+
+ public:
+   size_t capacity() const { return is_null(cells_) ? 0 : mask_ + 1; };
+   //The approximate size, any thread.
+   size_t size() const {
+     size_t tail = enqueue_pos_.load(std::memory_order_relaxed);
+     size_t head = dequeue_pos_.load(std::memory_order_relaxed);
+     return tail > head ? tail - head : 0;
+   };
+   bool empty() const { return 0 == size(); };
+   //The max size reached from init.
+   size_t high_water() const {
+     return high_water_.load(std::memory_order_relaxed);
+   };
+   //The count of push failed by full.
+   uint64_t full_count() const {
+     return full_count_.load(std::memory_order_relaxed);
+   };
+
+ private:
+   typedef struct cell_struct {
+     std::atomic<size_t> sequence;
+     T data;
+   } cell_t;
+
+ private:
+   std::unique_ptr<cell_t[]> cells_;
+   size_t mask_;
+   //The producers and consumer positions in different cache lines.
+   char pad0_[64];
+   std::atomic<size_t> enqueue_pos_;
+   char pad1_[64];
+   std::atomic<size_t> dequeue_pos_;
+   char pad2_[64];
+   std::atomic<size_t> high_water_;
+   std::atomic<uint64_t> full_count_;
+
+};
+
+} //namespace pf_basic
+
+#endif //PF_BASIC_MPSC_QUEUE_TCC_
@@ -0,0 +1,75 @@
+/**
+ * PLAIN FRAMEWORK ( https://github.com/viticm/plainframework )
+ * $Id timing_wheel.h
+ * @link https://github.com/viticm/plainframework for the canonical source repository
+ * @copyright Copyright (c) 2014- viticm( viticm.ti@gmail.com )
+ * @license
+ * @user viticm<viticm.ti@gmail.com>
+ * @date 2026/10/17 14:05
+ * @uses The hierarchical timing wheel(256 + 64 * 3 slots).
+ *       Add and cancel are O(1), advance only touch the expired timers and
+ *       cascade the upper levels when the lower level wrapped.
+ *       The timers longer than the wheel(2^26 slots) wait in the top level
+ *       and cascade again until in range, so they never expire early.
+ */
+#ifndef PF_BASIC_TIMING_WHEEL_H_
+#define PF_BASIC_TIMING_WHEEL_H_
+
+#include "pf/basic/config.h"
+
+#define TIMING_WHEEL_NEAR_BITS 8
+#define TIMING_WHEEL_LEVEL_BITS 6
+#define TIMING_WHEEL_LEVELS 3
+
+namespace pf_basic {
+
+class PF_API TimingWheel {
+
+ public:
+   TimingWheel();
+   ~TimingWheel();
+
+ public:
+   //The precision is the milliseconds of a slot.
+   void init(uint32_t precision, uint32_t now);
+   //Add a timer expire after delay milliseconds, return the id(0 is failed).
+   uint64_t add(uint32_t delay, uint64_t data);
+   bool cancel(uint64_t id);
+   //Run to now and call the function with the data of expired timers.
+   uint32_t advance(uint32_t now,
+                    const std::function<void (uint64_t)> &function);
+   //The milliseconds from now to the next slot have timers(or cascade).
+   uint32_t timeout(uint32_t now) const;
+   size_t size() const { return size_; };
+   uint32_t precision() const { return precision_; };
+
+ private:
+   typedef struct node_struct {
+     uint64_t expire;
+     uint64_t data;
+     uint32_t prev;
+     uint32_t next;
+     uint32_t slot;
+     uint32_t serial;
+   } node_t;
+
+ private:
+   void link(uint32_t index);
+   void unlink(uint32_t index);
+   void cascade(uint32_t level);
+   void release(uint32_t index);
+
+ private:
+   std::vector<node_t> nodes_;
+   std::vector<uint32_t> slots_; /* 所有层的槽位链表头 */
+   uint32_t free_;               /* 空闲节点链表头 */
+   uint64_t current_;            /* 下一个要处理的槽位刻度 */
+   uint32_t time_;               /* 当前刻度对应的时间 */
+   uint32_t precision_;
+   size_t size_;
+
+};
+
+} //namespace pf_basic
+
+#endif //PF_BASIC_TIMING_WHEEL_H_
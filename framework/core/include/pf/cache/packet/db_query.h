@@ -32,6 +32,14 @@ class DBQuery : public pf_net::packet::Interface {
    virtual ~DBQuery() {}
 
  public:
+   //The id is the factory id, keep it.
+   virtual void clear() {
+     Interface::clear();
+     type_ = 0;
+     operate_ = 0;
+     memset(key_, 0, sizeof(key_));
+     sql_str_[0] = '\0';
+   }
    virtual bool read(pf_net::stream::Input &);
    virtual bool write(pf_net::stream::Output &);
    virtual uint32_t execute(pf_net::connection::Basic *connection);
@@ -69,7 +77,9 @@ class DBQueryFactory : public pf_net::packet::Factory {
    
  public:
    virtual pf_net::packet::Interface *packet_create() {
-     return new DBQuery();
+     auto packet = new DBQuery();
+     packet->set_id(id_);
+     return packet;
    }
    uint16_t packet_id() const {
      return id_;
@@ -31,6 +31,18 @@ class DBResult : public pf_net::packet::Interface {
        key_{0} { data_size_ = get_data_size(); }
    virtual ~DBResult() {}
 
+ public:
+   //The id is the factory id, keep it.
+   virtual void clear() {
+     Interface::clear();
+     result_ = kResultFailed;
+     operate_ = -1;
+     memset(key_, 0, sizeof(key_));
+     columns_.clear();
+     rows_.clear();
+     data_size_ = 0;
+   }
+
  public:
    enum {
      kResultFailed = -1,
@@ -80,7 +92,9 @@ class DBResultFactory : public pf_net::packet::Factory {
    
  public:
    virtual pf_net::packet::Interface *packet_create() {
-     return new DBResult();
+     auto packet = new DBResult();
+     packet->set_id(id_);
+     return packet;
    }
    uint16_t packet_id() const {
      return id_;
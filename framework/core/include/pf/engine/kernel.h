@@ -50,9 +50,12 @@ class PF_API Kernel : public pf_basic::Singleton< Kernel > {
  public:
 
    //Use these interface will send handshake packt after connected.
+   //Connect in the net thread and wait the result(blocking).
    pf_net::connection::Basic *default_connect(
        const std::string &ip, uint16_t port);
    pf_net::connection::Basic *connect(const std::string &name);
+   //Connect in the net thread(non blocking) and reconnect if lost.
+   void keep_connect(const std::string &name);
 
    //Get the extra listener or connector.
    pf_net::connection::Basic *get_connector(const std::string &name);
@@ -68,6 +71,9 @@ class PF_API Kernel : public pf_basic::Singleton< Kernel > {
  public:
    template<class F, class... Args>
    std::thread::id newthread(F&& f, Args&&... args);
+   //The thread loop without frame sleep, the task wait by itself.
+   template<class F, class... Args>
+   std::thread::id newloop(F&& f, Args&&... args);
 
  protected:
    virtual bool init_base();
@@ -77,6 +83,8 @@ class PF_API Kernel : public pf_basic::Singleton< Kernel > {
    virtual bool init_script();
 
  protected:
+   //The managers detach it when destroy, so it destroy after them.
+   std::unique_ptr<pf_net::connection::Executor> net_executor_;
    std::unique_ptr<pf_net::connection::manager::Basic> net_;
    std::unique_ptr<pf_db::Factory> db_factory_;
    std::unique_ptr<
@@ -89,17 +97,21 @@ class PF_API Kernel : public pf_basic::Singleton< Kernel > {
    std::vector< std::thread > thread_workers_;
    std::map<std::string, int8_t> db_list_;  //Database name to factory id.
    std::map<std::string, int8_t> listen_list_; //Listen net name to factory id.
-   std::map<std::string, int8_t> connect_list_; //connect net name to id.
+   std::map<std::string, int32_t> connect_list_; //connect net name to id.
    std::map<std::string, int8_t> connect_env_; //connect net name to config id.
    bool isinit_;
 
  private:
    void loop();
+   void handshake(pf_net::connection::Basic *connection, 
+                  const std::string &encrypt_str);
 
  private:
    std::queue< std::function<void()> > tasks_;
    std::vector< std::function<void()> > thread_tasks_;
    std::mutex queue_mutex_;
+   //The connect list is set in net thread by the async connector.
+   std::mutex connect_mutex_;
    bool stop_;
 
 };
@@ -73,6 +73,31 @@ std::thread::id Kernel::newthread(F&& f, Args&&... args) {
   return res;
 }
 
+template<class F, class... Args>
+std::thread::id Kernel::newloop(F&& f, Args&&... args) {
+  using return_type = typename std::result_of<F(Args...)>::type;
+  std::thread::id res;
+  {
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    if (stop_)
+       throw std::runtime_error("newloop on stopped Kernel");
+    auto task = std::make_shared< std::packaged_task<return_type()> >(
+        std::bind(std::forward<F>(f), std::forward<Args>(args)...)
+      );
+    thread_workers_.emplace_back([task](){ 
+      pf_sys::thread::start();
+      pf_sys::ThreadCollect tc;
+      for (;;) {
+        if (pf_sys::thread::is_stopping()) break;
+        (*task)(); 
+        (*task).reset();
+      }
+    });
+    res = thread_workers_[thread_workers_.size() - 1].get_id();
+  }
+  return res;
+}
+
 } //namespace pf_engine
 
 #endif //PF_ENGINE_KERNEL_TCC_
@@ -15,8 +15,47 @@
 
 #define NET_ONESTEP_ACCEPT_DEFAULT 50 //每帧接受新连接的默认值
 #define NET_MANAGER_FRAME 100         //网络帧率
-#define NET_MANAGER_CACHE_SIZE 1024   //网络管理器默认缓存大小
+#define NET_MANAGER_WAIT_TIME 100     //网络线程等待事件的最长时间(毫秒)，0为不等待
+#define NET_MANAGER_TIMER_PRECISION 10 //网络管理器连接定时器的精度(毫秒)
+#define NET_MANAGER_KEEPALIVE_TIME 1000 //调用连接心跳的间隔(毫秒)，0为不调用
+#define NET_MANAGER_CACHE_SIZE 4096   //网络管理器跨线程消息队列的大小(2的幂)
+#define NET_CONNECTOR_TIMEOUT 3000    //异步连接的超时时间(毫秒)
+#define NET_CONNECTOR_WAIT_EXTRA 1000 //阻塞连接等待结果的额外时间(毫秒)
+#define NET_CONNECTOR_BACKOFF_MIN 100 //重连退避的最短时间(毫秒)
+#define NET_CONNECTOR_BACKOFF_MAX (30 * 1000) //重连退避的最长时间(毫秒)
+#define NET_LISTENER_REACTORS_MAX 64  //监听器的最大网络线程(分片)数量
+#define NET_LISTENER_BACKLOG 1024     //监听套接字的连接队列大小(暂停接受时保留连接)
+#define NET_LISTENER_ACCEPT_RATE 0    //监听器每秒接受的新连接数量，0为不限制
+#define NET_LISTENER_ACCEPT_BURST 0   //接受新连接的突发数量，0为每秒的数量
+#define NET_LISTENER_HANDSHAKE_MAX 0  //等待握手的最大连接数量，0为不限制
+#define NET_LISTENER_PAUSE_TIME 100   //达到限制后暂停接受新连接的时间(毫秒)
+#define NET_IOURING_ENTRIES 1024      //io_uring提交队列的大小
+#define NET_IOURING_RECV_BUFFERS 1024 //io_uring接收缓存的数量(2的幂)
+#define NET_IOURING_RECV_BUFFER_SIZE (8 * 1024)
+#define NET_IOURING_SEND_BUFFERS 256  //io_uring发送(注册)缓存的数量
+#define NET_IOURING_SEND_BUFFER_SIZE (32 * 1024)
+#define NET_UDP_MTU 1400              //可靠UDP数据报的最大字节数
+#define NET_UDP_WINDOW 256            //可靠分片的发送(接收)窗口大小
+#define NET_UDP_RTO_DEFAULT 200       //没有往返时间样本时的重传超时(毫秒)
+#define NET_UDP_RTO_MIN 30            //重传超时的最小值(毫秒)
+#define NET_UDP_RTO_MAX 3000          //重传超时的最大值(毫秒)
+#define NET_UDP_FAST_RESEND 2         //分片被之后的确认跳过该次数则快速重传
+#define NET_UDP_DEAD_LINK 20          //分片发送该次数仍未确认则断开
+#define NET_UDP_PING_TIME 1000        //空闲时发送心跳的间隔(毫秒)
+#define NET_UDP_TIMEOUT 10000         //没有收到数据报则断开的时间(毫秒)
+#define NET_UDP_INPUT_LIMIT (1024 * 1024) //输入流超过该大小时通告零窗口
+#define NET_UDP_ACK_BLOCKS 16         //每个确认携带的选择确认块的最大数量
+#define NET_UDP_UNRELIABLE_HOLD 16    //保留的未完整不可靠消息的数量
+#define NET_UDP_FRAGMENTS_MAX 1024    //一个消息的最大分片数量，超过的分片丢弃
+#define NET_UDP_REASSEMBLY_MAX (4 * 1024 * 1024) //每个连接重组中消息的最大字节数
+#define NET_UDP_RECEIVE_BATCH 256     //每帧读取数据报的最大数量
+#define NET_SHARE_RING_SIZE (1024 * 1024) //共享内存连接每个方向的环大小
+#define NET_SHARE_CHECK_TIME 1000     //检查共享内存对端进程存活的间隔(毫秒)
+#define NET_SHARE_DOORBELL_PATH "/tmp/pf_net_share" //共享内存门铃管道的前缀
+#define NET_EXECUTOR_QUEUE_MAX 256     //每个连接在工作线程排队的最大消息数量
 #define NET_PACKET_FACTORYMANAGER_ALLOCMAX (1024 * 100)
+#define NET_PACKET_POOL_CACHE_SIZE 64   //每个线程每种网络包缓存的最大数量
+#define NET_PACKET_POOL_SIZE_MAX 1024   //每种网络包全局回收的最大数量
 #define NET_MODULENAME "net" 
 #define NET_ENCRYPT_CONNECTION_TIMEOUT 30 //加密的连接未成功加密断开的时间
 #define NET_EID_INVALID (-1)
@@ -61,16 +61,22 @@ class PF_API Basic {
 
  public:
    virtual bool process_input();
+   //Receive the data read by the completion io(not read the socket).
+   bool receive(const char *data, uint32_t size);
    virtual bool process_output();
    virtual bool process_command();
    virtual bool heartbeat(uint32_t time = 0, uint32_t flag = 0);
    virtual bool send(packet::Interface *packet);
+   //Send the data encoded by protocol.
+   bool send(const char *data, uint32_t size);
+   //Flush the output in this tick, not wait the coalescing.
+   void flush();
 
  public:
-   int16_t get_id() const { return id_; };
-   void set_id(int16_t id) { id_ = id; };
-   int16_t get_managerid() const { return managerid_; };
-   void set_managerid(int16_t managerid) { managerid_ = managerid; };
+   int32_t get_id() const { return id_; };
+   void set_id(int32_t id) { id_ = id; };
+   int32_t get_managerid() const { return managerid_; };
+   void set_managerid(int32_t managerid) { managerid_ = managerid; };
    socket::Basic *socket() { return socket_.get(); };
 
  public:
@@ -87,6 +93,9 @@ class PF_API Basic {
    void set_execute_count_pretick(uint8_t count) { 
      execute_count_pretick_ = count; 
    };
+   //The packets execute count reach the limit in this tick, maybe have more.
+   bool command_pending() const { return command_pending_; };
+   void set_command_pending(bool flag) { command_pending_ = flag; };
    void set_status(uint8_t status) { status_ = status; };
    uint8_t get_status() const { return status_; };
    void set_safe_encrypt(bool flag) { safe_encrypt_ = flag; };
@@ -110,6 +119,8 @@ class PF_API Basic {
    void encrypt_set_key(const char *key);
    uint32_t get_receive_bytes();
    uint32_t get_send_bytes();
+   //Return the stream buffers to pool if idle than stream::buffer::idle_time.
+   void shrink(uint32_t time);
 
  public:
    stream::Input &istream() { return *istream_.get(); }
@@ -119,25 +130,60 @@ class PF_API Basic {
    void set_protocol(protocol::Interface *protocol) {
      protocol_ = protocol;
    }
+   protocol::Interface *get_protocol() {
+     return protocol_;
+   }
    void set_listener(manager::Listener *listener) {
      listener_ = listener;
    }
    manager::Listener *get_listener() {
      return listener_;
    }
+   void set_manager(manager::Interface *manager) { manager_ = manager; };
+   manager::Interface *get_manager() { return manager_; };
+
+ public: //The flags of manager dirty lists(dirty_flag_t).
+   bool is_dirty(uint8_t flag) const { return (dirty_ & flag) != 0; };
+   void set_dirty(uint8_t flag, bool status = true) {
+     dirty_ = status ? (dirty_ | flag) : (dirty_ & ~flag);
+   };
+   //Have data in output stream wait to flush.
+   bool output_pending() const { 
+     return ostream_ && ostream_->size() > 0; 
+   };
+
+ public: //The timer ids in the manager timing wheel(connection_timer_t).
+   uint64_t timer(uint8_t kind) const { return timers_[kind]; };
+   void set_timer(uint8_t kind, uint64_t id) { timers_[kind] = id; };
+   bool is_alive() const { return alive_; };
+   void set_alive(bool flag) { alive_ = flag; };
+
+ public: //The output budget(connection::budget), work in net thread.
+   //Over the budget limits, the manager will remove it.
+   bool output_overflow() const { return output_overflow_; };
+   //Over the soft limit with throttle policy, not execute the input.
+   bool output_throttled() const { return output_throttled_; };
+   //The output bytes(stream and held packets) accounted to the global.
+   uint32_t output_size() const { return output_size_; };
+   //Account the output bytes, write the held packets if under soft limit.
+   void output_update();
 
  private:
    void process_input_compress();
+   //Check the budget before write the packet, return the action.
+   uint8_t output_check(uint16_t packet_id, uint32_t size);
+   void output_hold(uint16_t packet_id, const char *data, uint32_t size);
 
  private:
-   int16_t id_;
-   int16_t managerid_;
+   int32_t id_;
+   int32_t managerid_;
    std::unique_ptr<socket::Basic> socket_;
    std::unique_ptr<stream::Input> istream_;
    std::unique_ptr<stream::Input> istream_compress_;
    std::unique_ptr<stream::Output> ostream_;
    protocol::Interface *protocol_; //用个引用来做是否好些？
    manager::Listener *listener_;
+   manager::Interface *manager_; //The manager of connection added.
 
  private:
    bool empty_;
@@ -152,10 +198,22 @@ class PF_API Basic {
  private:
    uint32_t receive_bytes_;
    uint32_t send_bytes_;
+   bool active_; //Have traffic from the last shrink.
+   uint32_t idle_time_; //The idle start time.
+   bool alive_; //Have received from the last kick check.
+   uint64_t timers_[kConnectionTimerMax];
+   uint32_t output_size_; //The output bytes accounted to the global.
+   uint32_t output_soft_time_; //The time start over the soft limit.
+   bool output_overflow_;
+   bool output_throttled_;
+   std::deque< std::pair<uint16_t, std::string> > output_held_;
+   uint32_t output_held_size_;
 
  private:
    int8_t packet_index_;
    uint8_t execute_count_pretick_;
+   bool command_pending_;
+   uint8_t dirty_;
    uint8_t status_;
    bool safe_encrypt_; //This flag say the connection if encrypt in encrypt mode.
    uint32_t safe_encrypt_time_; //If not 0 then will check the safe encrypt. 
@@ -0,0 +1,111 @@
+/**
+ * PLAIN FRAMEWORK ( https://github.com/viticm/plainframework )
+ * $Id budget.h
+ * @link https://github.com/viticm/plainframework for the canonical source repository
+ * @copyright Copyright (c) 2014- viticm( viticm.ti@gmail.com )
+ * @license
+ * @user viticm<viticm.ti@gmail.com>
+ * @date 2026/10/17 20:10
+ * @uses The output memory budget of connections.
+ *       Every connection have a soft and a hard limit of the output bytes
+ *       wait to send, and all connections share the global limit(all off
+ *       by default, the kernel set them from the config).
+ *       Over the hard limit(or the soft limit too long) will disconnect,
+ *       over the soft limit use the policy(output_policy_t), over the global
+ *       limit the droppable packets drop and the connections over the soft
+ *       limit disconnect, so the slow consumers can't use all the memory.
+ *       The write coalescing default of connections also here, the small
+ *       writes flush together by the size or deadline(urgent packets not
+ *       wait), so the chatty connections use less syscalls and segments.
+*/
+#ifndef PF_NET_CONNECTION_BUDGET_H_
+#define PF_NET_CONNECTION_BUDGET_H_
+
+#include "pf/net/connection/config.h"
+
+namespace pf_net {
+
+namespace connection {
+
+namespace budget {
+
+typedef struct stat_struct {
+  uint64_t size;              //The output bytes of all connections.
+  uint64_t peak;              //The max size reached.
+  uint64_t held;              //The droppable packets held.
+  uint64_t dropped;           //The droppable packets dropped.
+  uint64_t coalesced;         //The held packets replaced by newer.
+  uint64_t throttled;         //The times of connection throttled.
+  uint64_t overflow_soft;     //Disconnect by the soft limit(policy or time).
+  uint64_t overflow_hard;     //Disconnect by the hard limit.
+  uint64_t overflow_global;   //Disconnect by the global limit.
+  stat_struct() :
+    size{0},
+    peak{0},
+    held{0},
+    dropped{0},
+    coalesced{0},
+    throttled{0},
+    overflow_soft{0},
+    overflow_hard{0},
+    overflow_global{0} {};
+} stat_t;
+
+//The counter kinds of stat.
+typedef enum {
+  kStatHeld = 0,
+  kStatDropped,
+  kStatCoalesced,
+  kStatThrottled,
+  kStatOverflowSoft,
+  kStatOverflowHard,
+  kStatOverflowGlobal,
+  kStatMax,
+} stat_kind_t;
+
+//The limits of every connection output bytes, 0 is no limit.
+PF_API uint32_t soft_limit();
+PF_API void set_soft_limit(uint32_t size);
+PF_API uint32_t hard_limit();
+PF_API void set_hard_limit(uint32_t size);
+
+//The max milliseconds over the soft limit, 0 is no limit.
+PF_API uint32_t soft_time();
+PF_API void set_soft_time(uint32_t time);
+
+//The limit of all connections output bytes, 0 is no limit.
+PF_API uint64_t global_limit();
+PF_API void set_global_limit(uint64_t size);
+
+//The policy(output_policy_t) when the connection over the soft limit.
+PF_API uint8_t policy();
+PF_API void set_policy(uint8_t policy);
+
+//The packets can hold and drop when the connection over the soft limit.
+PF_API bool droppable(uint16_t packet_id);
+PF_API void set_droppable(uint16_t packet_id, bool flag = true);
+
+//The write coalescing of new connections(stream::Output::set_coalesce),
+//0 size is off, the delay is microseconds.
+PF_API uint32_t coalesce_size();
+PF_API uint32_t coalesce_delay();
+PF_API void set_coalesce(uint32_t size, uint32_t delay);
+
+//The packets flush in this tick when the output coalescing.
+PF_API bool urgent(uint16_t packet_id);
+PF_API void set_urgent(uint16_t packet_id, bool flag = true);
+
+//The output bytes of all connections, the connections add the changed.
+PF_API uint64_t global_size();
+PF_API void global_add(int64_t size);
+
+PF_API void stat_add(uint8_t kind);
+PF_API stat_t stat();
+
+} //namespace budget
+
+} //namespace connection
+
+} //namespace pf_net
+
+#endif //PF_NET_CONNECTION_BUDGET_H_
@@ -19,6 +19,31 @@
 #define NET_CONNECTION_KICKTIME 6000000 //超过该时间则断开连接
 #define NET_CONNECTION_INCOME_KICKTIME 60000
 #define NET_CONNECTION_POOL_SIZE_DEFAULT 1280 //连接池默认大小
+#define NET_CONNECTION_OUTPUT_SOFT_LIMIT 0 //输出待发送的软限制，0为不限制
+#define NET_CONNECTION_OUTPUT_HARD_LIMIT 0 //超过则断开连接，0为不限制
+#define NET_CONNECTION_OUTPUT_SOFT_TIME (60 * 1000) //超过软限制的最长时间(毫秒)
+#define NET_CONNECTION_OUTPUT_GLOBAL_LIMIT 0 //所有连接输出的总限制，0为不限制
+#define NET_CONNECTION_OUTPUT_HOLD_MAX 64 //超过软限制后保留的可丢弃消息数量
+#define NET_CONNECTION_COALESCE_SIZE 0 //输出合并发送的字节数，0为不合并
+#define NET_CONNECTION_COALESCE_DELAY 1000 //输出合并等待的最长时间(微秒)
+
+//The connection id is a handle [generation:11][index:20], the index is the 
+//slot in pool and the generation changed when the slot recycled, so the old
+//handles of the async works will not get the new connection.
+#define NET_CONNECTION_INDEX_BITS 20
+#define NET_CONNECTION_INDEX_MASK ((1 << NET_CONNECTION_INDEX_BITS) - 1)
+#define NET_CONNECTION_INDEX_MAX (NET_CONNECTION_INDEX_MASK + 1)
+#define NET_CONNECTION_GENERATION_MASK 0x7ff
+#define NET_CONNECTION_ID(index,generation) \
+  static_cast<int32_t>( \
+    ((static_cast<uint32_t>(generation) & NET_CONNECTION_GENERATION_MASK) \
+     << NET_CONNECTION_INDEX_BITS) | \
+    (static_cast<uint32_t>(index) & NET_CONNECTION_INDEX_MASK))
+#define NET_CONNECTION_ID_INDEX(id) \
+  (static_cast<uint32_t>(id) & NET_CONNECTION_INDEX_MASK)
+#define NET_CONNECTION_ID_GENERATION(id) \
+  ((static_cast<uint32_t>(id) >> NET_CONNECTION_INDEX_BITS) & \
+   NET_CONNECTION_GENERATION_MASK)
 
 namespace pf_net {
 
@@ -32,8 +57,49 @@ typedef enum {
   kCompressModeAll = 3,     //无论是输入流还是输出流都压缩
 } compress_mode_t;
 
+//管理器脏链表标记，只处理链表中的连接
+typedef enum {
+  kDirtyFlagNone = 0,
+  kDirtyFlagOutput = 1,     //In the output list(have data wait to flush).
+  kDirtyFlagInput = 2,      //In the input list(have data wait to execute).
+  kDirtyFlagWritable = 4,   //Output blocked, wait the socket writable event.
+  kDirtyFlagCoalesce = 8,   //Output held by coalescing, flush at the deadline.
+  kDirtyFlagAll = 15,
+} dirty_flag_t;
+
+//The timers of connection in the manager timing wheel.
+typedef enum {
+  kConnectionTimerIdle = 0,       //Shrink the stream buffers if idle.
+  kConnectionTimerKick,           //Kick if no traffic in the kick time.
+  kConnectionTimerHandshake,      //Kick if not safe encrypt in time.
+  kConnectionTimerKeepalive,      //Call the connection heartbeat.
+  kConnectionTimerConnect,        //The connect timeout of connector.
+  kConnectionTimerMax,
+} connection_timer_t;
+
+//The output policies when the connection over the soft limit.
+typedef enum {
+  kOutputPolicyNone = 0,   //Write all until the hard limit.
+  kOutputPolicyDrop,       //Hold the droppable packets, drop the oldest.
+  kOutputPolicyCoalesce,   //Hold the droppable packets, the newer replace
+                           //the held with same id.
+  kOutputPolicyThrottle,   //Pause executing the input packets.
+  kOutputPolicyDisconnect, //Disconnect at once.
+} output_policy_t;
+
+//The channels of udp connection(the packet id decide it).
+typedef enum {
+  kUdpChannelReliable = 0, //Reliable and ordered(the output stream).
+  kUdpChannelUnordered,    //Reliable, deliver when the message arrived.
+  kUdpChannelUnreliable,   //Send once, the lost not resend.
+  kUdpChannelMax,
+} udp_channel_t;
+
 class Basic;
 class Pool;
+class Udp;
+class Share;
+class Executor;
 
 } //namespace connection
 
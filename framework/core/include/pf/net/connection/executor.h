@@ -0,0 +1,130 @@
+/**
+ * PLAIN FRAMEWORK ( https://github.com/viticm/plainframework )
+ * $Id executor.h
+ * @link https://github.com/viticm/plainframework for the canonical source repository
+ * @copyright Copyright (c) 2014- viticm( viticm.ti@gmail.com )
+ * @license
+ * @user viticm<viticm.ti@gmail.com>
+ * @date 2026/10/19 15:30
+ * @uses The packet executor, run the packet handlers in the worker threads.
+ *       The net thread only decode the packets, the packets of a connection
+ *       in a serial queue(execute in order and one by one), every queue
+ *       belong to one worker by the hash, so the net threads and workers 
+ *       only lock the worker of the connection.
+ *       The handler in worker get a proxy of the connection(the connection
+ *       may removed and reused in net thread), it only have the id, manager
+ *       and protocol, the send encode the packet and write it to the 
+ *       connection of the id in net thread. The handlers need the other
+ *       state of connection must execute in net thread(no executor).
+ */
+#ifndef PF_NET_CONNECTION_EXECUTOR_H_
+#define PF_NET_CONNECTION_EXECUTOR_H_
+
+#include "pf/net/connection/manager/config.h"
+#include "pf/net/packet/factorymanager.h"
+#include <unordered_map>
+
+namespace pf_net {
+
+namespace connection {
+
+class PF_API Executor {
+
+ public:
+   Executor();
+   ~Executor();
+
+ public:
+   //Start the worker threads.
+   bool init(uint32_t workers, uint32_t queue_max = NET_EXECUTOR_QUEUE_MAX);
+   //Wait the running handlers and drop the waiting packets.
+   void stop();
+   uint32_t workers() const { return static_cast<uint32_t>(workers_.size()); };
+
+ public: //Work in net thread.
+   //Execute the packet in worker with the handler(packet execute if null)
+   //and the proxy of connection, the packet removed after executed.
+   bool post(connection::Basic *connection,
+             packet::Interface *packet,
+             packet::function_packet_execute handler);
+   //The queue of connection reach the max, stop decode until it drained
+   //half(the manager execute the connection again).
+   bool full(connection::Basic *connection);
+   //Drop the waiting packets of connection(removed). The handler error
+   //close the queue at once, the packets posted after it are dropped until
+   //the cancel.
+   void cancel(manager::Interface *manager, int32_t id);
+   //Drop the waiting packets of manager and wait the running handlers.
+   void detach(manager::Interface *manager);
+
+ public:
+   //The worker thread executing the handler(send in net thread).
+   static bool in_worker();
+   //Encode in worker and write to the connection of the id in net thread
+   //(the connection::Basic::send call it in worker).
+   static bool send(connection::Basic *connection, packet::Interface *packet);
+   static bool send(connection::Basic *connection,
+                    const char *data,
+                    uint32_t size);
+   //Flush the connection output after the sends in net thread.
+   static bool flush(connection::Basic *connection);
+   uint64_t executed() const { return executed_; };
+   uint64_t pending() const { return pending_; };
+
+ private:
+   struct task_struct {
+     packet::Interface *packet;
+     packet::function_packet_execute handler;
+     protocol::Interface *protocol; //The protocol of connection(encode).
+   };
+   struct strand_struct {
+     manager::Interface *manager;
+     int32_t id;
+     std::deque<task_struct> tasks;
+     bool scheduled; //In the ready queue or running.
+     bool blocked;   //The net thread stopped decode.
+     bool closed;    //Not execute(the handler error or cancelled).
+     bool cancelled; //The net thread removed the connection.
+   };
+   using strand_key_t = std::pair<manager::Interface *, int32_t>;
+   struct strand_hash {
+     size_t operator()(const strand_key_t &key) const {
+       return std::hash<void *>()(key.first) ^
+              std::hash<int32_t>()(key.second);
+     }
+   };
+   struct worker_struct {
+     std::thread thread;
+     std::unordered_map<strand_key_t,
+                        std::unique_ptr<strand_struct>,
+                        strand_hash> strands;
+     std::deque<strand_struct *> ready; /* 有待执行消息的连接队列 */
+     std::mutex mutex;
+     std::condition_variable condition;
+     std::condition_variable idle;      /* 执行完成的通知(等待分离) */
+   };
+
+ private:
+   worker_struct &worker_get(manager::Interface *manager, int32_t id);
+   void work(worker_struct &worker);
+   //Return false if the handler error(the connection will remove).
+   bool execute(Basic &proxy, strand_struct *strand, task_struct &task);
+   //Drop the waiting packets and not execute the strand(locked).
+   void strand_close(strand_struct *strand);
+   //Remove the strand if not have work and not wait the cancel(locked).
+   void strand_release(worker_struct &worker, strand_struct *strand);
+
+ private:
+   std::vector< std::unique_ptr<worker_struct> > workers_;
+   uint32_t queue_max_;                /* 每个连接排队的最大数量 */
+   std::atomic<bool> stop_;
+   std::atomic<uint64_t> executed_;
+   std::atomic<uint64_t> pending_;
+
+};
+
+} //namespace connection
+
+} //namespace pf_net
+
+#endif //PF_NET_CONNECTION_EXECUTOR_H_
@@ -13,6 +13,7 @@
 
 #include "pf/net/connection/manager/config.h"
 #include "pf/net/connection/manager/epoll.h"
+#include "pf/net/connection/manager/iouring.h"
 #include "pf/net/connection/manager/select.h"
 
 namespace pf_net {
@@ -21,7 +22,9 @@ namespace connection {
 
 namespace manager {
 
-#if OS_UNIX && defined(PF_OPEN_EPOLL) /* { */  
+#if OS_UNIX && defined(PF_OPEN_IOURING) /* { */
+class PF_API Basic : public IoUring {
+#elif OS_UNIX && defined(PF_OPEN_EPOLL) /* }{ */
 class PF_API Basic : public Epoll {
 #elif OS_WIN && defined(PF_OPEN_IOCP) /* }{ */
 class PF_API Basic : public Iocp {
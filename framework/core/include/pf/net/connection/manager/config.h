@@ -14,12 +14,21 @@
 #include "pf/net/connection/config.h"
 #include "pf/net/packet/config.h"
 
+//The global handle of connection in reactors(listener shards).
+#define NET_REACTOR_HANDLE(index,id) \
+  ((static_cast<int64_t>(index) << 32) | static_cast<uint32_t>(id))
+#define NET_REACTOR_HANDLE_INDEX(handle) \
+  static_cast<uint8_t>(static_cast<uint64_t>(handle) >> 32)
+#define NET_REACTOR_HANDLE_ID(handle) \
+  static_cast<int32_t>((handle) & 0xffffffff)
+
 namespace pf_net {
 
 namespace connection {
 
 namespace manager {
 
+class Interface;
 class Basic;
 class Listener;
 class ListenerFactory;
@@ -27,29 +36,63 @@ class Connector;
 class Epool;
 class Iocp;
 class Select;
+class Udp;
+class Share;
 
-typedef PF_API struct cache_struct cache_t;
-struct cache_struct {
-  packet::queue_t *queue;
-  uint32_t head;
-  uint32_t tail;
-  uint32_t size;
-  cache_struct() : 
-    queue{nullptr},
-    head{0},
-    tail{0},
-    size{0}
-  {};
-  ~cache_struct() {
-    safe_delete_array(queue);
-  };
-};
+//The manager timers not belong to connection(the id is not connection).
+typedef enum {
+  kManagerTimerReconnect = kConnectionTimerMax, //Connector target reconnect.
+  kManagerTimerAccept,                          //Listener resume accepting.
+  kManagerTimerUdp,                             //Udp connection update.
+  kManagerTimerUdpDelay,                        //Udp simulated delay.
+  kManagerTimerShare,                           //Share check the peers.
+} manager_timer_t;
+
+//The listener accept metrics(every reactor).
+typedef struct accept_stat_struct {
+  uint64_t accepted;          //The sockets accepted.
+  uint64_t rate_limited;      //The times limited by accept rate.
+  uint64_t handshake_limited; //The times limited by pending handshakes.
+  uint64_t rejected;          //The sockets closed after accepted(full or paused).
+  uint64_t forwarded;         //The sockets passed to the workers.
+  accept_stat_struct() :
+    accepted{0},
+    rate_limited{0},
+    handshake_limited{0},
+    rejected{0},
+    forwarded{0} {};
+} accept_stat_t;
+
+//The accepted socket passed to the worker(the descriptor in SCM_RIGHTS).
+typedef struct forward_struct {
+  uint16_t port;
+  char host[IP_SIZE];
+} forward_t;
+
+//The udp manager metrics.
+typedef struct udp_stat_struct {
+  uint64_t sent;              //The datagrams sent.
+  uint64_t received;          //The datagrams received.
+  uint64_t invalid;           //The datagrams ignored(unknown peer or session).
+  uint64_t challenged;        //The connects challenged(no or wrong cookie).
+  uint64_t simulate_lost;     //The datagrams dropped by the simulation.
+  uint64_t simulate_delayed;  //The datagrams delayed by the simulation.
+  udp_stat_struct() :
+    sent{0},
+    received{0},
+    invalid{0},
+    challenged{0},
+    simulate_lost{0},
+    simulate_delayed{0} {};
+} udp_stat_t;
 
 struct listener_config_struct {
   std::string ip;
   uint16_t port;
-  uint16_t conn_max;
+  std::string path; //The unix domain socket(not empty) instead of ip and port.
+  uint32_t conn_max;
   std::string encrypt_str;
+  uint8_t reactors{1}; //The net threads count(listener shards).
 };
 using eid_t = int16_t; //Environment.
 
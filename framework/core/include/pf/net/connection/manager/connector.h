@@ -24,13 +24,80 @@ namespace manager {
 class PF_API Connector : public Basic {
 
  public:
-   Connector() {};
+   Connector();
    virtual ~Connector() {};
 
  public:
-   bool init(uint16_t max_size = NET_CONNECTION_MAX);
+   bool init(uint32_t max_size = NET_CONNECTION_MAX);
+   //The blocking connect, the port 0 connect the unix domain socket of the
+   //path ip(same as the non blocking).
+   //It connect in the net thread and wait the result, drive the tick if no
+   //other thread ticking, can't call in the tick(use connect_async).
    virtual connection::Basic *connect(const char *ip, uint16_t port);
+   //Same as the connect(the old with select).
    virtual connection::Basic *group_connect(const char *ip, uint16_t port);
+   //Only one thread tick at the same time, the others return at once.
+   virtual void tick();
+
+ public: //Non blocking connect, can work in mutli thread(run in net thread).
+   using connect_callback_t = std::function<void (connection::Basic *)>;
+   //The callback with the connection or nullptr(failed or timeout).
+   void connect_async(const std::string &ip, 
+                      uint16_t port, 
+                      connect_callback_t callback,
+                      uint32_t timeout = NET_CONNECTOR_TIMEOUT);
+   //Keep the connection of name, reconnect with backoff if failed or lost.
+   //The callback only with the connected connections.
+   void keep(const std::string &name,
+             const std::string &ip,
+             uint16_t port,
+             connect_callback_t callback);
+   //The blocking connect, the connected callback run in the net thread
+   //before return(send the first packets).
+   connection::Basic *connect_wait(const std::string &ip,
+                                   uint16_t port,
+                                   connect_callback_t connected,
+                                   uint32_t timeout = NET_CONNECTOR_TIMEOUT);
+   size_t connecting_size() const { return connecting_.size(); };
+
+ public:
+   virtual void on_timer(uint8_t kind, int32_t id);
+   virtual void on_disconnect(connection::Basic *connection);
+
+ private:
+   typedef struct target_struct {
+     std::string name;
+     std::string ip;
+     uint16_t port;
+     connect_callback_t callback;
+     uint32_t failures; //The failed times from the last connected.
+     int32_t connectionid;
+   } target_t;
+   typedef struct connecting_struct {
+     connect_callback_t callback;
+     int32_t target; //The index of targets, -1 is not.
+     bool watched; //The reactor watch the writable.
+   } connecting_t;
+
+ protected:
+   //Finish the connecting by the socket error(SO_ERROR).
+   virtual bool connect_ready(connection::Basic *connection);
+
+ private:
+   void connect_start(const std::string &ip, 
+                      uint16_t port, 
+                      connect_callback_t callback,
+                      uint32_t timeout,
+                      int32_t target);
+   void connect_finish(connection::Basic *connection, bool success);
+   void reconnect_later(int32_t target);
+
+ private:
+   std::map<int32_t, connecting_t> connecting_; /* 正在连接的连接 */
+   std::vector<target_t> targets_;               /* 保持连接的目标 */
+   std::atomic<bool> ticking_;                   /* 正在帧处理 */
+   std::atomic<std::thread::id> tick_thread_;    /* 最后帧处理的线程 */
+   std::minstd_rand random_;                     /* 退避的随机抖动 */
 
 };
 
@@ -29,7 +29,7 @@ class PF_API Epoll : public Interface {
    virtual ~Epoll();
 
  public:
-   virtual bool init(uint16_t connectionmax = NET_CONNECTION_MAX);
+   virtual bool init(uint32_t connectionmax = NET_CONNECTION_MAX);
    virtual bool select();             //网络侦测
    virtual bool process_input();      //数据接收接口
    virtual bool process_output();     //数据发送接口
@@ -38,15 +38,29 @@ class PF_API Epoll : public Interface {
    virtual bool heartbeat(uint32_t time = 0);
 
  public:
-   virtual bool socket_add(int32_t socketid, int16_t connectionid);
+   virtual bool socket_add(int32_t socketid, int32_t connectionid);
    //将拥有fd句柄的玩家(服务器)数据从当前系统中清除
    virtual bool socket_remove(int32_t socketid);
 
+ protected:
+   //Watch the writable of the blocked connection.
+   virtual bool output_wait(connection::Basic *connection, bool wait);
+   //Watch the writable of the connecting socket.
+   virtual bool connect_watch(connection::Basic *connection, bool watch);
+   //Pause or resume the readable of the listener socket.
+   virtual bool accept_watch(bool on);
+
+ public:
+   //Wake up the epoll wait by the eventfd.
+   virtual void wakeup();
+
  public:
-   bool poll_set_max_size(uint16_t max_size);
+   bool poll_set_max_size(uint32_t max_size);
 
  private:
    polldata_t polldata_;
+   int32_t wakeup_fd_;
+   std::atomic<bool> wakeup_pending_;
 
 };
 
@@ -15,6 +15,8 @@
 
 #include "pf/net/connection/manager/config.h"
 #include "pf/sys/thread.h"
+#include "pf/basic/timing_wheel.h"
+#include "pf/basic/mpsc_queue.tcc"
 #include "pf/net/packet/interface.h"
 #include "pf/net/protocol/basic.h"
 #include "pf/net/connection/basic.h"
@@ -33,32 +35,32 @@ class PF_API Interface {
    virtual ~Interface();
  
  public:
-   bool init(uint16_t maxcount = NET_CONNECTION_MAX);
-   bool pool_init(uint16_t connectionmax = NET_CONNECTION_MAX);
+   bool init(uint32_t maxcount = NET_CONNECTION_MAX);
+   bool pool_init(uint32_t connectionmax = NET_CONNECTION_MAX);
    void pool_set(connection::Pool *pool);
    bool add(connection::Basic *connection);
 
  public:
    virtual bool heartbeat(uint32_t time = 0);
    //从管理器中移除连接
-   virtual bool remove(int16_t id);
+   virtual bool remove(int32_t id);
    //删除连接包括管理器、socket
    virtual bool erase(connection::Basic *connection);
    //彻底删除连接，管理器、socket、pool
    virtual bool remove(connection::Basic *connection);
    //清除管理器中所有连接
    virtual bool destroy();
-   connection::Basic *get(int16_t id);
-   virtual bool socket_add(int32_t socketid, int16_t connectionid) = 0;
+   //Get the connection by the id(handle), nullptr if it is stale.
+   connection::Basic *get(int32_t id);
+   virtual bool socket_add(int32_t socketid, int32_t connectionid) = 0;
    virtual bool socket_remove(int32_t socketid) = 0;
    virtual bool is_service() const { return false; }
 
  public:
-   int16_t *get_idset();
-   uint16_t size() const { return size_; };
-   uint16_t max_size() const { return max_size_; }
+   int32_t *get_idset();
+   uint32_t size() const { return size_; };
+   uint32_t max_size() const { return max_size_; }
    bool hash();
-   connection::Basic *get(uint16_t id);
    connection::Pool *get_pool();
    int32_t get_onestep_accept() const;
    void set_onestep_accept(int32_t count);
@@ -67,18 +69,44 @@ class PF_API Interface {
    bool is_ready() const { return ready_; };
    bool full() const { return pool_ ? pool_->full() : true; };
 
- public: //Packet queue, can work in mutli thread.
+ public: //Packet queue(lock free and bounded), can work in mutli thread.
+   //The manager own the packet, return false if the queue is full(the packet
+   //dropped, check the cache_pressure before send to slow down).
    virtual bool send(packet::Interface *packet, 
-                     uint16_t id, 
+                     int32_t id, 
                      uint32_t flag = kPacketFlagNone);
    virtual bool process_command_cache();
    virtual bool recv(packet::Interface *&packet,
-                     uint16_t &connectionid,
+                     int32_t &connectionid,
                      uint32_t &flag);
    virtual void on_disconnect(connection::Basic *) {}
    virtual void on_connect(connection::Basic *) {}
-   bool cache_resize();
+   size_t cache_size() const { return cache_.size(); };
+   size_t cache_capacity() const { return cache_.capacity(); };
+   size_t cache_high_water() const { return cache_.high_water(); };
+   //The count of packets dropped by the queue is full.
+   uint64_t cache_full_count() const { return cache_.full_count(); };
+   //The queue is over the high water mark, the producers should slow down.
+   bool cache_pressure() const {
+     return cache_.size() >= cache_.capacity() / 4 * 3;
+   };
+   //Run the task in net thread(next tick), can work in mutli thread.
+   void enqueue(std::function<void ()> task);
+   bool process_tasks();
+   //The packet encode once and copy to all connections.
    void broadcast(packet::Interface *packet);
+   //Execute the packets in the workers(not owned), the net thread only 
+   //decode, nullptr execute in net thread(default).
+   void set_executor(connection::Executor *executor);
+   connection::Executor *executor() const { return executor_; };
+
+ public: //Connection groups(room, channel and so on), work in net thread.
+   bool group_join(const std::string &name, int32_t id);
+   bool group_leave(const std::string &name, int32_t id);
+   //Leave all groups.
+   void group_leave(int32_t id);
+   void group_broadcast(const std::string &name, packet::Interface *packet);
+   size_t group_size(const std::string &name) const;
 
  public:
    void callback_disconnect(
@@ -93,6 +121,69 @@ class PF_API Interface {
  public:
    bool checkpool(bool log = true);
 
+ public: //Wait events.
+   //The max time(milliseconds) of select waiting, 0 is not wait(default).
+   void set_wait_time(uint32_t time) { wait_time_ = time; };
+   uint32_t wait_time() const { return wait_time_; };
+   //Wake up the waiting select, can work in mutli thread.
+   virtual void wakeup() {};
+   //Have work to do now(not wait in select).
+   bool busy();
+
+ public: //Connection timers, work in net thread.
+   //Kick the connection if no traffic in the time(milliseconds), 0 is off.
+   void set_kick_time(uint32_t time) { kick_time_ = time; };
+   uint32_t kick_time() const { return kick_time_; };
+   //Call the connection heartbeat in the time(milliseconds), 0 is off.
+   void set_keepalive_time(uint32_t time) { keepalive_time_ = time; };
+   uint32_t keepalive_time() const { return keepalive_time_; };
+   //Call the connection heartbeat in every tick(walk all connections), off
+   //by default, only for the heartbeats need it.
+   void set_heartbeat_tick(bool flag) { heartbeat_tick_ = flag; };
+   bool heartbeat_tick() const { return heartbeat_tick_; };
+   //Set the timer(connection_timer_t) of connection, reset if exists.
+   bool timer_set(connection::Basic *connection, uint8_t kind, uint32_t delay);
+   void timer_cancel(connection::Basic *connection, uint8_t kind);
+   //The expired timers not handled by manager(the extend kinds).
+   virtual void on_timer(uint8_t, int32_t) {};
+   //The connections wait the handshake(armed the handshake timer).
+   uint32_t handshake_pending() const { return handshakes_; };
+
+ public: //Dirty lists, the tick only flush and execute the connections in it.
+   //The connection have output wait to flush(after send).
+   void output_dirty(connection::Basic *connection);
+   //The connection have input wait to execute(after receive).
+   void input_dirty(connection::Basic *connection);
+
+ protected:
+   void broadcast(packet::Interface *packet, 
+                  const int32_t *ids, 
+                  size_t count);
+   //Watch the writable event of the connection when output is blocked.
+   virtual bool output_wait(connection::Basic *, bool) { return true; };
+   //Watch the writable event of the connecting socket(not added).
+   virtual bool connect_watch(connection::Basic *, bool) { return true; };
+   //The connecting socket is writable(connected or failed), false if the
+   //connection is not connecting.
+   virtual bool connect_ready(connection::Basic *) { return false; };
+   //Flush the output dirty list, the blocked connections wait writable.
+   bool process_output_dirty();
+   //Move the coalescing connections reached the deadline to output list.
+   void process_coalesce_dirty();
+   //Hold the output of connection until the coalescing size or deadline(in
+   //the coalescing list), the now get when the first need.
+   bool output_coalesce(connection::Basic *connection, uint64_t &now);
+   //The milliseconds to the nearest coalescing deadline(round up).
+   uint32_t coalesce_timeout() const;
+   //The connection output over the budget(log it), should remove.
+   bool output_overflow(connection::Basic *connection);
+   //Execute the input dirty list, keep the pending connections in it.
+   bool process_command_dirty();
+   //Add the timer of kind and id to wheel, return the timer id(0 failed).
+   uint64_t timer_add(uint8_t kind, int32_t id, uint32_t delay);
+   //Watch the readable event of listener socket or not(pause accepting).
+   virtual bool accept_watch(bool) { return true; };
+
  public:
    std::thread::id thread_id() const { return thread_id_; }
 
@@ -113,18 +204,29 @@ class PF_API Interface {
  public:
    //For listener.
    virtual connection::Basic *accept() { return nullptr; };
+   //Add the socket accepted by the completion io.
+   virtual connection::Basic *attach(int32_t, const std::string &, uint16_t) {
+     return nullptr;
+   };
    virtual int32_t listener_socket_id() const { return SOCKET_INVALID; };
+   //The listener socket is the forward channel(wait readable, not accept).
+   virtual bool is_forward() const { return false; };
+   //Accept the sockets in backlog until would block or limited.
+   virtual uint32_t accept_batch(uint32_t) { return 0; };
+   //Check the accept limits before accept one socket, the completion io 
+   //close the socket accepted if false.
+   virtual bool accept_check() { return true; };
 
  protected:
-   uint16_t connection_max_size_;
+   uint32_t connection_max_size_;
    int32_t fdsize_; //实际的网络连接数量，正在连接的，
                     //其实和count_一样，不过此值只用于轮询模式
    bool ready_; /* 是否把该准备的已经准备好了，主要是内存的初始化 */
 
  protected:
-   int16_t *connection_idset_;    /* 连接的ID数组 */
-   uint16_t max_size_;            /* 连接的最大数量 */
-   uint16_t size_;                /* 连接的当前数量 */
+   int32_t *connection_idset_;    /* 连接的ID数组 */
+   uint32_t max_size_;            /* 连接的最大数量 */
+   uint32_t size_;                /* 连接的当前数量 */
    uint64_t send_bytes_;          /* 发送字节数 */
    uint64_t receive_bytes_;       /* 接收字节数 */
    int32_t onestep_accept_;       /* 帧内接受的新连接数量, -1无限制 */
@@ -133,8 +235,35 @@ class PF_API Interface {
    std::function<void (connection::Basic *)> callback_disconnect_;
    /* 断开连接的回调，同上 */
    std::function<void (connection::Basic *)> callback_connect_;
-   cache_t cache_;
-   std::mutex mutex_;
+   pf_basic::MpscQueue<packet::queue_t> cache_; /* 跨线程的消息队列 */
+   //The ids of group, the indexes of ids remove it by swap the last.
+   struct group_struct {
+     std::vector<int32_t> ids;
+     std::unordered_map<int32_t, size_t> indexes;
+   };
+   std::unordered_map<std::string, group_struct> groups_; /* 连接分组 */
+   /* 连接加入的分组 */
+   std::unordered_map< int32_t, std::unordered_set<std::string> > memberships_;
+   std::vector< std::function<void ()> > tasks_; /* 网络线程任务 */
+   std::mutex task_mutex_;
+   uint32_t wait_time_;           /* 等待事件的最长时间 */
+   int32_t wait_timeout_;         /* 本帧等待事件的时间 */
+   std::vector<int32_t> output_dirtys_; /* 有数据待发送的连接 */
+   std::vector<int32_t> input_dirtys_;  /* 有数据待执行的连接 */
+   std::vector<int32_t> dirtys_;        /* 处理中的脏链表 */
+   std::vector<int32_t> coalesce_dirtys_; /* 合并等待发送的连接 */
+   uint64_t coalesce_deadline_;         /* 最近的合并发送时间(微秒) */
+   pf_basic::TimingWheel wheel_;        /* 连接的定时器 */
+   uint32_t kick_time_;                 /* 无流量踢出的时间 */
+   uint32_t keepalive_time_;            /* 连接心跳的间隔 */
+   bool heartbeat_tick_;                /* 每帧调用所有连接的心跳 */
+   std::atomic<uint32_t> handshakes_;   /* 等待握手的连接数量 */
+   connection::Executor *executor_;     /* 执行消息的工作线程 */
+
+ private:
+   //Remove the id from the group, erase the group if it is empty.
+   bool group_erase(
+       std::unordered_map<std::string, group_struct>::iterator it, int32_t id);
 
  private:
    std::thread::id thread_id_;
@@ -0,0 +1,87 @@
+/**
+ * PLAIN FRAMEWORK ( https://github.com/viticm/plainframework )
+ * $Id iouring.h
+ * @link https://github.com/viticm/plainframework for the canonical source repository
+ * @copyright Copyright (c) 2014- viticm( viticm.ti@gmail.com )
+ * @license
+ * @user viticm<viticm.ti@gmail.com>
+ * @date 2026/10/17 10:21
+ * @uses The io_uring connection manager(linux 5.19+, use it by PF_OPEN_IOURING).
+ *       The completions of multishot accept and recv(provided buffer ring)
+ *       feed the connections, the output copy to the registered buffers and
+ *       write with the fixed files, all submissions batched in select.
+ */
+#ifndef PF_NET_CONNECTION_MANAGER_IOURING_H_
+#define PF_NET_CONNECTION_MANAGER_IOURING_H_
+
+#include "pf/net/connection/manager/config.h"
+
+#if OS_UNIX && defined(PF_OPEN_IOURING)
+
+#include "pf/net/connection/manager/interface.h"
+
+namespace pf_net {
+
+namespace connection {
+
+namespace manager {
+
+typedef PF_API struct uringdata_struct uringdata_t;
+
+class PF_API IoUring : public Interface {
+
+ public:
+   IoUring();
+   virtual ~IoUring();
+
+ public:
+   virtual bool init(uint32_t connectionmax = NET_CONNECTION_MAX);
+   virtual bool select();             //提交请求并等待完成事件
+   virtual bool process_input();      //处理完成事件
+   virtual bool process_output();     //数据发送接口
+   virtual bool process_exception();  //异常连接处理
+   virtual bool process_command();    //消息执行
+   virtual bool heartbeat(uint32_t time = 0);
+
+ public:
+   virtual bool socket_add(int32_t socketid, int32_t connectionid);
+   virtual bool socket_remove(int32_t socketid);
+
+ public:
+   //Wake up the waiting by the eventfd.
+   virtual void wakeup();
+
+ protected:
+   //Cancel the multishot accept when pause, arm it again when resume.
+   virtual bool accept_watch(bool on);
+   //Poll the writable of the connecting socket once(not fixed file).
+   virtual bool connect_watch(connection::Basic *connection, bool watch);
+
+ private:
+   bool uring_init(uint32_t connectionmax);
+   bool accept_arm();
+   bool recv_arm(int32_t connection_id);
+   bool write_submit(int32_t connection_id);
+   void on_accept(int32_t result, uint32_t flags);
+   void on_recv(int32_t connection_id, int32_t result, uint32_t flags);
+   void on_write(int32_t connection_id, int32_t result);
+   void send_buffer_free(uint16_t index);
+
+ private:
+   std::unique_ptr<uringdata_t> uringdata_;
+   int32_t wakeup_fd_;
+   std::atomic<bool> wakeup_pending_;
+   bool accept_armed_; /* 已提交多次接受 */
+   bool accept_on_; /* 是否接受新连接 */
+
+};
+
+} //namespace manager
+
+} //namespace connection
+
+} //namespace pf_net
+
+#endif
+
+#endif //PF_NET_CONNECTION_MANAGER_IOURING_H_
@@ -31,7 +31,21 @@ class PF_API Listener : public Basic {
    virtual bool is_service() const { return true; }
 
  public:
-   bool init(uint16_t max_size, uint16_t port, const std::string &ip);
+   //The reactors more than 1 will start the shards listen the same port.
+   bool init(uint32_t max_size, 
+             uint16_t port, 
+             const std::string &ip, 
+             uint8_t reactors = 1);
+   //Listen the unix domain socket of path, the primary accept for all shards.
+   bool init_unix(uint32_t max_size, 
+                  const std::string &path, 
+                  uint8_t reactors = 1);
+   //Not listen, the sockets come from the forward channel of the front, the
+   //reactor watch the channel as the listener socket(kernel: 
+   //default.net.forward_channel, the caller own the channel).
+   bool init_forward(uint32_t max_size, 
+                     int32_t channel_id, 
+                     uint8_t reactors = 1);
    uint16_t port() const { 
      return listener_socket_ ? listener_socket_->port() : 0; 
    };
@@ -39,28 +53,113 @@ class PF_API Listener : public Basic {
      return listener_socket_ ? listener_socket_->host() : "";
    }
    virtual connection::Basic *accept(); //新连接接受处理
+   virtual uint32_t accept_batch(uint32_t count);
+   //Add the socket accepted by listener(close it if failed), the options
+   //inherit from the listener socket.
+   virtual connection::Basic *attach(int32_t socket_id, 
+                                     const std::string &host, 
+                                     uint16_t port);
 
  public:
 
    virtual void on_connect(connection::Basic * connection);
+   virtual void on_timer(uint8_t kind, int32_t id);
+
+ public: //Accept overload protection(every reactor accepted by itself).
+   //The token bucket of accept, rate is the count per second(0 no limit) and
+   //burst is the bucket size(0 same as rate).
+   void set_accept_rate(uint32_t rate, uint32_t burst = 0);
+   uint32_t accept_rate() const { return accept_rate_; };
+   //Pause accept when the connections wait handshake reach it(0 no limit).
+   void set_handshake_max(uint32_t count);
+   uint32_t handshake_max() const { return handshake_max_; };
+   virtual bool accept_check();
+   const accept_stat_t &accept_stat() const { return accept_stat_; };
+
+ public: //Accept in the front process and serve in the workers.
+   //The channel is the connected unix socket(socketpair) to the worker, the 
+   //accepted sockets pass to the channels in turn(work in the net thread).
+   //The socket attach in this listener if all channels busy or broken.
+   //Only the channel keep the message boundaries(SOCK_SEQPACKET or 
+   //SOCK_DGRAM) can add, the stream maybe split a message. The channels are
+   //owned by the caller(kernel: default.net.forward_channels).
+   bool forward_add(int32_t channel_id);
+   //Create the SOCK_SEQPACKET channel, the front end is nonblocking.
+   static bool forward_channel(int32_t &front_id, int32_t &worker_id);
+   size_t forward_size() const { return forwards_.size(); };
+   //Receive one socket from the channel of front and attach it in the thread
+   //of this listener, return 1 if received, 0 if not have and SOCKET_ERROR 
+   //if the front closed(can work in other thread with blocking channel).
+   int32_t forward_receive(int32_t channel_id);
 
  public:
 
    int32_t listener_socket_id() const {
+     if (forward_id_ != SOCKET_INVALID) return forward_id_;
      return listener_socket_ ? listener_socket_->get_id() : SOCKET_INVALID;
    }
+   virtual bool is_forward() const { return forward_id_ != SOCKET_INVALID; };
    //If set safe encrypt string then all connection will check it. 
    void set_safe_encrypt_str(const std::string &str) {
      safe_encrypt_str_ = str;
+     for (auto &shard : shards_) shard->set_safe_encrypt_str(str);
    }
    const std::string get_safe_encrypt_str() {
      return safe_encrypt_str_;
    }
 
+ public: //Reactors, every shard have the connection pool and run in a thread.
+   uint8_t reactor_size() const { 
+     return static_cast<uint8_t>(primary_->shards_.size() + 1); 
+   };
+   //The index 0 is the primary(the listener inited).
+   Listener *reactor(uint8_t index);
+   uint8_t reactor_index() const { return reactor_index_; };
+   //The kernel balance the connections if true, else accept by primary and
+   //hand off to the shards in turn.
+   bool reuseport() const { return primary_->reuseport_; };
+   int64_t handle(connection::Basic *connection) const {
+     return NET_REACTOR_HANDLE(reactor_index_, connection->get_id());
+   };
+   //Send the packet to connection of the handle in any reactor, work in the 
+   //thread of this listener(as the packet handlers).
+   bool send_to(int64_t handle, packet::Interface *packet);
+
+ private:
+   bool init_reactors(uint32_t max_size, 
+                      uint8_t reactors, 
+                      uint16_t port, 
+                      const std::string &ip);
+   //Pass the socket to the workers, false if all channels failed.
+   bool forward(int32_t socket_id, const std::string &host, uint16_t port);
+   void handoff(Listener *target, 
+                int32_t socket_id, 
+                const std::string &host, 
+                uint16_t port);
+   //Accept one socket, return false if would block or limited.
+   bool accept_one(connection::Basic *&connection);
+   //Stop watch the listener socket and resume after the delay.
+   void accept_pause(uint32_t delay);
+
  private:
    std::unique_ptr<socket::Listener> listener_socket_;
    std::string safe_encrypt_str_;
    bool ready_;
+   Listener *primary_;
+   uint8_t reactor_index_;
+   bool reuseport_;
+   std::vector< std::unique_ptr<Listener> > shards_; /* 其他分片(主监听器) */
+   uint32_t reactor_next_; /* 轮流分配的分片 */
+   uint32_t accept_rate_; /* 每秒接受的连接数量 */
+   uint32_t accept_burst_; /* 令牌桶的大小 */
+   uint64_t accept_tokens_; /* 剩余的令牌(千分之一) */
+   uint32_t accept_time_; /* 上次填充令牌的时间 */
+   uint32_t handshake_max_; /* 等待握手的最大连接数量 */
+   bool accept_paused_; /* 暂停接受新连接 */
+   accept_stat_t accept_stat_;
+   std::vector<int32_t> forwards_; /* 传递连接的工作进程通道 */
+   uint32_t forward_next_; /* 轮流分配的通道 */
+   int32_t forward_id_; /* 接收连接的前端通道 */
 
 };
 
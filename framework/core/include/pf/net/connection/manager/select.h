@@ -12,6 +12,7 @@
 #define PF_NET_CONNECTION_MANAGER_SELECT_H_
 
 #if !(OS_UNIX && defined(PF_OPEN_EPOLL)) && \
+  !(OS_UNIX && defined(PF_OPEN_IOURING)) && \
   !(OS_WIN && defined(PF_OPEN_IOCP))
 #include "pf/net/connection/manager/config.h"
 #include "pf/net/connection/manager/interface.h"
@@ -30,7 +31,7 @@ class PF_API Select : public Interface {
    virtual ~Select();
 
  public:
-   virtual bool init(uint16_t connectionmax = NET_CONNECTION_MAX);
+   virtual bool init(uint32_t connectionmax = NET_CONNECTION_MAX);
    virtual bool select(); //网络侦测
    virtual bool process_input(); //数据接收接口
    virtual bool process_output(); //数据发送接口
@@ -40,10 +41,18 @@ class PF_API Select : public Interface {
 
  public:
    //增加连接socket
-   virtual bool socket_add(int32_t socketid, int16_t connectionid);
+   virtual bool socket_add(int32_t socketid, int32_t connectionid);
    //将拥有fd句柄的玩家(服务器)数据从当前系统中清除
    virtual bool socket_remove(int32_t socketid);
 
+ protected:
+   //Watch the writable of the blocked connection.
+   virtual bool output_wait(connection::Basic *connection, bool wait);
+   //Watch the writable of the connecting socket.
+   virtual bool connect_watch(connection::Basic *connection, bool watch);
+   //Pause or resume the readable of the listener socket.
+   virtual bool accept_watch(bool on);
+
  private:
   //网络相关数据
    enum {
@@ -57,6 +66,7 @@ class PF_API Select : public Interface {
    timeval timeout_[kSelectMax];
    int32_t maxfd_;
    int32_t minfd_;
+   std::vector<int32_t> connecting_ids_; /* 正在连接的连接ID */
 
 };
 
@@ -0,0 +1,86 @@
+/**
+ * PLAIN FRAMEWORK ( https://github.com/viticm/plainframework )
+ * $Id share.h
+ * @link https://github.com/viticm/plainframework for the canonical source repository
+ * @copyright Copyright (c) 2014- viticm( viticm.ti@gmail.com )
+ * @license
+ * @user viticm<viticm.ti@gmail.com>
+ * @date 2026/10/18 10:50
+ * @uses The share memory connection manager(connection::Share).
+ *       Only the busy rings and the rings of the doorbells rang polled in
+ *       the tick, the idle ones sleep on the doorbells(epoll), the select
+ *       only wait when all of them are idle. The packets execute in the
+ *       dirty lists same as tcp managers, so it can tick in the same thread
+ *       with the socket managers.
+ */
+#ifndef PF_NET_CONNECTION_MANAGER_SHARE_H_
+#define PF_NET_CONNECTION_MANAGER_SHARE_H_
+
+#include "pf/net/connection/manager/config.h"
+#include "pf/net/connection/manager/basic.h"
+#include "pf/net/connection/share.h"
+#if OS_UNIX
+#include "pf/net/socket/extend.inl"
+#endif
+
+namespace pf_net {
+
+namespace connection {
+
+namespace manager {
+
+class PF_API Share : public Basic {
+
+ public:
+   Share();
+   virtual ~Share();
+
+ public:
+   virtual bool init(uint32_t max_size = NET_CONNECTION_MAX);
+   //Create the segment of key, the connection wait the client attach(the
+   //data sent before it keep in the ring).
+   connection::Basic *open(uint32_t key, uint32_t size = NET_SHARE_RING_SIZE);
+   //Attach the segment of key created by the service.
+   connection::Basic *attach(uint32_t key, uint32_t size = NET_SHARE_RING_SIZE);
+
+ public:
+   virtual bool select();
+   virtual bool process_input();
+   virtual bool process_output();
+   virtual bool process_exception();
+   virtual bool process_command();
+   //The connections not have socket.
+   virtual bool socket_add(int32_t, int32_t) { return true; };
+   virtual bool socket_remove(int32_t) { return true; };
+   //Notify the peer and release the segment.
+   virtual bool erase(connection::Basic *connection);
+   //The connections polled in the next tick.
+   size_t ready_size() const { return ready_.size(); };
+   virtual void wakeup();
+   virtual void on_timer(uint8_t kind, int32_t id);
+
+ protected:
+   virtual bool output_wait(connection::Basic *, bool) { return true; };
+   virtual bool accept_watch(bool) { return true; };
+
+ private:
+   connection::Basic *create(uint32_t key, uint32_t size, bool service);
+
+ private:
+   int32_t wakeup_fds_[2]; /* 唤醒等待的管道 */
+   std::atomic<bool> wakeup_pending_;
+#if OS_UNIX
+   polldata_t polldata_; /* 等待门铃的epoll */
+#endif
+   std::vector<int32_t> ready_; /* 忙碌或门铃响了的连接，本帧轮询 */
+   std::vector<int32_t> ids_; /* 检查对端存活的连接 */
+
+};
+
+} //namespace manager
+
+} //namespace connection
+
+} //namespace pf_net
+
+#endif //PF_NET_CONNECTION_MANAGER_SHARE_H_
@@ -0,0 +1,136 @@
+/**
+ * PLAIN FRAMEWORK ( https://github.com/viticm/plainframework )
+ * $Id udp.h
+ * @link https://github.com/viticm/plainframework for the canonical source repository
+ * @copyright Copyright (c) 2014- viticm( viticm.ti@gmail.com )
+ * @license
+ * @user viticm<viticm.ti@gmail.com>
+ * @date 2026/10/17 22:10
+ * @uses The reliable udp connection manager(connection::Udp).
+ *       All connections share one udp socket, the peer address find the
+ *       connection and the session check the datagram. The service create
+ *       the connection by the connect request which echo the cookie of the
+ *       challenge(stateless, so the spoofed addresses can't take the pool),
+ *       the client connect by connect_async. The timers of wheel drive the retransmits and pings,
+ *       the packets execute in the dirty lists same as tcp managers.
+ */
+#ifndef PF_NET_CONNECTION_MANAGER_UDP_H_
+#define PF_NET_CONNECTION_MANAGER_UDP_H_
+
+#include "pf/net/connection/manager/config.h"
+#include "pf/net/connection/manager/basic.h"
+#include "pf/net/connection/udp.h"
+
+namespace pf_net {
+
+namespace connection {
+
+namespace manager {
+
+class PF_API Udp : public Basic {
+
+ public:
+   Udp();
+   virtual ~Udp();
+
+ public:
+   //Bind the socket(port 0 is any), the service accept the new peers.
+   bool init(uint32_t max_size,
+             uint16_t port = 0,
+             const std::string &ip = "",
+             bool service = true);
+   uint16_t port() const { return socket_ ? socket_->port() : 0; };
+   virtual bool is_service() const { return service_; };
+
+ public: //Connect the udp service, can work in mutli thread(run in net thread).
+   using connect_callback_t = std::function<void (connection::Basic *)>;
+   //The callback with the connection or nullptr(failed or timeout), only
+   //one connection to the same address.
+   void connect_async(const std::string &ip,
+                      uint16_t port,
+                      connect_callback_t callback,
+                      uint32_t timeout = NET_CONNECTOR_TIMEOUT);
+   size_t connecting_size() const { return connecting_.size(); };
+
+ public: //Simulate the bad network(the sent datagrams), for the tests.
+   //The loss percent(0-100), the latency and random jitter(milliseconds).
+   void set_simulate(uint8_t loss, uint32_t latency = 0, uint32_t jitter = 0);
+   const udp_stat_t &udp_stat() const { return udp_stat_; };
+
+ public:
+   virtual bool select();
+   virtual bool process_input();
+   virtual bool process_output();
+   virtual bool process_exception();
+   virtual bool process_command();
+   //The connections not have socket.
+   virtual bool socket_add(int32_t, int32_t) { return true; };
+   virtual bool socket_remove(int32_t) { return true; };
+   //Send the close to peer and forget the address.
+   virtual bool erase(connection::Basic *connection);
+   //Wake up the select by an empty datagram to self.
+   virtual void wakeup();
+   virtual void on_timer(uint8_t kind, int32_t id);
+
+ protected:
+   virtual bool output_wait(connection::Basic *, bool) { return true; };
+   virtual bool accept_watch(bool) { return true; };
+
+ private:
+   static uint64_t address_key(const struct sockaddr_in &address);
+   //The cookie of the address and session, only the owner can echo it.
+   uint32_t cookie(const struct sockaddr_in &address, uint32_t session) const;
+   //The connect echo the cookie, or challenge the address and false.
+   bool cookie_check(const struct sockaddr_in &address,
+                     uint32_t session,
+                     const char *data,
+                     uint32_t size);
+   void input(const struct sockaddr_in &address,
+              const char *data,
+              uint32_t size,
+              uint32_t now);
+   connection::Udp *accept_peer(const struct sockaddr_in &address,
+                                uint32_t session,
+                                uint32_t now);
+   void connect_start(const std::string &ip,
+                      uint16_t port,
+                      connect_callback_t callback,
+                      uint32_t timeout);
+   void connect_finish(connection::Udp *connection, bool success);
+   //Update the connection and arm the timer, remove it if the link dead.
+   void update(connection::Udp *connection, uint32_t now);
+   void datagram_send(const struct sockaddr_in &address,
+                      const char *data,
+                      uint32_t size);
+   void datagram_write(const struct sockaddr_in &address,
+                       const char *data,
+                       uint32_t size);
+   void delay_flush(uint32_t now);
+
+ private:
+   std::unique_ptr<socket::Basic> socket_;
+   bool service_;
+   struct sockaddr_in wakeup_address_;
+   std::atomic<bool> wakeup_pending_;
+   std::map<uint64_t, int32_t> peers_; /* 地址对应的连接 */
+   std::map<int32_t, connect_callback_t> connecting_; /* 正在连接的连接 */
+   /* 模拟延迟的数据报 */
+   std::multimap< uint32_t,
+                  std::pair<struct sockaddr_in, std::string> > delays_;
+   uint8_t simulate_loss_;
+   uint32_t simulate_latency_;
+   uint32_t simulate_jitter_;
+   std::minstd_rand random_;
+   uint64_t cookie_secret_;
+   udp_stat_t udp_stat_;
+   char buffer_[NET_UDP_MTU];
+
+};
+
+} //namespace manager
+
+} //namespace connection
+
+} //namespace pf_net
+
+#endif //PF_NET_CONNECTION_MANAGER_UDP_H_
@@ -27,25 +27,42 @@ class PF_API Pool {
 
  public:
    bool init(uint32_t maxcount = NET_CONNECTION_POOL_SIZE_DEFAULT);
-   Basic *get(int16_t id);
+   //Get the connection of the id, nullptr if the handle is stale.
+   Basic *get(int32_t id);
+   //Pop the free list or construct the next slot, work in the owner thread.
    Basic *create(bool clear = true); //new
-   bool init_data(uint16_t index, Basic *connection);
-   void remove(int16_t id); //delete
+   bool init_data(uint32_t index, Basic *connection);
+   void remove(int32_t id); //delete(the generation of the slot changed)
    void lock();
    void unlock();
    uint32_t get_max_size() const { return max_size_; }
    uint32_t size() const { return size_; }
+   //Construct all connections now(default construct on first create).
    bool create_default_connections();
    bool full() const { return size_ == max_size_; };
+   //The constructor of the slot connections(default connection::Basic), set
+   //it before the first create.
+   void set_constructor(std::function<Basic *()> constructor) {
+     constructor_ = constructor;
+   };
 
  private:
-   //Basic **connections_; //注意，这是一个指向Base对象的数组指针
-   std::vector< std::unique_ptr< Basic > > connections_;
+   Basic *construct(uint32_t index);
+
+ private:
+   //The slot link to the next free slot when it in free list.
+   struct slot_struct {
+     std::unique_ptr< Basic > connection;
+     uint32_t next;
+   };
+   std::vector< slot_struct > slots_;
    bool ready_;
-   uint32_t position_;
+   uint32_t free_head_;     /* 空闲链表头 */
+   uint32_t used_;          /* 使用过的槽位数量(之后的还未构造) */
    std::mutex mutex_;
    uint32_t size_;
    uint32_t max_size_;
+   std::function<Basic *()> constructor_;
 
 };
 
@@ -0,0 +1,86 @@
+/**
+ * PLAIN FRAMEWORK ( https://github.com/viticm/plainframework )
+ * $Id share.h
+ * @link https://github.com/viticm/plainframework for the canonical source repository
+ * @copyright Copyright (c) 2014- viticm( viticm.ti@gmail.com )
+ * @license
+ * @user viticm<viticm.ti@gmail.com>
+ * @date 2026/10/18 10:20
+ * @uses The same host connection on the share memory segment.
+ *       The service create the segment of key and the client attach it, one
+ *       single producer single consumer ring every direction carry the
+ *       stream bytes(same as tcp), so the packet handlers not changed.
+ *       The writer only ring the doorbell(named pipe) of the reader when it
+ *       is sleeping, the busy transfer not have any syscall.
+ */
+#ifndef PF_NET_CONNECTION_SHARE_H_
+#define PF_NET_CONNECTION_SHARE_H_
+
+#include "pf/net/connection/basic.h"
+#include "pf/sys/memory/share.h"
+
+namespace pf_net {
+
+namespace connection {
+
+struct share_block_struct;
+struct share_ring_struct;
+
+class PF_API Share : public Basic {
+
+ public:
+   Share();
+   virtual ~Share();
+
+ public:
+   //Move the ring bytes to the input stream.
+   virtual bool process_input();
+   //Move the output stream bytes to the ring, keep the left if it full.
+   virtual bool process_output();
+
+ public: //Work in the manager(net thread).
+   //Create the segment of key(the service), the size of ring is power of 2.
+   bool open(uint32_t key, uint32_t size);
+   //Attach the segment created by the service, the size same as the service.
+   bool attach(uint32_t key, uint32_t size);
+   //Notify the peer and release the segment.
+   void close();
+   uint32_t key() const { return key_; };
+   bool is_service() const { return 0 == side_; };
+   //The peer attached(the service wait it after open).
+   bool peer_attached() const;
+   //The peer closed or the process of peer exited.
+   bool peer_lost() const;
+   //The output can write now(have output and the ring not full).
+   bool output_writable() const;
+   //Tell the peer ring the doorbell, false if have work(not sleep).
+   bool sleep();
+   //Clear the sleeping and drain the doorbell.
+   void wake();
+   //The doorbell of this side(readable when the peer rang).
+   int32_t doorbell() const { return doorbell_; };
+
+ private:
+   bool map(uint32_t key, uint32_t size, bool create);
+   share_ring_struct &inbound();
+   share_ring_struct &outbound();
+   char *ring_data(uint8_t side);
+   void doorbell_ring(int32_t fd);
+   static std::string doorbell_path(uint32_t key, uint8_t side);
+
+ private:
+   pf_sys::memory::share::Base segment_;
+   share_block_struct *block_; /* 共享内存中的控制块 */
+   uint32_t key_;
+   uint32_t size_;             /* 环的大小 */
+   uint8_t side_;              /* 0服务端 1客户端 */
+   int32_t doorbell_;          /* 本端的门铃 */
+   int32_t peer_doorbell_;     /* 对端的门铃 */
+
+};
+
+} //namespace connection
+
+} //namespace pf_net
+
+#endif //PF_NET_CONNECTION_SHARE_H_
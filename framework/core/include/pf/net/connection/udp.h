@@ -0,0 +1,220 @@
+/**
+ * PLAIN FRAMEWORK ( https://github.com/viticm/plainframework )
+ * $Id udp.h
+ * @link https://github.com/viticm/plainframework for the canonical source repository
+ * @copyright Copyright (c) 2014- viticm( viticm.ti@gmail.com )
+ * @license
+ * @user viticm<viticm.ti@gmail.com>
+ * @date 2026/10/17 21:40
+ * @uses The reliable udp connection(ARQ with selective acks).
+ *       The packet send by the channel of its id(udp_channel_t), the
+ *       reliable channel carry the output stream(same as tcp) and the others
+ *       carry the encoded packets, so the input stream always receive whole
+ *       packets and the packet handlers not changed.
+ *       The message larger than the mtu split to fragments, every reliable
+ *       fragment have a sequence, the receiver ack the next sequence and the
+ *       received blocks after it, the sender resend by timeout or skipped.
+ *       The receiver drop the message of too many fragments and limit the
+ *       bytes in reassembly(the reliable peer over it is closed).
+ *       The service accept the new session(or replace the live peer of an
+ *       address) only after the connect echo the cookie of challenge, so the
+ *       spoofed addresses can't take the pool or disconnect the peers.
+ *       Datagram: [session:4][frame]...
+ *       Frame: [type:1] accept, ping, close
+ *              [type:1][cookie:4] connect(0 is no cookie), challenge
+ *              [type:1][una:4][window:2][count:1]([start:4][length:2])... ack
+ *              [type:1][channel:1][sequence:4][message:4][fragment:2]
+ *              [fragments:2][length:2][data] data
+ */
+#ifndef PF_NET_CONNECTION_UDP_H_
+#define PF_NET_CONNECTION_UDP_H_
+
+#include "pf/net/connection/basic.h"
+
+namespace pf_net {
+
+namespace connection {
+
+class PF_API Udp : public Basic {
+
+ public:
+   Udp();
+   virtual ~Udp();
+
+ public:
+   using Basic::send;
+   //Send by the channel of packet id.
+   virtual bool send(packet::Interface *packet);
+   bool send(packet::Interface *packet, uint8_t channel);
+   //Update now(flush the output stream, acks and retransmits).
+   virtual bool process_output();
+
+ public: //Work in the manager(net thread).
+   using output_t = std::function<
+     void (const struct sockaddr_in &, const char *, uint32_t)>;
+   void set_output(output_t output) { output_ = output; };
+   //Start the session with the peer, the client send connect until any
+   //datagram of the session received or timeout.
+   void open(const struct sockaddr_in &address,
+             uint32_t session,
+             bool client,
+             uint32_t now,
+             uint32_t timeout = 0);
+   //Send the close to peer if notify, and release the session.
+   void close(bool notify);
+   //Input the datagram of the session, false if the peer closed.
+   bool input(const char *data, uint32_t size, uint32_t now);
+   //Send the new messages, acks and retransmits, false if the link dead.
+   bool update(uint32_t now);
+   //The milliseconds from now to the next update.
+   uint32_t check(uint32_t now) const;
+   uint32_t session() const { return session_; };
+   bool connected() const { return connected_; };
+   const struct sockaddr_in &address() const { return address_; };
+   //The timer in manager wheel and the expire time.
+   uint64_t update_timer() const { return update_timer_; };
+   uint32_t update_time() const { return update_time_; };
+   void set_update_timer(uint64_t id, uint32_t time) {
+     update_timer_ = id;
+     update_time_ = time;
+   };
+
+ public: //Stat.
+   uint32_t rtt() const { return srtt_; };
+   uint32_t rto() const { return rto_; };
+   uint32_t in_flight() const {
+     return static_cast<uint32_t>(send_buffer_.size());
+   };
+   uint64_t retransmits() const { return retransmits_; };
+   //The bytes of incomplete messages.
+   uint32_t reassembly_size() const { return reassembly_size_; };
+
+ public:
+   //The session of datagram, 0 if invalid.
+   static uint32_t session(const char *data, uint32_t size);
+   //The datagram is connect request(new session).
+   static bool connecting(const char *data, uint32_t size);
+   //The cookie of the connect or challenge datagram, 0 if none.
+   static uint32_t cookie(const char *data, uint32_t size);
+   //The datagram is challenge(echo the cookie in connect).
+   static bool challenging(const char *data, uint32_t size);
+   //Write the challenge datagram of session to data, return the size.
+   static uint32_t challenge(char *data, uint32_t session, uint32_t cookie);
+   //The channel of packet id(udp_channel_t), default is reliable.
+   static uint8_t channel(uint16_t packet_id);
+   static void set_channel(uint16_t packet_id, uint8_t channel);
+
+ private:
+   typedef struct segment_struct {
+     uint32_t sequence;
+     uint8_t channel;
+     uint32_t message;
+     uint16_t fragment;
+     uint16_t fragments;
+     std::string data;
+     uint32_t send_time;
+     uint32_t resend_time;
+     uint32_t rto;
+     uint16_t transmits;
+     uint16_t skipped;
+     bool acked;
+   } segment_t;
+   typedef struct message_struct {
+     std::map<uint16_t, std::string> fragments;
+     uint16_t count;
+     uint32_t size;
+     message_struct() : count{0}, size{0} {};
+   } message_t;
+
+ private:
+   void reset();
+   void message_push(uint8_t channel, const char *data, uint32_t size);
+   void ack_input(uint32_t una,
+                  uint16_t window,
+                  const char *blocks,
+                  uint8_t count,
+                  uint32_t now);
+   void acked(segment_t &segment, uint32_t now);
+   bool data_input(uint8_t channel,
+                   uint32_t sequence,
+                   uint32_t message,
+                   uint16_t fragment,
+                   uint16_t fragments,
+                   const char *data,
+                   uint16_t length);
+   //Keep the fragment and deliver if completed, false if error(the
+   //unreliable over the reassembly limit is dropped).
+   bool deliver(std::map<uint32_t, message_t> &messages,
+                uint32_t message,
+                uint16_t fragment,
+                uint16_t fragments,
+                const char *data,
+                uint16_t length,
+                bool reliable);
+   //Keep the fragment in the reassembly, false if over the limit.
+   bool keep(message_t &item,
+             uint16_t fragment,
+             const char *data,
+             uint16_t length);
+   void release(std::map<uint32_t, message_t> &messages,
+                std::map<uint32_t, message_t>::iterator it);
+   //The receive window advertised, 0 if the input not executed.
+   uint16_t window();
+   //Reserve the frame in datagram, flush it if full.
+   char *frame(uint32_t size);
+   void frame_ack();
+   void frame_segment(const segment_t &segment);
+   void flush();
+
+ private:
+   output_t output_;
+   struct sockaddr_in address_;
+   uint32_t session_;
+   bool client_;
+   bool connected_;
+   uint32_t connect_time_; /* 下次发送连接请求的时间 */
+   uint32_t connect_deadline_; /* 连接超时的时间 */
+   uint32_t cookie_; /* 连接请求回显的cookie */
+   uint32_t reassembly_size_; /* 重组中消息的字节数 */
+   bool accept_pending_;
+   bool ack_pending_;
+   uint32_t last_send_;
+   uint32_t last_receive_;
+   uint64_t update_timer_;
+   uint32_t update_time_;
+
+ private: //Send.
+   std::deque<segment_t> send_queue_;  /* 等待窗口的分片 */
+   std::deque<segment_t> send_buffer_; /* 已发送未确认的分片(序号连续) */
+   std::vector<segment_t> unreliables_; /* 等待发送的不可靠分片 */
+   uint32_t send_una_;
+   uint32_t send_next_;
+   uint32_t messages_[kUdpChannelMax];
+   uint16_t remote_window_;
+   uint32_t srtt_;
+   uint32_t rttvar_;
+   uint32_t rto_;
+   uint64_t retransmits_;
+
+ private: //Receive.
+   uint32_t receive_next_;
+   std::vector<uint8_t> received_; /* 接收窗口内已收到的序号 */
+   uint32_t ordered_next_;
+   std::map<uint32_t, message_t> ordered_;
+   std::map<uint32_t, message_t> unordered_;
+   std::map<uint32_t, message_t> unreliable_;
+   uint16_t window_advertised_;
+
+ private: //The datagram building.
+   char datagram_[NET_UDP_MTU];
+   uint32_t datagram_size_;
+   bool delivered_; /* 本次输入有完整消息写入输入流 */
+   bool sent_; /* 本次更新发送了数据报 */
+
+};
+
+} //namespace connection
+
+} //namespace pf_net
+
+#endif //PF_NET_CONNECTION_UDP_H_
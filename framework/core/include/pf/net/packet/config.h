@@ -56,6 +56,15 @@ typedef enum {
   kPacketFlagRemove,
 } packetflag_t;
 
+//The packet id flags in dispatch table.
+typedef enum {
+  kPacketDispatchFlagNormal = 0x1,    //Normal packet id(factory create).
+  kPacketDispatchFlagDynamic = 0x2,   //Dynamic packet id.
+  kPacketDispatchFlagEncrypt = 0x4,   //Safe encrypt(handshake) packet id.
+} packet_dispatchflag_t;
+
+#define NET_PACKET_ID_MAX (0xffff)
+
 
 namespace pf_net {
 
@@ -70,13 +79,28 @@ typedef PF_API struct queue_struct queue_t;
 
 struct queue_struct {
   Interface *packet;
-  uint16_t connectionid;
+  int32_t connectionid;
   uint32_t flag;
   queue_struct() :
     packet{nullptr},
-    connectionid{static_cast<uint16_t>(ID_INVALID)},
+    connectionid{ID_INVALID},
     flag{kPacketFlagNone} {
   };
+  queue_struct(Interface *_packet, int32_t _connectionid, uint32_t _flag) :
+    packet{_packet},
+    connectionid{_connectionid},
+    flag{_flag} {
+  };
+  //The packet owned by one queue item, move only.
+  queue_struct(queue_struct &&object) :
+    packet{object.packet},
+    connectionid{object.connectionid},
+    flag{object.flag} {
+    object.packet = nullptr;
+  };
+  queue_struct &operator = (queue_struct &&object);
+  queue_struct(const queue_struct &) = delete;
+  queue_struct &operator = (const queue_struct &) = delete;
   ~queue_struct();
 };
 
@@ -30,6 +30,23 @@ typedef bool (__stdcall *function_is_valid_dynamic_packet_id)(uint16_t id);
 //typedef bool (__stdcall *function_is_encrypt_packet_id)(uint16_t id);
 typedef uint32_t (__stdcall *function_packet_execute)(connection::Basic *, Interface *);
 
+//The dispatch info of one packet id.
+typedef PF_API struct dispatch_struct dispatch_t;
+struct dispatch_struct {
+  Factory *factory;
+  function_packet_execute handler; //Replace the packet execute if not null.
+  uint32_t max_size;
+  uint16_t index; //The factory index(dynamic is the factory size).
+  uint8_t flags;
+  dispatch_struct() :
+    factory{nullptr},
+    handler{nullptr},
+    max_size{0},
+    index{0},
+    flags{0} {
+  };
+};
+
 class PF_API FactoryManager : public pf_basic::Singleton<FactoryManager> {
 
  public:
@@ -46,13 +63,17 @@ class PF_API FactoryManager : public pf_basic::Singleton<FactoryManager> {
  public:
    bool init();
    //根据消息类型从内存里分配消息实体数据（允许多线程同时调用，必须用removepacket释放）
+   //消息从线程的缓存中回收使用，缓存不足时才从全局列表或者工厂中分配
    Interface *packet_create(uint16_t packetid);
+   //需要开启分配记录（set_track）
    Interface *packet_get(int64_t objectid) {
+     std::unique_lock<std::mutex> autolock(mutex_);
      return alloc_packets_.get(objectid);
    };
    //根据消息类型取得对应消息的最大尺寸（允许多线程同时调用）
    uint32_t packet_max_size(uint16_t packetid);
    //删除消息实体（允许多线程同时调用，必须和createpacket成对出现）
+   //消息会调用clear后回收到线程的缓存中
    void packet_remove(Interface *packet);
    bool is_valid_packet_id(uint16_t id); //packetid is valid
    bool is_valid_dynamic_packet_id(uint16_t id); //dynamic packet id is valid
@@ -62,12 +83,22 @@ class PF_API FactoryManager : public pf_basic::Singleton<FactoryManager> {
    bool is_encrypt_packet_id(uint16_t id); //packetid is encrypt id
    uint32_t packet_execute(connection::Basic *connection, Interface *packet);
 
+ public: //dispatch table
+   //消息号对应的分发信息，init时建立，冻结后读取不需要加锁
+   const dispatch_t &dispatch(uint16_t id) const { return dispatches_[id]; };
+   //设置消息号的执行函数，替代消息的execute
+   bool set_packet_handler(uint16_t id, function_packet_execute handler);
+   //冻结后工厂和分发表不再改变
+   void freeze() { frozen_ = true; };
+   bool frozen() const { return frozen_; };
+
  public: //exports
    void set_function_register_factories(function_register_factories function) {
      function_register_factories_ = function;
    };
    void set_function_is_valid_packet_id(function_is_valid_packet_id function) {
      function_is_valid_packet_id_ = function;
+     dispatch_build();
    }
    /**
    void set_function_is_encrypt_packet_id(
@@ -78,11 +109,25 @@ class PF_API FactoryManager : public pf_basic::Singleton<FactoryManager> {
    void set_function_is_valid_dynamic_packet_id(
        function_is_valid_dynamic_packet_id function) {
      function_is_valid_dynamic_packet_id_ = function;
+     dispatch_build();
    }
    void set_function_packet_execute(function_packet_execute function) {
      function_packet_execute_ = function;
    }
    bool ready() const { return ready_; };
+   //Track the alloc packets(packet_get and packet_alloc_size_), set it before 
+   //create packets, default is off.
+   void set_track(bool flag) { track_ = flag; };
+   bool track() const { return track_; };
+
+ private:
+   //Build the dispatch table(rebuild if the id functions changed).
+   void dispatch_build();
+   void dispatch_set(uint16_t id);
+   //Fetch the packets from the global list to thread cache.
+   void pool_fetch(uint16_t index, std::vector<Interface *> &list);
+   //Return the half packets of thread cache to the global list.
+   void pool_put(uint16_t index, std::vector<Interface *> &list);
 
  private:
    Factory **factories_;
@@ -91,6 +136,12 @@ class PF_API FactoryManager : public pf_basic::Singleton<FactoryManager> {
    uint16_t size_;
    uint16_t factory_size_;
    std::mutex mutex_;
+   std::vector< std::vector<Interface *> > pools_; //全局回收列表，最后一个为动态包
+   std::mutex pool_mutex_;
+   uint64_t serial_; //The thread cache owner.
+   std::unique_ptr<dispatch_t[]> dispatches_;
+   bool frozen_;
+   bool track_;
    bool ready_; //凡是有内存的初始化都需加上这个标记，以检测再次初始化的情况
    
  private: //exports
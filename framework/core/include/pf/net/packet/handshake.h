@@ -27,6 +27,10 @@ class Handshake : public pf_net::packet::Interface {
    virtual ~Handshake() {}
 
  public:
+   virtual void clear() {
+     Interface::clear();
+     memset(key_, 0, sizeof(key_));
+   }
    virtual bool read(pf_net::stream::Input &);
    virtual bool write(pf_net::stream::Output &);
    virtual uint32_t execute(pf_net::connection::Basic *connection);
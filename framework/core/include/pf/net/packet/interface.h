@@ -24,11 +24,19 @@ namespace packet {
 class PF_API Interface {
 
  public:
-   Interface() {};
+   Interface() : status_{0}, index_{0} {};
    virtual ~Interface() {};
 
  public:
-   virtual void clear() {};
+   /**
+    * The packets recycle in the factory manager caches(packet_remove) and
+    * reuse by the next packet_create, so every packet must reset all of its
+    * fields here(call this too), or the next reader get the old values.
+    */
+   virtual void clear() {
+     status_ = 0;
+     index_ = 0;
+   };
    virtual bool read(stream::Input &) = 0;
    virtual bool write(stream::Output &) = 0;
    virtual uint32_t execute(connection::Basic *connection);
@@ -33,6 +33,12 @@ class PF_API Basic : public Interface {
                          char *compress_buffer);
    virtual bool send(connection::Basic *connection, packet::Interface *packet);
    virtual size_t header_size() const { return NET_PACKET_HEADERSIZE; };
+   //编码网络包(序列号为0)，用于广播时只序列化一次
+   virtual bool encode(packet::Interface *packet, std::string &buffer);
+   //发送编码后的数据，修正序列号并按连接加密
+   virtual bool send(connection::Basic *connection, 
+                     const char *data, 
+                     uint32_t size);
 
 };
 
@@ -30,6 +30,12 @@ class PF_API Interface {
    virtual bool compress(connection::Basic *, char *, char *) = 0;
    virtual bool send(connection::Basic *, packet::Interface *) = 0;
    virtual size_t header_size() const = 0;
+   //Encode the packet once(for broadcast), false if not support.
+   virtual bool encode(packet::Interface *, std::string &) { return false; };
+   //Send the encoded data.
+   virtual bool send(connection::Basic *, const char *, uint32_t) { 
+     return false; 
+   };
 
 };
 
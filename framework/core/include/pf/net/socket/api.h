@@ -18,6 +18,7 @@
 #include <arpa/inet.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/un.h>
 #elif OS_WIN
 #include <winsock.h>
 #endif
@@ -85,6 +86,34 @@ PF_API int32_t recvex(int32_t socketid,
                       uint32_t length, 
                       uint32_t flag);
 
+//Send the buffers with one syscall(sendmsg), the result same as sendex.
+PF_API int32_t sendvex(int32_t socketid, 
+                       const iobuffer_t *buffers, 
+                       uint32_t count, 
+                       uint32_t flag);
+
+//Receive to the buffers with one syscall(recvmsg), the result same as recvex.
+PF_API int32_t recvvex(int32_t socketid, 
+                       iobuffer_t *buffers, 
+                       uint32_t count, 
+                       uint32_t flag);
+
+//Send the data with the descriptor(SCM_RIGHTS) on the unix socket, the data
+//at least one byte, the result same as sendex.
+PF_API int32_t sendfd_ex(int32_t socketid, 
+                         int32_t fd, 
+                         const void *buffer, 
+                         uint32_t length, 
+                         uint32_t flag);
+
+//Receive the data and the descriptor(SOCKET_INVALID if not have) on the unix
+//socket, the result same as recvex.
+PF_API int32_t recvfd_ex(int32_t socketid, 
+                         int32_t *fd, 
+                         void *buffer, 
+                         uint32_t length, 
+                         uint32_t flag);
+
 PF_API int32_t recvfrom_ex(int32_t socketid, 
                            void *buffer, 
                            int32_t length, 
@@ -92,6 +121,10 @@ PF_API int32_t recvfrom_ex(int32_t socketid,
                            struct sockaddr* from, 
                            uint32_t *fromlength);
 
+//Create the connected pair of unix sockets(SOCK_STREAM, SOCK_SEQPACKET or
+//SOCK_DGRAM) in socketids[2].
+PF_API bool socketpair_ex(int32_t type, int32_t *socketids);
+
 PF_API bool closeex(int32_t socketid);
 
 PF_API bool ioctlex(int32_t socketid, int64_t cmd, uint64_t *argp);
@@ -26,18 +26,33 @@ class PF_API Basic {
    virtual ~Basic();
 
  public: //socket base operate functions
-   bool create();
+   bool create(int32_t family = AF_INET);
    void close();
    bool connect(); //use self host_ and port_
+   //The port 0 connect the unix domain socket of the path host.
    bool connect(const char *host, uint16_t port);
    bool reconnect(const char *host, uint16_t port);
    int32_t send(const void *buffer, uint32_t length, uint32_t flag = 0);
    int32_t receive(void *buffer, uint32_t length, uint32_t flag = 0);
+   int32_t send(const iobuffer_t *buffers, uint32_t count, uint32_t flag = 0);
+   int32_t receive(iobuffer_t *buffers, uint32_t count, uint32_t flag = 0);
    uint32_t available() const;
    int32_t accept(struct sockaddr_in *accept_sockaddr_in = nullptr);
    bool bind(const char *ip = nullptr);
    bool bind(uint16_t port, const char *ip = nullptr);
    bool listen(uint32_t backlog);
+   //The unix domain socket(create with AF_UNIX), bind remove the stale one.
+   bool bind_unix(const char *path);
+   bool connect_unix(const char *path);
+   //Pass the descriptor with the data on unix socket(SCM_RIGHTS).
+   int32_t send_fd(int32_t fd, 
+                   const void *buffer, 
+                   uint32_t length, 
+                   uint32_t flag = 0);
+   int32_t receive_fd(int32_t &fd, 
+                      void *buffer, 
+                      uint32_t length, 
+                      uint32_t flag = 0);
    static int32_t select(int32_t maxfdp, 
                          fd_set *readset, 
                          fd_set *writeset, 
@@ -49,6 +64,8 @@ class PF_API Basic {
    bool set_linger(uint32_t lingertime);
    bool is_reuseaddr() const;
    bool set_reuseaddr(bool on = true);
+   //Many sockets bind the same port, the kernel balance the connections.
+   bool set_reuseport(bool on = true);
    uint32_t get_last_error_code() const;
    void get_last_error_message(char *buffer, uint16_t length) const;
    bool error() const; //socket if has error
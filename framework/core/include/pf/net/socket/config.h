@@ -36,6 +36,16 @@
 #define SOCKET_WOULD_BLOCK EWOULDBLOCK //api use SOCKET_ERROR_WOULD_BLOCK
 #define SOCKET_CONNECT_ERROR EINPROGRESS
 #define SOCKET_CONNECT_TIMEOUT 10
+#define SOCKET_UNIX_HOST "unix" //The host of unix domain sockets(port is 0).
+
+//The accepted socket is nonblocking and close on exec(accept4), no fcntl.
+#ifndef SOCKET_ACCEPT_NONBLOCK
+#if OS_UNIX && defined(__linux__)
+#define SOCKET_ACCEPT_NONBLOCK 1
+#else
+#define SOCKET_ACCEPT_NONBLOCK 0
+#endif
+#endif
 
 namespace pf_net {
 
@@ -59,6 +69,13 @@ typedef struct streamdata_struct {
   }
 } streamdata_t;
 
+//The scatter/gather buffer for vectored send and receive.
+typedef struct iobuffer_struct {
+  void *data;
+  uint32_t length;
+  iobuffer_struct() : data{nullptr}, length{0} {}
+} iobuffer_t;
+
 } //namespace socket
 
 } //namespace pf_net
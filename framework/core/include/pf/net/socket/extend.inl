@@ -53,7 +53,7 @@ inline int32_t poll_create(polldata_t& polldata, int32_t maxcount) {
 inline int32_t poll_add(polldata_t& polldata, 
                         int32_t fd, 
                         int32_t mask, 
-                        int16_t connectionid) {
+                        int32_t connectionid) {
   struct epoll_event _epoll_event;
   memset(&_epoll_event, 0, sizeof(_epoll_event));
   _epoll_event.events = mask;
@@ -63,11 +63,16 @@ inline int32_t poll_add(polldata_t& polldata,
   return result;
 }
 
-inline int32_t poll_mod(polldata_t& polldata, int32_t fd, int32_t mask) {
+inline int32_t poll_mod(polldata_t& polldata, 
+                        int32_t fd, 
+                        int32_t mask, 
+                        int32_t connectionid) {
   struct epoll_event _epoll_event;
   memset(&_epoll_event, 0, sizeof(_epoll_event));
   _epoll_event.events = mask;
-  _epoll_event.data.fd = fd;
+  //Same as poll_add, the events read the fd and id from data.
+  _epoll_event.data.u64 = pf_basic::util::touint64(
+      static_cast<uint32_t>(fd), static_cast<uint32_t>(connectionid));
   int32_t result = epoll_ctl(polldata.fd, EPOLL_CTL_MOD, fd, &_epoll_event);
   return result;
 }
@@ -24,7 +24,12 @@ class PF_API Listener {
    ~Listener();
 
  public:
-   bool init(uint16_t port, const std::string &ip = "", uint32_t backlog = 5);
+   bool init(uint16_t port, 
+             const std::string &ip = "", 
+             uint32_t backlog = 5, 
+             bool reuseport = false);
+   //Listen the unix domain socket of path, remove the path when close.
+   bool init_unix(const std::string &path, uint32_t backlog = 5);
    void close();
    bool accept(pf_net::socket::Basic *socket);
    uint32_t get_linger() const;
@@ -40,9 +45,11 @@ class PF_API Listener {
    };
    uint16_t port() const { return socket_ ? socket_->port() : 0; };
    const char *host() { return socket_ ? socket_->host() : ""; };
+   const std::string &path() const { return path_; };
 
  protected:
    std::unique_ptr<pf_net::socket::Basic> socket_;
+   std::string path_; /* 本地套接字的路径 */
 
 };
 
@@ -35,17 +35,26 @@ class PF_API Basic {
    size_t size() const;
    /* Try use the unused buffer size, maybe use the resize extend buffer size. */
    bool use(size_t _size) {
+     if (is_null(streamdata_.buffer) && 
+         !alloc(static_cast<uint32_t>(_size) + 1)) return false;
      auto freecount = unused();
      if (_size >= freecount && !resize(_size - freecount + 1)) return false;
      return true;
    };
    size_t unused() const {
+    if (is_null(streamdata_.buffer)) return 0;
     return streamdata_.head <= streamdata_.tail ? 
            streamdata_.bufferlength - streamdata_.tail + streamdata_.head - 1 : 
            streamdata_.head - streamdata_.tail - 1;
    };
    size_t max_size() const { return streamdata_.bufferlength; }
    bool empty() const { return streamdata_.head == streamdata_.tail; }
+   /* The buffer memory is alloc from the pool when used. */
+   bool allocated() const { return !is_null(streamdata_.buffer); }
+   /* Return the buffer memory to the pool if no data. */
+   virtual bool release();
+   /* The buffer mapped twice, so the data and free space are contiguous. */
+   bool mirrored() const { return mirrored_; }
    void clear();
    socket::Basic *socket() { return socket_; };
    Compressor *getcompressor() { return &compressor_; };
@@ -53,24 +62,48 @@ class PF_API Basic {
 
  public:
    bool encrypt_isenable() const { return encrypt_isenable_; };
-   void encryptenable(bool enable) { 
-     encrypt_isenable_ = enable;
-   };
+   //The decrypted once buffer data change to the new mode.
+   void encryptenable(bool enable);
    void compressenable(bool enable) {
      compressor_.getassistant()->enable(enable);
    };
-   void encrypt_setkey(const char * key){
-     encryptor_.setkey(key);
-   };
+   void encrypt_setkey(const char *key);
    bool isinit() const { return isinit_; };
    void set_isinit(bool _isinit) {  isinit_ = _isinit; };
 
+ protected:
+   /* Alloc the buffer(not less than the default length) if not alloc. */
+   bool alloc(uint32_t length = 0);
+   /* The contiguous data length from head. */
+   uint32_t contiguous_size() const {
+     if (mirrored_ || streamdata_.head <= streamdata_.tail) 
+       return static_cast<uint32_t>(size());
+     return streamdata_.bufferlength - streamdata_.head;
+   };
+   /* The contiguous free length from tail. */
+   uint32_t contiguous_unused() const {
+     if (mirrored_ || streamdata_.head > streamdata_.tail) 
+       return static_cast<uint32_t>(unused());
+     return 0 == streamdata_.head ? 
+            streamdata_.bufferlength - streamdata_.tail - 1 : 
+            streamdata_.bufferlength - streamdata_.tail;
+   };
+   /* Copy the data from head(decrypt if enable), not move the head. */
+   void copyout(char *buffer, uint32_t length);
+   /* Copy the data to tail(encrypt if enable), not move the tail. */
+   void copyin(const char *buffer, uint32_t length);
+   /* Encrypt or decrypt the buffer data in place from the position. */
+   void crypt_inplace(uint32_t position, uint32_t length, bool decrypt);
+
  protected:
    socket::Basic *socket_;
    Encryptor encryptor_;
    socket::streamdata_t streamdata_;
+   uint32_t bufferlength_default_;
    Compressor compressor_;
    bool encrypt_isenable_;
+   bool mirrored_;
+   bool decrypt_once_; //The buffer data is decrypted when it in.
    uint64_t send_bytes_;
    uint64_t receive_bytes_;
    bool isinit_;
@@ -0,0 +1,55 @@
+/**
+ * PLAIN FRAMEWORK ( https://github.com/viticm/plainframework )
+ * $Id buffer.h
+ * @link https://github.com/viticm/plainframework for the canonical source repository
+ * @copyright Copyright (c) 2014- viticm( viticm.ti@gmail.com )
+ * @license
+ * @user viticm<viticm.ti@gmail.com>
+ * @date 2026/10/17 10:21
+ * @uses The net stream ring buffer memory.
+ *       If NET_STREAM_MIRROR_ENABLE the memory is mapped twice back to back
+ *       (the same memfd pages), so any range [offset, offset + length) with
+ *       offset < length is contiguous and the ring never need split copy.
+ *       When the mirror failed(no memfd or map limit) use the heap memory.
+ *       The memory is shared by all streams with a size class(page size 
+ *       power of two) pool, the streams alloc it when used and return it 
+ *       after idle some time, so the memory just with the active traffic.
+*/
+#ifndef PF_NET_STREAM_BUFFER_H_
+#define PF_NET_STREAM_BUFFER_H_
+
+#include "pf/net/stream/config.h"
+
+namespace pf_net {
+
+namespace stream {
+
+namespace buffer {
+
+//The memory page size, the mirrored buffer length is multiple of it.
+PF_API uint32_t pagesize();
+
+//Alloc the ring buffer memory, the length round up to the size class.
+PF_API char *alloc(uint32_t &length, bool &mirrored);
+
+//Free the memory from alloc, return it to the pool if can.
+PF_API void free(char *buffer, uint32_t length, bool mirrored);
+
+//The memory size cached in pool.
+PF_API uint64_t pool_size();
+
+//The max memory size can cache in pool, the more will free to system(the
+//cached trimmed at once when it lowered).
+PF_API void set_pool_max_size(uint64_t size);
+
+//The idle milliseconds of connection to return buffers, 0 is never.
+PF_API uint32_t idle_time();
+PF_API void set_idle_time(uint32_t time);
+
+} //namespace buffer
+
+} //namespace stream
+
+} //namespace pf_net
+
+#endif //PF_NET_STREAM_BUFFER_H_
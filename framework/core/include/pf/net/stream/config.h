@@ -17,6 +17,20 @@
 #define NETINPUT_DISCONNECT_MAXSIZE (96*1024) //if buffer more than it, disconnet.
 #define NETOUTPUT_BUFFERSIZE_DEFAULT (8*1024)
 #define NETOUTPUT_DISCONNECT_MAXSIZE (100*1024)
+#define NETINPUT_FILL_EXTRASIZE (64*1024) //fill stack buffer when ring is full
+
+#define NET_STREAM_BUFFER_CLASS_COUNT 12 //pool size classes, page << 0 ~ 11
+#define NET_STREAM_BUFFER_POOL_MAXSIZE (64*1024*1024) //pool cached max bytes
+#define NET_STREAM_BUFFER_IDLE_TIME (30*1000) //idle ms to return the buffer
+
+//The stream ring buffer mapped twice(memfd), read and write never wrap.
+#ifndef NET_STREAM_MIRROR_ENABLE
+#if OS_UNIX && defined(__linux__)
+#define NET_STREAM_MIRROR_ENABLE 1
+#else
+#define NET_STREAM_MIRROR_ENABLE 0
+#endif
+#endif
 
 namespace pf_net {
 
@@ -28,6 +42,9 @@ class Output;
 class Encryptor;
 class Compressor;
 
+//The microseconds clock of the output coalescing.
+typedef uint64_t (__stdcall *function_coalesce_clock)();
+
 }
 
 } //namespace pf_net
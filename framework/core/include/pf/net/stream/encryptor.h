@@ -7,6 +7,10 @@
  * @user viticm<viticm@126.com>/viticm.ti@gmail.com
  * @date 2015/01/25 22:06
  * @uses encryptor of net socket stream
+ *       The transform is a nibble substitution: the high nibble xor the key
+ *       indexed by the low nibble, the low nibble is inverted and add the 
+ *       first key low nibble. It run 16/32 bytes once with SSE2/SSSE3/AVX2 
+ *       (chose in runtime) and the result is same as the byte by byte one.
 */
 #ifndef PF_NET_STREAM_ENCRYPTOR_H_
 #define PF_NET_STREAM_ENCRYPTOR_H_
@@ -26,6 +30,14 @@ class PF_API Encryptor {
 
  public:
    enum { kKeyLength = 16, };
+   //The transform kernels, the best supported one is used by default.
+   enum {
+     kKernelScalar = 0,
+     kKernelSse2,
+     kKernelSsse3,
+     kKernelAvx2,
+     kKernelMax,
+   };
 
  public:
    void *encrypt(void *out, const void *in, uint32_t count);
@@ -34,13 +46,22 @@ class PF_API Encryptor {
  public:
    void setkey(const char *key) {
      pf_basic::string::safecopy(key_, key, sizeof(key_));
+     for (uint8_t i = 0; i < kKeyLength; ++i) 
+       keyhigh_[i] = static_cast<uint8_t>(key_[i] & 0xF0);
    };
    const char *getkey() { return key_; };
    void enable(bool _enable) { isenable_ = _enable; };
    bool isenable() const { return isenable_; };
 
+ public:
+   //Use the kernel for all encryptors(check the same result), false if the
+   //cpu not support it.
+   static bool set_kernel(uint8_t kernel);
+   static uint8_t kernel();
+
  private:
    char key_[kKeyLength];
+   uint8_t keyhigh_[kKeyLength]; //The key high nibbles for the lookup table.
    bool isenable_;
 
 };
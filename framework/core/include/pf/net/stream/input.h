@@ -34,6 +34,20 @@ class PF_API Input : public Basic {
    bool peek(char *buffer, uint32_t length);
    bool skip(uint32_t length);
    int32_t fill();
+   //Fill the data received by the completion io(not read the socket).
+   int32_t fill(const char *buffer, uint32_t length);
+   /**
+    * View the next length bytes in the buffer without copy, commit it with 
+    * skip(length). The pointer is valid until the next fill/write.
+    * Return nullptr if the data not enough or need decrypt.
+    */
+   const char *view(uint32_t length);
+   /**
+    * Decrypt the data once when fill into the buffer, then read/peek/view 
+    * not need decrypt again(the view can use with encrypt).
+    */
+   void set_decrypt_once(bool flag);
+   bool decrypt_once() const { return decrypt_once_; }
 
  public:
    int8_t read_int8();
@@ -91,13 +105,20 @@ class PF_API Input : public Basic {
      read(var, _size);
      return *this;
    };
-   Input &operator >> (std::string &var) { //Need optimize
+   Input &operator >> (std::string &var) {
      uint32_t _size = read_uint32();
-     auto temp = new char[_size];
-     memset(temp, 0, _size);
-     read(temp, _size);
-     var = temp;
-     safe_delete(temp);
+     if (0 == _size || _size > size()) {
+       var.clear();
+       return *this;
+     }
+     auto data = view(_size);
+     if (data) {
+       var.assign(data, _size);
+       skip(_size);
+     } else {
+       var.resize(_size);
+       read(&var[0], _size);
+     }
      return *this;
    };
 
@@ -25,17 +25,70 @@ class PF_API Output : public Basic {
      socket::Basic *_socket, 
        uint32_t bufferlength = NETOUTPUT_BUFFERSIZE_DEFAULT,
        uint32_t bufferlength_max = NETOUTPUT_DISCONNECT_MAXSIZE)
-     : Basic(_socket, bufferlength, bufferlength_max), tail_(0) {};
+     : Basic(_socket, bufferlength, bufferlength_max), 
+     tail_(0),
+     reserved_{nullptr},
+     reserved_length_{0},
+     reserved_size_{0},
+     coalesce_size_{0},
+     coalesce_delay_{0},
+     coalesce_start_{0},
+     urgent_{false} {};
    virtual ~Output() {};
 
  public:
    void clear();
+   virtual bool release();
 
  public:
    uint32_t write(const char *buffer, uint32_t length);
    //bool writepacket(packet::Base *packet); change this to protocol.
    int32_t flush();
 
+ public:
+   /**
+    * Reserve a contiguous region of length bytes at the tail, the write(and
+    * write_*) will copy into it directly until commit. The region can also 
+    * write with the pointer, return nullptr if failed.
+    * Only one reserve can be active, not call flush before commit.
+    */
+   char *reserve(uint32_t length);
+   /* Commit the length bytes of the reserved region(encrypt if enable). */
+   bool commit(uint32_t length);
+   /* The bytes written into the reserved region by write. */
+   uint32_t reserved_size() const { return reserved_size_; }
+   /**
+    * Move the data(encrypted if enable) from head into the buffer, for the 
+    * completion io that not flush by the socket. Return the moved length.
+    */
+   uint32_t drain(char *buffer, uint32_t length);
+
+ public: //Write coalescing, the manager hold the small writes and flush them 
+         //with one send.
+   /**
+    * Flush when the size bytes reached or the delay microseconds from the
+    * first byte written, 0 size is not coalesce(flush every tick).
+    */
+   void set_coalesce(uint32_t size, uint32_t delay) {
+     coalesce_size_ = size;
+     coalesce_delay_ = delay;
+   }
+   uint32_t coalesce_size() const { return coalesce_size_; }
+   uint32_t coalesce_delay() const { return coalesce_delay_; }
+   bool coalesce() const { return coalesce_size_ > 0; }
+   /* Flush in this tick, not wait the size or deadline. */
+   void urgent() { urgent_ = true; }
+   /* The size reached or urgent, flush now not wait the deadline. */
+   bool coalesce_full() const {
+     return urgent_ || size() >= coalesce_size_;
+   }
+   /* The microseconds wait to the deadline, 0 is flush now. */
+   uint32_t coalesce_wait(uint64_t now) const;
+   /* The microseconds of the steady clock(the coalescing time). */
+   static uint64_t coalesce_now();
+   /* Replace the clock of coalescing(the tests), nullptr is steady clock. */
+   static void set_coalesce_clock(function_coalesce_clock function);
+
  public: //write_*常用方法
    bool write_int8(int8_t value);
    bool write_uint8(uint8_t value);
@@ -105,10 +158,19 @@ class PF_API Output : public Basic {
    int32_t rawflush();
    bool raw_isempty() const;
    void rawprepare(uint32_t tail);
+   //The output sent all, start the coalescing again.
+   void coalesce_reset();
 
 
  private:
    uint32_t tail_; //compress mode is enable, tail_ will replace streamdata.tail
+   char *reserved_;
+   uint32_t reserved_length_;
+   uint32_t reserved_size_;
+   uint32_t coalesce_size_;  //The bytes flush at once, 0 is off.
+   uint32_t coalesce_delay_; //The max microseconds hold the output.
+   uint64_t coalesce_start_; //The time of first byte written after sent.
+   bool urgent_;
 
 };
 
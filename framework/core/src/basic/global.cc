@@ -1,6 +1,7 @@
 #include "pf/basic/global.h"
 #include "pf/basic/type/variable.h"
 #include "pf/net/connection/config.h"
+#include "pf/net/stream/config.h"
 #include "pf/script/config.h"
 #include "pf/db/config.h"
 #include "pf/cache/config.h"
@@ -27,7 +28,28 @@
  * GLOBALS["default.net.service"] = bool;         //default false.
  * GLOBALS["default.net.service_ip"] = string;    //default "".
  * GLOBALS["default.net.service_port"] = number;  //default 0.
+ * GLOBALS["default.net.service_path"] = string;  //default ""(the unix domain socket).
+ * GLOBALS["default.net.forward_channel"] = number; //default -1(the worker receive sockets from it, not listen).
+ * GLOBALS["default.net.forward_channels"] = string; //default ""(the front pass sockets to them, split by ',').
  * GLOBALS["default.net.conn_max"] = number;      //default NET_CONNECTION_MAX.
+ * GLOBALS["default.net.buffer_idle"] = number;   //default NET_STREAM_BUFFER_IDLE_TIME.
+ * GLOBALS["default.net.buffer_pool"] = number;   //default NET_STREAM_BUFFER_POOL_MAXSIZE.
+ * GLOBALS["default.net.wait_time"] = number;     //default NET_MANAGER_WAIT_TIME.
+ * GLOBALS["default.net.reactors"] = number;      //default 1.
+ * GLOBALS["default.net.kick_time"] = number;     //default 0(off).
+ * GLOBALS["default.net.keepalive"] = number;     //default NET_MANAGER_KEEPALIVE_TIME(0 is off).
+ * GLOBALS["default.net.heartbeat_tick"] = bool;  //default false(heartbeat in every tick).
+ * GLOBALS["default.net.executors"] = number;     //default 0(execute in net thread).
+ * GLOBALS["default.net.accept_rate"] = number;   //default NET_LISTENER_ACCEPT_RATE.
+ * GLOBALS["default.net.accept_burst"] = number;  //default NET_LISTENER_ACCEPT_BURST.
+ * GLOBALS["default.net.handshake_max"] = number; //default NET_LISTENER_HANDSHAKE_MAX.
+ * GLOBALS["default.net.output_soft"] = number;   //default NET_CONNECTION_OUTPUT_SOFT_LIMIT(0 is off).
+ * GLOBALS["default.net.output_hard"] = number;   //default NET_CONNECTION_OUTPUT_HARD_LIMIT(0 is off).
+ * GLOBALS["default.net.output_soft_time"] = number; //default NET_CONNECTION_OUTPUT_SOFT_TIME.
+ * GLOBALS["default.net.output_global"] = number; //default NET_CONNECTION_OUTPUT_GLOBAL_LIMIT.
+ * GLOBALS["default.net.output_policy"] = number; //default 0(kOutputPolicyNone).
+ * GLOBALS["default.net.coalesce_size"] = number; //default NET_CONNECTION_COALESCE_SIZE(0 is off).
+ * GLOBALS["default.net.coalesce_delay"] = number; //default NET_CONNECTION_COALESCE_DELAY(microseconds).
  * GLOBALS["default.script.open"] = bool;         //default false.
  * GLOBALS["default.script.rootpath"] = string;   //default SCRIPT_ROOT_PATH.
  * GLOBALS["default.script.workpath"] = string;   //default SCRIPT_WORK_PATH.
@@ -97,7 +119,28 @@ void set_default_globals(type::variable_set_t &g) {
   g["default.net.service"] = false;
   g["default.net.service_ip"] = "";
   g["default.net.service_port"] = 0;
+  g["default.net.service_path"] = "";
+  g["default.net.forward_channel"] = -1;
+  g["default.net.forward_channels"] = "";
   g["default.net.conn_max"] = NET_CONNECTION_MAX;
+  g["default.net.buffer_idle"] = NET_STREAM_BUFFER_IDLE_TIME;
+  g["default.net.buffer_pool"] = NET_STREAM_BUFFER_POOL_MAXSIZE;
+  g["default.net.wait_time"] = NET_MANAGER_WAIT_TIME;
+  g["default.net.reactors"] = 1;
+  g["default.net.kick_time"] = 0;
+  g["default.net.keepalive"] = NET_MANAGER_KEEPALIVE_TIME;
+  g["default.net.heartbeat_tick"] = false;
+  g["default.net.executors"] = 0;
+  g["default.net.accept_rate"] = NET_LISTENER_ACCEPT_RATE;
+  g["default.net.accept_burst"] = NET_LISTENER_ACCEPT_BURST;
+  g["default.net.handshake_max"] = NET_LISTENER_HANDSHAKE_MAX;
+  g["default.net.output_soft"] = NET_CONNECTION_OUTPUT_SOFT_LIMIT;
+  g["default.net.output_hard"] = NET_CONNECTION_OUTPUT_HARD_LIMIT;
+  g["default.net.output_soft_time"] = NET_CONNECTION_OUTPUT_SOFT_TIME;
+  g["default.net.output_global"] = NET_CONNECTION_OUTPUT_GLOBAL_LIMIT;
+  g["default.net.output_policy"] = 0;
+  g["default.net.coalesce_size"] = NET_CONNECTION_COALESCE_SIZE;
+  g["default.net.coalesce_delay"] = NET_CONNECTION_COALESCE_DELAY;
   g["default.script.open"] = false;
   g["default.script.rootpath"] = SCRIPT_ROOT_PATH;
   g["default.script.workpath"] = SCRIPT_WORK_PATH;
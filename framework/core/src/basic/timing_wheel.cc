@@ -0,0 +1,179 @@
+#include "pf/basic/timing_wheel.h"
+
+#define TIMING_WHEEL_NEAR (1 << TIMING_WHEEL_NEAR_BITS)
+#define TIMING_WHEEL_NEAR_MASK (TIMING_WHEEL_NEAR - 1)
+#define TIMING_WHEEL_LEVEL (1 << TIMING_WHEEL_LEVEL_BITS)
+#define TIMING_WHEEL_LEVEL_MASK (TIMING_WHEEL_LEVEL - 1)
+//The expiring timers move to this slot, so cancel in callback is safe.
+#define TIMING_WHEEL_PENDING \
+  (TIMING_WHEEL_NEAR + TIMING_WHEEL_LEVEL * TIMING_WHEEL_LEVELS)
+#define TIMING_WHEEL_NONE 0xffffffff
+
+namespace pf_basic {
+
+TimingWheel::TimingWheel() :
+  free_{TIMING_WHEEL_NONE},
+  current_{0},
+  time_{0},
+  precision_{1},
+  size_{0} {
+  slots_.resize(TIMING_WHEEL_PENDING + 1, TIMING_WHEEL_NONE);
+}
+
+TimingWheel::~TimingWheel() {
+  //do nothing
+}
+
+void TimingWheel::init(uint32_t precision, uint32_t now) {
+  precision_ = 0 == precision ? 1 : precision;
+  time_ = now;
+}
+
+uint64_t TimingWheel::add(uint32_t delay, uint64_t data) {
+  uint32_t index = free_;
+  if (index != TIMING_WHEEL_NONE) {
+    free_ = nodes_[index].next;
+  } else {
+    if (nodes_.size() >= TIMING_WHEEL_NONE - 1) return 0;
+    index = static_cast<uint32_t>(nodes_.size());
+    node_t node;
+    memset(&node, 0, sizeof(node));
+    nodes_.push_back(node);
+  }
+  auto &node = nodes_[index];
+  node.expire = current_ + (delay + precision_ - 1) / precision_;
+  node.data = data;
+  link(index);
+  ++size_;
+  return (static_cast<uint64_t>(node.serial) << 32) | (index + 1);
+}
+
+bool TimingWheel::cancel(uint64_t id) {
+  uint32_t index = static_cast<uint32_t>(id & 0xffffffff);
+  if (0 == index || index > nodes_.size()) return false;
+  --index;
+  auto &node = nodes_[index];
+  if (node.slot == TIMING_WHEEL_NONE ||
+      node.serial != static_cast<uint32_t>(id >> 32)) return false;
+  unlink(index);
+  release(index);
+  return true;
+}
+
+uint32_t TimingWheel::advance(uint32_t now,
+                              const std::function<void (uint64_t)> &function) {
+  uint32_t count{0};
+  if (static_cast<int32_t>(now - time_) < 0) return count;
+  //Nothing to expire, jump to now.
+  if (0 == size_) {
+    uint32_t ticks = (now - time_) / precision_ + 1;
+    current_ += ticks;
+    time_ += ticks * precision_;
+    return count;
+  }
+  while (static_cast<int32_t>(now - time_) >= 0) {
+    uint32_t index = static_cast<uint32_t>(current_ & TIMING_WHEEL_NEAR_MASK);
+    if (0 == index) {
+      for (uint32_t level = 1; level <= TIMING_WHEEL_LEVELS; ++level) {
+        cascade(level);
+        uint32_t shift =
+          TIMING_WHEEL_NEAR_BITS + (level - 1) * TIMING_WHEEL_LEVEL_BITS;
+        if (((current_ >> shift) & TIMING_WHEEL_LEVEL_MASK) != 0) break;
+      }
+    }
+    ++current_;
+    time_ += precision_;
+    if (TIMING_WHEEL_NONE == slots_[index]) continue;
+    //Move to pending, the timers added in callback will not in it.
+    uint32_t head = slots_[index];
+    slots_[index] = TIMING_WHEEL_NONE;
+    slots_[TIMING_WHEEL_PENDING] = head;
+    for (uint32_t i = head; i != TIMING_WHEEL_NONE; i = nodes_[i].next)
+      nodes_[i].slot = TIMING_WHEEL_PENDING;
+    while (slots_[TIMING_WHEEL_PENDING] != TIMING_WHEEL_NONE) {
+      uint32_t i = slots_[TIMING_WHEEL_PENDING];
+      uint64_t data = nodes_[i].data;
+      unlink(i);
+      release(i);
+      function(data);
+      ++count;
+    }
+  }
+  return count;
+}
+
+uint32_t TimingWheel::timeout(uint32_t now) const {
+  if (0 == size_) return TIMING_WHEEL_NONE;
+  uint32_t i = 0;
+  for (; i < TIMING_WHEEL_NEAR; ++i) {
+    uint64_t tick = current_ + i;
+    //The upper levels cascade at the wrap(the current tick too).
+    if (0 == (tick & TIMING_WHEEL_NEAR_MASK)) break;
+    if (slots_[tick & TIMING_WHEEL_NEAR_MASK] != TIMING_WHEEL_NONE) break;
+  }
+  int32_t result = static_cast<int32_t>(time_ + i * precision_ - now);
+  return result > 0 ? static_cast<uint32_t>(result) : 0;
+}
+
+void TimingWheel::link(uint32_t index) {
+  auto &node = nodes_[index];
+  if (node.expire < current_) node.expire = current_;
+  uint64_t diff = node.expire - current_;
+  uint32_t slot{0};
+  if (diff < TIMING_WHEEL_NEAR) {
+    slot = static_cast<uint32_t>(node.expire & TIMING_WHEEL_NEAR_MASK);
+  } else {
+    for (uint32_t level = 1; level <= TIMING_WHEEL_LEVELS; ++level) {
+      uint32_t bits = TIMING_WHEEL_NEAR_BITS + level * TIMING_WHEEL_LEVEL_BITS;
+      uint64_t range = static_cast<uint64_t>(1) << bits;
+      if (diff >= range && level != TIMING_WHEEL_LEVELS) continue;
+      //Out of the wheel, wait in the last slot and link again when cascade.
+      uint64_t expire = diff >= range ? current_ + range - 1 : node.expire;
+      uint32_t shift = bits - TIMING_WHEEL_LEVEL_BITS;
+      slot = TIMING_WHEEL_NEAR + (level - 1) * TIMING_WHEEL_LEVEL +
+        static_cast<uint32_t>((expire >> shift) & TIMING_WHEEL_LEVEL_MASK);
+      break;
+    }
+  }
+  node.slot = slot;
+  node.prev = TIMING_WHEEL_NONE;
+  node.next = slots_[slot];
+  if (node.next != TIMING_WHEEL_NONE) nodes_[node.next].prev = index;
+  slots_[slot] = index;
+}
+
+void TimingWheel::unlink(uint32_t index) {
+  auto &node = nodes_[index];
+  if (node.prev != TIMING_WHEEL_NONE) {
+    nodes_[node.prev].next = node.next;
+  } else {
+    slots_[node.slot] = node.next;
+  }
+  if (node.next != TIMING_WHEEL_NONE) nodes_[node.next].prev = node.prev;
+  node.prev = node.next = TIMING_WHEEL_NONE;
+}
+
+void TimingWheel::cascade(uint32_t level) {
+  uint32_t shift =
+    TIMING_WHEEL_NEAR_BITS + (level - 1) * TIMING_WHEEL_LEVEL_BITS;
+  uint32_t slot = TIMING_WHEEL_NEAR + (level - 1) * TIMING_WHEEL_LEVEL +
+    static_cast<uint32_t>((current_ >> shift) & TIMING_WHEEL_LEVEL_MASK);
+  uint32_t head = slots_[slot];
+  slots_[slot] = TIMING_WHEEL_NONE;
+  while (head != TIMING_WHEEL_NONE) {
+    uint32_t next = nodes_[head].next;
+    link(head);
+    head = next;
+  }
+}
+
+void TimingWheel::release(uint32_t index) {
+  auto &node = nodes_[index];
+  node.slot = TIMING_WHEEL_NONE;
+  ++node.serial;
+  node.next = free_;
+  free_ = index;
+  --size_;
+}
+
+} //namespace pf_basic
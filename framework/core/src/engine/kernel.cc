@@ -7,6 +7,10 @@
 #include "pf/net/connection/manager/listener_factory.h"
 #include "pf/net/connection/manager/connector.h"
 #include "pf/net/packet/handshake.h"
+#include "pf/net/packet/factorymanager.h"
+#include "pf/net/stream/buffer.h"
+#include "pf/net/connection/budget.h"
+#include "pf/net/connection/executor.h"
 #include "pf/db/interface.h"
 #include "pf/db/null.h"
 #include "pf/db/factory.h"
@@ -67,10 +71,15 @@ pf_script::Interface *Kernel::get_script() {
 }
 
 pf_net::connection::Basic *Kernel::get_connector(const std::string &name) {
-  if (is_null(net_connector_) || 
-      connect_list_.find(name) == connect_list_.end() ||
-      -1 == connect_list_[name]) return nullptr;
-  int16_t id = connect_list_[name];
+  if (is_null(net_connector_)) return nullptr;
+  int32_t id{-1};
+  {
+    std::unique_lock<std::mutex> lock(connect_mutex_);
+    auto it = connect_list_.find(name);
+    if (it == connect_list_.end()) return nullptr;
+    id = it->second;
+  }
+  if (-1 == id) return nullptr;
   return net_connector_->get(id);
 }
 
@@ -101,9 +110,41 @@ bool Kernel::init() {
 }
 
 void Kernel::run() {
+  using namespace pf_net::connection::manager;
+  //The net threads wait events in select if have wait time, no frame sleep.
+  auto wait_time = GLOBALS["default.net.wait_time"].get<uint32_t>();
+  auto kick_time = GLOBALS["default.net.kick_time"].get<uint32_t>();
+  auto keepalive = GLOBALS["default.net.keepalive"].get<uint32_t>();
+  auto heartbeat_tick = GLOBALS["default.net.heartbeat_tick"].get<bool>();
+  auto net_thread = 
+    [this, wait_time, kick_time, keepalive, heartbeat_tick](Basic *net) {
+    net->set_kick_time(kick_time);
+    net->set_keepalive_time(keepalive);
+    net->set_heartbeat_tick(heartbeat_tick);
+    if (wait_time > 0) {
+      net->set_wait_time(wait_time);
+      this->newloop([net]() { return thread::for_net(net); });
+    } else {
+      this->newthread([net]() { return thread::for_net(net); });
+    }
+  };
+  auto accept_rate = GLOBALS["default.net.accept_rate"].get<uint32_t>();
+  auto accept_burst = GLOBALS["default.net.accept_burst"].get<uint32_t>();
+  auto handshake_max = GLOBALS["default.net.handshake_max"].get<uint32_t>();
+  //The listener shards run in self thread too.
+  auto listener_thread = 
+    [&net_thread, accept_rate, accept_burst, handshake_max](Listener *net) {
+    net->set_accept_rate(accept_rate, accept_burst);
+    net->set_handshake_max(handshake_max);
+    for (uint8_t i = 0; i < net->reactor_size(); ++i) 
+      net_thread(net->reactor(i));
+  };
   if (!is_null(net_)) {
-    auto net = net_.get();
-    this->newthread([&net]() { return thread::for_net(net); });
+    if (net_->is_service()) {
+      listener_thread(dynamic_cast<Listener *>(net_.get()));
+    } else {
+      net_thread(net_.get());
+    }
   }
   if (!is_null(db_factory_) && db_eid_ != DB_EID_INVALID) {
     auto env = db_factory_->getenv(db_eid_);
@@ -121,13 +162,13 @@ void Kernel::run() {
   if (!is_null(net_listener_factory_)) {
     for (auto it = listen_list_.begin(); it != listen_list_.end(); ++it) {
       auto net = net_listener_factory_->getenv(it->second);
-      if (!is_null(net))
-        this->newthread([&net]() { return thread::for_net(net); });
+      if (!is_null(net)) listener_thread(net);
     }
   }
-  if (!is_null(net_connector_))
-    this->newthread(
-        [this]() { return thread::for_net(net_connector_.get()); });
+  if (!is_null(net_connector_)) net_thread(net_connector_.get());
+  //The packet dispatch table is read only when running.
+  if (!is_null(NET_PACKET_FACTORYMANAGER_POINTER))
+    NET_PACKET_FACTORYMANAGER_POINTER->freeze();
   GLOBALS["app.status"] = kAppStatusRunning;
   loop();
 }
@@ -145,19 +186,20 @@ pf_net::connection::Basic *Kernel::default_connect(
   using namespace pf_net::connection::manager;
   if (is_null(net_) || net_->is_service()) return nullptr;
   Connector *connector = dynamic_cast<Connector *>(net_.get());
-  auto connection = connector->connect(ip.c_str(), port);
-  if (is_null(connection)) return nullptr;
   auto encrypt_str = GLOBALS["default.net.encrypt"].data;
-  if ("" == encrypt_str) return connection;
-  auto now = TIME_MANAGER_POINTER->get_ctime();
-  std::string str{""};
-  char key[NET_PACKET_HANDSHAKE_KEY_SIZE]{0};
-  pf_basic::string::encrypt(encrypt_str, now, str);
-  pf_basic::base64encode(key, str.c_str());
-  pf_net::packet::Handshake handshake;
-  handshake.set_key(str);
-  connection->send(&handshake);
-  return connection;
+  //The handshake send in the net thread.
+  auto connected = [encrypt_str](pf_net::connection::Basic *connection) {
+    if ("" == encrypt_str) return;
+    auto now = TIME_MANAGER_POINTER->get_ctime();
+    std::string str{""};
+    char key[NET_PACKET_HANDSHAKE_KEY_SIZE]{0};
+    pf_basic::string::encrypt(encrypt_str, now, str);
+    pf_basic::base64encode(key, str.c_str());
+    pf_net::packet::Handshake handshake;
+    handshake.set_key(str);
+    connection->send(&handshake);
+  };
+  return connector->connect_wait(ip, port, connected);
 }
 
 pf_net::connection::Basic *Kernel::connect(const std::string &name) {
@@ -165,10 +207,45 @@ pf_net::connection::Basic *Kernel::connect(const std::string &name) {
   auto id = connect_env_[name];
   auto ip = GLOBALS["client.ip" + std::to_string(id)].data;
   auto port = GLOBALS["client.port" + std::to_string(id)].get<uint16_t>();
-  auto connection = net_connector_->connect(ip.c_str(), port);
-  if (is_null(connection)) return nullptr;
+  auto path = GLOBALS["client.path" + std::to_string(id)].data;
+  if (path != "") { //The unix domain socket.
+    ip = path;
+    port = 0;
+  }
   auto encrypt_str = GLOBALS["client.encrypt" + std::to_string(id)].data;
-  if ("" == encrypt_str) return connection;
+  //Same as the keep connect, the pool only used in the net thread.
+  auto connected = [this, name, encrypt_str](
+      pf_net::connection::Basic *connection) {
+    handshake(connection, encrypt_str);
+    std::unique_lock<std::mutex> lock(connect_mutex_);
+    connect_list_[name] = connection->get_id();
+  };
+  return net_connector_->connect_wait(ip, port, connected);
+}
+
+void Kernel::keep_connect(const std::string &name) {
+  if (connect_env_.find(name) == connect_env_.end()) return;
+  auto id = connect_env_[name];
+  auto ip = GLOBALS["client.ip" + std::to_string(id)].data;
+  auto port = GLOBALS["client.port" + std::to_string(id)].get<uint16_t>();
+  auto path = GLOBALS["client.path" + std::to_string(id)].data;
+  if (path != "") {
+    ip = path;
+    port = 0;
+  }
+  auto encrypt_str = GLOBALS["client.encrypt" + std::to_string(id)].data;
+  auto connected = [this, name, encrypt_str](
+      pf_net::connection::Basic *connection) {
+    handshake(connection, encrypt_str);
+    std::unique_lock<std::mutex> lock(connect_mutex_);
+    connect_list_[name] = connection->get_id();
+  };
+  net_connector_->keep(name, ip, port, connected);
+}
+
+void Kernel::handshake(pf_net::connection::Basic *connection, 
+                       const std::string &encrypt_str) {
+  if ("" == encrypt_str) return;
   auto now = TIME_MANAGER_POINTER->get_ctime();
   char key[NET_PACKET_HANDSHAKE_KEY_SIZE]{0};
   std::string str{""};
@@ -179,8 +256,6 @@ pf_net::connection::Basic *Kernel::connect(const std::string &name) {
   pf_net::packet::Handshake handshake;
   handshake.set_key(key);
   connection->send(&handshake);
-  connect_list_[name] = connection->get_id();
-  return connection;
 }
 
 bool Kernel::init_base() {
@@ -233,30 +308,92 @@ bool Kernel::init_net() {
   SLOW_DEBUGLOG(ENGINE_MODULENAME, 
                 "[%s] Kernel::init_net start...", 
                 ENGINE_MODULENAME);
+  //The stream buffers memory.
+  stream::buffer::set_idle_time(
+      GLOBALS["default.net.buffer_idle"].get<uint32_t>());
+  stream::buffer::set_pool_max_size(
+      GLOBALS["default.net.buffer_pool"].get<uint64_t>());
+  //The output budget of connections.
+  connection::budget::set_soft_limit(
+      GLOBALS["default.net.output_soft"].get<uint32_t>());
+  connection::budget::set_hard_limit(
+      GLOBALS["default.net.output_hard"].get<uint32_t>());
+  connection::budget::set_soft_time(
+      GLOBALS["default.net.output_soft_time"].get<uint32_t>());
+  connection::budget::set_global_limit(
+      GLOBALS["default.net.output_global"].get<uint64_t>());
+  connection::budget::set_policy(
+      GLOBALS["default.net.output_policy"].get<uint8_t>());
+  //The write coalescing of connections.
+  connection::budget::set_coalesce(
+      GLOBALS["default.net.coalesce_size"].get<uint32_t>(),
+      GLOBALS["default.net.coalesce_delay"].get<uint32_t>());
   if (GLOBALS["default.net.open"] == true) {
     connection::manager::Basic *net{nullptr};
-    auto conn_max = GLOBALS["default.net.conn_max"].get<uint16_t>();
+    auto conn_max = GLOBALS["default.net.conn_max"].get<uint32_t>();
     if (GLOBALS["default.net.service"] == true) {
       net = new connection::manager::Listener();
       unique_move(connection::manager::Basic, net, net_)
       auto service_ip = GLOBALS["default.net.service_ip"].c_str();
       auto service_port = GLOBALS["default.net.service_port"].get<uint16_t>();
+      auto service_path = GLOBALS["default.net.service_path"].data;
       auto service = dynamic_cast< connection::manager::Listener *>(net);
       auto encrypt_str = GLOBALS["default.net.encrypt"].data;
-      if (!service->init(conn_max, service_port, service_ip)) return false;
-      std::string host{service->host()};
+      auto reactors = GLOBALS["default.net.reactors"].get<uint8_t>();
+      //The worker receive the sockets from the front channel(inherited).
+      auto forward_channel = 
+        GLOBALS["default.net.forward_channel"].get<int32_t>();
+      bool result{false};
+      if (forward_channel >= 0) {
+        result = service->init_forward(conn_max, forward_channel, reactors);
+      } else {
+        result = service_path != "" ? 
+          service->init_unix(conn_max, service_path, reactors) :
+          service->init(conn_max, service_port, service_ip, reactors);
+      }
+      if (!result) return false;
+      //The front pass the accepted sockets to the worker channels.
+      std::vector<std::string> forward_channels;
+      pf_basic::string::explode(
+          GLOBALS["default.net.forward_channels"].c_str(), 
+          forward_channels, 
+          ",", 
+          true, 
+          true);
+      for (auto &channel : forward_channels) {
+        if (!service->forward_add(atoi(channel.c_str()))) return false;
+      }
+      std::string host{service_path != "" ? service_path : service->host()};
+      if (forward_channel >= 0) 
+        host = "forward:" + std::to_string(forward_channel);
       if (encrypt_str != "") service->set_safe_encrypt_str(encrypt_str);
       SLOW_DEBUGLOG(ENGINE_MODULENAME,
-                    "[%s] service listen at: host[%s] port[%d] max[%d].",
+                    "[%s] service listen at: host[%s] port[%d] max[%d]"
+                    " reactors[%d].",
                     ENGINE_MODULENAME,
                     0 == host.size() ? "*" : host.c_str(),
                     service->port(),
-                    conn_max);
+                    conn_max,
+                    service->reactor_size());
     } else {
       net = new connection::manager::Connector();
       unique_move(connection::manager::Basic, net, net_)
       if (!net->init(conn_max)) return false;
     }
+    //The packet handlers run in the workers, the net threads only decode.
+    auto executors = GLOBALS["default.net.executors"].get<uint32_t>();
+    if (executors > 0) {
+      std::unique_ptr<connection::Executor> executor{new connection::Executor};
+      if (!executor->init(executors)) return false;
+      net_executor_ = std::move(executor);
+      if (net_->is_service()) {
+        auto service = dynamic_cast<connection::manager::Listener *>(net);
+        for (uint8_t i = 0; i < service->reactor_size(); ++i)
+          service->reactor(i)->set_executor(net_executor_.get());
+      } else {
+        net_->set_executor(net_executor_.get());
+      }
+    }
   }
   //Extra net listeners.
   if (GLOBALS["server.count"] > 0) {
@@ -280,11 +417,14 @@ bool Kernel::init_net() {
         return false;
       }
       auto conn_max = 
-        GLOBALS["server.connmax" + std::to_string(i)].get<uint16_t>();
+        GLOBALS["server.connmax" + std::to_string(i)].get<uint32_t>();
       auto ip = GLOBALS["server.ip" + std::to_string(i)].data;
       auto port = GLOBALS["server.port" + std::to_string(i)].get<uint16_t>();
       auto encrypt_str = GLOBALS["server.encrypt" + std::to_string(i)].data;
-      if (0 == port || conn_max <= 0) {
+      auto reactors = 
+        GLOBALS["server.reactors" + std::to_string(i)].get<uint8_t>();
+      auto path = GLOBALS["server.path" + std::to_string(i)].data;
+      if ((0 == port && "" == path) || conn_max <= 0) {
         SLOW_ERRORLOG(ENGINE_MODULENAME,
                       "[%s] Kernel::init_net extra service the port or "
                       "connection count error: [%d|%d|%d]",
@@ -298,15 +438,18 @@ bool Kernel::init_net() {
       listener_config_t config;
       config.ip = ip;
       config.port = port;
+      config.path = path;
       config.conn_max = conn_max;
       config.encrypt_str = encrypt_str;
+      config.reactors = reactors > 0 ? reactors : 1;
       auto envid = net_listener_factory_->newenv(config);
       if (NET_EID_INVALID == envid) return false;
       listen_list_[name] = envid;
       SLOW_DEBUGLOG(ENGINE_MODULENAME,
                     "[%s] service extra listen at: host[%s] port[%d] max[%d].",
                     ENGINE_MODULENAME,
-                    0 == ip.size() ? "*" : ip.c_str(),
+                    path != "" ? path.c_str() : 
+                    (0 == ip.size() ? "*" : ip.c_str()),
                     port,
                     conn_max);
     }
@@ -324,13 +467,20 @@ bool Kernel::init_net() {
     if (!connector->init(count + 1)) return false;
     auto reset_connect = [this](pf_net::connection::Basic *connection) {
       std::cout << "reset_connect" << std::endl;
-      for (auto it = connect_list_.begin(); it != connect_list_.end(); ++it) {
-        if (it->second == connection->get_id()) {
-          std::cout << "reset: " << it->first << std::endl;
-          it->second = -1; //Reset the hash to invalid.
-          break;
+      std::string name{""};
+      {
+        std::unique_lock<std::mutex> lock(connect_mutex_);
+        for (auto it = connect_list_.begin(); it != connect_list_.end(); ++it) {
+          if (it->second == connection->get_id()) {
+            std::cout << "reset: " << it->first << std::endl;
+            it->second = -1; //Reset the hash to invalid.
+            name = it->first;
+            break;
+          }
         }
       }
+      //Reconnect with backoff in net thread.
+      if (name != "") keep_connect(name);
     };
     connector->callback_disconnect(reset_connect);
     unique_move(Connector, connector, net_connector_);
@@ -346,8 +496,8 @@ bool Kernel::init_net() {
       }
       connect_env_[name] = i;
       if (!startup) continue;
-      //Try connect.
-      connect(name);
+      //Try connect(in the net thread).
+      keep_connect(name);
     }
   }
   return true;
@@ -486,10 +636,6 @@ void Kernel::loop() {
       }
     }
     if (task) task();
-    //Reconnect the connected.
-    for (auto it = connect_list_.begin(); it != connect_list_.end(); ++it) {
-      if (-1 == it->second) connect(it->first);
-    }
     worksleep(starttime);
   }
   auto check_starttime = TIME_MANAGER_POINTER->get_tickcount();
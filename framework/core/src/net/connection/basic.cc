@@ -1,13 +1,25 @@
 #include "pf/basic/logger.h"
 #include "pf/basic/io.tcc"
 #include "pf/basic/time_manager.h"
+#include "pf/net/stream/buffer.h"
 #include "pf/net/packet/factorymanager.h"
+#include "pf/net/connection/manager/interface.h"
+#include "pf/net/connection/budget.h"
+#include "pf/net/connection/executor.h"
 #include "pf/net/connection/basic.h"
 
 namespace pf_net {
 
 namespace connection {
 
+//The actions of output check.
+enum {
+  kOutputActionWrite = 0,
+  kOutputActionHold,
+  kOutputActionDrop,
+  kOutputActionOverflow,
+};
+
 Basic::Basic() : 
   id_{ID_INVALID},
   managerid_{ID_INVALID},
@@ -17,6 +29,7 @@ Basic::Basic() :
   ostream_{nullptr},
   protocol_{nullptr},
   listener_{nullptr},
+  manager_{nullptr},
   empty_{true},
   disconnect_{false},
   ready_{false},
@@ -25,8 +38,19 @@ Basic::Basic() :
   compress_buffer_{nullptr},
   receive_bytes_{0},
   send_bytes_{0},
+  active_{false},
+  idle_time_{0},
+  alive_{false},
+  timers_{0},
+  output_size_{0},
+  output_soft_time_{0},
+  output_overflow_{false},
+  output_throttled_{false},
+  output_held_size_{0},
   packet_index_{0},
   execute_count_pretick_{NET_CONNECTION_EXECUTE_COUNT_PRE_TICK_DEFAULT},
+  command_pending_{false},
+  dirty_{kDirtyFlagNone},
   status_{0},
   safe_encrypt_{false},
   safe_encrypt_time_{0},
@@ -35,6 +59,7 @@ Basic::Basic() :
 }
 
 Basic::~Basic() {
+  budget::global_add(-static_cast<int64_t>(output_size_));
   safe_delete(compress_buffer_);
   safe_delete(uncompress_buffer_);
 }
@@ -52,6 +77,7 @@ bool Basic::init(protocol::Interface *protocol) {
   istream_ = std::move(_istream);
   Assert(istream_.get());
   istream_->init();
+  istream_->set_decrypt_once(true);
   std::unique_ptr<stream::Output> _ostream (
       new stream::Output(
       socket_.get(),
@@ -60,6 +86,7 @@ bool Basic::init(protocol::Interface *protocol) {
   ostream_ = std::move(_ostream);
   Assert(ostream_.get());
   ostream_->init();
+  ostream_->set_coalesce(budget::coalesce_size(), budget::coalesce_delay());
   ready_ = true;
   return true;
 }
@@ -98,6 +125,7 @@ bool Basic::process_input() {
     } else {
       result = true;
       receive_bytes_ += static_cast<uint32_t>(fillresult); //网络流量
+      if (fillresult > 0) active_ = alive_ = true;
     }
   } catch(...) {
     SaveErrorLog();
@@ -108,6 +136,25 @@ bool Basic::process_input() {
   return result;
 }
 
+bool Basic::receive(const char *data, uint32_t size) {
+  if (is_disconnect()) return true;
+  bool compress = istream_->getcompressor()->getassistant()->isenable();
+  if (compress && is_null(istream_compress_)) return false;
+  auto &stream = compress ? *istream_compress_ : *istream_;
+  int32_t fillresult = stream.fill(data, size);
+  if (fillresult <= SOCKET_ERROR) {
+    SLOW_ERRORLOG("net",
+                  "[net.connection] (Basic::receive)"
+                  " fill result: %d",
+                  fillresult);
+    return false;
+  }
+  receive_bytes_ += static_cast<uint32_t>(fillresult);
+  if (fillresult > 0) active_ = alive_ = true;
+  if (compress) process_input_compress();
+  return true;
+}
+
 void Basic::process_input_compress() {
   protocol_->compress(this, uncompress_buffer_, compress_buffer_);
 }
@@ -131,6 +178,8 @@ bool Basic::process_output() {
     } else {
       result = true;
       send_bytes_ += static_cast<uint32_t>(flushresult);
+      if (flushresult > 0) active_ = true;
+      output_update();
     }
   } catch(...) {
     SaveErrorLog();
@@ -144,21 +193,182 @@ bool Basic::process_command() {
 }
 
 bool Basic::send(packet::Interface* packet) {
+  //The handler in worker, write it in net thread.
+  if (Executor::in_worker()) return Executor::send(this, packet);
   if (is_disconnect()) return true;
   if (is_null(protocol_)) return false;
-  return protocol_->send(this, packet);
+  bool result = false;
+  auto packetid = packet->get_id();
+  switch (output_check(packetid, NET_PACKET_HEADERSIZE + packet->size())) {
+    case kOutputActionWrite:
+      result = protocol_->send(this, packet);
+      if (result && budget::urgent(packetid)) ostream_->urgent();
+      break;
+    case kOutputActionHold: {
+      std::string data{""};
+      result = protocol_->encode(packet, data);
+      if (result) 
+        output_hold(packetid, data.data(), static_cast<uint32_t>(data.size()));
+      break;
+    }
+    case kOutputActionDrop:
+      return true;
+    default:
+      break;
+  }
+  output_update();
+  //The overflow connection will remove in manager output.
+  if ((result || output_overflow_) && manager_) manager_->output_dirty(this);
+  return result;
 }
 
-bool Basic::heartbeat(uint32_t, uint32_t) {
-  using namespace pf_basic;
-  if (safe_encrypt_time_ != 0 && !is_safe_encrypt()) {
-    auto now = TIME_MANAGER_POINTER->get_ctime();
-    if (safe_encrypt_time_ + NET_ENCRYPT_CONNECTION_TIMEOUT < now) {
-      io_cwarn("[%s] Connection with safe encrypt timeout!",
-               NET_MODULENAME);
-      return false;
+bool Basic::send(const char *data, uint32_t size) {
+  if (Executor::in_worker()) return Executor::send(this, data, size);
+  if (is_disconnect()) return true;
+  if (is_null(protocol_)) return false;
+  if (size < sizeof(uint16_t)) return false;
+  bool result = false;
+  uint16_t packetid{0};
+  memcpy(&packetid, data, sizeof(packetid));
+  switch (output_check(packetid, size)) {
+    case kOutputActionWrite:
+      result = protocol_->send(this, data, size);
+      if (result && budget::urgent(packetid)) ostream_->urgent();
+      break;
+    case kOutputActionHold:
+      output_hold(packetid, data, size);
+      result = true;
+      break;
+    case kOutputActionDrop:
+      return true;
+    default:
+      break;
+  }
+  output_update();
+  if ((result || output_overflow_) && manager_) manager_->output_dirty(this);
+  return result;
+}
+
+void Basic::flush() {
+  //Flush after the sends of the handler in net thread.
+  if (Executor::in_worker()) {
+    Executor::flush(this);
+    return;
+  }
+  if (!ready() || is_disconnect()) return;
+  ostream_->urgent();
+  if (manager_) manager_->output_dirty(this);
+}
+
+void Basic::output_update() {
+  if (!ready()) return;
+  auto soft = budget::soft_limit();
+  if (!output_overflow_ && (0 == soft || ostream_->size() < soft)) {
+    output_soft_time_ = 0;
+    //The held packets write in order until over the soft limit again.
+    bool wrote{false};
+    while (!output_held_.empty() && (0 == soft || ostream_->size() < soft)) {
+      auto &item = output_held_.front();
+      auto length = static_cast<uint32_t>(item.second.size());
+      output_held_size_ -= length;
+      if (!is_null(protocol_) && 
+          protocol_->send(this, item.second.data(), length)) wrote = true;
+      output_held_.pop_front();
+    }
+    if (wrote && manager_) manager_->output_dirty(this);
+    if (output_throttled_ && ostream_->size() <= soft / 2) {
+      output_throttled_ = false;
+      if (manager_) manager_->input_dirty(this);
     }
   }
+  auto size = static_cast<uint32_t>(ostream_->size()) + output_held_size_;
+  budget::global_add(static_cast<int64_t>(size) - output_size_);
+  output_size_ = size;
+}
+
+uint8_t Basic::output_check(uint16_t packet_id, uint32_t size) {
+  if (output_overflow_) return kOutputActionOverflow;
+  uint8_t overflow{budget::kStatMax};
+  uint64_t after = static_cast<uint64_t>(ostream_->size()) + 
+                   output_held_size_ + size;
+  auto hard = budget::hard_limit();
+  auto soft = budget::soft_limit();
+  bool over_soft = soft > 0 && after > soft;
+  bool droppable = budget::droppable(packet_id);
+  auto global = budget::global_limit();
+  if (hard > 0 && after > hard) {
+    overflow = budget::kStatOverflowHard;
+  } else if (global > 0 && budget::global_size() + size > global) {
+    //The slow consumers disconnect first, the others not affected.
+    if (droppable) {
+      budget::stat_add(budget::kStatDropped);
+      return kOutputActionDrop;
+    }
+    if (over_soft) overflow = budget::kStatOverflowGlobal;
+  }
+  if (overflow != budget::kStatMax) {
+    output_overflow_ = true;
+    budget::stat_add(overflow);
+    return kOutputActionOverflow;
+  }
+  //Keep the order of droppable packets.
+  if (droppable && !output_held_.empty()) return kOutputActionHold;
+  if (!over_soft) return kOutputActionWrite;
+  auto now = TIME_MANAGER_POINTER->get_tickcount();
+  auto soft_time = budget::soft_time();
+  if (0 == output_soft_time_) {
+    output_soft_time_ = now;
+  } else if (soft_time > 0 && now - output_soft_time_ >= soft_time) {
+    output_overflow_ = true;
+    budget::stat_add(budget::kStatOverflowSoft);
+    return kOutputActionOverflow;
+  }
+  switch (budget::policy()) {
+    case kOutputPolicyDrop:
+    case kOutputPolicyCoalesce:
+      if (droppable) return kOutputActionHold;
+      break;
+    case kOutputPolicyThrottle:
+      if (!output_throttled_) {
+        output_throttled_ = true;
+        budget::stat_add(budget::kStatThrottled);
+      }
+      break;
+    case kOutputPolicyDisconnect:
+      output_overflow_ = true;
+      budget::stat_add(budget::kStatOverflowSoft);
+      return kOutputActionOverflow;
+    default:
+      break;
+  }
+  return kOutputActionWrite;
+}
+
+void Basic::output_hold(uint16_t packet_id, const char *data, uint32_t size) {
+  //The newer replace the held with same id(the latest state).
+  if (kOutputPolicyCoalesce == budget::policy()) {
+    for (auto &item : output_held_) {
+      if (item.first != packet_id) continue;
+      output_held_size_ -= static_cast<uint32_t>(item.second.size());
+      item.second.assign(data, size);
+      output_held_size_ += size;
+      budget::stat_add(budget::kStatCoalesced);
+      return;
+    }
+  }
+  if (output_held_.size() >= NET_CONNECTION_OUTPUT_HOLD_MAX) {
+    auto &item = output_held_.front();
+    output_held_size_ -= static_cast<uint32_t>(item.second.size());
+    output_held_.pop_front();
+    budget::stat_add(budget::kStatDropped);
+  }
+  output_held_.emplace_back(packet_id, std::string(data, size));
+  output_held_size_ += size;
+  budget::stat_add(budget::kStatHeld);
+}
+
+bool Basic::heartbeat(uint32_t, uint32_t) {
+  //The safe encrypt timeout is the handshake timer of manager.
   return true;
 }
 
@@ -175,12 +385,37 @@ bool Basic::is_valid() {
 
 void Basic::clear() {
   if (socket_) socket_->close();
-  if (istream_) istream_->clear();
-  if (ostream_) ostream_->clear();
+  if (istream_) {
+    istream_->clear();
+    istream_->release();
+  }
+  if (istream_compress_) {
+    istream_compress_->clear();
+    istream_compress_->release();
+  }
+  if (ostream_) {
+    ostream_->clear();
+    ostream_->release();
+    ostream_->set_coalesce(budget::coalesce_size(), budget::coalesce_delay());
+  }
+  active_ = false;
+  idle_time_ = 0;
+  alive_ = false;
+  memset(timers_, 0, sizeof(timers_));
+  budget::global_add(-static_cast<int64_t>(output_size_));
+  output_size_ = 0;
+  output_soft_time_ = 0;
+  output_overflow_ = false;
+  output_throttled_ = false;
+  output_held_.clear();
+  output_held_size_ = 0;
   set_managerid(ID_INVALID);
   packet_index_ = 0;
   status_ = 0;
   execute_count_pretick_ = NET_CONNECTION_EXECUTE_COUNT_PRE_TICK_DEFAULT;
+  command_pending_ = false;
+  dirty_ = kDirtyFlagNone;
+  manager_ = nullptr;
   set_disconnect(true);
   set_empty(true);
   set_safe_encrypt(false);
@@ -200,6 +435,20 @@ uint32_t Basic::get_send_bytes() {
   return result;
 }
 
+void Basic::shrink(uint32_t time) {
+  auto idle = stream::buffer::idle_time();
+  if (0 == idle || !ready()) return;
+  if (active_) {
+    active_ = false;
+    idle_time_ = time;
+    return;
+  }
+  if (time - idle_time_ < idle) return;
+  istream_->release();
+  ostream_->release();
+  if (istream_compress_) istream_compress_->release();
+}
+
 void Basic::compress_set_mode(compress_mode_t mode) {
   compress_mode_ = mode;
   pf_util::compressor::Assistant *assistant = nullptr;
@@ -0,0 +1,176 @@
+#include "pf/net/packet/config.h"
+#include "pf/net/connection/budget.h"
+
+namespace pf_net {
+
+namespace connection {
+
+namespace budget {
+
+typedef struct budgetdata_struct {
+  std::atomic<uint32_t> soft_limit;
+  std::atomic<uint32_t> hard_limit;
+  std::atomic<uint32_t> soft_time;
+  std::atomic<uint64_t> global_limit;
+  std::atomic<uint8_t> policy;
+  std::atomic<uint64_t> size;
+  std::atomic<uint64_t> peak;
+  std::atomic<uint64_t> counts[kStatMax];
+  std::atomic<uint32_t> droppables[(NET_PACKET_ID_MAX + 1) / 32];
+  std::atomic<uint32_t> coalesce_size;
+  std::atomic<uint32_t> coalesce_delay;
+  std::atomic<uint32_t> urgents[(NET_PACKET_ID_MAX + 1) / 32];
+  budgetdata_struct() :
+    soft_limit{NET_CONNECTION_OUTPUT_SOFT_LIMIT},
+    hard_limit{NET_CONNECTION_OUTPUT_HARD_LIMIT},
+    soft_time{NET_CONNECTION_OUTPUT_SOFT_TIME},
+    global_limit{NET_CONNECTION_OUTPUT_GLOBAL_LIMIT},
+    policy{kOutputPolicyNone},
+    size{0},
+    peak{0},
+    coalesce_size{NET_CONNECTION_COALESCE_SIZE},
+    coalesce_delay{NET_CONNECTION_COALESCE_DELAY} {
+    for (auto &count : counts) count = 0;
+    for (auto &bits : droppables) bits = 0;
+    for (auto &bits : urgents) bits = 0;
+  }
+} budgetdata_t;
+
+//Never destroy, the connections in static objects maybe clear after exit.
+static budgetdata_t &budgetdata() {
+  static budgetdata_t *data = new budgetdata_t;
+  return *data;
+}
+
+uint32_t soft_limit() {
+  return budgetdata().soft_limit.load(std::memory_order_relaxed);
+}
+
+void set_soft_limit(uint32_t size) {
+  budgetdata().soft_limit = size;
+}
+
+uint32_t hard_limit() {
+  return budgetdata().hard_limit.load(std::memory_order_relaxed);
+}
+
+void set_hard_limit(uint32_t size) {
+  budgetdata().hard_limit = size;
+}
+
+uint32_t soft_time() {
+  return budgetdata().soft_time.load(std::memory_order_relaxed);
+}
+
+void set_soft_time(uint32_t time) {
+  budgetdata().soft_time = time;
+}
+
+uint64_t global_limit() {
+  return budgetdata().global_limit.load(std::memory_order_relaxed);
+}
+
+void set_global_limit(uint64_t size) {
+  budgetdata().global_limit = size;
+}
+
+uint8_t policy() {
+  return budgetdata().policy.load(std::memory_order_relaxed);
+}
+
+void set_policy(uint8_t policy) {
+  budgetdata().policy = policy;
+}
+
+bool droppable(uint16_t packet_id) {
+  auto bits = budgetdata().droppables[packet_id >> 5].load(
+      std::memory_order_relaxed);
+  return (bits & (1u << (packet_id & 31))) != 0;
+}
+
+void set_droppable(uint16_t packet_id, bool flag) {
+  auto &bits = budgetdata().droppables[packet_id >> 5];
+  uint32_t mask = 1u << (packet_id & 31);
+  if (flag) {
+    bits.fetch_or(mask);
+  } else {
+    bits.fetch_and(~mask);
+  }
+}
+
+uint32_t coalesce_size() {
+  return budgetdata().coalesce_size.load(std::memory_order_relaxed);
+}
+
+uint32_t coalesce_delay() {
+  return budgetdata().coalesce_delay.load(std::memory_order_relaxed);
+}
+
+void set_coalesce(uint32_t size, uint32_t delay) {
+  budgetdata().coalesce_size = size;
+  budgetdata().coalesce_delay = delay;
+}
+
+bool urgent(uint16_t packet_id) {
+  auto bits = budgetdata().urgents[packet_id >> 5].load(
+      std::memory_order_relaxed);
+  return (bits & (1u << (packet_id & 31))) != 0;
+}
+
+void set_urgent(uint16_t packet_id, bool flag) {
+  auto &bits = budgetdata().urgents[packet_id >> 5];
+  uint32_t mask = 1u << (packet_id & 31);
+  if (flag) {
+    bits.fetch_or(mask);
+  } else {
+    bits.fetch_and(~mask);
+  }
+}
+
+uint64_t global_size() {
+  return budgetdata().size.load(std::memory_order_relaxed);
+}
+
+void global_add(int64_t size) {
+  if (0 == size) return;
+  auto &data = budgetdata();
+  auto result =
+    data.size.fetch_add(static_cast<uint64_t>(size),
+                        std::memory_order_relaxed) +
+    static_cast<uint64_t>(size);
+  uint64_t peak = data.peak.load(std::memory_order_relaxed);
+  while (size > 0 && result > peak &&
+         !data.peak.compare_exchange_weak(
+           peak, result, std::memory_order_relaxed)) {}
+}
+
+void stat_add(uint8_t kind) {
+  if (kind >= kStatMax) return;
+  budgetdata().counts[kind].fetch_add(1, std::memory_order_relaxed);
+}
+
+stat_t stat() {
+  auto &data = budgetdata();
+  stat_t result;
+  result.size = data.size.load(std::memory_order_relaxed);
+  result.peak = data.peak.load(std::memory_order_relaxed);
+  result.held = data.counts[kStatHeld].load(std::memory_order_relaxed);
+  result.dropped = data.counts[kStatDropped].load(std::memory_order_relaxed);
+  result.coalesced =
+    data.counts[kStatCoalesced].load(std::memory_order_relaxed);
+  result.throttled =
+    data.counts[kStatThrottled].load(std::memory_order_relaxed);
+  result.overflow_soft =
+    data.counts[kStatOverflowSoft].load(std::memory_order_relaxed);
+  result.overflow_hard =
+    data.counts[kStatOverflowHard].load(std::memory_order_relaxed);
+  result.overflow_global =
+    data.counts[kStatOverflowGlobal].load(std::memory_order_relaxed);
+  return result;
+}
+
+} //namespace budget
+
+} //namespace connection
+
+} //namespace pf_net
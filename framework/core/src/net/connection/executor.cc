@@ -0,0 +1,275 @@
+#include "pf/basic/logger.h"
+#include "pf/net/connection/manager/interface.h"
+#include "pf/net/connection/executor.h"
+
+using namespace pf_net::connection;
+
+static thread_local bool executor_worker{false};
+//The manager of the handler executing in this worker.
+static thread_local manager::Interface *executor_manager{nullptr};
+
+Executor::Executor() :
+  queue_max_{NET_EXECUTOR_QUEUE_MAX},
+  stop_{false},
+  executed_{0},
+  pending_{0} {
+}
+
+Executor::~Executor() {
+  stop();
+}
+
+bool Executor::init(uint32_t workers, uint32_t queue_max) {
+  if (!workers_.empty()) return true;
+  if (0 == workers) return false;
+  queue_max_ = queue_max > 0 ? queue_max : 1;
+  stop_ = false;
+  for (uint32_t i = 0; i < workers; ++i)
+    workers_.emplace_back(new worker_struct);
+  for (auto &worker : workers_) {
+    auto pointer = worker.get();
+    worker->thread = std::thread([this, pointer]() { work(*pointer); });
+  }
+  return true;
+}
+
+void Executor::stop() {
+  stop_ = true;
+  for (auto &worker : workers_) {
+    std::unique_lock<std::mutex> lock(worker->mutex);
+    worker->condition.notify_all();
+  }
+  for (auto &worker : workers_) {
+    if (worker->thread.joinable()) worker->thread.join();
+    for (auto &it : worker->strands) {
+      for (auto &task : it.second->tasks)
+        NET_PACKET_FACTORYMANAGER_POINTER->packet_remove(task.packet);
+    }
+  }
+  workers_.clear();
+  pending_ = 0;
+}
+
+Executor::worker_struct &Executor::worker_get(manager::Interface *manager,
+                                              int32_t id) {
+  auto hash = strand_hash()(strand_key_t{manager, id});
+  return *workers_[hash % workers_.size()];
+}
+
+bool Executor::post(Basic *connection,
+                    packet::Interface *packet,
+                    packet::function_packet_execute handler) {
+  auto manager = connection->get_manager();
+  if (is_null(manager) || stop_ || workers_.empty()) return false;
+  auto id = connection->get_id();
+  auto &worker = worker_get(manager, id);
+  std::unique_lock<std::mutex> lock(worker.mutex);
+  auto &strand = worker.strands[strand_key_t{manager, id}];
+  if (is_null(strand)) {
+    strand.reset(new strand_struct);
+    strand->manager = manager;
+    strand->id = id;
+    strand->scheduled = strand->blocked = false;
+    strand->closed = strand->cancelled = false;
+  }
+  //The connection will remove, drop it.
+  if (strand->closed) {
+    lock.unlock();
+    NET_PACKET_FACTORYMANAGER_POINTER->packet_remove(packet);
+    return true;
+  }
+  strand->tasks.push_back({packet, handler, connection->get_protocol()});
+  ++pending_;
+  if (strand->scheduled) return true;
+  strand->scheduled = true;
+  worker.ready.push_back(strand.get());
+  lock.unlock();
+  worker.condition.notify_one();
+  return true;
+}
+
+bool Executor::full(Basic *connection) {
+  if (workers_.empty()) return false;
+  auto manager = connection->get_manager();
+  auto id = connection->get_id();
+  auto &worker = worker_get(manager, id);
+  std::unique_lock<std::mutex> lock(worker.mutex);
+  auto it = worker.strands.find(strand_key_t{manager, id});
+  if (it == worker.strands.end() || it->second->tasks.size() < queue_max_)
+    return false;
+  it->second->blocked = true;
+  return true;
+}
+
+void Executor::cancel(manager::Interface *manager, int32_t id) {
+  if (workers_.empty()) return;
+  auto &worker = worker_get(manager, id);
+  std::unique_lock<std::mutex> lock(worker.mutex);
+  auto it = worker.strands.find(strand_key_t{manager, id});
+  if (it == worker.strands.end()) return;
+  auto strand = it->second.get();
+  strand_close(strand);
+  strand->cancelled = true;
+  strand_release(worker, strand);
+}
+
+void Executor::detach(manager::Interface *manager) {
+  for (auto &pointer : workers_) {
+    auto &worker = *pointer;
+    std::unique_lock<std::mutex> lock(worker.mutex);
+    std::vector<strand_struct *> strands;
+    for (auto &it : worker.strands) {
+      if (it.first.first == manager) strands.push_back(it.second.get());
+    }
+    for (auto strand : strands) {
+      strand_close(strand);
+      strand->cancelled = true;
+      strand_release(worker, strand);
+    }
+    //The running handlers may send with the manager.
+    if (executor_worker && executor_manager == manager) continue;
+    worker.idle.wait(lock, [&worker, manager]() {
+      for (auto &it : worker.strands) {
+        if (it.first.first == manager) return false;
+      }
+      return true;
+    });
+  }
+}
+
+bool Executor::in_worker() {
+  return executor_worker;
+}
+
+bool Executor::send(Basic *connection, packet::Interface *packet) {
+  auto protocol = connection->get_protocol();
+  if (is_null(protocol)) return false;
+  std::string data{""};
+  if (!protocol->encode(packet, data)) return false;
+  return send(connection, data.data(), static_cast<uint32_t>(data.size()));
+}
+
+bool Executor::send(Basic *connection, const char *data, uint32_t size) {
+  //The connection is the proxy, find it by id in net thread.
+  auto manager = connection->get_manager();
+  auto id = connection->get_id();
+  if (is_null(manager)) return false;
+  std::string buffer{data, size};
+  manager->enqueue([manager, id, buffer]() {
+    auto target = manager->get(id);
+    if (is_null(target) || target->empty()) return;
+    target->send(buffer.data(), static_cast<uint32_t>(buffer.size()));
+  });
+  return true;
+}
+
+bool Executor::flush(Basic *connection) {
+  auto manager = connection->get_manager();
+  auto id = connection->get_id();
+  if (is_null(manager)) return false;
+  manager->enqueue([manager, id]() {
+    auto target = manager->get(id);
+    if (!is_null(target) && !target->empty()) target->flush();
+  });
+  return true;
+}
+
+void Executor::work(worker_struct &worker) {
+  executor_worker = true;
+  //The handlers get the proxy, never the connection of net thread.
+  Basic proxy;
+  std::unique_lock<std::mutex> lock(worker.mutex);
+  for (;;) {
+    worker.condition.wait(lock, [this, &worker]() { 
+      return stop_ || !worker.ready.empty(); 
+    });
+    if (stop_) break;
+    auto strand = worker.ready.front();
+    worker.ready.pop_front();
+    if (strand->closed || strand->tasks.empty()) {
+      strand->scheduled = false;
+      strand_release(worker, strand);
+      worker.idle.notify_all();
+      continue;
+    }
+    task_struct task = strand->tasks.front();
+    strand->tasks.pop_front();
+    --pending_;
+    //The net thread decode the connection again.
+    bool resume = strand->blocked && strand->tasks.size() <= queue_max_ / 2;
+    if (resume) strand->blocked = false;
+    lock.unlock();
+    auto manager = strand->manager;
+    auto id = strand->id;
+    if (resume) {
+      manager->enqueue([manager, id]() {
+        auto connection = manager->get(id);
+        if (!is_null(connection) && !connection->is_disconnect())
+          manager->input_dirty(connection);
+      });
+    }
+    bool success = execute(proxy, strand, task);
+    lock.lock();
+    //The packets after the error not execute with the connection removing.
+    if (!success) strand_close(strand);
+    if (!strand->closed && !strand->tasks.empty()) {
+      worker.ready.push_back(strand); //The others first, one by one in turn.
+    } else {
+      strand->scheduled = false;
+      strand_release(worker, strand);
+    }
+    worker.idle.notify_all();
+  }
+  executor_worker = false;
+}
+
+bool Executor::execute(Basic &proxy, strand_struct *strand, task_struct &task) {
+  auto manager = strand->manager;
+  auto id = strand->id;
+  proxy.set_id(id);
+  proxy.set_manager(manager);
+  proxy.set_protocol(task.protocol);
+  proxy.set_empty(false);
+  executor_manager = manager;
+  uint32_t status{kPacketExecuteStatusError};
+  try {
+    status = task.handler ?
+             (*task.handler)(&proxy, task.packet) :
+             task.packet->execute(&proxy);
+  } catch(...) {
+    SaveErrorLog();
+    status = kPacketExecuteStatusError;
+  }
+  ++executed_;
+  if (status != kPacketExecuteStatusNotRemove &&
+      status != kPacketExecuteStatusNotRemoveError)
+    NET_PACKET_FACTORYMANAGER_POINTER->packet_remove(task.packet);
+  bool result = kPacketExecuteStatusError != status &&
+                kPacketExecuteStatusNotRemoveError != status;
+  if (!result) {
+    //Remove the connection in net thread.
+    manager->enqueue([manager, id]() {
+      auto connection = manager->get(id);
+      if (!is_null(connection)) manager->remove(connection);
+    });
+  }
+  proxy.set_manager(nullptr);
+  proxy.set_id(ID_INVALID);
+  executor_manager = nullptr;
+  return result;
+}
+
+void Executor::strand_close(strand_struct *strand) {
+  for (auto &task : strand->tasks)
+    NET_PACKET_FACTORYMANAGER_POINTER->packet_remove(task.packet);
+  pending_ -= strand->tasks.size();
+  strand->tasks.clear();
+  strand->closed = true;
+}
+
+void Executor::strand_release(worker_struct &worker, strand_struct *strand) {
+  if (strand->scheduled || !strand->tasks.empty()) return;
+  //Keep the closed until cancel, the new posts not create it again.
+  if (strand->closed && !strand->cancelled) return;
+  worker.strands.erase(strand_key_t{strand->manager, strand->id});
+}
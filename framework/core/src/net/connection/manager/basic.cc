@@ -1,5 +1,7 @@
+#include "pf/basic/logger.h"
 #include "pf/basic/time_manager.h"
 #include "pf/sys/assert.h"
+#include "pf/net/stream/buffer.h"
 #include "pf/net/connection/manager/basic.h"
 
 using namespace pf_net::connection::manager;
@@ -7,26 +9,97 @@ using namespace pf_net::connection::manager;
 bool Basic::heartbeat(uint32_t time) {
   using namespace pf_net;
   auto _time = 0 == time ? TIME_MANAGER_POINTER->get_tickcount() : time;
-  auto _size = size();
-  for (decltype(_size)i = 0; i < _size; ++i) {
-    if (ID_INVALID == connection_idset_[i]) continue;
-    connection::Basic* connection = nullptr;
-    connection = pool_->get(connection_idset_[i]);
-    if (nullptr == connection) {
-      //Assert(false);
-      return false;
-    }
-    if (!connection->heartbeat(_time)) {
-      remove(connection);
-      //Assert(false);
-      return false;
+  //Call the connection heartbeat in every tick if opened.
+  if (heartbeat_tick_) {
+    auto _size = size();
+    for (decltype(_size)i = 0; i < _size; ++i) {
+      if (ID_INVALID == connection_idset_[i]) continue;
+      connection::Basic *connection = pool_->get(connection_idset_[i]);
+      if (is_null(connection)) continue;
+      if (!connection->heartbeat(_time)) {
+        remove(connection);
+        if (size() < _size) { //The last one moved to here.
+          --i;
+          _size = size();
+        }
+      }
     }
   }
+  //The expired timers.
+  wheel_.advance(_time, [this, _time](uint64_t data) {
+    auto kind = static_cast<uint8_t>(data >> 32);
+    auto id = static_cast<int32_t>(data & 0xffffffff);
+    if (kind > kConnectionTimerKeepalive) {
+      on_timer(kind, id);
+      return;
+    }
+    connection::Basic *connection = pool_->get(id);
+    if (is_null(connection) || connection->empty()) return;
+    connection->set_timer(kind, 0);
+    switch (kind) {
+      case kConnectionTimerIdle: {
+        connection->shrink(_time);
+        auto idle = stream::buffer::idle_time();
+        timer_set(connection, 
+                  kind, 
+                  idle > 0 ? idle : NET_STREAM_BUFFER_IDLE_TIME);
+        break;
+      }
+      case kConnectionTimerKick:
+        if (!connection->is_alive()) {
+          SLOW_WARNINGLOG(NET_MODULENAME,
+                          "[net.connection.manager] (Basic::heartbeat)"
+                          " kick the connection no traffic, id: %d",
+                          id);
+          remove(connection);
+          break;
+        }
+        connection->set_alive(false);
+        timer_set(connection, kind, kick_time_);
+        break;
+      case kConnectionTimerHandshake:
+        --handshakes_;
+        if (!connection->is_safe_encrypt()) {
+          SLOW_WARNINGLOG(NET_MODULENAME,
+                          "[net.connection.manager] (Basic::heartbeat)"
+                          " safe encrypt timeout, id: %d",
+                          id);
+          remove(connection);
+        }
+        break;
+      case kConnectionTimerKeepalive:
+        if (!connection->heartbeat(_time, kind)) {
+          remove(connection);
+          break;
+        }
+        timer_set(connection, kind, keepalive_time_);
+        break;
+      default:
+        break;
+    }
+  });
   return true;
 }
 
 void Basic::tick() {
   bool result = false;
+  //output first, send the replies of last tick and others before waiting.
+  try {
+    result = process_output();
+    //Assert(result); 
+  } catch(...) {
+    
+  }
+  //The select wait until the next timer(or the coalescing output deadline) 
+  //if no work, wake up by events.
+  auto now = TIME_MANAGER_POINTER->get_tickcount();
+  wait_timeout_ = 0;
+  if (wait_time_ > 0 && !busy()) {
+    auto timeout = min(min(wheel_.timeout(now), wait_time_), 
+                       coalesce_timeout());
+    wait_timeout_ = static_cast<int32_t>(timeout);
+  }
+
   //normal.
   try {
     result = select();
@@ -37,9 +110,6 @@ void Basic::tick() {
 
     result = process_input();
     //Assert(result);
-
-    result = process_output();
-    //Assert(result); 
   } catch(...) {
     
   }
@@ -57,13 +127,21 @@ void Basic::tick() {
     //Assert(result);
   } catch(...) {
 
+  }
+  //tasks.
+  try {
+    result = process_tasks();
+    //Assert(result);
+  } catch(...) {
+
   }
 
-  //heartbeat.
+  //heartbeat(the expired timers).
   try {
-    result = heartbeat();
+    result = heartbeat(TIME_MANAGER_POINTER->get_tickcount());
     //Assert(result);
   } catch(...) {
 
   }
+
 }
@@ -1,172 +1,293 @@
 #include "pf/basic/logger.h"
 #include "pf/sys/assert.h"
+#include "pf/net/socket/api.h"
 #include "pf/net/connection/manager/connector.h"
 
 using namespace pf_net::connection::manager;
 
-bool Connector::init(uint16_t _max_size) {
+//The port 0 connect the unix domain socket of the path(ip).
+static int32_t socket_family(uint16_t port) {
+  return 0 == port ? AF_UNIX : AF_INET;
+}
+
+Connector::Connector() :
+  ticking_{false},
+  tick_thread_{std::thread::id()},
+  random_{static_cast<uint32_t>(
+      std::chrono::steady_clock::now().time_since_epoch().count())} {
+}
+
+bool Connector::init(uint32_t _max_size) {
   return Basic::init(_max_size);
 }
 
 pf_net::connection::Basic *Connector::connect(const char *ip, uint16_t port) {
-  if (!checkpool()) return nullptr;
-  pf_net::connection::Basic *connection = pool_->create();
-  if (is_null(connection)) return nullptr;
-  if (!connection->init(protocol())) {
+  return connect_wait(ip, port, nullptr);
+}
+
+pf_net::connection::Basic *
+Connector::group_connect(const char *ip, uint16_t port) {
+  return connect_wait(ip, port, nullptr);
+}
+
+void Connector::tick() {
+  if (ticking_.exchange(true)) return;
+  tick_thread_ = std::this_thread::get_id();
+  Basic::tick();
+  ticking_ = false;
+}
+
+pf_net::connection::Basic *
+Connector::connect_wait(const std::string &ip,
+                        uint16_t port,
+                        connect_callback_t connected,
+                        uint32_t timeout) {
+  auto self = std::this_thread::get_id();
+  if (ticking_ && tick_thread_ == self) {
+    SLOW_ERRORLOG(NET_MODULENAME,
+                  "[net.connection.manager] (Connector::connect_wait)"
+                  " can't wait in the tick! ip: %s, port: %d",
+                  ip.c_str(),
+                  port);
     return nullptr;
   }
-  pf_net::socket::Basic *socket = connection->socket();
-  bool result = false;
-  uint8_t step = 0;
-  bool _remove = false;
-  try {
-    result = socket->is_valid() ? true : socket->create();
-    if (!result) {
-      step = 1;
-      goto EXCEPTION;
+  //The result set in the net thread, the late connected removed there.
+  struct result_struct {
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool done{false};
+    bool abandoned{false};
+    connection::Basic *connection{nullptr};
+  };
+  auto result = std::make_shared<result_struct>();
+  auto callback = [this, result, connected](connection::Basic *connection) {
+    std::unique_lock<std::mutex> lock(result->mutex);
+    if (result->abandoned) {
+      if (!is_null(connection)) remove(connection);
+      return;
     }
-    result = socket->connect(ip, port);
-    if (!result) {
-      step = 2;
-      goto EXCEPTION;
+    if (!is_null(connection) && connected) connected(connection);
+    result->connection = connection;
+    result->done = true;
+    result->condition.notify_all();
+  };
+  connect_async(ip, port, callback, timeout);
+  auto deadline = std::chrono::steady_clock::now() + 
+    std::chrono::milliseconds(timeout + NET_CONNECTOR_WAIT_EXTRA);
+  std::unique_lock<std::mutex> lock(result->mutex);
+  while (!result->done) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      result->abandoned = true;
+      SLOW_WARNINGLOG(NET_MODULENAME,
+                      "[net.connection.manager] (Connector::connect_wait)"
+                      " timeout! ip: %s, port: %d",
+                      ip.c_str(),
+                      port);
+      return nullptr;
     }
-    result = socket->set_nonblocking();
-    if (!result) {
-      step = 3;
-      goto EXCEPTION;
+    //Drive the tick if the net thread not run(or it is this thread).
+    auto thread_id = tick_thread_.load();
+    if (!ticking_ && (thread_id == std::thread::id() || thread_id == self)) {
+      lock.unlock();
+      tick();
+      lock.lock();
+    } else {
+      result->condition.wait_for(lock, std::chrono::milliseconds(10));
     }
-    result = socket->set_linger(0);
-    if (!result) {
-      step = 4;
-      goto EXCEPTION;
+  }
+  return result->connection;
+}
+
+void Connector::connect_async(const std::string &ip, 
+                              uint16_t port, 
+                              connect_callback_t callback,
+                              uint32_t timeout) {
+  enqueue([this, ip, port, callback, timeout]() {
+    connect_start(ip, port, callback, timeout, -1);
+  });
+}
+
+void Connector::keep(const std::string &name,
+                     const std::string &ip,
+                     uint16_t port,
+                     connect_callback_t callback) {
+  enqueue([this, name, ip, port, callback]() {
+    for (target_t &target : targets_) {
+      if (target.name != name) continue;
+      //Use the new address in the next reconnect.
+      target.ip = ip;
+      target.port = port;
+      target.callback = callback;
+      return;
+    }
+    target_t target{name, ip, port, callback, 0, ID_INVALID};
+    targets_.emplace_back(target);
+    connect_start(ip, 
+                  port, 
+                  callback, 
+                  NET_CONNECTOR_TIMEOUT, 
+                  static_cast<int32_t>(targets_.size() - 1));
+  });
+}
+
+void Connector::on_timer(uint8_t kind, int32_t id) {
+  switch (kind) {
+    case kConnectionTimerConnect: {
+      auto connection = pool_->get(id);
+      if (is_null(connection)) return;
+      connection->set_timer(kind, 0);
+      SLOW_WARNINGLOG(NET_MODULENAME,
+                      "[net.connection.manager] (Connector::on_timer)"
+                      " connect timeout! ip: %s, port: %d",
+                      connection->socket()->host(),
+                      connection->socket()->port());
+      connect_finish(connection, false);
+      break;
     }
-  } catch (...) {
-    step = 5;
+    case kManagerTimerReconnect: {
+      if (id < 0 || id >= static_cast<int32_t>(targets_.size())) return;
+      target_t &target = targets_[id];
+      if (target.connectionid != ID_INVALID) return;
+      connect_start(
+          target.ip, target.port, target.callback, NET_CONNECTOR_TIMEOUT, id);
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+void Connector::on_disconnect(connection::Basic *connection) {
+  for (size_t i = 0; i < targets_.size(); ++i) {
+    if (targets_[i].connectionid != connection->get_id()) continue;
+    targets_[i].connectionid = ID_INVALID;
+    reconnect_later(static_cast<int32_t>(i));
+    break;
+  }
+}
+
+void Connector::connect_start(const std::string &ip, 
+                              uint16_t port, 
+                              connect_callback_t callback,
+                              uint32_t timeout,
+                              int32_t target) {
+  uint8_t step = 0;
+  bool result = false;
+  uint32_t error = 0;
+  pf_net::connection::Basic *connection{nullptr};
+  pf_net::socket::Basic *socket{nullptr};
+  if (!checkpool()) {
+    step = 1;
+    goto EXCEPTION;
+  }
+  connection = pool_->create(true);
+  if (is_null(connection)) {
+    step = 2;
+    goto EXCEPTION;
+  }
+  if (!connection->init(protocol())) {
+    step = 3;
     goto EXCEPTION;
   }
-  result = add(connection);
+  socket = connection->socket();
+  result = socket->create(socket_family(port)) && 
+           socket->set_nonblocking() && socket->set_linger(0);
   if (!result) {
-    step = 6;
+    step = 4;
     goto EXCEPTION;
   }
-  _remove = true;
-  connection->set_disconnect(false); //Success.
-  SLOW_LOG(NET_MODULENAME,
-           "[net.connection.manager] (Connector::connect) success!"
-           " ip: %s, port: %d",
-           ip,
-           port);
-  return connection;
+  connecting_[connection->get_id()] = {callback, target, false};
+  if (socket->connect(ip.c_str(), port)) {
+    connect_finish(connection, true);
+    return;
+  }
+  //Wait the socket writable, then check the error(SO_ERROR).
+  error = socket->get_last_error_code();
+#if OS_WIN
+  if (error != WSAEWOULDBLOCK) {
+#else
+  if (error != EINPROGRESS) {
+#endif
+    connect_finish(connection, false);
+    return;
+  }
+  if (!connect_watch(connection, true)) {
+    connect_finish(connection, false);
+    return;
+  }
+  connecting_[connection->get_id()].watched = true;
+  timer_set(connection, kConnectionTimerConnect, timeout);
+  return;
 EXCEPTION:
   SLOW_WARNINGLOG(NET_MODULENAME,
-                  "[net.connection.manager] (Connector::connect) failed!"
+                  "[net.connection.manager] (Connector::connect_start) failed!"
                   " ip: %s, port: %d, step: %d",
-                  ip,
+                  ip.c_str(),
                   port,
                   step);
-  if (_remove) {
-    remove(connection);
-  } else {
-    pool_->remove(connection->get_id());
+  if (!is_null(connection)) pool_->remove(connection->get_id());
+  if (target >= 0) {
+    ++targets_[target].failures;
+    reconnect_later(target);
+  } else if (callback) {
+    callback(nullptr);
   }
-  return nullptr;
 }
 
-pf_net::connection::Basic *
-Connector::group_connect(const char *ip, uint16_t port) {
-  if (!checkpool()) return nullptr;
-  uint8_t step = 0;
-  bool result = false;
-  bool _remove = false;
-  bool closesocket = false;
-  pf_net::connection::Basic *connection = pool_->create(true);
-  if (nullptr == connection) return nullptr;
-  if (!connection->init(protocol())) return nullptr;
-  pf_net::socket::Basic *socket = connection->socket();
-  try {
-    result = socket->create();
-    if (!result) {
-      step = 1;
-      goto EXCEPTION;
-    }
-    result = socket->set_nonblocking();
-    if (!result) {
-      step = 2;
-      goto EXCEPTION;
-    }
-    result = socket->connect(ip, port);
-    if (!result) {
-      step = 3;
-      struct timeval tm;
-      fd_set readset, writeset;
-      tm.tv_sec = 10;
-      tm.tv_usec = 0;
-      FD_ZERO(&readset);
-      FD_SET(socket->get_id(), &readset);
-      writeset = readset;
-      int32_t _result = 0;
-      _result = 
-        socket->select(socket->get_id() + 1, &readset, &writeset, nullptr, &tm);
-      closesocket = true;
-      if (0 == _result) { //连接超时
-        step = 4;
-        goto EXCEPTION;
-      }
-      //如果描述符变为可读或可写，就调用get_sockopt取得套接字的待处理错误
-      if (FD_ISSET(socket->get_id(), &readset) || 
-          FD_ISSET(socket->get_id(), &writeset)) {
-        uint32_t length = sizeof(_result);
-        if (!pf_net::socket::api::getsockopt_exb(
-              socket->get_id(), SOL_SOCKET, SO_ERROR, &result, &length)) {
-          step = 5;
-          goto EXCEPTION;
-        }
-        if (_result != 0) {
-          step = 6;
-          goto EXCEPTION;
-        }
-      }
-    }
-    result = socket->set_nonblocking();
-    if (!result) {
-      step = 7;
-      goto EXCEPTION;
-    }
-    result = socket->set_linger(0);
-    if (!result) {
-      step = 8;
-      goto EXCEPTION;
-    }
-  } catch (...) {
-    step = 9;
-    goto EXCEPTION;
-  }
-  result = add(connection); //加入到管理器
-  if (!result) {
-    step = 10;
-    goto EXCEPTION;
-  }
-  connection->set_disconnect(false); //Success.
-  _remove = true;
-  SLOW_LOG(NET_MODULENAME,
-           "[net.connection.manager] (Connector::group_connect) success!"
-           " ip: %s, port: %d",
-           ip,
-           port);
-  return connection;
-EXCEPTION:
-  SLOW_WARNINGLOG(
-      NET_MODULENAME,
-      "[net.connection.manager] (Connector::group_connect) failed!"
-      " ip: %s, port: %d, step: %d",
-      ip,
-      port,
-      step);
-  if (closesocket) socket->close();
-  if (_remove) {
-    remove(connection);
+void Connector::connect_finish(connection::Basic *connection, bool success) {
+  auto it = connecting_.find(connection->get_id());
+  if (it == connecting_.end()) return;
+  connecting_t connecting = it->second;
+  connecting_.erase(it);
+  timer_cancel(connection, kConnectionTimerConnect);
+  if (connecting.watched) connect_watch(connection, false);
+  if (success) success = add(connection);
+  if (success) {
+    SLOW_LOG(NET_MODULENAME,
+             "[net.connection.manager] (Connector::connect_finish) success!"
+             " ip: %s, port: %d",
+             connection->socket()->host(),
+             connection->socket()->port());
   } else {
+    SLOW_WARNINGLOG(NET_MODULENAME,
+                    "[net.connection.manager] (Connector::connect_finish)"
+                    " failed! ip: %s, port: %d",
+                    connection->socket()->host(),
+                    connection->socket()->port());
     pool_->remove(connection->get_id());
+    connection = nullptr;
+  }
+  if (connecting.target >= 0) {
+    target_t &target = targets_[connecting.target];
+    if (is_null(connection)) {
+      ++target.failures;
+      reconnect_later(connecting.target);
+      return;
+    }
+    target.failures = 0;
+    target.connectionid = connection->get_id();
   }
-  return nullptr;
+  if (connecting.callback) connecting.callback(connection);
+}
+
+bool Connector::connect_ready(connection::Basic *connection) {
+  if (connecting_.find(connection->get_id()) == connecting_.end()) 
+    return false;
+  int32_t error = 0;
+  uint32_t length = sizeof(error);
+  bool result = pf_net::socket::api::getsockopt_exb(
+      connection->socket()->get_id(), SOL_SOCKET, SO_ERROR, &error, &length);
+  connect_finish(connection, result && 0 == error);
+  return true;
+}
+
+void Connector::reconnect_later(int32_t target) {
+  //Exponential backoff with equal jitter(half fixed and half random), so the
+  //reconnects of many clients will not in step.
+  auto shift = min(targets_[target].failures, static_cast<uint32_t>(16));
+  uint64_t delay = static_cast<uint64_t>(NET_CONNECTOR_BACKOFF_MIN) << shift;
+  if (delay > NET_CONNECTOR_BACKOFF_MAX) delay = NET_CONNECTOR_BACKOFF_MAX;
+  auto half = delay / 2;
+  delay = half + random_() % (half + 1);
+  timer_add(kManagerTimerReconnect, target, static_cast<uint32_t>(delay));
 }
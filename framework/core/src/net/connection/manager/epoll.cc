@@ -4,13 +4,15 @@
 
 #if OS_UNIX && defined(PF_OPEN_EPOLL)
 
+#include <sys/eventfd.h>
+
 namespace pf_net {
 
 namespace connection {
 
 namespace manager {
 
-Epoll::Epoll() {
+Epoll::Epoll() : wakeup_fd_{SOCKET_INVALID}, wakeup_pending_{false} {
   polldata_.fd = ID_INVALID;
   polldata_.maxcount = 0;
   polldata_.result_eventcount = 0;
@@ -20,9 +22,10 @@ Epoll::Epoll() {
 
 Epoll::~Epoll() {
   poll_destory(polldata_);
+  if (wakeup_fd_ != SOCKET_INVALID) pf_file::api::closeex(wakeup_fd_);
 }
 
-bool Epoll::init(uint16_t connectionmax) {
+bool Epoll::init(uint32_t connectionmax) {
   if (!poll_set_max_size(connectionmax)) return false;
   if (!Interface::init(connectionmax)) return false;
   return true;
@@ -31,7 +34,9 @@ bool Epoll::init(uint16_t connectionmax) {
 bool Epoll::select() {
   int32_t result = SOCKET_ERROR;
   try {
-    poll_wait(polldata_, 0);
+    poll_wait(polldata_, wait_timeout_);
+    if (polldata_.result_eventcount < 0 && EINTR == errno)
+      polldata_.result_eventcount = 0;
     if (polldata_.result_eventcount > polldata_.maxcount || 
         polldata_.result_eventcount < 0) {
       char message[128] = {0};
@@ -50,18 +55,34 @@ bool Epoll::select() {
   return true;
 }
 
-bool Epoll::poll_set_max_size(uint16_t _max_size) {
+bool Epoll::poll_set_max_size(uint32_t _max_size) {
   if (polldata_.fd > 0) return true;
-  bool result = poll_create(polldata_, _max_size) > 0 ? true : false;
+  bool result = poll_create(polldata_, static_cast<int32_t>(_max_size)) > 0 ? true : false;
   if (!result) return false;
-  if (is_service()) {
-    if (ID_INVALID == listener_socket_id()) return false;
-    poll_add(polldata_, listener_socket_id(), EPOLLIN, ID_INVALID);
+  wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (SOCKET_INVALID == wakeup_fd_ ||
+      poll_add(polldata_, wakeup_fd_, EPOLLIN, ID_INVALID) != 0) {
+    SLOW_ERRORLOG(NET_MODULENAME, 
+                  "[net.connection.manager] (Epoll::poll_set_max_size)"
+                  " eventfd error, message: %s", 
+                  strerror(errno));
+    return false;
   }
+  //The listener shard without socket accept the connections by hand off.
+  if (is_service() && listener_socket_id() != SOCKET_INVALID)
+    poll_add(polldata_, listener_socket_id(), EPOLLIN, ID_INVALID);
   return true;
 }
 
-bool Epoll::socket_add(int32_t socket_id, int16_t connection_id) {
+void Epoll::wakeup() {
+  //Write once until the select drain it.
+  if (SOCKET_INVALID == wakeup_fd_ || wakeup_pending_.exchange(true)) return;
+  uint64_t value{1};
+  auto result = ::write(wakeup_fd_, &value, sizeof(value));
+  UNUSED(result);
+}
+
+bool Epoll::socket_add(int32_t socket_id, int32_t connection_id) {
   if (fdsize_ > polldata_.maxcount) {
     Assert(false);
     return false;
@@ -105,20 +126,25 @@ bool Epoll::socket_remove(int32_t socket_id) {
 
 bool Epoll::process_input() {
   using namespace pf_basic;
-  uint16_t i;
-  uint16_t accept_count{0};
+  int32_t i;
   for (i = 0; i < polldata_.result_eventcount; ++i) {
     //接受新连接的时候至少尝试两次，所以连接池里会多创建一个
     int32_t socket_id = static_cast<int32_t>(
         util::get_highsection(polldata_.events[i].data.u64));
-    int16_t connection_id = static_cast<int16_t>(
+    int32_t connection_id = static_cast<int32_t>(
         util::get_lowsection(polldata_.events[i].data.u64));
-    if (socket_id != SOCKET_INVALID && 
-        socket_id == listener_socket_id() && 
-        accept_count < onestep_accept_ ) {
-      accept();
-      ++accept_count;
-    } else if (polldata_.events[i].events & EPOLLIN) {
+    if (socket_id == wakeup_fd_) {
+      uint64_t value{0};
+      auto result = ::read(wakeup_fd_, &value, sizeof(value));
+      UNUSED(result);
+      wakeup_pending_ = false; //The works after it will run in this tick.
+      continue;
+    }
+    if (socket_id != SOCKET_INVALID && socket_id == listener_socket_id()) {
+      //Drain the backlog(level triggered), the -1 is no limit.
+      accept_batch(static_cast<uint32_t>(onestep_accept_));
+    } else if (polldata_.events[i].events & 
+               (EPOLLIN | EPOLLOUT | EPOLLERR | EPOLLHUP)) {
       connection::Basic *connection = nullptr;
       if (ID_INVALID == connection_id) {
         SLOW_WARNINGLOG(NET_MODULENAME, 
@@ -133,6 +159,7 @@ bool Epoll::process_input() {
                         " nullptr == connection, id: %d", connection_id);
         continue;
       }
+      if (connect_ready(connection)) continue;
       if (connection->is_disconnect()) continue;
       //int32_t socket_id = connection->socket()->get_id();
       if (SOCKET_INVALID == socket_id) {
@@ -142,6 +169,14 @@ bool Epoll::process_input() {
                       connection_id);
         return false;
       }
+      //The blocked output can send now, unwatch and flush it in next tick.
+      if ((polldata_.events[i].events & EPOLLOUT) && 
+          connection->is_dirty(kDirtyFlagWritable)) {
+        connection->set_dirty(kDirtyFlagWritable, false);
+        output_wait(connection, false);
+        output_dirty(connection);
+      }
+      if (!(polldata_.events[i].events & EPOLLIN)) continue;
       if (connection->socket()->error()) {
         pf_basic::io_cerr("connection->socket()->error()");
         remove(connection);
@@ -152,6 +187,7 @@ bool Epoll::process_input() {
             remove(connection);
           } else {
             receive_bytes_ += connection->get_receive_bytes();
+            input_dirty(connection);
           }
         } catch(...) {
           pf_basic::io_cerr("connection catch");
@@ -164,66 +200,64 @@ bool Epoll::process_input() {
 }
 
 bool Epoll::process_output() {
-  uint16_t i;
-  uint16_t _size = size();
-  for (i = 0; i < _size; ++i) {
-    if (ID_INVALID == connection_idset_[i]) continue;
-    connection::Basic* connection = nullptr;
-    connection = pool_->get(connection_idset_[i]);
-    Assert(connection);
-    if (connection->socket()->error()) {
-      char msg[1024]{0};
-      connection->socket()->get_last_error_message(msg, sizeof(msg) - 1);
-      pf_basic::io_cerr("msg: %s", msg);
-      throw 1;
-      pf_basic::io_cerr("connection->socket()->error() 1");
-      remove(connection);
-    } else {
-      try {
-        if (!connection->process_output()) { 
-          pf_basic::io_cerr("!connection->process_output()");
-          remove(connection);
-        } else {
-          send_bytes_ += connection->get_send_bytes();
-        }
-      } catch(...) {
-        remove(connection);
-      }
-    } //connection->socket()->error()
+  return process_output_dirty();
+}
+
+bool Epoll::output_wait(connection::Basic *connection, bool wait) {
+  //Only the blocked connection watch EPOLLOUT, the idle not wake the wait.
+  int32_t mask = wait ? EPOLLIN | EPOLLOUT | EPOLLET : EPOLLIN | EPOLLET;
+  if (poll_mod(polldata_, 
+               connection->socket()->get_id(), 
+               mask, 
+               connection->get_id()) != 0) {
+    SLOW_ERRORLOG(NET_MODULENAME, 
+                  "[net.connection.manager] (Epoll::output_wait)"
+                  " error, message: %s", 
+                  strerror(errno));
+    return false;
   }
   return true;
 }
 
-bool Epoll::process_exception() {
+bool Epoll::connect_watch(connection::Basic *connection, bool watch) {
+  int32_t socket_id = connection->socket()->get_id();
+  if (SOCKET_INVALID == socket_id) return false;
+  //The socket add again with input events after connected.
+  auto result = watch ? 
+    poll_add(polldata_, socket_id, EPOLLOUT, connection->get_id()) :
+    poll_delete(polldata_, socket_id);
+  if (result != 0) {
+    SLOW_ERRORLOG(NET_MODULENAME, 
+                  "[net.connection.manager] (Epoll::connect_watch)"
+                  " error, message: %s", 
+                  strerror(errno));
+    return false;
+  }
   return true;
 }
 
-bool Epoll::process_command() {
-  uint16_t i;
-  uint16_t _size = size();
-  for (i = 0; i < _size; ++i) {
-    if (ID_INVALID == connection_idset_[i]) continue;
-    connection::Basic* connection = nullptr;
-    connection = pool_->get(connection_idset_[i]);
-    Assert(connection);
-    if (connection->is_disconnect()) continue;
-    int32_t socket_id = connection->socket()->get_id();
-    if (listener_socket_id() == socket_id) continue;
-    if (connection->socket()->error()) {
-      remove(connection);
-    } else { //connection is ok
-      try {
-        if (!connection->process_command()) {
-          remove(connection);
-        }
-      } catch(...) {
-        remove(connection);
-      }
-    } //connection->getsocket()->iserror()
+bool Epoll::accept_watch(bool on) {
+  if (listener_socket_id() == SOCKET_INVALID) return true;
+  //Leave the sockets in backlog, the kernel stop the storm by it.
+  int32_t mask = on ? EPOLLIN : 0;
+  if (poll_mod(polldata_, listener_socket_id(), mask, ID_INVALID) != 0) {
+    SLOW_ERRORLOG(NET_MODULENAME, 
+                  "[net.connection.manager] (Epoll::accept_watch)"
+                  " error, message: %s", 
+                  strerror(errno));
+    return false;
   }
   return true;
 }
 
+bool Epoll::process_exception() {
+  return true;
+}
+
+bool Epoll::process_command() {
+  return process_command_dirty();
+}
+
 bool Epoll::heartbeat(uint32_t time) {
   bool result = Interface::heartbeat(time);
   return result;
@@ -1,6 +1,9 @@
 #include "pf/basic/logger.h"
+#include "pf/basic/time_manager.h"
 #include "pf/sys/thread.h"
 #include "pf/net/packet/factorymanager.h"
+#include "pf/net/stream/buffer.h"
+#include "pf/net/connection/executor.h"
 #include "pf/net/connection/manager/interface.h"
 
 namespace pf_net {
@@ -21,21 +24,30 @@ Interface::Interface() :
   onestep_accept_{NET_ONESTEP_ACCEPT_DEFAULT},
   pool_{nullptr},
   callback_disconnect_{nullptr},
-  callback_connect_{nullptr} {
+  callback_connect_{nullptr},
+  wait_time_{0},
+  wait_timeout_{0},
+  coalesce_deadline_{0},
+  kick_time_{0},
+  keepalive_time_{NET_MANAGER_KEEPALIVE_TIME},
+  heartbeat_tick_{false},
+  handshakes_{0},
+  executor_{nullptr} {
 }
 
 Interface::~Interface() {
+  if (executor_) executor_->detach(this);
   safe_delete_array(connection_idset_);
 }
 
-bool Interface::init(uint16_t maxcount) {
+bool Interface::init(uint32_t maxcount) {
   if (is_ready()) return true; //有内存分配的请参考此方式避免再次分配内存
   size_ = 0;
   max_size_ = maxcount;
-  connection_idset_ = new int16_t[max_size_];
+  connection_idset_ = new int32_t[max_size_];
   Assert(connection_idset_);
   if (is_null(connection_idset_)) return false;
-  memset(connection_idset_, ID_INVALID, sizeof(int16_t) * max_size_);
+  memset(connection_idset_, ID_INVALID, sizeof(int32_t) * max_size_);
   auto pool = new connection::Pool();
   if (is_null(pool)) return false;
   std::unique_ptr<connection::Pool> pointer{pool};
@@ -51,15 +63,19 @@ bool Interface::init(uint16_t maxcount) {
   if (is_null(NET_PACKET_FACTORYMANAGER_POINTER)) return false;
   if (!NET_PACKET_FACTORYMANAGER_POINTER->init()) return false;
   if (!pool_init(maxcount)) return false;
+  if (!cache_.init(NET_MANAGER_CACHE_SIZE)) return false;
+  auto now = 
+    is_null(TIME_MANAGER_POINTER) ? 0 : TIME_MANAGER_POINTER->get_tickcount();
+  wheel_.init(NET_MANAGER_TIMER_PRECISION, now);
   ready_ = true;
   return true;
 }
 
-bool Interface::pool_init(uint16_t connectionmax) {
+bool Interface::pool_init(uint32_t connectionmax) {
   if (is_null(pool_)) return false;
   connection_max_size_ = connectionmax;
+  //The connections construct on first use.
   if (!pool_->init(connection_max_size_)) return false;
-  if (!pool_->create_default_connections()) return false;
   return true;
 }
 
@@ -95,12 +111,24 @@ bool Interface::add(connection::Basic *connection) {
   }
   connection->set_disconnect(false); //connect is success
   connection->set_empty(false);      //Pool use flag.
+  connection->set_manager(this);
+  connection->set_alive(true);
+  //The idle time can be changed in runtime, so check it even if off.
+  auto idle = stream::buffer::idle_time();
+  timer_set(connection, 
+            kConnectionTimerIdle, 
+            idle > 0 ? idle : NET_STREAM_BUFFER_IDLE_TIME);
+  if (kick_time_ > 0) timer_set(connection, kConnectionTimerKick, kick_time_);
+  if (keepalive_time_ > 0)
+    timer_set(connection, kConnectionTimerKeepalive, keepalive_time_);
+  //The data written before add.
+  if (connection->output_pending()) output_dirty(connection);
   on_connect(connection);
   if (!is_null(callback_connect_)) callback_connect_(connection);
   return true;
 }
 
-bool Interface::remove(int16_t id) {
+bool Interface::remove(int32_t id) {
   Assert(size_ > 0);
   connection::Basic *connection = nullptr;
   connection = pool_->get(id);
@@ -108,15 +136,21 @@ bool Interface::remove(int16_t id) {
     Assert(false);
     return false;
   }
-  int16_t managerid = connection->get_managerid();
-  if (managerid >= static_cast<int16_t>(size_)) {
+  int32_t managerid = connection->get_managerid();
+  if (managerid < 0 || managerid >= static_cast<int32_t>(size_)) {
     Assert(false);
     return false;
   }
+  if (!memberships_.empty()) group_leave(id);
+  for (uint8_t kind = 0; kind < kConnectionTimerMax; ++kind)
+    timer_cancel(connection, kind);
+  //The ids left in dirty lists will skip by the flags.
+  connection->set_dirty(kDirtyFlagAll, false);
+  connection->set_manager(nullptr);
   //Swap last.
   --size_;
   connection_idset_[managerid] = ID_INVALID;
-  if (size_ != managerid) {
+  if (size_ != static_cast<uint32_t>(managerid)) {
     auto lastid = connection_idset_[size_];
     connection = pool_->get(lastid);
     connection_idset_[managerid] = lastid;
@@ -141,6 +175,7 @@ bool Interface::erase(connection::Basic *connection) {
 }
 
 bool Interface::remove(connection::Basic *connection) {
+  if (executor_) executor_->cancel(this, connection->get_id());
   on_disconnect(connection);
   if (!is_null(callback_disconnect_)) callback_disconnect_(connection);
   if (!erase(connection)) return false; 
@@ -149,7 +184,7 @@ bool Interface::remove(connection::Basic *connection) {
 }
 
 bool Interface::destroy() {
-  uint16_t i = 0;
+  uint32_t i = 0;
   for (i = 0; i < size_; ++i) {
     if (ID_INVALID == connection_idset_[i]) {
       SLOW_ERRORLOG(NET_MODULENAME, 
@@ -171,15 +206,39 @@ bool Interface::destroy() {
   return false;
 }
 
-connection::Basic *Interface::get(int16_t id) {
-  if (id < 0 || id > max_size_) return nullptr;
-  connection::Basic *connection = nullptr;
-  connection = pool_->get(id);
-  Assert(connection);
-  return connection;
+bool Interface::timer_set(connection::Basic *connection, 
+                          uint8_t kind, 
+                          uint32_t delay) {
+  if (kind >= kConnectionTimerMax) return false;
+  timer_cancel(connection, kind);
+  auto id = timer_add(kind, connection->get_id(), delay);
+  connection->set_timer(kind, id);
+  if (kConnectionTimerHandshake == kind && id != 0) ++handshakes_;
+  return id != 0;
 }
 
-int16_t* Interface::get_idset() {
+uint64_t Interface::timer_add(uint8_t kind, int32_t id, uint32_t delay) {
+  //The data is [kind:32][id:32].
+  uint64_t data = 
+    (static_cast<uint64_t>(kind) << 32) | static_cast<uint32_t>(id);
+  return wheel_.add(delay, data);
+}
+
+void Interface::timer_cancel(connection::Basic *connection, uint8_t kind) {
+  if (kind >= kConnectionTimerMax) return;
+  auto id = connection->timer(kind);
+  if (0 == id) return;
+  wheel_.cancel(id);
+  connection->set_timer(kind, 0);
+  if (kConnectionTimerHandshake == kind) --handshakes_;
+}
+
+connection::Basic *Interface::get(int32_t id) {
+  if (id < 0 || is_null(pool_)) return nullptr;
+  return pool_->get(id);
+}
+
+int32_t* Interface::get_idset() {
   return connection_idset_;
 }
 
@@ -217,38 +276,218 @@ connection::Pool *Interface::get_pool() {
   return pool_.get();
 }
 
-connection::Basic *Interface::get(uint16_t id) {
-  connection::Basic *connection = nullptr;
-  if ((id > 0 && id < pool_->size()) || 0 == id) {
-    connection = pool_->get(id);
-    Assert(connection);
+bool Interface::send(packet::Interface *packet, 
+                     int32_t connectionid, 
+                     uint32_t flag) {
+  if (is_null(packet)) return false;
+  packet::queue_t item{packet, connectionid, flag};
+  //The queue is full, drop the packet(the manager own it as before), the 
+  //producers should slow down by the cache_pressure.
+  if (!cache_.push(std::move(item))) {
+    FAST_WARNINGLOG(NET_MODULENAME,
+                    "[net.connection.manager] (Interface::send) queue full,"
+                    " drop the packet: %d, connection: %d",
+                    packet->get_id(),
+                    connectionid);
+    if (NET_PACKET_FACTORYMANAGER_POINTER) {
+      item.packet = nullptr;
+      NET_PACKET_FACTORYMANAGER_POINTER->packet_remove(packet);
+    }
+    return false;
   }
-  return connection;
+  wakeup();
+  return true;
 }
 
-bool Interface::send(packet::Interface *packet, 
-                     uint16_t connectionid, 
-                     uint32_t flag) {
-  std::unique_lock<std::mutex> autolock(mutex_);
-  if (cache_.queue[cache_.tail].packet) {
-    bool result = cache_resize();
-    Assert(result);
+void Interface::set_executor(connection::Executor *executor) {
+  //The handlers of old executor may send with this manager.
+  if (executor_ && executor_ != executor) executor_->detach(this);
+  executor_ = executor;
+}
+
+void Interface::enqueue(std::function<void ()> task) {
+  {
+    std::unique_lock<std::mutex> autolock(task_mutex_);
+    tasks_.emplace_back(std::move(task));
+  }
+  wakeup();
+}
+
+bool Interface::process_tasks() {
+  std::vector< std::function<void ()> > tasks;
+  {
+    std::unique_lock<std::mutex> autolock(task_mutex_);
+    if (tasks_.empty()) return true;
+    tasks.swap(tasks_);
+  }
+  for (auto &task : tasks) {
+    try {
+      task();
+    } catch(...) {
+      SaveErrorLog();
+    }
   }
-  cache_.queue[cache_.tail].packet = packet;
-  cache_.queue[cache_.tail].connectionid = connectionid;
-  cache_.queue[cache_.tail].flag = flag;
-  ++cache_.tail;
-  if (cache_.tail > cache_.size) cache_.tail = 0;
   return true;
 }
+
+bool Interface::busy() {
+  if (!input_dirtys_.empty() || !output_dirtys_.empty()) return true;
+  {
+    std::unique_lock<std::mutex> autolock(task_mutex_);
+    if (!tasks_.empty()) return true;
+  }
+  return !cache_.empty();
+}
    
+void Interface::output_dirty(connection::Basic *connection) {
+  //The blocked connection will add by the writable event, but the overflow
+  //connection remove at once.
+  if (connection->is_dirty(kDirtyFlagOutput)) return;
+  if (connection->is_dirty(kDirtyFlagWritable) &&
+      !connection->output_overflow()) return;
+  //The coalescing output flush at the deadline, or the size reached(urgent).
+  if (connection->is_dirty(kDirtyFlagCoalesce) &&
+      !connection->output_overflow() && 
+      !connection->ostream().coalesce_full()) return;
+  connection->set_dirty(kDirtyFlagOutput);
+  output_dirtys_.push_back(connection->get_id());
+}
+
+void Interface::input_dirty(connection::Basic *connection) {
+  if (connection->is_dirty(kDirtyFlagInput)) return;
+  connection->set_dirty(kDirtyFlagInput);
+  input_dirtys_.push_back(connection->get_id());
+}
+
+bool Interface::process_output_dirty() {
+  process_coalesce_dirty();
+  if (output_dirtys_.empty()) return true;
+  dirtys_.swap(output_dirtys_);
+  uint64_t now{0};
+  for (int32_t id : dirtys_) {
+    connection::Basic *connection = pool_->get(id);
+    if (is_null(connection) || !connection->is_dirty(kDirtyFlagOutput)) 
+      continue;
+    connection->set_dirty(kDirtyFlagOutput, false);
+    if (connection->is_disconnect()) continue;
+    if (connection->socket()->error() || output_overflow(connection)) {
+      remove(connection);
+      continue;
+    }
+    if (output_coalesce(connection, now)) continue;
+    try {
+      if (!connection->process_output()) {
+        remove(connection);
+        continue;
+      }
+      send_bytes_ += connection->get_send_bytes();
+      //Not all sent, the socket buffer is full(EAGAIN).
+      if (connection->output_pending()) {
+        connection->set_dirty(kDirtyFlagWritable);
+        if (!output_wait(connection, true)) remove(connection);
+      }
+    } catch(...) {
+      remove(connection);
+    }
+  }
+  dirtys_.clear();
+  return true;
+}
+
+void Interface::process_coalesce_dirty() {
+  coalesce_deadline_ = 0;
+  if (coalesce_dirtys_.empty()) return;
+  auto now = stream::Output::coalesce_now();
+  size_t count{0};
+  for (int32_t id : coalesce_dirtys_) {
+    connection::Basic *connection = pool_->get(id);
+    if (is_null(connection) || !connection->is_dirty(kDirtyFlagCoalesce))
+      continue;
+    //The size reached and flushed(output_dirty) not need wait.
+    auto wait = connection->output_pending() ?
+                connection->ostream().coalesce_wait(now) : 0;
+    if (wait > 0) {
+      coalesce_dirtys_[count++] = id;
+      if (0 == coalesce_deadline_ || now + wait < coalesce_deadline_)
+        coalesce_deadline_ = now + wait;
+      continue;
+    }
+    connection->set_dirty(kDirtyFlagCoalesce, false);
+    if (connection->output_pending()) output_dirty(connection);
+  }
+  coalesce_dirtys_.resize(count);
+}
+
+bool Interface::output_coalesce(connection::Basic *connection, uint64_t &now) {
+  auto &stream = connection->ostream();
+  if (!stream.coalesce() || stream.coalesce_full()) return false;
+  if (0 == now) now = stream::Output::coalesce_now();
+  auto wait = stream.coalesce_wait(now);
+  if (0 == wait) return false;
+  if (!connection->is_dirty(kDirtyFlagCoalesce)) {
+    connection->set_dirty(kDirtyFlagCoalesce);
+    coalesce_dirtys_.push_back(connection->get_id());
+  }
+  if (0 == coalesce_deadline_ || now + wait < coalesce_deadline_)
+    coalesce_deadline_ = now + wait;
+  return true;
+}
+
+uint32_t Interface::coalesce_timeout() const {
+  if (0 == coalesce_deadline_) return static_cast<uint32_t>(-1);
+  auto now = stream::Output::coalesce_now();
+  if (coalesce_deadline_ <= now) return 0;
+  return static_cast<uint32_t>((coalesce_deadline_ - now + 999) / 1000);
+}
+
+bool Interface::output_overflow(connection::Basic *connection) {
+  if (!connection->output_overflow()) return false;
+  SLOW_WARNINGLOG(NET_MODULENAME,
+                  "[net.connection.manager] (Interface::output_overflow)"
+                  " the output over budget, id: %d size: %u",
+                  connection->get_id(),
+                  connection->output_size());
+  return true;
+}
+
+bool Interface::process_command_dirty() {
+  if (input_dirtys_.empty()) return true;
+  dirtys_.swap(input_dirtys_);
+  for (int32_t id : dirtys_) {
+    connection::Basic *connection = pool_->get(id);
+    if (is_null(connection) || !connection->is_dirty(kDirtyFlagInput)) 
+      continue;
+    connection->set_dirty(kDirtyFlagInput, false);
+    if (connection->is_disconnect()) continue;
+    //Execute again when the output drained(connection::Basic::output_update).
+    if (connection->output_throttled()) continue;
+    if (connection->socket()->error()) {
+      remove(connection);
+      continue;
+    }
+    try {
+      if (!connection->process_command()) {
+        remove(connection);
+      } else if (connection->command_pending()) {
+        input_dirty(connection); //Execute the left in next tick.
+      }
+    } catch(...) {
+      remove(connection);
+    }
+  }
+  dirtys_.clear();
+  return true;
+}
+
 bool Interface::process_command_cache() {
   bool result = false;
   if (!NET_PACKET_FACTORYMANAGER_POINTER) return result;
   uint32_t _result = kPacketExecuteStatusContinue;
-  for (uint32_t i = 0; i < cache_.size; ++i) {
+  //Drain a queue at most in one tick, the producers push in the meantime.
+  auto count = cache_.capacity();
+  for (decltype(count) i = 0; i < count; ++i) {
     packet::Interface *packet = nullptr;
-    uint16_t connectionid = static_cast<uint16_t>(ID_INVALID);
+    int32_t connectionid = ID_INVALID;
     uint32_t flag = kPacketFlagNone;
     bool needremove = true;
     result = recv(packet, connectionid, flag);
@@ -263,8 +502,7 @@ bool Interface::process_command_cache() {
       break;
     }
     
-    int32_t _connectionid = static_cast<int32_t>(connectionid);
-    if (ID_INVALID == _connectionid || ID_INVALID_EX == _connectionid) {
+    if (ID_INVALID == connectionid || ID_INVALID_EX == connectionid) {
       try {
         packet->execute(nullptr);
       } catch (...) {
@@ -313,13 +551,12 @@ bool Interface::process_command_cache() {
           default:
             break;
         }
-      } else {
-        SLOW_ERRORLOG(NET_MODULENAME,
-                      "[net.connection.manager] (Interface::process_command_cache)"
-                      " the connection is nullptr id: %d, packet id: %d",
-                      connectionid,
-                      packet->get_id());
-        Assert(false);
+      } else { //The connection closed(stale handle).
+        SLOW_WARNINGLOG(NET_MODULENAME,
+                        "[net.connection.manager] (Interface::process_command_cache)"
+                        " the connection is nullptr id: %d, packet id: %d",
+                        connectionid,
+                        packet->get_id());
       }
     }
     if (needremove) NET_PACKET_FACTORYMANAGER_POINTER->packet_remove(packet);
@@ -328,57 +565,101 @@ bool Interface::process_command_cache() {
 }
 
 bool Interface::recv(packet::Interface *&packet, 
-                     uint16_t &connectionid, 
+                     int32_t &connectionid, 
                      uint32_t &flag) {
-  std::unique_lock<std::mutex> autolock(mutex_);
-  if (is_null(cache_.queue[cache_.head].packet)) return false;
-  packet = cache_.queue[cache_.head].packet;
-  connectionid = cache_.queue[cache_.head].connectionid;
-  flag = cache_.queue[cache_.head].flag;
-  cache_.queue[cache_.head].packet = nullptr;
-  cache_.queue[cache_.head].connectionid = static_cast<uint16_t>(ID_INVALID);
-  cache_.queue[cache_.head].flag = kPacketFlagNone;
-  ++cache_.head;
-  if (cache_.head > cache_.size) cache_.head = 0;
+  packet::queue_t item;
+  if (!cache_.pop(item)) return false;
+  packet = item.packet;
+  connectionid = item.connectionid;
+  flag = item.flag;
+  item.packet = nullptr;
   return true;
 }
    
-bool Interface::cache_resize() {
-  packet::queue_t *queuenew = 
-    new packet::queue_t[cache_.size + NET_MANAGER_CACHE_SIZE];
-  if (is_null(queuenew)) return false;
-  if (cache_.head < cache_.tail) {
-    memcpy(queuenew, 
-           &(cache_.queue[cache_.head]), 
-           sizeof(packet::queue_t) * (cache_.tail - cache_.head));
-  } else {
-    memcpy(queuenew, 
-           &(cache_.queue[cache_.head]), 
-           sizeof(packet::queue_t) * (cache_.size - cache_.head));
-    memcpy(&queuenew[cache_.size - cache_.head], 
-           cache_.queue, 
-           sizeof(packet::queue_t) * cache_.tail);
+void Interface::broadcast(packet::Interface *packet) {
+  broadcast(packet, connection_idset_, size_);
+}
+
+void Interface::broadcast(packet::Interface *packet, 
+                          const int32_t *ids, 
+                          size_t count) {
+  //Encode with the first connection protocol, the connections with same 
+  //protocol just copy it(the index and encrypt in protocol send).
+  protocol::Interface *encoder{nullptr};
+  std::string buffer;
+  bool encoded{false};
+  for (size_t i = 0; i < count; ++i) {
+    if (ID_INVALID == ids[i]) continue;
+    auto connection = get(ids[i]);
+    if (is_null(connection) || connection->is_disconnect()) continue;
+    auto protocol = connection->get_protocol();
+    if (is_null(encoder) && !is_null(protocol)) {
+      encoder = protocol;
+      encoded = encoder->encode(packet, buffer);
+    }
+    if (encoded && protocol == encoder) {
+      connection->send(buffer.data(), static_cast<uint32_t>(buffer.size()));
+    } else {
+      connection->send(packet);
+    }
   }
-  memset(cache_.queue, 0, sizeof(packet::queue_t) * cache_.size);
-  safe_delete_array(cache_.queue);
-  cache_.queue = queuenew;
-  cache_.head = 0;
-  cache_.tail = cache_.size;
-  cache_.size = cache_.size + NET_MANAGER_CACHE_SIZE;
-  FAST_DEBUGLOG(NET_MODULENAME,
-                "[net.connection.manager] (Interface::cache_resize)"
-                " from: %d, to: %d",
-                cache_.size - NET_MANAGER_CACHE_SIZE,
-                cache_.size);
+}
+
+bool Interface::group_join(const std::string &name, int32_t id) {
+  if (is_null(pool_->get(id))) return false;
+  auto &group = groups_[name];
+  if (!group.indexes.emplace(id, group.ids.size()).second) return true;
+  group.ids.push_back(id);
+  memberships_[id].insert(name);
   return true;
 }
 
-void Interface::broadcast(packet::Interface *packet) {
-  for (int32_t i = 0; i < size_; ++i) {
-    if (ID_INVALID == connection_idset_[i]) continue;
-    auto connection = get(connection_idset_[i]);
-    if (connection) connection->send(packet);
+bool Interface::group_leave(const std::string &name, int32_t id) {
+  auto it = groups_.find(name);
+  if (it == groups_.end() || !group_erase(it, id)) return false;
+  auto membership = memberships_.find(id);
+  if (membership != memberships_.end()) {
+    membership->second.erase(name);
+    if (membership->second.empty()) memberships_.erase(membership);
   }
+  return true;
+}
+
+void Interface::group_leave(int32_t id) {
+  auto membership = memberships_.find(id);
+  if (membership == memberships_.end()) return;
+  for (auto &name : membership->second) {
+    auto it = groups_.find(name);
+    if (it != groups_.end()) group_erase(it, id);
+  }
+  memberships_.erase(membership);
+}
+
+bool Interface::group_erase(
+    std::unordered_map<std::string, group_struct>::iterator it, int32_t id) {
+  auto &group = it->second;
+  auto index = group.indexes.find(id);
+  if (index == group.indexes.end()) return false;
+  //Move the last to the position of id.
+  auto last = group.ids.back();
+  group.ids[index->second] = last;
+  group.indexes[last] = index->second;
+  group.ids.pop_back();
+  group.indexes.erase(id);
+  if (group.ids.empty()) groups_.erase(it);
+  return true;
+}
+
+void Interface::group_broadcast(const std::string &name, 
+                                packet::Interface *packet) {
+  auto it = groups_.find(name);
+  if (it == groups_.end()) return;
+  broadcast(packet, it->second.ids.data(), it->second.ids.size());
+}
+
+size_t Interface::group_size(const std::string &name) const {
+  auto it = groups_.find(name);
+  return it == groups_.end() ? 0 : it->second.ids.size();
 }
 
 bool Interface::checkpool(bool log) {
@@ -0,0 +1,807 @@
+#include "pf/basic/logger.h"
+#include "pf/basic/util.h"
+#include "pf/file/api.h"
+#include "pf/net/connection/manager/iouring.h"
+
+#if OS_UNIX && defined(PF_OPEN_IOURING)
+
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <signal.h>
+#include <unordered_map>
+
+namespace pf_net {
+
+namespace connection {
+
+namespace manager {
+
+//The operations of the completions(in the user data).
+enum {
+  kUringOpAccept = 1,
+  kUringOpRecv = 2,
+  kUringOpWrite = 3,
+  kUringOpWakeup = 4,
+  kUringOpCancel = 5,
+  kUringOpConnect = 6,
+};
+
+//The connection slot(the fixed file index is the connection id index).
+typedef struct uringslot_struct uringslot_t;
+struct uringslot_struct {
+  uint32_t serial;      //Changed when the socket add or remove.
+  int32_t send_buffer;  //The send buffer in writing, -1 is none.
+  uint32_t send_offset;
+  uint32_t send_length;
+  uringslot_struct() :
+    serial{0},
+    send_buffer{-1},
+    send_offset{0},
+    send_length{0} {
+  };
+};
+
+struct uringdata_struct {
+  int32_t fd;
+  void *sq_ring;
+  size_t sq_ring_size;
+  void *cq_ring;
+  size_t cq_ring_size;
+  struct io_uring_sqe *sqes;
+  size_t sqes_size;
+  uint32_t *sq_head;
+  uint32_t *sq_tail;
+  uint32_t sq_mask;
+  uint32_t sq_entries;
+  uint32_t sq_local_tail;   //The prepared tail, publish in submit.
+  uint32_t *cq_head;
+  uint32_t *cq_tail;
+  uint32_t cq_mask;
+  struct io_uring_cqe *cqes;
+  struct io_uring_buf_ring *recv_ring;
+  size_t recv_ring_size;
+  char *recv_buffers;
+  uint16_t recv_tail;
+  char *send_buffers;
+  bool send_fixed;          //The send buffers is registered.
+  std::vector<uint16_t> send_frees;
+  std::vector<int32_t> send_waits;
+  std::vector<uringslot_t> slots;
+  std::unordered_map<int32_t, int32_t> sockets; //The socket id to connection.
+  uint32_t listener_slot;
+  uringdata_struct() :
+    fd{SOCKET_INVALID},
+    sq_ring{nullptr},
+    sq_ring_size{0},
+    cq_ring{nullptr},
+    cq_ring_size{0},
+    sqes{nullptr},
+    sqes_size{0},
+    sq_head{nullptr},
+    sq_tail{nullptr},
+    sq_mask{0},
+    sq_entries{0},
+    sq_local_tail{0},
+    cq_head{nullptr},
+    cq_tail{nullptr},
+    cq_mask{0},
+    cqes{nullptr},
+    recv_ring{nullptr},
+    recv_ring_size{0},
+    recv_buffers{nullptr},
+    recv_tail{0},
+    send_buffers{nullptr},
+    send_fixed{false},
+    listener_slot{0} {
+  };
+  ~uringdata_struct() {
+    if (fd != SOCKET_INVALID) close(fd);
+    if (sq_ring) munmap(sq_ring, sq_ring_size);
+    if (cq_ring && cq_ring != sq_ring) munmap(cq_ring, cq_ring_size);
+    if (sqes) munmap(sqes, sqes_size);
+    if (recv_ring) munmap(recv_ring, recv_ring_size);
+    if (recv_buffers) {
+      munmap(recv_buffers,
+             NET_IOURING_RECV_BUFFERS * NET_IOURING_RECV_BUFFER_SIZE);
+    }
+    if (send_buffers) {
+      munmap(send_buffers,
+             NET_IOURING_SEND_BUFFERS * NET_IOURING_SEND_BUFFER_SIZE);
+    }
+  };
+};
+
+/* The io_uring system calls(not use the liburing). */
+static inline int32_t uring_setup(uint32_t entries, io_uring_params *params) {
+  return static_cast<int32_t>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static inline int32_t uring_enter(int32_t fd,
+                                  uint32_t submit,
+                                  uint32_t complete,
+                                  uint32_t flags,
+                                  const void *arg,
+                                  size_t size) {
+  return static_cast<int32_t>(
+      syscall(__NR_io_uring_enter, fd, submit, complete, flags, arg, size));
+}
+
+static inline int32_t uring_register(int32_t fd,
+                                     uint32_t opcode,
+                                     const void *arg,
+                                     uint32_t count) {
+  return static_cast<int32_t>(
+      syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+// [op:8][buffer:16][serial:8][id:32]
+static inline uint64_t uring_userdata(uint8_t op,
+                                      int32_t id,
+                                      uint32_t serial,
+                                      uint16_t buffer = 0) {
+  return (static_cast<uint64_t>(op) << 56) |
+         (static_cast<uint64_t>(buffer) << 40) |
+         (static_cast<uint64_t>(serial & 0xff) << 32) |
+         static_cast<uint32_t>(id);
+}
+
+//Submit the prepared and wait the completions(timeout milliseconds).
+static int32_t uring_submit(uringdata_t &uringdata,
+                            uint32_t wait,
+                            int32_t timeout = 0) {
+  uint32_t submit =
+    uringdata.sq_local_tail - __atomic_load_n(uringdata.sq_head, __ATOMIC_ACQUIRE);
+  __atomic_store_n(
+      uringdata.sq_tail, uringdata.sq_local_tail, __ATOMIC_RELEASE);
+  if (0 == submit && 0 == wait) return 0;
+  uint32_t flags = wait > 0 ? IORING_ENTER_GETEVENTS : 0;
+  if (wait > 0 && timeout > 0) {
+    struct __kernel_timespec ts;
+    ts.tv_sec = timeout / 1000;
+    ts.tv_nsec = (timeout % 1000) * 1000000;
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    arg.sigmask_sz = _NSIG / 8;
+    arg.ts = reinterpret_cast<uint64_t>(&ts);
+    flags |= IORING_ENTER_EXT_ARG;
+    return uring_enter(
+        uringdata.fd, submit, wait, flags, &arg, sizeof(arg));
+  }
+  return uring_enter(uringdata.fd, submit, wait, flags, nullptr, 0);
+}
+
+//Get a free submission entry, submit the prepared if full.
+static struct io_uring_sqe *uring_sqe(uringdata_t &uringdata) {
+  auto head = __atomic_load_n(uringdata.sq_head, __ATOMIC_ACQUIRE);
+  if (uringdata.sq_local_tail - head >= uringdata.sq_entries) {
+    uring_submit(uringdata, 0);
+    head = __atomic_load_n(uringdata.sq_head, __ATOMIC_ACQUIRE);
+    if (uringdata.sq_local_tail - head >= uringdata.sq_entries) return nullptr;
+  }
+  auto sqe = &uringdata.sqes[uringdata.sq_local_tail & uringdata.sq_mask];
+  ++uringdata.sq_local_tail;
+  memset(sqe, 0, sizeof(*sqe));
+  return sqe;
+}
+
+//Give back the buffer to the recv buffer ring.
+//Not use the bufs of io_uring_buf_ring, the flex array offset is 8 in c++.
+static void uring_recv_recycle(uringdata_t &uringdata, uint16_t index) {
+  auto buffer = reinterpret_cast<struct io_uring_buf *>(uringdata.recv_ring) +
+    (uringdata.recv_tail & (NET_IOURING_RECV_BUFFERS - 1));
+  buffer->addr = reinterpret_cast<uint64_t>(
+      uringdata.recv_buffers + index * NET_IOURING_RECV_BUFFER_SIZE);
+  buffer->len = NET_IOURING_RECV_BUFFER_SIZE;
+  buffer->bid = index;
+  ++uringdata.recv_tail;
+  __atomic_store_n(
+      &uringdata.recv_ring->tail, uringdata.recv_tail, __ATOMIC_RELEASE);
+}
+
+static bool uring_file_update(uringdata_t &uringdata,
+                              uint32_t slot,
+                              int32_t socket_id) {
+  struct io_uring_files_update update;
+  memset(&update, 0, sizeof(update));
+  update.offset = slot;
+  update.fds = reinterpret_cast<uint64_t>(&socket_id);
+  return
+    1 == uring_register(uringdata.fd, IORING_REGISTER_FILES_UPDATE, &update, 1);
+}
+
+IoUring::IoUring() :
+  uringdata_{nullptr},
+  wakeup_fd_{SOCKET_INVALID},
+  wakeup_pending_{false},
+  accept_armed_{false},
+  accept_on_{true} {
+}
+
+IoUring::~IoUring() {
+  if (wakeup_fd_ != SOCKET_INVALID) pf_file::api::closeex(wakeup_fd_);
+}
+
+bool IoUring::init(uint32_t connectionmax) {
+  if (!Interface::init(connectionmax)) return false;
+  if (!uring_init(connectionmax)) return false;
+  return true;
+}
+
+bool IoUring::uring_init(uint32_t connectionmax) {
+  if (uringdata_) return true;
+  signal(SIGPIPE, SIG_IGN);
+  std::unique_ptr<uringdata_t> pointer{new uringdata_t};
+  uringdata_ = std::move(pointer);
+  auto &uringdata = *uringdata_;
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  params.flags = IORING_SETUP_CQSIZE |
+                 IORING_SETUP_SUBMIT_ALL |
+                 IORING_SETUP_COOP_TASKRUN;
+  params.cq_entries = NET_IOURING_ENTRIES * 4;
+  uringdata.fd = uring_setup(NET_IOURING_ENTRIES, &params);
+  if (uringdata.fd < 0) { //The old kernel not support the flags.
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = NET_IOURING_ENTRIES * 4;
+    uringdata.fd = uring_setup(NET_IOURING_ENTRIES, &params);
+  }
+  if (uringdata.fd < 0 || !(params.features & IORING_FEAT_EXT_ARG)) {
+    SLOW_ERRORLOG(NET_MODULENAME,
+                  "[net.connection.manager] (IoUring::uring_init)"
+                  " setup error, message: %s",
+                  strerror(errno));
+    return false;
+  }
+
+  //Map the rings.
+  uringdata.sq_ring_size =
+    params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  uringdata.cq_ring_size =
+    params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single) {
+    uringdata.sq_ring_size = uringdata.cq_ring_size =
+      max(uringdata.sq_ring_size, uringdata.cq_ring_size);
+  }
+  auto ring = mmap(nullptr,
+                   uringdata.sq_ring_size,
+                   PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE,
+                   uringdata.fd,
+                   IORING_OFF_SQ_RING);
+  if (MAP_FAILED == ring) return false;
+  uringdata.sq_ring = ring;
+  if (single) {
+    uringdata.cq_ring = ring;
+  } else {
+    ring = mmap(nullptr,
+                uringdata.cq_ring_size,
+                PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE,
+                uringdata.fd,
+                IORING_OFF_CQ_RING);
+    if (MAP_FAILED == ring) return false;
+    uringdata.cq_ring = ring;
+  }
+  uringdata.sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+  ring = mmap(nullptr,
+              uringdata.sqes_size,
+              PROT_READ | PROT_WRITE,
+              MAP_SHARED | MAP_POPULATE,
+              uringdata.fd,
+              IORING_OFF_SQES);
+  if (MAP_FAILED == ring) return false;
+  uringdata.sqes = reinterpret_cast<struct io_uring_sqe *>(ring);
+  auto sq = reinterpret_cast<char *>(uringdata.sq_ring);
+  auto cq = reinterpret_cast<char *>(uringdata.cq_ring);
+  uringdata.sq_head = reinterpret_cast<uint32_t *>(sq + params.sq_off.head);
+  uringdata.sq_tail = reinterpret_cast<uint32_t *>(sq + params.sq_off.tail);
+  uringdata.sq_mask =
+    *reinterpret_cast<uint32_t *>(sq + params.sq_off.ring_mask);
+  uringdata.sq_entries = params.sq_entries;
+  uringdata.sq_local_tail = *uringdata.sq_tail;
+  auto array = reinterpret_cast<uint32_t *>(sq + params.sq_off.array);
+  for (uint32_t i = 0; i < params.sq_entries; ++i) array[i] = i;
+  uringdata.cq_head = reinterpret_cast<uint32_t *>(cq + params.cq_off.head);
+  uringdata.cq_tail = reinterpret_cast<uint32_t *>(cq + params.cq_off.tail);
+  uringdata.cq_mask =
+    *reinterpret_cast<uint32_t *>(cq + params.cq_off.ring_mask);
+  uringdata.cqes =
+    reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+
+  //The fixed files, the connection id index is the slot and the last is 
+  //listener, the table can't more than the open files limit.
+  uint32_t files_max = connectionmax + 1;
+  struct rlimit limit;
+  if (0 == getrlimit(RLIMIT_NOFILE, &limit) && 
+      limit.rlim_cur != RLIM_INFINITY && files_max > limit.rlim_cur) {
+    files_max = static_cast<uint32_t>(limit.rlim_cur);
+  }
+  uringdata.slots.resize(files_max - 1);
+  uringdata.listener_slot = files_max - 1;
+  struct io_uring_rsrc_register files;
+  memset(&files, 0, sizeof(files));
+  files.nr = files_max;
+  files.flags = IORING_RSRC_REGISTER_SPARSE;
+  if (uring_register(
+        uringdata.fd, IORING_REGISTER_FILES2, &files, sizeof(files)) < 0) {
+    SLOW_ERRORLOG(NET_MODULENAME,
+                  "[net.connection.manager] (IoUring::uring_init)"
+                  " register files error, message: %s",
+                  strerror(errno));
+    return false;
+  }
+
+  //The recv buffers provide to kernel by the buffer ring.
+  uringdata.recv_ring_size =
+    NET_IOURING_RECV_BUFFERS * sizeof(struct io_uring_buf);
+  ring = mmap(nullptr,
+              uringdata.recv_ring_size,
+              PROT_READ | PROT_WRITE,
+              MAP_PRIVATE | MAP_ANONYMOUS,
+              -1,
+              0);
+  if (MAP_FAILED == ring) return false;
+  uringdata.recv_ring = reinterpret_cast<struct io_uring_buf_ring *>(ring);
+  ring = mmap(nullptr,
+              NET_IOURING_RECV_BUFFERS * NET_IOURING_RECV_BUFFER_SIZE,
+              PROT_READ | PROT_WRITE,
+              MAP_PRIVATE | MAP_ANONYMOUS,
+              -1,
+              0);
+  if (MAP_FAILED == ring) return false;
+  uringdata.recv_buffers = reinterpret_cast<char *>(ring);
+  struct io_uring_buf_reg bufreg;
+  memset(&bufreg, 0, sizeof(bufreg));
+  bufreg.ring_addr = reinterpret_cast<uint64_t>(uringdata.recv_ring);
+  bufreg.ring_entries = NET_IOURING_RECV_BUFFERS;
+  bufreg.bgid = 0;
+  if (uring_register(
+        uringdata.fd, IORING_REGISTER_PBUF_RING, &bufreg, 1) < 0) {
+    SLOW_ERRORLOG(NET_MODULENAME,
+                  "[net.connection.manager] (IoUring::uring_init)"
+                  " register buffer ring error, message: %s",
+                  strerror(errno));
+    return false;
+  }
+  for (uint16_t i = 0; i < NET_IOURING_RECV_BUFFERS; ++i)
+    uring_recv_recycle(uringdata, i);
+
+  //The send buffers, write with fixed buffer if register success(memlock).
+  ring = mmap(nullptr,
+              NET_IOURING_SEND_BUFFERS * NET_IOURING_SEND_BUFFER_SIZE,
+              PROT_READ | PROT_WRITE,
+              MAP_PRIVATE | MAP_ANONYMOUS,
+              -1,
+              0);
+  if (MAP_FAILED == ring) return false;
+  uringdata.send_buffers = reinterpret_cast<char *>(ring);
+  struct iovec iov;
+  iov.iov_base = uringdata.send_buffers;
+  iov.iov_len = NET_IOURING_SEND_BUFFERS * NET_IOURING_SEND_BUFFER_SIZE;
+  uringdata.send_fixed =
+    0 == uring_register(uringdata.fd, IORING_REGISTER_BUFFERS, &iov, 1);
+  for (uint16_t i = NET_IOURING_SEND_BUFFERS; i > 0; --i)
+    uringdata.send_frees.push_back(i - 1);
+
+  //Wake up.
+  wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (SOCKET_INVALID == wakeup_fd_) return false;
+  auto sqe = uring_sqe(uringdata);
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = wakeup_fd_;
+  sqe->poll32_events = POLLIN;
+  sqe->len = IORING_POLL_ADD_MULTI;
+  sqe->user_data = uring_userdata(kUringOpWakeup, 0, 0);
+
+  //Listener.
+  if (is_service() && listener_socket_id() != SOCKET_INVALID) {
+    if (!uring_file_update(
+          uringdata, uringdata.listener_slot, listener_socket_id())) {
+      return false;
+    }
+    if (!accept_arm()) return false;
+  }
+  uring_submit(uringdata, 0);
+  return true;
+}
+
+bool IoUring::accept_arm() {
+  auto sqe = uring_sqe(*uringdata_);
+  if (is_null(sqe)) return false;
+  sqe->fd = static_cast<int32_t>(uringdata_->listener_slot);
+  sqe->flags = IOSQE_FIXED_FILE;
+  if (is_forward()) { //The channel readable, receive the sockets.
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->poll32_events = POLLIN;
+    sqe->len = IORING_POLL_ADD_MULTI;
+  } else {
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+  }
+  sqe->user_data = uring_userdata(kUringOpAccept, 0, 0);
+  accept_armed_ = true;
+  return true;
+}
+
+bool IoUring::accept_watch(bool on) {
+  if (!is_service() || listener_socket_id() == SOCKET_INVALID) return true;
+  accept_on_ = on;
+  if (on) return accept_armed_ || accept_arm();
+  if (!accept_armed_) return true;
+  //Cancel the multishot accept, the sockets leave in backlog.
+  auto sqe = uring_sqe(*uringdata_);
+  if (is_null(sqe)) return false;
+  sqe->opcode = IORING_OP_ASYNC_CANCEL;
+  sqe->fd = -1;
+  sqe->addr = uring_userdata(kUringOpAccept, 0, 0);
+  sqe->user_data = uring_userdata(kUringOpCancel, 0, 0);
+  return true;
+}
+
+bool IoUring::connect_watch(connection::Basic *connection, bool watch) {
+  auto sqe = uring_sqe(*uringdata_);
+  if (is_null(sqe)) return false;
+  //The id changed after the connection removed, the old completion skipped.
+  auto userdata = uring_userdata(kUringOpConnect, connection->get_id(), 0);
+  if (watch) {
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = connection->socket()->get_id();
+    sqe->poll32_events = POLLOUT;
+    sqe->user_data = userdata;
+  } else { //Not found if the poll completed.
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = userdata;
+    sqe->user_data = uring_userdata(kUringOpCancel, 0, 0);
+  }
+  return true;
+}
+
+bool IoUring::recv_arm(int32_t connection_id) {
+  auto sqe = uring_sqe(*uringdata_);
+  if (is_null(sqe)) return false;
+  auto index = NET_CONNECTION_ID_INDEX(connection_id);
+  sqe->opcode = IORING_OP_RECV;
+  sqe->fd = static_cast<int32_t>(index);
+  sqe->flags = IOSQE_FIXED_FILE | IOSQE_BUFFER_SELECT;
+  sqe->ioprio = IORING_RECV_MULTISHOT;
+  sqe->buf_group = 0;
+  sqe->user_data = uring_userdata(
+      kUringOpRecv, connection_id, uringdata_->slots[index].serial);
+  return true;
+}
+
+bool IoUring::write_submit(int32_t connection_id) {
+  auto &uringdata = *uringdata_;
+  auto index = NET_CONNECTION_ID_INDEX(connection_id);
+  auto &slot = uringdata.slots[index];
+  if (slot.send_buffer < 0) { //Move the output data to a send buffer.
+    auto connection = pool_->get(connection_id);
+    if (is_null(connection) || !connection->output_pending()) return true;
+    if (uringdata.send_frees.empty()) {
+      connection->set_dirty(kDirtyFlagWritable);
+      uringdata.send_waits.push_back(connection_id);
+      return true;
+    }
+    auto buffer_index = uringdata.send_frees.back();
+    uringdata.send_frees.pop_back();
+    auto length = connection->ostream().drain(
+        uringdata.send_buffers + buffer_index * NET_IOURING_SEND_BUFFER_SIZE,
+        NET_IOURING_SEND_BUFFER_SIZE);
+    connection->output_update();
+    if (0 == length) {
+      uringdata.send_frees.push_back(buffer_index);
+      return true;
+    }
+    slot.send_buffer = buffer_index;
+    slot.send_offset = 0;
+    slot.send_length = length;
+  }
+  auto sqe = uring_sqe(uringdata);
+  if (is_null(sqe)) return false;
+  sqe->opcode = uringdata.send_fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+  sqe->fd = static_cast<int32_t>(index);
+  sqe->flags = IOSQE_FIXED_FILE;
+  sqe->addr = reinterpret_cast<uint64_t>(
+      uringdata.send_buffers +
+      slot.send_buffer * NET_IOURING_SEND_BUFFER_SIZE +
+      slot.send_offset);
+  sqe->len = slot.send_length - slot.send_offset;
+  sqe->buf_index = 0;
+  sqe->user_data = uring_userdata(kUringOpWrite,
+                                  connection_id,
+                                  slot.serial,
+                                  static_cast<uint16_t>(slot.send_buffer));
+  return true;
+}
+
+void IoUring::send_buffer_free(uint16_t index) {
+  auto &uringdata = *uringdata_;
+  uringdata.send_frees.push_back(index);
+  //The first waiting connection will write in next tick.
+  while (!uringdata.send_waits.empty()) {
+    auto id = uringdata.send_waits.front();
+    uringdata.send_waits.erase(uringdata.send_waits.begin());
+    auto connection = pool_->get(id);
+    if (is_null(connection) || !connection->is_dirty(kDirtyFlagWritable))
+      continue;
+    connection->set_dirty(kDirtyFlagWritable, false);
+    output_dirty(connection);
+    break;
+  }
+}
+
+bool IoUring::select() {
+  int32_t result = uring_submit(*uringdata_, wait_timeout_ > 0 ? 1 : 0,
+                                wait_timeout_);
+  if (result < 0 && errno != EINTR && errno != ETIME &&
+      errno != EAGAIN && errno != EBUSY) {
+    FAST_ERRORLOG(NET_MODULENAME,
+                  "[net.connection.manager] (IoUring::select)"
+                  " have error, message: %s",
+                  strerror(errno));
+  }
+  return true;
+}
+
+bool IoUring::process_input() {
+  auto &uringdata = *uringdata_;
+  uint32_t head = *uringdata.cq_head;
+  uint32_t tail = __atomic_load_n(uringdata.cq_tail, __ATOMIC_ACQUIRE);
+  for (; head != tail; ++head) {
+    auto cqe = &uringdata.cqes[head & uringdata.cq_mask];
+    uint64_t userdata = cqe->user_data;
+    int32_t result = cqe->res;
+    uint32_t flags = cqe->flags;
+    auto op = static_cast<uint8_t>(userdata >> 56);
+    auto id = static_cast<int32_t>(userdata & 0xffffffff);
+    auto serial = static_cast<uint32_t>((userdata >> 32) & 0xff);
+    auto index = NET_CONNECTION_ID_INDEX(id);
+    bool current = id >= 0 &&
+                   index < uringdata.slots.size() &&
+                   (uringdata.slots[index].serial & 0xff) == serial;
+    switch (op) {
+      case kUringOpAccept:
+        on_accept(result, flags);
+        break;
+      case kUringOpRecv:
+        if (current) {
+          on_recv(id, result, flags);
+        } else if (flags & IORING_CQE_F_BUFFER) { //The closed connection.
+          uring_recv_recycle(
+              uringdata, static_cast<uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT));
+        }
+        break;
+      case kUringOpWrite:
+        if (current) {
+          on_write(id, result);
+        } else {
+          send_buffer_free(static_cast<uint16_t>((userdata >> 40) & 0xffff));
+        }
+        break;
+      case kUringOpConnect: {
+        auto connection = pool_->get(id);
+        if (result >= 0 && !is_null(connection)) connect_ready(connection);
+        break;
+      }
+      case kUringOpWakeup: {
+        uint64_t value{0};
+        auto _result = ::read(wakeup_fd_, &value, sizeof(value));
+        UNUSED(_result);
+        wakeup_pending_ = false; //The works after it will run in this tick.
+        if (!(flags & IORING_CQE_F_MORE)) {
+          auto sqe = uring_sqe(uringdata);
+          if (sqe) {
+            sqe->opcode = IORING_OP_POLL_ADD;
+            sqe->fd = wakeup_fd_;
+            sqe->poll32_events = POLLIN;
+            sqe->len = IORING_POLL_ADD_MULTI;
+            sqe->user_data = uring_userdata(kUringOpWakeup, 0, 0);
+          }
+        }
+        break;
+      }
+      default:
+        break;
+    }
+  }
+  __atomic_store_n(uringdata.cq_head, head, __ATOMIC_RELEASE);
+  return true;
+}
+
+void IoUring::on_accept(int32_t result, uint32_t flags) {
+  if (result >= 0 && is_forward()) { //The result is the poll events.
+    accept_batch(static_cast<uint32_t>(onestep_accept_));
+  } else if (result >= 0 && !accept_check()) {
+    //Accepted before the cancel done.
+    pf_file::api::closeex(result);
+  } else if (result >= 0) {
+    struct sockaddr_in address;
+    socklen_t length = sizeof(address);
+    memset(&address, 0, sizeof(address));
+    getpeername(result, reinterpret_cast<struct sockaddr *>(&address), &length);
+    if (address.sin_family != AF_INET) { //The unix domain socket.
+      attach(result, SOCKET_UNIX_HOST, 0);
+    } else {
+      attach(result, inet_ntoa(address.sin_addr), ntohs(address.sin_port));
+    }
+  } else if (result != -ECANCELED) {
+    SLOW_WARNINGLOG(NET_MODULENAME,
+                    "[net.connection.manager] (IoUring::on_accept)"
+                    " error: %d",
+                    result);
+  }
+  if (!(flags & IORING_CQE_F_MORE)) {
+    accept_armed_ = false;
+    if (accept_on_) accept_arm();
+  }
+}
+
+void IoUring::on_recv(int32_t connection_id, int32_t result, uint32_t flags) {
+  auto &uringdata = *uringdata_;
+  auto connection = pool_->get(connection_id);
+  bool buffer = (flags & IORING_CQE_F_BUFFER) != 0;
+  auto index = static_cast<uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT);
+  bool result_ok = false;
+  if (result > 0 && buffer && !is_null(connection)) {
+    auto data = uringdata.recv_buffers + index * NET_IOURING_RECV_BUFFER_SIZE;
+    try {
+      result_ok = connection->receive(data, static_cast<uint32_t>(result));
+    } catch(...) {
+      result_ok = false;
+    }
+    if (result_ok) {
+      receive_bytes_ += connection->get_receive_bytes();
+      input_dirty(connection);
+    }
+  }
+  if (buffer) uring_recv_recycle(uringdata, index);
+  if (-ENOBUFS == result) result_ok = true; //The buffers used up, arm again.
+  if (!result_ok) {
+    if (!is_null(connection) && !connection->empty()) remove(connection);
+    return;
+  }
+  if (!(flags & IORING_CQE_F_MORE)) recv_arm(connection_id);
+}
+
+void IoUring::on_write(int32_t connection_id, int32_t result) {
+  auto &slot = uringdata_->slots[NET_CONNECTION_ID_INDEX(connection_id)];
+  auto connection = pool_->get(connection_id);
+  if (result < 0 || is_null(connection)) {
+    auto index = slot.send_buffer;
+    slot.send_buffer = -1;
+    if (index >= 0) send_buffer_free(static_cast<uint16_t>(index));
+    if (!is_null(connection) && !connection->empty()) remove(connection);
+    return;
+  }
+  send_bytes_ += result;
+  slot.send_offset += static_cast<uint32_t>(result);
+  if (slot.send_offset < slot.send_length) { //Write the left.
+    if (!write_submit(connection_id)) remove(connection);
+    return;
+  }
+  auto index = slot.send_buffer;
+  slot.send_buffer = -1;
+  send_buffer_free(static_cast<uint16_t>(index));
+  if (connection->output_pending()) output_dirty(connection);
+}
+
+bool IoUring::process_output() {
+  process_coalesce_dirty();
+  if (output_dirtys_.empty()) return true;
+  dirtys_.swap(output_dirtys_);
+  uint64_t now{0};
+  for (int32_t id : dirtys_) {
+    connection::Basic *connection = pool_->get(id);
+    if (is_null(connection) || !connection->is_dirty(kDirtyFlagOutput))
+      continue;
+    connection->set_dirty(kDirtyFlagOutput, false);
+    if (connection->is_disconnect()) continue;
+    if (output_overflow(connection)) {
+      remove(connection);
+      continue;
+    }
+    //The writing connection will check the output when it completed.
+    if (uringdata_->slots[NET_CONNECTION_ID_INDEX(id)].send_buffer >= 0) 
+      continue;
+    if (output_coalesce(connection, now)) continue;
+    bool result = true;
+    try {
+      //The compress output send in the stream flush.
+      if (connection->ostream().getcompressor()->getassistant()->isenable()) {
+        result = connection->process_output();
+        if (result) send_bytes_ += connection->get_send_bytes();
+        if (result && connection->output_pending()) output_dirty(connection);
+      } else {
+        result = write_submit(id);
+      }
+    } catch(...) {
+      result = false;
+    }
+    if (!result) remove(connection);
+  }
+  dirtys_.clear();
+  return true;
+}
+
+bool IoUring::process_exception() {
+  return true;
+}
+
+bool IoUring::process_command() {
+  return process_command_dirty();
+}
+
+bool IoUring::heartbeat(uint32_t time) {
+  bool result = Interface::heartbeat(time);
+  return result;
+}
+
+bool IoUring::socket_add(int32_t socket_id, int32_t connection_id) {
+  auto &uringdata = *uringdata_;
+  Assert(SOCKET_INVALID != socket_id);
+  auto index = NET_CONNECTION_ID_INDEX(connection_id);
+  if (connection_id < 0 || index >= uringdata.slots.size()) return false;
+  if (!uring_file_update(uringdata, index, socket_id)) {
+    SLOW_ERRORLOG(NET_MODULENAME,
+                  "[net.connection.manager] (IoUring::socket_add)"
+                  " error, message: %s",
+                  strerror(errno));
+    return false;
+  }
+  auto &slot = uringdata.slots[index];
+  ++slot.serial;
+  slot.send_buffer = -1;
+  uringdata.sockets[socket_id] = connection_id;
+  if (!recv_arm(connection_id)) return false;
+  ++fdsize_;
+  return true;
+}
+
+bool IoUring::socket_remove(int32_t socket_id) {
+  auto &uringdata = *uringdata_;
+  auto it = uringdata.sockets.find(socket_id);
+  if (it == uringdata.sockets.end()) {
+    SLOW_ERRORLOG(NET_MODULENAME,
+                  "[net.connection.manager] (IoUring::socket_remove) error!"
+                  " not found the socket: %d",
+                  socket_id);
+    return false;
+  }
+  auto index = NET_CONNECTION_ID_INDEX(it->second);
+  uringdata.sockets.erase(it);
+  //The completions of the socket in flight will be skipped(free buffers).
+  auto &slot = uringdata.slots[index];
+  ++slot.serial;
+  slot.send_buffer = -1;
+  //The ring hold the file, shutdown it to finish the recv and write.
+  shutdown(socket_id, SHUT_RDWR);
+  uring_file_update(uringdata, index, -1);
+  --fdsize_;
+  Assert(fdsize_ >= 0);
+  return true;
+}
+
+void IoUring::wakeup() {
+  //Write once until the completion drain it.
+  if (SOCKET_INVALID == wakeup_fd_ || wakeup_pending_.exchange(true)) return;
+  uint64_t value{1};
+  auto result = ::write(wakeup_fd_, &value, sizeof(value));
+  UNUSED(result);
+}
+
+} //namespace manager
+
+} //namespace connection
+
+} //namespace pf_net
+
+#endif
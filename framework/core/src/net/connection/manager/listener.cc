@@ -10,7 +10,19 @@ using namespace pf_net::connection::manager;
 Listener::Listener() :
   listener_socket_{nullptr},
   ready_{false}, 
-  safe_encrypt_str_{""} {
+  safe_encrypt_str_{""},
+  primary_{this},
+  reactor_index_{0},
+  reuseport_{false},
+  reactor_next_{0},
+  accept_rate_{NET_LISTENER_ACCEPT_RATE},
+  accept_burst_{NET_LISTENER_ACCEPT_BURST},
+  accept_tokens_{0},
+  accept_time_{0},
+  handshake_max_{NET_LISTENER_HANDSHAKE_MAX},
+  accept_paused_{false},
+  forward_next_{0},
+  forward_id_{SOCKET_INVALID} {
   //do nothing
 }
 
@@ -18,109 +30,394 @@ Listener::~Listener() {
   //do nothing
 }
 
-bool Listener::init(uint16_t _max_size, uint16_t _port, const std::string &ip) {
+bool Listener::init(uint32_t _max_size, 
+                    uint16_t _port, 
+                    const std::string &ip, 
+                    uint8_t reactors) {
   if (is_ready()) return true;
   std::unique_ptr<socket::Listener> 
     pointer{new socket::Listener()};
   if (is_null(pointer)) return false;
   listener_socket_ = std::move(pointer);
-  if (!listener_socket_->init(_port, ip)) return false;
+  reuseport_ = reactors > 1 && 
+    listener_socket_->init(_port, ip, NET_LISTENER_BACKLOG, true);
+  if (!reuseport_ && 
+      !listener_socket_->init(_port, ip, NET_LISTENER_BACKLOG)) return false;
   listener_socket_->set_nonblocking();
+  //The accepted sockets inherit it, not set one by one.
+  listener_socket_->set_linger(0);
   Assert(listener_socket_->get_id() != SOCKET_INVALID);
-  return Basic::init(_max_size);
+  return init_reactors(_max_size, reactors, _port, ip);
+}
+
+bool Listener::init_unix(uint32_t _max_size, 
+                         const std::string &path, 
+                         uint8_t reactors) {
+  if (is_ready()) return true;
+  std::unique_ptr<socket::Listener> 
+    pointer{new socket::Listener()};
+  if (is_null(pointer)) return false;
+  listener_socket_ = std::move(pointer);
+  if (!listener_socket_->init_unix(path, NET_LISTENER_BACKLOG)) return false;
+  listener_socket_->set_nonblocking();
+  return init_reactors(_max_size, reactors, 0, path);
+}
+
+bool Listener::init_forward(uint32_t _max_size, 
+                            int32_t channel_id, 
+                            uint8_t reactors) {
+  if (is_ready()) return true;
+  if (SOCKET_INVALID == channel_id) return false;
+  //Set before init, the reactor watch it as the listener socket.
+  socket::api::set_nonblocking_ex(channel_id, true);
+  forward_id_ = channel_id;
+  return init_reactors(_max_size, reactors, 0, "");
+}
+
+bool Listener::init_reactors(uint32_t _max_size, 
+                             uint8_t reactors, 
+                             uint16_t _port, 
+                             const std::string &ip) {
+  if (reactors < 1) reactors = 1;
+  if (reactors > NET_LISTENER_REACTORS_MAX) 
+    reactors = NET_LISTENER_REACTORS_MAX;
+  //The max size is the all shards.
+  uint32_t max_size = (_max_size + reactors - 1) / reactors;
+  if (!Basic::init(max_size)) return false;
+  for (uint8_t i = 1; i < reactors; ++i) {
+    std::unique_ptr<Listener> shard{new Listener()};
+    if (is_null(shard)) return false;
+    shard->primary_ = this;
+    shard->reactor_index_ = i;
+    if (reuseport_) {
+      std::unique_ptr<socket::Listener> _pointer{new socket::Listener()};
+      shard->listener_socket_ = std::move(_pointer);
+      if (!shard->listener_socket_->init(
+            _port, ip, NET_LISTENER_BACKLOG, true)) return false;
+      shard->listener_socket_->set_nonblocking();
+      shard->listener_socket_->set_linger(0);
+    }
+    if (!shard->Basic::init(max_size)) return false;
+    shards_.emplace_back(std::move(shard));
+  }
+  return true;
 }
 
 pf_net::connection::Basic *Listener::accept() {
-  uint32_t step = 0;
-  bool result = false;
+  pf_net::connection::Basic *connection{nullptr};
+  accept_one(connection);
+  return connection;
+}
+
+uint32_t Listener::accept_batch(uint32_t count) {
+  uint32_t result{0};
+  if (is_forward()) {
+    for (; result < count; ++result) {
+      auto received = forward_receive(forward_id_);
+      if (1 == received) continue;
+      if (SOCKET_ERROR == received) {
+        SLOW_ERRORLOG(NET_MODULENAME, 
+                      "[net.connection.manager] (Listener::accept_batch)"
+                      " the forward channel closed: %d",
+                      forward_id_);
+        accept_watch(false);
+      }
+      break;
+    }
+    return result;
+  }
+  pf_net::connection::Basic *connection{nullptr};
+  for (; result < count; ++result) {
+    if (!accept_one(connection)) break;
+  }
+  return result;
+}
+
+bool Listener::accept_one(pf_net::connection::Basic *&connection) {
+  connection = nullptr;
+  if (!accept_check()) return false;
+  socket::Basic socket;
+  if (!listener_socket_->accept(&socket)) {
+    //Not accepted, give back the token.
+    if (accept_rate_ > 0) accept_tokens_ += 1000;
+#if OS_UNIX
+    //The backlog still readable, wait the descriptors closed.
+    if (EMFILE == errno || ENFILE == errno) {
+      SLOW_WARNINGLOG(NET_MODULENAME, 
+                      "[net.connection.manager] (Listener::accept_one)"
+                      " too many open files");
+      accept_pause(NET_LISTENER_PAUSE_TIME);
+    }
+#endif
+    return false;
+  }
+  connection = attach(socket.get_id(), socket.host(), socket.port());
+  socket.set_id(SOCKET_INVALID); //The attach own it.
+  return true;
+}
+
+bool Listener::accept_check() {
+  if (accept_paused_) { //The completion io accepted before paused.
+    ++accept_stat_.rejected;
+    return false;
+  }
+  uint32_t delay{0};
+  if (handshake_max_ > 0) {
+    //The primary accept for all shards if not reuseport.
+    uint32_t pending{handshake_pending()};
+    if (!reuseport_) {
+      for (auto &shard : shards_) pending += shard->handshake_pending();
+    }
+    if (pending >= handshake_max_) {
+      ++accept_stat_.handshake_limited;
+      delay = NET_LISTENER_PAUSE_TIME;
+    }
+  }
+  if (0 == delay && accept_rate_ > 0) {
+    //The tokens are thousandth, the rate per second is the tokens per ms.
+    auto now = TIME_MANAGER_POINTER->get_tickcount();
+    uint64_t burst = 
+      static_cast<uint64_t>(0 == accept_burst_ ? accept_rate_ : accept_burst_);
+    burst *= 1000;
+    accept_tokens_ += static_cast<uint64_t>(now - accept_time_) * accept_rate_;
+    if (accept_tokens_ > burst) accept_tokens_ = burst;
+    accept_time_ = now;
+    if (accept_tokens_ < 1000) {
+      ++accept_stat_.rate_limited;
+      delay = static_cast<uint32_t>(
+          (1000 - accept_tokens_ + accept_rate_ - 1) / accept_rate_);
+    } else {
+      accept_tokens_ -= 1000;
+    }
+  }
+  if (0 == delay) return true;
+  accept_pause(delay);
+  return false;
+}
+
+void Listener::accept_pause(uint32_t delay) {
+  if (accept_paused_) return;
+  accept_paused_ = true;
+  accept_watch(false);
+  timer_add(kManagerTimerAccept, 0, delay);
+}
+
+void Listener::on_timer(uint8_t kind, int32_t) {
+  if (kind != kManagerTimerAccept) return;
+  accept_paused_ = false;
+  accept_watch(true);
+}
+
+void Listener::set_accept_rate(uint32_t rate, uint32_t burst) {
+  accept_rate_ = rate;
+  accept_burst_ = burst;
+  accept_tokens_ = static_cast<uint64_t>(0 == burst ? rate : burst) * 1000;
+  accept_time_ = TIME_MANAGER_POINTER->get_tickcount();
+  for (auto &shard : shards_) shard->set_accept_rate(rate, burst);
+}
+
+void Listener::set_handshake_max(uint32_t count) {
+  handshake_max_ = count;
+  for (auto &shard : shards_) shard->set_handshake_max(count);
+}
+
+void Listener::on_connect(connection::Basic *connection) {
+  if (safe_encrypt_str_ != "") {
+    connection->set_safe_encrypt_time(TIME_MANAGER_POINTER->get_ctime());
+    timer_set(connection, 
+              kConnectionTimerHandshake, 
+              NET_ENCRYPT_CONNECTION_TIMEOUT * 1000);
+  }
+  connection->set_listener(this);
+}
+
+void Listener::handoff(Listener *target, 
+                       int32_t socket_id, 
+                       const std::string &host, 
+                       uint16_t port) {
+  target->enqueue([target, socket_id, host, port]() {
+    target->attach(socket_id, host, port);
+  });
+}
+
+bool Listener::forward_add(int32_t channel_id) {
+  if (SOCKET_INVALID == channel_id) return false;
+  int32_t type{0};
+  uint32_t length = sizeof(type);
+#if OS_UNIX
+  if (!socket::api::getsockopt_exb(
+        channel_id, SOL_SOCKET, SO_TYPE, &type, &length) ||
+      (type != SOCK_SEQPACKET && type != SOCK_DGRAM)) {
+    SLOW_ERRORLOG(NET_MODULENAME, 
+                  "[net.connection.manager] (Listener::forward_add)"
+                  " the channel not keep the message boundaries: %d,"
+                  " type: %d",
+                  channel_id,
+                  type);
+    return false;
+  }
+#else
+  UNUSED(length);
+#endif
+  forwards_.push_back(channel_id);
+  return true;
+}
+
+bool Listener::forward_channel(int32_t &front_id, int32_t &worker_id) {
+#if OS_UNIX
+  int32_t socketids[2];
+  if (!socket::api::socketpair_ex(SOCK_SEQPACKET, socketids)) return false;
+  socket::api::set_nonblocking_ex(socketids[0], true);
+  front_id = socketids[0];
+  worker_id = socketids[1];
+  return true;
+#else
+  UNUSED(front_id);
+  UNUSED(worker_id);
+  return false;
+#endif
+}
+
+int32_t Listener::forward_receive(int32_t channel_id) {
+  forward_t forward;
+  int32_t socket_id{SOCKET_INVALID};
+  auto result = socket::api::recvfd_ex(
+      channel_id, &socket_id, &forward, sizeof(forward), 0);
+  if (SOCKET_ERROR_WOULD_BLOCK == result) return 0;
+  if (result <= 0) return SOCKET_ERROR; //The front closed.
+  if (SOCKET_INVALID == socket_id) return 0;
+  //The channel keep the boundaries, only drop the bad message.
+  if (result != static_cast<int32_t>(sizeof(forward))) {
+    socket::api::closeex(socket_id);
+    return 0;
+  }
+  //The front not sure nonblocking(other process).
+  socket::api::set_nonblocking_ex(socket_id, true);
+  forward.host[sizeof(forward.host) - 1] = '\0';
+  std::string host{forward.host};
+  uint16_t port{forward.port};
+  enqueue([this, socket_id, host, port]() {
+    attach(socket_id, host, port);
+  });
+  return 1;
+}
+
+bool Listener::forward(int32_t socket_id, 
+                       const std::string &host, 
+                       uint16_t port) {
+  forward_t forward;
+  memset(&forward, 0, sizeof(forward));
+  pf_basic::string::safecopy(forward.host, host.c_str(), sizeof(forward.host));
+  forward.port = port;
+  uint32_t flag{0};
+#if OS_UNIX
+  flag = MSG_NOSIGNAL;
+#endif
+  //The channels in turn, skip the busy and remove the broken.
+  for (size_t i = 0; i < forwards_.size();) {
+    auto index = forward_next_++ % forwards_.size();
+    auto channel_id = forwards_[index];
+    auto result = socket::api::sendfd_ex(
+        channel_id, socket_id, &forward, sizeof(forward), flag);
+    //The worker own it only if the whole message sent.
+    if (static_cast<int32_t>(sizeof(forward)) == result) {
+      socket::api::closeex(socket_id);
+      ++accept_stat_.forwarded;
+      return true;
+    }
+    if (SOCKET_ERROR_WOULD_BLOCK == result) {
+      ++i;
+      continue;
+    }
+    SLOW_WARNINGLOG(NET_MODULENAME, 
+                    "[net.connection.manager] (Listener::forward)"
+                    " the channel broken: %d, result: %d",
+                    channel_id,
+                    result);
+    forwards_.erase(forwards_.begin() + index);
+  }
+  return false;
+}
+
+pf_net::connection::Basic *Listener::attach(int32_t socket_id, 
+                                            const std::string &host, 
+                                            uint16_t port) {
+  if (!forwards_.empty() && forward(socket_id, host, port)) return nullptr;
+  if (!shards_.empty() && !reuseport_) {
+    auto index = static_cast<uint8_t>(reactor_next_++ % reactor_size());
+    if (index != 0) {
+      handoff(shards_[index - 1].get(), socket_id, host, port);
+      return nullptr;
+    }
+  }
   pf_net::connection::Basic *newconnection{nullptr};
   newconnection = pool_->create();
   if (is_null(newconnection)) { /* When pool full then will close new socket. */
     socket::Basic socket;
-    if (listener_socket_->accept(&socket)) {
-      socket.close();
-    }
+    socket.set_id(socket_id);
+    socket.close();
+    ++accept_stat_.rejected;
     static uint32_t checktime{0};
     auto _tick = TIME_MANAGER_POINTER->get_tickcount();
     if (0 == checktime || _tick - checktime >= 600000) {
       SLOW_WARNINGLOG(NET_MODULENAME, 
-                      "[net.connection.manager] (Listener::accept)"
-                      " can't accept new connection");
+                      "[net.connection.manager] (Listener::attach)"
+                      " can't attach new connection");
       checktime = _tick;
     }
     return nullptr;
   }
-  step = 5;
   newconnection->init(protocol());
   newconnection->clear();
-  int32_t socketid = SOCKET_INVALID;
-  step = 10;
-  try {
-    //accept client socket
-    result = listener_socket_->accept(newconnection->socket());
-    if (!result) {
-      step = 15;
-      goto EXCEPTION;
-    }
-  } catch(...) {
-    step += 1000;
-    goto EXCEPTION;
-  }
-  try {
-    step = 30;
-    socketid = newconnection->socket()->get_id();
-    if (SOCKET_INVALID == socketid) {
-      Assert(false);
-      goto EXCEPTION;
-    }
-    step = 40;
-    result = newconnection->socket()->set_nonblocking();
-    if (!result) {
-      Assert(false);
-      goto EXCEPTION;
-    }
-    step = 50;
-    if (newconnection->socket()->error()) {
-      Assert(false);
-      goto EXCEPTION;
-    }
-    step = 60;
-    result = newconnection->socket()->set_linger(0);
-    if (!result) {
-      Assert(false);
-      goto EXCEPTION;
-    }
-    step = 70;
-    try {
-      result = add(newconnection);
-      if (!result) {
-        Assert(false);
-        goto EXCEPTION;
-      }
-    } catch(...) {
-      step += 10000;
-      goto EXCEPTION;
-    }
-  } catch(...) {
-    step += 100000;
+  auto socket = newconnection->socket();
+  socket->set_id(socket_id);
+  socket->set_host(host.c_str());
+  socket->set_port(port);
+  //The linger inherit from listener, and nonblocking if accept4.
+  if (
+#if !SOCKET_ACCEPT_NONBLOCK
+      !socket->set_nonblocking() || 
+#endif
+      !add(newconnection)) {
+    newconnection->clear();
+    pool_->remove(newconnection->get_id());
+    ++accept_stat_.rejected;
+    return nullptr;
   }
+  ++accept_stat_.accepted;
 #ifdef _DEBUG
   FAST_LOG(NET_MODULENAME,
-           "[net.connection.manager] (Listener::accept)"
+           "[net.connection.manager] (Listener::attach)"
            " host: %s id: %d socketid: %d",
-           newconnection->socket()->host(),
+           socket->host(),
            newconnection->get_id(),
-           newconnection->socket()->get_id());
+           socket_id);
 #endif
   return newconnection;
-EXCEPTION:
-  newconnection->clear();
-  pool_->remove(newconnection->get_id());
-  return nullptr;
 }
 
-void Listener::on_connect(connection::Basic *connection) {
-  if (safe_encrypt_str_ != "")
-    connection->set_safe_encrypt_time(TIME_MANAGER_POINTER->get_ctime());
-  connection->set_listener(this);
+Listener *Listener::reactor(uint8_t index) {
+  if (0 == index) return primary_;
+  if (index > primary_->shards_.size()) return nullptr;
+  return primary_->shards_[index - 1].get();
+}
+
+bool Listener::send_to(int64_t handle, packet::Interface *packet) {
+  auto target = reactor(NET_REACTOR_HANDLE_INDEX(handle));
+  if (is_null(target) || is_null(packet)) return false;
+  int32_t id = NET_REACTOR_HANDLE_ID(handle);
+  if (target == this) {
+    auto connection = get(id);
+    if (is_null(connection) || connection->empty()) return false;
+    return connection->send(packet);
+  }
+  //Encode in this thread and send the data in the thread of target.
+  std::string data{""};
+  if (!target->protocol()->encode(packet, data)) return false;
+  target->enqueue([target, id, data]() {
+    auto connection = target->get(id);
+    if (is_null(connection) || connection->empty()) return;
+    connection->send(data.data(), static_cast<uint32_t>(data.size()));
+  });
+  return true;
 }
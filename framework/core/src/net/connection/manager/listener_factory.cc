@@ -8,8 +8,10 @@ eid_t ListenerFactory::newenv(const listener_config_t &config) {
   eid_t eid = neweid();
   if (NET_EID_INVALID == eid) return eid;
   std::unique_ptr< Listener > pointer(new Listener);
-  if (is_null(pointer) || 
-      !pointer->init(config.conn_max, config.port, config.ip)) {
+  bool result = !is_null(pointer) && (config.path != "" ? 
+    pointer->init_unix(config.conn_max, config.path, config.reactors) : 
+    pointer->init(config.conn_max, config.port, config.ip, config.reactors));
+  if (!result) {
     last_del_eid_ = eid;
     return NET_EID_INVALID;
   }
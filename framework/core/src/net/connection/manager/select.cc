@@ -1,8 +1,10 @@
+#include <algorithm>
 #include "pf/basic/logger.h"
 #include "pf/basic/util.h"
 #include "pf/net/connection/manager/select.h"
 
 #if !(OS_UNIX && defined(PF_OPEN_EPOLL)) && \
+  !(OS_UNIX && defined(PF_OPEN_IOURING)) && \
   !(OS_WIN && defined(PF_OPEN_IOCP))
 
 namespace pf_net {
@@ -27,7 +29,7 @@ Select::~Select() {
   //do nothing
 }
 
-bool Select::init(uint16_t connectionmax) {
+bool Select::init(uint32_t connectionmax) {
   if (!Interface::init(connectionmax)) return false;
   if (listener_socket_id() != ID_INVALID) {
     FD_SET(listener_socket_id(), &readfds_[kSelectFull]);
@@ -40,8 +42,14 @@ bool Select::init(uint16_t connectionmax) {
 }
 
 bool Select::select() {
-	if (SOCKET_INVALID == minfd_ && SOCKET_INVALID == maxfd_)
+	if (SOCKET_INVALID == minfd_ && SOCKET_INVALID == maxfd_ &&
+      connecting_ids_.empty())
     return true; //no connection
+  int32_t maxfd = maxfd_;
+  for (int32_t id : connecting_ids_) {
+    connection::Basic *connection = pool_->get(id);
+    if (connection) maxfd = max(maxfd, connection->socket()->get_id());
+  }
   timeout_[kSelectUse].tv_sec = timeout_[kSelectFull].tv_sec;
   timeout_[kSelectUse].tv_usec = timeout_[kSelectFull].tv_usec;
   readfds_[kSelectUse] = readfds_[kSelectFull];
@@ -50,7 +58,7 @@ bool Select::select() {
   int32_t result = SOCKET_ERROR;
   try {
     result = socket::Basic::select(
-        maxfd_ + 1,
+        maxfd + 1,
         &readfds_[kSelectUse],
         &writefds_[kSelectUse],
         &exceptfds_[kSelectUse],
@@ -66,17 +74,26 @@ bool Select::select() {
 }
 
 bool Select::process_input() {
+  //The failed connecting socket in the except set on windows.
+  auto connecting_ids = connecting_ids_;
+  for (int32_t id : connecting_ids) {
+    connection::Basic *connection = pool_->get(id);
+    if (is_null(connection)) continue;
+    int32_t socket_id = connection->socket()->get_id();
+    if (FD_ISSET(socket_id, &writefds_[kSelectUse]) ||
+        FD_ISSET(socket_id, &exceptfds_[kSelectUse])) {
+      connect_ready(connection);
+    }
+  }
   if (SOCKET_INVALID == minfd_ && SOCKET_INVALID == maxfd_)
     return true; //no connection
-  uint16_t i;
+  uint32_t i;
   //接受新连接的时候至少尝试两次，所以连接池里会多创建一个
   if (listener_socket_id() != SOCKET_INVALID && 
       FD_ISSET(listener_socket_id(), &readfds_[kSelectUse])) {
-    for (i = 0; i < onestep_accept_; ++i) {
-      if (!accept()) break;
-    }
+    accept_batch(static_cast<uint32_t>(onestep_accept_)); //-1 is no limit.
   }
-  uint16_t _size = size();
+  uint32_t _size = size();
   for (i = 0; i < _size; ++i) {
     if (ID_INVALID == connection_idset_[i]) continue;
     connection::Basic *connection = nullptr;
@@ -84,6 +101,13 @@ bool Select::process_input() {
     Assert(connection);
     int32_t socket_id = connection->socket()->get_id();
     if (listener_socket_id() == socket_id) continue;
+    //Only the blocked connection in write set.
+    if (FD_ISSET(socket_id, &writefds_[kSelectUse]) && 
+        connection->is_dirty(kDirtyFlagWritable)) {
+      connection->set_dirty(kDirtyFlagWritable, false);
+      output_wait(connection, false);
+      output_dirty(connection);
+    }
     if (FD_ISSET(socket_id, &readfds_[kSelectUse])) { //read information
       if (connection->socket()->error()) {
         remove(connection);
@@ -93,6 +117,7 @@ bool Select::process_input() {
             remove(connection);
           } else {
             receive_bytes_ += connection->get_receive_bytes();
+            input_dirty(connection);
           }
         } catch(...) {
           remove(connection);
@@ -104,32 +129,49 @@ bool Select::process_input() {
 }
 
 bool Select::process_output() {
-  if (SOCKET_INVALID == maxfd_ && SOCKET_INVALID == minfd_)
-    return true;
-  uint16_t i;
-  uint16_t _size = size();
-  for (i = 0; i < _size; ++i) {
-    if (ID_INVALID == connection_idset_[i]) continue;
-    connection::Basic* connection = nullptr;
-    connection = pool_->get(connection_idset_[i]);
-    Assert(connection);
-    int32_t socket_id = connection->socket()->get_id();
-    if (listener_socket_id() == socket_id) continue;
-    if (FD_ISSET(socket_id, &writefds_[kSelectUse])) {
-      if (connection->socket()->error()) {
-        remove(connection);
-      } else {
-        try {
-          if (!connection->process_output()) { 
-            remove(connection);
-          } else {
-            send_bytes_ += connection->get_send_bytes();
-          }
-        } catch(...) {
-          remove(connection);
-        }
-      } //connection->socket()->error()
-    }
+  return process_output_dirty();
+}
+
+bool Select::accept_watch(bool on) {
+  if (listener_socket_id() == SOCKET_INVALID) return true;
+  if (on) {
+    FD_SET(listener_socket_id(), &readfds_[kSelectFull]);
+  } else {
+    FD_CLR(listener_socket_id(), &readfds_[kSelectFull]);
+  }
+  return true;
+}
+
+bool Select::output_wait(connection::Basic *connection, bool wait) {
+  int32_t socket_id = connection->socket()->get_id();
+  if (SOCKET_INVALID == socket_id) return false;
+  if (wait) {
+    FD_SET(socket_id, &writefds_[kSelectFull]);
+  } else {
+    FD_CLR(static_cast<uint32_t>(socket_id), &writefds_[kSelectFull]);
+    FD_CLR(static_cast<uint32_t>(socket_id), &writefds_[kSelectUse]);
+  }
+  return true;
+}
+
+bool Select::connect_watch(connection::Basic *connection, bool watch) {
+  int32_t socket_id = connection->socket()->get_id();
+  if (SOCKET_INVALID == socket_id) return false;
+  auto it = std::find(
+      connecting_ids_.begin(), connecting_ids_.end(), connection->get_id());
+  if (watch) {
+    auto size = fdsize_ + static_cast<int32_t>(connecting_ids_.size());
+    if (size >= FD_SETSIZE) return false;
+    if (it == connecting_ids_.end())
+      connecting_ids_.push_back(connection->get_id());
+    FD_SET(socket_id, &writefds_[kSelectFull]);
+    FD_SET(socket_id, &exceptfds_[kSelectFull]);
+  } else {
+    if (it != connecting_ids_.end()) connecting_ids_.erase(it);
+    FD_CLR(static_cast<uint32_t>(socket_id), &writefds_[kSelectFull]);
+    FD_CLR(static_cast<uint32_t>(socket_id), &writefds_[kSelectUse]);
+    FD_CLR(static_cast<uint32_t>(socket_id), &exceptfds_[kSelectFull]);
+    FD_CLR(static_cast<uint32_t>(socket_id), &exceptfds_[kSelectUse]);
   }
   return true;
 }
@@ -137,9 +179,9 @@ bool Select::process_output() {
 bool Select::process_exception() {
   if (SOCKET_INVALID == minfd_ && SOCKET_INVALID == maxfd_)
     return true;
-  uint16_t _size = size();
+  uint32_t _size = size();
   connection::Basic *connection = nullptr;
-  uint16_t i;
+  uint32_t i;
   for (i = 0; i < _size; ++i) {
     if (ID_INVALID == connection_idset_[i]) continue;
     connection = pool_->get(connection_idset_[i]);
@@ -157,32 +199,10 @@ bool Select::process_exception() {
 }
 
 bool Select::process_command() {
-  if (SOCKET_INVALID == maxfd_ && SOCKET_INVALID == minfd_)
-    return true;
-  uint16_t i;
-  uint16_t _size = size();
-  for (i = 0; i < _size; ++i) {
-    if (ID_INVALID == connection_idset_[i]) continue;
-    connection::Basic* connection = nullptr;
-    connection = pool_->get(connection_idset_[i]);
-    Assert(connection);
-    int32_t socket_id = connection->socket()->get_id();
-    if (listener_socket_id() == socket_id) continue;
-    if (connection->socket()->error()) {
-      remove(connection);
-    } else { //connection is ok
-      try {
-        if (!connection->process_command()) 
-          remove(connection);
-      } catch(...) {
-        remove(connection);
-      }
-    } //connection->socket()->error()
-  }
-  return true;
+  return process_command_dirty();
 }
 
-bool Select::socket_add(int32_t socketid, int16_t) {
+bool Select::socket_add(int32_t socketid, int32_t) {
   if (fdsize_ > FD_SETSIZE) {
     Assert(false);
     return false;
@@ -191,7 +211,6 @@ bool Select::socket_add(int32_t socketid, int16_t) {
   minfd_ = SOCKET_INVALID == minfd_ ? socketid : min(socketid, minfd_);
   maxfd_ = SOCKET_INVALID == maxfd_ ? socketid : max(socketid, maxfd_);
   FD_SET(socketid, &readfds_[kSelectFull]);
-  FD_SET(socketid, &writefds_[kSelectFull]);
   FD_SET(socketid, &exceptfds_[kSelectFull]);
   ++fdsize_;
   return true;
@@ -200,12 +219,12 @@ bool Select::socket_add(int32_t socketid, int16_t) {
 bool Select::socket_remove(int32_t socketid) {
   connection::Basic *connection = nullptr;
   int32_t _listener_socket_id = listener_socket_id();
-  uint16_t i;
+  uint32_t i;
   Assert(minfd_ != SOCKET_INVALID || maxfd_ != SOCKET_INVALID);
   Assert(fdsize_ > 0);
   if (socketid == minfd_) { //the first connection
     int32_t socketid_max = maxfd_;
-    uint16_t _size = size();
+    uint32_t _size = size();
     for (i = 0; i < _size; ++i) {
       if (ID_INVALID == connection_idset_[i]) continue;
       connection = pool_->get(connection_idset_[i]);
@@ -222,7 +241,7 @@ bool Select::socket_remove(int32_t socketid) {
     }
   } else if (socketid == maxfd_) { //
     int32_t socketid_min = minfd_;
-    uint16_t _size = size();
+    uint32_t _size = size();
     for (i = 0; i < _size; ++i) {
       if (ID_INVALID == connection_idset_[i]) continue;
       connection = pool_->get(connection_idset_[i]);
@@ -0,0 +1,229 @@
+#include <algorithm>
+#include "pf/basic/logger.h"
+#include "pf/basic/util.h"
+#include "pf/net/connection/pool.h"
+#include "pf/net/connection/manager/share.h"
+#if OS_UNIX
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+using namespace pf_net::connection::manager;
+
+Share::Share() : wakeup_pending_{false} {
+  wakeup_fds_[0] = wakeup_fds_[1] = -1;
+#if OS_UNIX
+  polldata_.fd = ID_INVALID;
+  polldata_.maxcount = 0;
+  polldata_.result_eventcount = 0;
+  polldata_.event_index = 0;
+  polldata_.events = nullptr;
+#endif
+}
+
+Share::~Share() {
+#if OS_UNIX
+  if (polldata_.fd > 0) poll_destory(polldata_);
+  if (wakeup_fds_[0] >= 0) ::close(wakeup_fds_[0]);
+  if (wakeup_fds_[1] >= 0) ::close(wakeup_fds_[1]);
+#endif
+}
+
+bool Share::init(uint32_t max_size) {
+  if (is_ready()) return true;
+#if OS_UNIX
+  //The self pipe wake up the waiting in doorbells.
+  if (::pipe(wakeup_fds_) != 0) {
+    SLOW_ERRORLOG(NET_MODULENAME,
+                  "[net.connection.manager] (Share::init) pipe error: %s",
+                  strerror(errno));
+    return false;
+  }
+  for (int32_t fd : wakeup_fds_) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+  }
+  //The doorbells of connections and the wakeup pipe.
+  if (poll_create(polldata_, static_cast<int32_t>(max_size) + 1) <= 0 ||
+      poll_add(polldata_, wakeup_fds_[0], EPOLLIN, ID_INVALID) != 0) {
+    SLOW_ERRORLOG(NET_MODULENAME,
+                  "[net.connection.manager] (Share::init) epoll error: %s",
+                  strerror(errno));
+    return false;
+  }
+#endif
+  if (!Interface::init(max_size)) return false;
+  pool_->set_constructor([]() { return new connection::Share(); });
+  timer_add(kManagerTimerShare, 0, NET_SHARE_CHECK_TIME);
+  return true;
+}
+
+pf_net::connection::Basic *Share::open(uint32_t key, uint32_t size) {
+  return create(key, size, true);
+}
+
+pf_net::connection::Basic *Share::attach(uint32_t key, uint32_t size) {
+  return create(key, size, false);
+}
+
+bool Share::select() {
+#if OS_UNIX
+  //Tell the idle peers ring the doorbells, the busy ones keep polling.
+  bool idle = output_dirtys_.empty();
+  size_t count = 0;
+  for (int32_t id : ready_) {
+    auto connection = static_cast<connection::Share *>(get(id));
+    if (is_null(connection) || connection->sleep()) continue;
+    ready_[count++] = id;
+    idle = false;
+  }
+  ready_.resize(count);
+  poll_wait(polldata_, idle ? wait_timeout_ : 0);
+  if (polldata_.result_eventcount < 0) polldata_.result_eventcount = 0;
+  for (int32_t i = 0; i < polldata_.result_eventcount; ++i) {
+    auto id = static_cast<int32_t>(
+        pf_basic::util::get_lowsection(polldata_.events[i].data.u64));
+    if (ID_INVALID == id) {
+      char buffer[64];
+      while (::read(wakeup_fds_[0], buffer, sizeof(buffer)) > 0) {}
+      wakeup_pending_ = false; //The works after it will run in this tick.
+      continue;
+    }
+    auto connection = static_cast<connection::Share *>(get(id));
+    if (is_null(connection)) continue;
+    connection->wake();
+    ready_.push_back(id);
+  }
+  //The busy one may rang too.
+  if (count > 0 && ready_.size() > count) {
+    std::sort(ready_.begin(), ready_.end());
+    ready_.erase(std::unique(ready_.begin(), ready_.end()), ready_.end());
+  }
+#endif
+  return true;
+}
+
+bool Share::process_input() {
+  ids_.assign(ready_.begin(), ready_.end());
+  for (int32_t id : ids_) {
+    auto connection = static_cast<connection::Share *>(get(id));
+    if (is_null(connection) || connection->is_disconnect()) continue;
+    if (!connection->process_input()) {
+      remove(connection);
+      continue;
+    }
+    auto bytes = connection->get_receive_bytes();
+    if (bytes > 0) {
+      receive_bytes_ += bytes;
+      input_dirty(connection);
+    }
+    //The reader made the space of ring.
+    if (!connection->is_dirty(kDirtyFlagOutput) &&
+        connection->output_writable()) output_dirty(connection);
+  }
+  return true;
+}
+
+bool Share::process_output() {
+  if (output_dirtys_.empty()) return true;
+  dirtys_.swap(output_dirtys_);
+  for (int32_t id : dirtys_) {
+    connection::Basic *connection = pool_->get(id);
+    if (is_null(connection) || !connection->is_dirty(kDirtyFlagOutput))
+      continue;
+    connection->set_dirty(kDirtyFlagOutput, false);
+    if (connection->is_disconnect()) continue;
+    if (output_overflow(connection)) {
+      remove(connection);
+      continue;
+    }
+    auto size = connection->ostream().size();
+    if (!connection->process_output()) {
+      remove(connection);
+      continue;
+    }
+    send_bytes_ += size - connection->ostream().size();
+    //The reader made the space before the waiting set.
+    auto share = static_cast<connection::Share *>(connection);
+    if (share->output_writable()) output_dirty(connection);
+  }
+  dirtys_.clear();
+  return true;
+}
+
+bool Share::process_exception() {
+  return true;
+}
+
+bool Share::process_command() {
+  return process_command_dirty();
+}
+
+bool Share::erase(connection::Basic *connection) {
+  auto share = static_cast<connection::Share *>(connection);
+#if OS_UNIX
+  if (share->doorbell() >= 0) poll_delete(polldata_, share->doorbell());
+#endif
+  share->close();
+  return Basic::erase(connection);
+}
+
+void Share::wakeup() {
+#if OS_UNIX
+  //Write once until the select drain it.
+  if (wakeup_fds_[1] < 0 || wakeup_pending_.exchange(true)) return;
+  char value{1};
+  auto result = ::write(wakeup_fds_[1], &value, sizeof(value));
+  UNUSED(result);
+#endif
+}
+
+void Share::on_timer(uint8_t kind, int32_t) {
+  if (kind != kManagerTimerShare) return;
+  //The peer exited without close.
+  ids_.assign(connection_idset_, connection_idset_ + size_);
+  for (int32_t id : ids_) {
+    auto connection = static_cast<connection::Share *>(get(id));
+    if (is_null(connection) || connection->is_disconnect()) continue;
+    if (connection->peer_lost()) {
+      SLOW_WARNINGLOG(NET_MODULENAME,
+                      "[net.connection.manager] (Share::on_timer)"
+                      " the peer lost, key: %u",
+                      connection->key());
+      remove(connection);
+    }
+  }
+  timer_add(kManagerTimerShare, 0, NET_SHARE_CHECK_TIME);
+}
+
+pf_net::connection::Basic *Share::create(uint32_t key,
+                                         uint32_t size,
+                                         bool service) {
+  if (!checkpool()) return nullptr;
+  auto connection = static_cast<connection::Share *>(pool_->create());
+  if (is_null(connection)) return nullptr;
+  if (!connection->init(protocol())) {
+    pool_->remove(connection->get_id());
+    return nullptr;
+  }
+  connection->clear();
+  bool result = service ?
+                connection->open(key, size) : connection->attach(key, size);
+  if (!result || !add(connection)) {
+    SLOW_WARNINGLOG(NET_MODULENAME,
+                    "[net.connection.manager] (Share::create) failed!"
+                    " key: %u, service: %d",
+                    key,
+                    service ? 1 : 0);
+    connection->close();
+    pool_->remove(connection->get_id());
+    return nullptr;
+  }
+#if OS_UNIX
+  //Check the ring once, the data may sent before the doorbell watched.
+  poll_add(polldata_, connection->doorbell(), EPOLLIN, connection->get_id());
+#endif
+  ready_.push_back(connection->get_id());
+  return connection;
+}
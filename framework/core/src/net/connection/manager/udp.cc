@@ -0,0 +1,439 @@
+#include "pf/basic/logger.h"
+#include "pf/basic/time_manager.h"
+#include "pf/net/socket/api.h"
+#include "pf/net/connection/pool.h"
+#include "pf/net/connection/manager/udp.h"
+
+using namespace pf_net::connection::manager;
+
+//The tickcount of net, 0 if no time manager.
+static uint32_t tickcount() {
+  return is_null(TIME_MANAGER_POINTER) ?
+         0 : TIME_MANAGER_POINTER->get_tickcount();
+}
+
+Udp::Udp() :
+  service_{true},
+  wakeup_pending_{false},
+  simulate_loss_{0},
+  simulate_latency_{0},
+  simulate_jitter_{0},
+  random_{static_cast<uint32_t>(
+      std::chrono::steady_clock::now().time_since_epoch().count())},
+  cookie_secret_{0} {
+  memset(&wakeup_address_, 0, sizeof(wakeup_address_));
+  std::random_device device;
+  cookie_secret_ = (static_cast<uint64_t>(device()) << 32) | device();
+}
+
+Udp::~Udp() {
+  if (socket_) socket_->close();
+}
+
+bool Udp::init(uint32_t max_size,
+               uint16_t port,
+               const std::string &ip,
+               bool service) {
+  if (is_ready()) return true;
+  service_ = service;
+  std::unique_ptr<socket::Basic> socket{new socket::Basic()};
+  socket->set_id(socket::api::socketex(AF_INET, SOCK_DGRAM, 0));
+  if (!socket->is_valid() ||
+      !socket->bind(port, ip.c_str()) ||
+      !socket->set_nonblocking()) {
+    SLOW_ERRORLOG(NET_MODULENAME,
+                  "[net.connection.manager] (Udp::init) socket error,"
+                  " port: %d, ip: %s",
+                  port,
+                  ip.c_str());
+    return false;
+  }
+  //The full windows of the peers in kernel buffer.
+  socket->set_receive_buffer_size(NET_UDP_WINDOW * NET_UDP_MTU * 4);
+  socket->set_send_buffer_size(NET_UDP_WINDOW * NET_UDP_MTU * 4);
+  int32_t length = sizeof(wakeup_address_);
+  if (SOCKET_ERROR == socket::api::getsockname_ex(
+        socket->get_id(),
+        reinterpret_cast<struct sockaddr *>(&wakeup_address_),
+        &length)) {
+    return false;
+  }
+  if (htonl(INADDR_ANY) == wakeup_address_.sin_addr.s_addr)
+    wakeup_address_.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socket_ = std::move(socket);
+  if (!Interface::init(max_size)) return false;
+  pool_->set_constructor([this]() {
+    auto connection = new connection::Udp();
+    connection->set_output([this](const struct sockaddr_in &address,
+                                  const char *data,
+                                  uint32_t size) {
+      datagram_send(address, data, size);
+    });
+    return connection;
+  });
+  return true;
+}
+
+void Udp::connect_async(const std::string &ip,
+                        uint16_t port,
+                        connect_callback_t callback,
+                        uint32_t timeout) {
+  enqueue([this, ip, port, callback, timeout]() {
+    connect_start(ip, port, callback, timeout);
+  });
+}
+
+void Udp::set_simulate(uint8_t loss, uint32_t latency, uint32_t jitter) {
+  simulate_loss_ = min(loss, 100);
+  simulate_latency_ = latency;
+  simulate_jitter_ = jitter;
+}
+
+bool Udp::select() {
+  if (!socket_ || wait_timeout_ <= 0) return true;
+  fd_set readset;
+  FD_ZERO(&readset);
+  FD_SET(socket_->get_id(), &readset);
+  struct timeval timeout;
+  timeout.tv_sec = wait_timeout_ / 1000;
+  timeout.tv_usec = (wait_timeout_ % 1000) * 1000;
+  socket::Basic::select(socket_->get_id() + 1, &readset, nullptr, nullptr,
+                        &timeout);
+  return true;
+}
+
+bool Udp::process_input() {
+  if (!socket_) return true;
+  auto now = tickcount();
+  for (uint32_t i = 0; i < NET_UDP_RECEIVE_BATCH; ++i) {
+    struct sockaddr_in address;
+    uint32_t length = sizeof(address);
+    auto result = socket::api::recvfrom_ex(
+        socket_->get_id(),
+        buffer_,
+        sizeof(buffer_),
+        0,
+        reinterpret_cast<struct sockaddr *>(&address),
+        &length);
+    if (result < 0) break;
+    if (0 == result) { //The wakeup.
+      wakeup_pending_ = false;
+      continue;
+    }
+    ++udp_stat_.received;
+    receive_bytes_ += result;
+    input(address, buffer_, static_cast<uint32_t>(result), now);
+  }
+  return true;
+}
+
+bool Udp::process_output() {
+  auto now = tickcount();
+  if (!delays_.empty()) delay_flush(now);
+  if (output_dirtys_.empty()) return true;
+  dirtys_.swap(output_dirtys_);
+  for (int32_t id : dirtys_) {
+    auto connection = static_cast<connection::Udp *>(pool_->get(id));
+    if (is_null(connection) || !connection->is_dirty(kDirtyFlagOutput))
+      continue;
+    connection->set_dirty(kDirtyFlagOutput, false);
+    if (connection->is_disconnect()) continue;
+    if (output_overflow(connection)) {
+      remove(connection);
+      continue;
+    }
+    update(connection, now);
+  }
+  dirtys_.clear();
+  return true;
+}
+
+bool Udp::process_exception() {
+  return true;
+}
+
+bool Udp::process_command() {
+  return process_command_dirty();
+}
+
+bool Udp::erase(connection::Basic *connection) {
+  auto udp = static_cast<connection::Udp *>(connection);
+  if (udp->update_timer() != 0) wheel_.cancel(udp->update_timer());
+  udp->set_update_timer(0, 0);
+  auto it = peers_.find(address_key(udp->address()));
+  if (it != peers_.end() && it->second == connection->get_id())
+    peers_.erase(it);
+  udp->close(true);
+  return Basic::erase(connection);
+}
+
+void Udp::wakeup() {
+  //Send once until the input receive it.
+  if (!socket_ || wakeup_pending_.exchange(true)) return;
+  socket::api::sendto_ex(
+      socket_->get_id(),
+      "",
+      0,
+      0,
+      reinterpret_cast<const struct sockaddr *>(&wakeup_address_),
+      sizeof(wakeup_address_));
+}
+
+void Udp::on_timer(uint8_t kind, int32_t id) {
+  auto now = tickcount();
+  if (kManagerTimerUdpDelay == kind) {
+    delay_flush(now);
+    return;
+  }
+  if (kind != kManagerTimerUdp) return;
+  auto connection = static_cast<connection::Udp *>(pool_->get(id));
+  if (is_null(connection) || 0 == connection->session()) return;
+  connection->set_update_timer(0, 0);
+  update(connection, now);
+}
+
+uint64_t Udp::address_key(const struct sockaddr_in &address) {
+  return (static_cast<uint64_t>(ntohl(address.sin_addr.s_addr)) << 16) |
+         ntohs(address.sin_port);
+}
+
+uint32_t Udp::cookie(const struct sockaddr_in &address,
+                     uint32_t session) const {
+  //The splitmix64 finalizer of the key, session and secret.
+  uint64_t value = address_key(address) * 0x9e3779b97f4a7c15ULL ^
+                   ((static_cast<uint64_t>(session) << 32) | session) ^
+                   cookie_secret_;
+  value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+  value ^= value >> 31;
+  auto result = static_cast<uint32_t>(value);
+  return 0 == result ? 1 : result;
+}
+
+void Udp::input(const struct sockaddr_in &address,
+                const char *data,
+                uint32_t size,
+                uint32_t now) {
+  auto session = connection::Udp::session(data, size);
+  if (0 == session) {
+    ++udp_stat_.invalid;
+    return;
+  }
+  connection::Udp *connection{nullptr};
+  auto it = peers_.find(address_key(address));
+  if (it != peers_.end())
+    connection = static_cast<connection::Udp *>(pool_->get(it->second));
+  bool connecting = connection::Udp::connecting(data, size);
+  if (!is_null(connection) && connection->session() != session) {
+    //The peer restarted with the new session.
+    if (!is_service() || !connecting || !connection->connected()) {
+      ++udp_stat_.invalid;
+      return;
+    }
+  }
+  if (is_null(connection) || connection->session() != session) {
+    if (!is_service() || !connecting) {
+      ++udp_stat_.invalid;
+      return;
+    }
+    //The source address maybe spoofed, the new session(or replace the live
+    //peer) only after the connect echo the cookie sent to the address.
+    if (!cookie_check(address, session, data, size)) return;
+    if (!is_null(connection)) remove(connection);
+    connection = accept_peer(address, session, now);
+    if (is_null(connection)) return;
+  }
+  if (connection::Udp::challenging(data, size)) {
+    connection->input(data, size, now);
+    update(connection, now);
+    return;
+  }
+  //Add the client before input, the packets in datagram can execute.
+  if (!connection->connected() &&
+      connecting_.find(connection->get_id()) != connecting_.end()) {
+    connect_finish(connection, true);
+    if (0 == connection->session()) return;
+  }
+  if (!connection->input(data, size, now)) remove(connection);
+}
+
+bool Udp::cookie_check(const struct sockaddr_in &address,
+                       uint32_t session,
+                       const char *data,
+                       uint32_t size) {
+  auto expect = cookie(address, session);
+  if (connection::Udp::cookie(data, size) == expect) return true;
+  //Stateless, and the challenge not larger than the request(not reflect).
+  char datagram[NET_UDP_MTU];
+  auto length = connection::Udp::challenge(datagram, session, expect);
+  if (length <= size) datagram_send(address, datagram, length);
+  ++udp_stat_.challenged;
+  return false;
+}
+
+pf_net::connection::Udp *Udp::accept_peer(const struct sockaddr_in &address,
+                                          uint32_t session,
+                                          uint32_t now) {
+  if (!checkpool()) return nullptr;
+  auto connection = static_cast<connection::Udp *>(pool_->create());
+  if (is_null(connection)) return nullptr;
+  if (!connection->init(protocol())) {
+    pool_->remove(connection->get_id());
+    return nullptr;
+  }
+  connection->clear();
+  connection->socket()->set_host(inet_ntoa(address.sin_addr));
+  connection->socket()->set_port(ntohs(address.sin_port));
+  connection->open(address, session, false, now);
+  peers_[address_key(address)] = connection->get_id();
+  if (!add(connection)) {
+    peers_.erase(address_key(address));
+    connection->close(false);
+    pool_->remove(connection->get_id());
+    return nullptr;
+  }
+  return connection;
+}
+
+void Udp::connect_start(const std::string &ip,
+                        uint16_t port,
+                        connect_callback_t callback,
+                        uint32_t timeout) {
+  uint8_t step = 0;
+  auto now = tickcount();
+  connection::Udp *connection{nullptr};
+  struct sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = inet_addr(ip.c_str());
+  uint32_t session{0};
+  if (!checkpool() || !socket_) {
+    step = 1;
+    goto EXCEPTION;
+  }
+  if (INADDR_NONE == address.sin_addr.s_addr || 0 == port ||
+      peers_.find(address_key(address)) != peers_.end()) {
+    step = 2;
+    goto EXCEPTION;
+  }
+  connection = static_cast<connection::Udp *>(pool_->create());
+  if (is_null(connection)) {
+    step = 3;
+    goto EXCEPTION;
+  }
+  if (!connection->init(protocol())) {
+    step = 4;
+    goto EXCEPTION;
+  }
+  connection->clear();
+  connection->socket()->set_host(ip.c_str());
+  connection->socket()->set_port(port);
+  while (0 == session) session = static_cast<uint32_t>(random_());
+  connection->open(address, session, true, now, timeout);
+  peers_[address_key(address)] = connection->get_id();
+  connecting_[connection->get_id()] = callback;
+  update(connection, now);
+  return;
+EXCEPTION:
+  SLOW_WARNINGLOG(NET_MODULENAME,
+                  "[net.connection.manager] (Udp::connect_start) failed!"
+                  " ip: %s, port: %d, step: %d",
+                  ip.c_str(),
+                  port,
+                  step);
+  if (!is_null(connection)) pool_->remove(connection->get_id());
+  if (callback) callback(nullptr);
+}
+
+void Udp::connect_finish(connection::Udp *connection, bool success) {
+  auto it = connecting_.find(connection->get_id());
+  if (it == connecting_.end()) return;
+  connect_callback_t callback = it->second;
+  connecting_.erase(it);
+  if (success) success = add(connection);
+  if (success) {
+    if (callback) callback(connection);
+    return;
+  }
+  SLOW_WARNINGLOG(NET_MODULENAME,
+                  "[net.connection.manager] (Udp::connect_finish) failed!"
+                  " ip: %s, port: %d",
+                  connection->socket()->host(),
+                  connection->socket()->port());
+  if (connection->update_timer() != 0) wheel_.cancel(connection->update_timer());
+  connection->set_update_timer(0, 0);
+  auto peer = peers_.find(address_key(connection->address()));
+  if (peer != peers_.end() && peer->second == connection->get_id())
+    peers_.erase(peer);
+  connection->close(false);
+  pool_->remove(connection->get_id());
+  if (callback) callback(nullptr);
+}
+
+void Udp::update(connection::Udp *connection, uint32_t now) {
+  if (!connection->update(now)) {
+    if (connecting_.find(connection->get_id()) != connecting_.end()) {
+      connect_finish(connection, false);
+    } else {
+      remove(connection);
+    }
+    return;
+  }
+  //Only arm the timer earlier than the armed.
+  auto delay = connection->check(now);
+  auto time = now + delay;
+  if (connection->update_timer() != 0) {
+    if (static_cast<int32_t>(time - connection->update_time()) >= 0) return;
+    wheel_.cancel(connection->update_timer());
+  }
+  connection->set_update_timer(
+      timer_add(kManagerTimerUdp, connection->get_id(), delay), time);
+}
+
+void Udp::datagram_send(const struct sockaddr_in &address,
+                        const char *data,
+                        uint32_t size) {
+  if (simulate_loss_ > 0 && random_() % 100 < simulate_loss_) {
+    ++udp_stat_.simulate_lost;
+    return;
+  }
+  uint32_t delay = simulate_latency_;
+  if (simulate_jitter_ > 0) delay += random_() % (simulate_jitter_ + 1);
+  if (0 == delay) {
+    datagram_write(address, data, size);
+    return;
+  }
+  auto time = tickcount() + delay;
+  delays_.emplace(time, std::make_pair(address, std::string(data, size)));
+  timer_add(kManagerTimerUdpDelay, 0, delay);
+  ++udp_stat_.simulate_delayed;
+}
+
+void Udp::datagram_write(const struct sockaddr_in &address,
+                         const char *data,
+                         uint32_t size) {
+  if (!socket_) return;
+  auto result = socket::api::sendto_ex(
+      socket_->get_id(),
+      data,
+      size,
+      0,
+      reinterpret_cast<const struct sockaddr *>(&address),
+      sizeof(address));
+  //The lost datagram resend by the connection.
+  if (result <= 0) return;
+  ++udp_stat_.sent;
+  send_bytes_ += result;
+}
+
+void Udp::delay_flush(uint32_t now) {
+  while (!delays_.empty() &&
+         static_cast<int32_t>(now - delays_.begin()->first) >= 0) {
+    auto &datagram = delays_.begin()->second;
+    datagram_write(datagram.first,
+                   datagram.second.data(),
+                   static_cast<uint32_t>(datagram.second.size()));
+    delays_.erase(delays_.begin());
+  }
+}
@@ -7,12 +7,16 @@ namespace pf_net {
 
 namespace connection {
 
+#define NET_CONNECTION_POOL_SLOT_NONE 0xffffffff
+
 Pool::Pool() : 
   ready_{false},
-  position_{0},
+  free_head_{NET_CONNECTION_POOL_SLOT_NONE},
+  used_{0},
   size_{0},
-  max_size_{NET_CONNECTION_POOL_SIZE_DEFAULT} {
-  connections_.clear();
+  max_size_{NET_CONNECTION_POOL_SIZE_DEFAULT},
+  constructor_{nullptr} {
+  slots_.clear();
 }
 
 Pool::~Pool() {
@@ -21,86 +25,98 @@ Pool::~Pool() {
 
 bool Pool::init(uint32_t max_size) {
   if (ready_) return true;
+  if (max_size > NET_CONNECTION_INDEX_MAX) {
+    Assert(false);
+    return false;
+  }
   max_size_ = max_size;
-  for (uint32_t i = 0; i < max_size_; ++i)
-    connections_.push_back(nullptr);
-  position_ = 0;
+  slots_.resize(max_size_);
+  free_head_ = NET_CONNECTION_POOL_SLOT_NONE;
+  used_ = 0;
   size_ = max_size_;
   ready_ = true;
   return true;
 }
 
-bool Pool::init_data(uint16_t index, Basic *connection) {
+bool Pool::init_data(uint32_t index, Basic *connection) {
   Assert(connection);
-  Assert((0 == index || index > 0) && index < max_size_);
+  Assert(index < max_size_);
   std::unique_ptr< Basic > ptr(connection);
-  connections_[index] = std::move(ptr);
-  connections_[index]->set_id(index);
-  connections_[index]->set_empty(true);
+  slots_[index].connection = std::move(ptr);
+  slots_[index].connection->set_id(NET_CONNECTION_ID(index, 0));
+  slots_[index].connection->set_empty(true);
   return true;
 }
 
-Basic *Pool::get(int16_t id) {
+Basic *Pool::construct(uint32_t index) {
+  if (is_null(slots_[index].connection)) {
+    auto connection = 
+      is_null(constructor_) ? new connection::Basic() : constructor_();
+    if (is_null(connection)) return nullptr;
+    connection->set_protocol(manager::Basic::protocol_default());
+    init_data(index, connection);
+  }
+  return slots_[index].connection.get();
+}
+
+Basic *Pool::get(int32_t id) {
   Basic *connection = nullptr;
-  if (static_cast<uint32_t>(id) > max_size_) return connection;
-  connection = connections_[id].get();
-  if (nullptr == connection) pf_basic::io_cerr("Pool::get is nullptr");
+  if (id < 0) return connection;
+  auto index = NET_CONNECTION_ID_INDEX(id);
+  if (index >= max_size_) return connection;
+  connection = slots_[index].connection.get();
+  //Not constructed or the slot is used by other(recycled).
+  if (is_null(connection) || connection->get_id() != id) connection = nullptr;
   return connection;
 }
 
 Basic *Pool::create(bool clear) {
   if (0 == size_) return nullptr;  //Can used connection count.
   Basic *connection = nullptr;
-  std::unique_lock<std::mutex> autolock(mutex_);
-  /* Closure to get connection. */
-  auto func = [this, clear, &connection]() {
-    if (connections_[position_] && connections_[position_]->empty()) {
-      connection = connections_[position_].get();
-      if (clear) connection->clear();
-      connection->set_empty(false);
-      ++position_; //Position to next.
-    }
-  };
-  auto lastpos = position_;
-  //Right.
-  for (; position_ < max_size_; ++position_) {
-    func();
-    if (connection) {
-      --size_;
-      break;
-    }
-  }
-  //Left.
-  if (is_null(connection)) {
-    for (position_ = 0; position_ < lastpos; ++position_) {
-      func();
-      if (connection) {
-        --size_;
-        break;
-      }
-    }
+  if (free_head_ != NET_CONNECTION_POOL_SLOT_NONE) {
+    auto index = free_head_;
+    free_head_ = slots_[index].next;
+    connection = slots_[index].connection.get();
+  } else if (used_ < max_size_) {
+    connection = construct(used_);
+    if (is_null(connection)) return nullptr;
+    ++used_;
   }
+  if (is_null(connection)) return nullptr;
+  if (clear) connection->clear();
+  connection->set_empty(false);
+  --size_;
   return connection;
 }
 
-void Pool::remove(int16_t id) {
-  if (static_cast<uint32_t>(id) > max_size_) {
+void Pool::remove(int32_t id) {
+  auto connection = get(id);
+  if (is_null(connection)) {
     Assert(false);
     return;
   }
-  if (!is_null(connections_[id])) connections_[id]->clear(); //清除连接信息
+  connection->clear(); //清除连接信息
+  //The next user of the slot get a new handle.
+  auto index = NET_CONNECTION_ID_INDEX(id);
+  connection->set_id(
+      NET_CONNECTION_ID(index, NET_CONNECTION_ID_GENERATION(id) + 1));
+  slots_[index].next = free_head_;
+  free_head_ = index;
   ++size_;
 }
 
+void Pool::lock() {
+  mutex_.lock();
+}
+
+void Pool::unlock() {
+  mutex_.unlock();
+}
+
 bool Pool::create_default_connections() {
-  if (!is_null(connections_[0]) && !is_null(connections_[max_size_ - 1])) 
-    return true;
   std::unique_lock<std::mutex> autolock(mutex_);
-  for (uint16_t i = 0; i < max_size_; i++) {
-    auto connection = new connection::Basic();
-    if (is_null(connection)) return false;
-    connection->set_protocol(manager::Basic::protocol_default());
-    init_data(i, connection);
+  for (uint32_t i = 0; i < max_size_; i++) {
+    if (is_null(construct(i))) return false;
   }
   return true;
 }
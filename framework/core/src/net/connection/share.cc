@@ -0,0 +1,300 @@
+#include "pf/basic/logger.h"
+#include "pf/sys/process.h"
+#if OS_UNIX
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
+#include "pf/net/connection/share.h"
+
+#define SHARE_MAGIC (0x50465348)
+#define SHARE_ALIGN (64)
+
+namespace pf_net {
+
+namespace connection {
+
+//The writer fields and reader fields in the different cache lines.
+struct share_ring_struct {
+  alignas(SHARE_ALIGN) std::atomic<uint32_t> head; /* 写入的位置 */
+  std::atomic<uint32_t> waiting;                   /* 写端等待空间 */
+  alignas(SHARE_ALIGN) std::atomic<uint32_t> tail; /* 读取的位置 */
+  std::atomic<uint32_t> sleeping;                  /* 读端等待门铃 */
+};
+
+struct share_block_struct {
+  std::atomic<uint32_t> magic;
+  uint32_t size;
+  std::atomic<int32_t> pids[2];    /* 服务端和客户端的进程 */
+  std::atomic<uint32_t> closed[2]; /* 服务端和客户端已关闭 */
+  share_ring_struct rings[2];      /* 服务端和客户端写入的环 */
+};
+
+} //namespace connection
+
+} //namespace pf_net
+
+using namespace pf_net::connection;
+
+Share::Share() :
+  block_{nullptr},
+  key_{0},
+  size_{0},
+  side_{0},
+  doorbell_{-1},
+  peer_doorbell_{-1} {
+}
+
+Share::~Share() {
+  close();
+}
+
+bool Share::process_input() {
+  if (is_disconnect()) return true;
+  if (is_null(block_)) return false;
+  auto &ring = inbound();
+  auto head = ring.head.load(std::memory_order_acquire);
+  auto tail = ring.tail.load(std::memory_order_relaxed);
+  if (head == tail) return 0 == block_->closed[1 - side_].load();
+  auto data = ring_data(1 - side_);
+  uint32_t count = head - tail;
+  uint32_t offset = tail & (size_ - 1);
+  uint32_t first = min(count, size_ - offset);
+  if (!receive(data + offset, first)) return false;
+  if (count > first && !receive(data, count - first)) return false;
+  ring.tail.store(head);
+  //The writer wait the space.
+  if (ring.waiting.load() && ring.waiting.exchange(0))
+    doorbell_ring(peer_doorbell_);
+  return true;
+}
+
+bool Share::process_output() {
+  if (is_disconnect()) return true;
+  if (is_null(block_)) return false;
+  auto &ring = outbound();
+  auto head = ring.head.load(std::memory_order_relaxed);
+  auto tail = ring.tail.load(std::memory_order_acquire);
+  uint32_t space = size_ - (head - tail);
+  auto data = ring_data(side_);
+  uint32_t count = 0;
+  while (count < space && output_pending()) {
+    uint32_t offset = (head + count) & (size_ - 1);
+    auto length =
+      ostream().drain(data + offset, min(space - count, size_ - offset));
+    if (0 == length) break;
+    count += length;
+  }
+  if (count > 0) {
+    ring.head.store(head + count);
+    if (ring.sleeping.load() && ring.sleeping.exchange(0))
+      doorbell_ring(peer_doorbell_);
+  }
+  //The ring is full, the reader ring the doorbell after read.
+  if (output_pending()) ring.waiting.store(1);
+  output_update();
+  return true;
+}
+
+bool Share::open(uint32_t key, uint32_t size) {
+#if OS_UNIX
+  close();
+  side_ = 0;
+  //Create the doorbells before the segment, the client attach after ready.
+  for (uint8_t side = 0; side < 2; ++side) {
+    auto path = doorbell_path(key, side);
+    unlink(path.c_str());
+    if (mkfifo(path.c_str(), 0600) != 0) {
+      SLOW_ERRORLOG(NET_MODULENAME,
+                    "[net.connection] (Share::open) mkfifo error: %s, %s",
+                    path.c_str(),
+                    strerror(errno));
+      return false;
+    }
+  }
+  if (!map(key, size, true)) {
+    unlink(doorbell_path(key, 0).c_str());
+    unlink(doorbell_path(key, 1).c_str());
+    return false;
+  }
+  block_->size = size_;
+  block_->pids[0] = pf_sys::process::getid();
+  block_->pids[1] = 0;
+  for (uint8_t side = 0; side < 2; ++side) {
+    auto &ring = block_->rings[side];
+    block_->closed[side] = 0;
+    ring.head = ring.waiting = ring.tail = ring.sleeping = 0;
+  }
+  block_->magic = SHARE_MAGIC;
+  return true;
+#else
+  UNUSED(key);
+  UNUSED(size);
+  return false;
+#endif
+}
+
+bool Share::attach(uint32_t key, uint32_t size) {
+#if OS_UNIX
+  close();
+  side_ = 1;
+  if (!map(key, size, false)) return false;
+  //The other client attached and alive.
+  int32_t pid = block_->pids[1];
+  bool attached = pid > 0 && kill(pid, 0) == 0;
+  if (block_->magic != SHARE_MAGIC || block_->size != size_ ||
+      block_->closed[0] != 0 || attached) {
+    SLOW_ERRORLOG(NET_MODULENAME,
+                  "[net.connection] (Share::attach) the segment not ready"
+                  " or attached, key: %u",
+                  key);
+    //Not notify the peers of segment.
+    block_ = nullptr;
+    segment_.release();
+    close();
+    return false;
+  }
+  block_->pids[1] = pf_sys::process::getid();
+  doorbell_ring(peer_doorbell_);
+  return true;
+#else
+  UNUSED(key);
+  UNUSED(size);
+  return false;
+#endif
+}
+
+void Share::close() {
+#if OS_UNIX
+  if (!is_null(block_)) {
+    block_->closed[side_] = 1;
+    doorbell_ring(peer_doorbell_);
+    if (is_service()) {
+      unlink(doorbell_path(key_, 0).c_str());
+      unlink(doorbell_path(key_, 1).c_str());
+    }
+    segment_.release();
+    block_ = nullptr;
+  }
+  if (doorbell_ >= 0) ::close(doorbell_);
+  if (peer_doorbell_ >= 0) ::close(peer_doorbell_);
+#endif
+  doorbell_ = peer_doorbell_ = -1;
+  key_ = size_ = 0;
+}
+
+bool Share::peer_attached() const {
+  return !is_null(block_) && block_->pids[1 - side_] != 0;
+}
+
+bool Share::peer_lost() const {
+  if (is_null(block_)) return true;
+  if (block_->closed[1 - side_] != 0) return true;
+  int32_t pid = block_->pids[1 - side_];
+#if OS_UNIX
+  if (pid > 0 && kill(pid, 0) != 0 && ESRCH == errno) return true;
+#endif
+  return false;
+}
+
+bool Share::output_writable() const {
+  if (is_null(block_) || !output_pending()) return false;
+  auto &ring = block_->rings[side_];
+  return ring.head.load(std::memory_order_relaxed) - ring.tail.load() < size_;
+}
+
+bool Share::sleep() {
+  if (is_null(block_)) return true;
+  auto &ring = inbound();
+  ring.sleeping.store(1);
+  //Keep polling, the writer not ring it.
+  if (ring.head.load() != ring.tail.load(std::memory_order_relaxed) ||
+      output_writable() || block_->closed[1 - side_] != 0) {
+    ring.sleeping.store(0, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+void Share::wake() {
+  if (!is_null(block_))
+    inbound().sleeping.store(0, std::memory_order_relaxed);
+#if OS_UNIX
+  if (doorbell_ < 0) return;
+  char buffer[64];
+  while (::read(doorbell_, buffer, sizeof(buffer)) > 0) {}
+#endif
+}
+
+bool Share::map(uint32_t key, uint32_t size, bool create) {
+  //The ring positions wrap by the mask.
+  uint32_t length = SHARE_ALIGN;
+  while (length < size && length < (1u << 30)) length <<= 1;
+  size_t total = sizeof(pf_sys::memory::share::header_t) + SHARE_ALIGN +
+                 sizeof(share_block_struct) + length * 2;
+  bool result = create ? segment_.create(key, total) :
+                         segment_.attach(key, total);
+  if (!result) {
+    SLOW_ERRORLOG(NET_MODULENAME,
+                  "[net.connection] (Share::map) segment error, key: %u"
+                  " size: %u",
+                  key,
+                  size);
+    return false;
+  }
+  auto address = reinterpret_cast<uintptr_t>(segment_.get());
+  address = (address + SHARE_ALIGN - 1) &
+            ~static_cast<uintptr_t>(SHARE_ALIGN - 1);
+  block_ = reinterpret_cast<share_block_struct *>(address);
+  key_ = key;
+  size_ = length;
+#if OS_UNIX
+  doorbell_ =
+    ::open(doorbell_path(key, side_).c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+  peer_doorbell_ =
+    ::open(doorbell_path(key, 1 - side_).c_str(),
+           O_RDWR | O_NONBLOCK | O_CLOEXEC);
+  if (doorbell_ < 0 || peer_doorbell_ < 0) {
+    SLOW_ERRORLOG(NET_MODULENAME,
+                  "[net.connection] (Share::map) doorbell error: %s, key: %u",
+                  strerror(errno),
+                  key);
+    block_ = nullptr;
+    segment_.release();
+    close();
+    return false;
+  }
+#endif
+  return true;
+}
+
+share_ring_struct &Share::inbound() {
+  return block_->rings[1 - side_];
+}
+
+share_ring_struct &Share::outbound() {
+  return block_->rings[side_];
+}
+
+char *Share::ring_data(uint8_t side) {
+  return reinterpret_cast<char *>(block_ + 1) + size_ * side;
+}
+
+void Share::doorbell_ring(int32_t fd) {
+#if OS_UNIX
+  if (fd < 0) return;
+  char value{1};
+  auto result = ::write(fd, &value, sizeof(value));
+  UNUSED(result);
+#else
+  UNUSED(fd);
+#endif
+}
+
+std::string Share::doorbell_path(uint32_t key, uint8_t side) {
+  char path[FILENAME_MAX]{0};
+  snprintf(path, sizeof(path) - 1, "%s_%u_%u",
+           NET_SHARE_DOORBELL_PATH, key, side);
+  return path;
+}
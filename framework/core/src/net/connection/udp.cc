@@ -0,0 +1,719 @@
+#include "pf/basic/logger.h"
+#include "pf/basic/time_manager.h"
+#include "pf/net/packet/config.h"
+#include "pf/net/connection/manager/interface.h"
+#include "pf/net/connection/udp.h"
+
+namespace pf_net {
+
+namespace connection {
+
+//The frame types of datagram.
+enum {
+  kUdpFrameConnect = 1,
+  kUdpFrameAccept,
+  kUdpFramePing,
+  kUdpFrameClose,
+  kUdpFrameAck,
+  kUdpFrameData,
+  kUdpFrameChallenge,
+};
+
+#define NET_UDP_SESSION_SIZE 4
+#define NET_UDP_CONNECT_SIZE (1 + 4)
+#define NET_UDP_ACK_SIZE (1 + 4 + 2 + 1)
+#define NET_UDP_ACK_BLOCK_SIZE (4 + 2)
+#define NET_UDP_DATA_SIZE (1 + 1 + 4 + 4 + 2 + 2 + 2)
+//The max data of a fragment.
+#define NET_UDP_MSS (NET_UDP_MTU - NET_UDP_SESSION_SIZE - NET_UDP_DATA_SIZE)
+
+//The sequence compare with wrap around.
+static inline int32_t sequence_diff(uint32_t a, uint32_t b) {
+  return static_cast<int32_t>(a - b);
+}
+
+template <typename T>
+static inline char *put(char *pointer, T value) {
+  memcpy(pointer, &value, sizeof(value));
+  return pointer + sizeof(value);
+}
+
+template <typename T>
+static inline const char *get(const char *pointer, T &value) {
+  memcpy(&value, pointer, sizeof(value));
+  return pointer + sizeof(value);
+}
+
+//Never destroy, the same as the output budget.
+static std::atomic<uint8_t> *channels() {
+  static std::atomic<uint8_t> *data = []() {
+    auto result = new std::atomic<uint8_t>[NET_PACKET_ID_MAX + 1];
+    for (uint32_t i = 0; i <= NET_PACKET_ID_MAX; ++i)
+      result[i] = kUdpChannelReliable;
+    return result;
+  }();
+  return data;
+}
+
+Udp::Udp() :
+  output_{nullptr},
+  session_{0},
+  client_{false},
+  connected_{false},
+  connect_time_{0},
+  connect_deadline_{0},
+  cookie_{0},
+  reassembly_size_{0},
+  accept_pending_{false},
+  ack_pending_{false},
+  last_send_{0},
+  last_receive_{0},
+  update_timer_{0},
+  update_time_{0},
+  send_una_{0},
+  send_next_{0},
+  remote_window_{NET_UDP_WINDOW},
+  srtt_{0},
+  rttvar_{0},
+  rto_{NET_UDP_RTO_DEFAULT},
+  retransmits_{0},
+  receive_next_{0},
+  ordered_next_{0},
+  window_advertised_{NET_UDP_WINDOW},
+  datagram_size_{0},
+  delivered_{false},
+  sent_{false} {
+  memset(&address_, 0, sizeof(address_));
+  memset(messages_, 0, sizeof(messages_));
+  received_.resize(NET_UDP_WINDOW, 0);
+}
+
+Udp::~Udp() {
+  //do nothing
+}
+
+uint32_t Udp::session(const char *data, uint32_t size) {
+  uint32_t result{0};
+  if (size < NET_UDP_SESSION_SIZE + 1) return result;
+  get(data, result);
+  return result;
+}
+
+bool Udp::connecting(const char *data, uint32_t size) {
+  return session(data, size) != 0 &&
+         kUdpFrameConnect == data[NET_UDP_SESSION_SIZE];
+}
+
+uint32_t Udp::cookie(const char *data, uint32_t size) {
+  uint32_t result{0};
+  if (size < NET_UDP_SESSION_SIZE + NET_UDP_CONNECT_SIZE ||
+      0 == session(data, size)) return result;
+  uint8_t type = static_cast<uint8_t>(data[NET_UDP_SESSION_SIZE]);
+  if (type != kUdpFrameConnect && type != kUdpFrameChallenge) return result;
+  get(data + NET_UDP_SESSION_SIZE + 1, result);
+  return result;
+}
+
+bool Udp::challenging(const char *data, uint32_t size) {
+  return session(data, size) != 0 &&
+         kUdpFrameChallenge == data[NET_UDP_SESSION_SIZE];
+}
+
+uint32_t Udp::challenge(char *data, uint32_t session, uint32_t cookie) {
+  char *pointer = put(data, session);
+  pointer = put(pointer, static_cast<uint8_t>(kUdpFrameChallenge));
+  pointer = put(pointer, cookie);
+  return static_cast<uint32_t>(pointer - data);
+}
+
+uint8_t Udp::channel(uint16_t packet_id) {
+  return channels()[packet_id].load(std::memory_order_relaxed);
+}
+
+void Udp::set_channel(uint16_t packet_id, uint8_t channel) {
+  if (channel >= kUdpChannelMax) return;
+  channels()[packet_id] = channel;
+}
+
+void Udp::reset() {
+  session_ = 0;
+  client_ = false;
+  connected_ = false;
+  cookie_ = 0;
+  accept_pending_ = false;
+  ack_pending_ = false;
+  update_timer_ = 0;
+  update_time_ = 0;
+  send_queue_.clear();
+  send_buffer_.clear();
+  unreliables_.clear();
+  send_una_ = send_next_ = 0;
+  memset(messages_, 0, sizeof(messages_));
+  remote_window_ = NET_UDP_WINDOW;
+  srtt_ = rttvar_ = 0;
+  rto_ = NET_UDP_RTO_DEFAULT;
+  retransmits_ = 0;
+  receive_next_ = 0;
+  std::fill(received_.begin(), received_.end(), 0);
+  ordered_next_ = 0;
+  ordered_.clear();
+  unordered_.clear();
+  unreliable_.clear();
+  reassembly_size_ = 0;
+  window_advertised_ = NET_UDP_WINDOW;
+  datagram_size_ = 0;
+}
+
+void Udp::open(const struct sockaddr_in &address,
+               uint32_t session,
+               bool client,
+               uint32_t now,
+               uint32_t timeout) {
+  reset();
+  address_ = address;
+  session_ = session;
+  client_ = client;
+  connected_ = !client;
+  accept_pending_ = !client;
+  connect_time_ = now;
+  connect_deadline_ = now + (0 == timeout ? NET_UDP_TIMEOUT : timeout);
+  last_send_ = last_receive_ = now;
+}
+
+void Udp::close(bool notify) {
+  if (notify && connected_ && session_ != 0) {
+    frame(1)[0] = kUdpFrameClose;
+    flush();
+  }
+  reset();
+}
+
+bool Udp::send(packet::Interface *packet) {
+  return send(packet, channel(packet->get_id()));
+}
+
+bool Udp::send(packet::Interface *packet, uint8_t channel) {
+  if (kUdpChannelReliable == channel || channel >= kUdpChannelMax)
+    return Basic::send(packet);
+  if (is_disconnect()) return true;
+  auto protocol = get_protocol();
+  std::string data{""};
+  //The protocol not support encode, send in the stream.
+  if (is_null(protocol) || !protocol->encode(packet, data))
+    return Basic::send(packet);
+  auto size = static_cast<uint32_t>(data.size());
+  if (ostream().encrypt_isenable())
+    ostream().getencryptor()->encrypt(&data[0], data.data(), size);
+  message_push(channel, data.data(), size);
+  if (get_manager()) get_manager()->output_dirty(this);
+  return true;
+}
+
+bool Udp::process_output() {
+  if (is_disconnect()) return true;
+  return update(TIME_MANAGER_POINTER->get_tickcount());
+}
+
+void Udp::message_push(uint8_t channel, const char *data, uint32_t size) {
+  uint32_t fragments = 0 == size ? 1 : (size + NET_UDP_MSS - 1) / NET_UDP_MSS;
+  if (fragments > NET_UDP_FRAGMENTS_MAX) {
+    SLOW_ERRORLOG(NET_MODULENAME,
+                  "[net.connection] (Udp::message_push)"
+                  " the message too large: %u",
+                  size);
+    return;
+  }
+  auto message = messages_[channel]++;
+  uint32_t offset{0};
+  for (uint32_t i = 0; i < fragments; ++i) {
+    uint32_t length = min(size - offset, static_cast<uint32_t>(NET_UDP_MSS));
+    segment_t segment;
+    segment.sequence = 0;
+    segment.channel = channel;
+    segment.message = message;
+    segment.fragment = static_cast<uint16_t>(i);
+    segment.fragments = static_cast<uint16_t>(fragments);
+    segment.data.assign(data + offset, length);
+    segment.send_time = segment.resend_time = 0;
+    segment.rto = 0;
+    segment.transmits = segment.skipped = 0;
+    segment.acked = false;
+    offset += length;
+    if (kUdpChannelUnreliable == channel) {
+      unreliables_.emplace_back(std::move(segment));
+    } else {
+      send_queue_.emplace_back(std::move(segment));
+    }
+  }
+}
+
+bool Udp::update(uint32_t now) {
+  if (0 == session_) return true;
+  sent_ = false;
+  if (!connected_) {
+    if (sequence_diff(now, connect_deadline_) >= 0) return false;
+    if (sequence_diff(now, connect_time_) >= 0) {
+      char *pointer = frame(NET_UDP_CONNECT_SIZE);
+      pointer = put(pointer, static_cast<uint8_t>(kUdpFrameConnect));
+      put(pointer, cookie_);
+      connect_time_ = now + rto_;
+    }
+    flush();
+    if (sent_) last_send_ = now;
+    return true;
+  }
+  if (sequence_diff(now, last_receive_) >= NET_UDP_TIMEOUT) return false;
+  if (accept_pending_) {
+    frame(1)[0] = kUdpFrameAccept;
+    accept_pending_ = false;
+  }
+  //The window opened, tell the peer.
+  if (0 == window_advertised_ && window() > 0) ack_pending_ = true;
+  if (ack_pending_) frame_ack();
+  //The output stream move to one message when the queue empty, so the
+  //message is whole packets(the stream is written by packets).
+  if (send_queue_.empty() && output_pending()) {
+    auto size = static_cast<uint32_t>(ostream().size());
+    size = min(size, static_cast<uint32_t>(NET_UDP_FRAGMENTS_MAX * NET_UDP_MSS));
+    uint32_t fragments = (size + NET_UDP_MSS - 1) / NET_UDP_MSS;
+    auto message = messages_[kUdpChannelReliable]++;
+    for (uint32_t i = 0; i < fragments; ++i) {
+      segment_t segment;
+      segment.sequence = 0;
+      segment.channel = kUdpChannelReliable;
+      segment.message = message;
+      segment.fragment = static_cast<uint16_t>(i);
+      segment.fragments = static_cast<uint16_t>(fragments);
+      segment.data.resize(min(size, static_cast<uint32_t>(NET_UDP_MSS)));
+      auto length = ostream().drain(
+          &segment.data[0], static_cast<uint32_t>(segment.data.size()));
+      segment.data.resize(length);
+      size -= length;
+      segment.send_time = segment.resend_time = 0;
+      segment.rto = 0;
+      segment.transmits = segment.skipped = 0;
+      segment.acked = false;
+      send_queue_.emplace_back(std::move(segment));
+    }
+    output_update();
+  }
+  uint32_t limit = min(static_cast<uint32_t>(NET_UDP_WINDOW),
+                       static_cast<uint32_t>(remote_window_));
+  while (!send_queue_.empty() && send_buffer_.size() < limit) {
+    send_buffer_.emplace_back(std::move(send_queue_.front()));
+    send_queue_.pop_front();
+    send_buffer_.back().sequence = send_next_++;
+  }
+  for (auto &segment : send_buffer_) {
+    if (segment.acked) continue;
+    if (0 == segment.transmits) {
+      segment.rto = rto_;
+    } else if (sequence_diff(now, segment.resend_time) >= 0) {
+      segment.rto = min(segment.rto + segment.rto / 2,
+                        static_cast<uint32_t>(NET_UDP_RTO_MAX));
+      ++retransmits_;
+    } else if (segment.skipped >= NET_UDP_FAST_RESEND) {
+      segment.skipped = 0;
+      ++retransmits_;
+    } else {
+      continue;
+    }
+    if (segment.transmits >= NET_UDP_DEAD_LINK) {
+      SLOW_WARNINGLOG(NET_MODULENAME,
+                      "[net.connection] (Udp::update)"
+                      " dead link, id: %d, sequence: %u",
+                      get_id(),
+                      segment.sequence);
+      return false;
+    }
+    ++segment.transmits;
+    segment.send_time = now;
+    segment.resend_time = now + segment.rto;
+    frame_segment(segment);
+  }
+  for (auto &segment : unreliables_) frame_segment(segment);
+  unreliables_.clear();
+  //Keep alive when idle, and probe the zero window.
+  auto ping = 0 == remote_window_ && !send_queue_.empty() ?
+              rto_ : static_cast<uint32_t>(NET_UDP_PING_TIME);
+  if (0 == datagram_size_ && !sent_ &&
+      sequence_diff(now, last_send_) >= static_cast<int32_t>(ping))
+    frame(1)[0] = kUdpFramePing;
+  flush();
+  if (sent_) last_send_ = now;
+  return true;
+}
+
+uint32_t Udp::check(uint32_t now) const {
+  if (0 == session_) return NET_UDP_PING_TIME;
+  if (!connected_) {
+    auto result = min(sequence_diff(connect_time_, now),
+                      sequence_diff(connect_deadline_, now));
+    return result > 0 ? static_cast<uint32_t>(result) : 0;
+  }
+  if (accept_pending_ || ack_pending_ || !unreliables_.empty()) return 0;
+  if (send_queue_.empty() && output_pending()) return 0;
+  uint32_t limit = min(static_cast<uint32_t>(NET_UDP_WINDOW),
+                       static_cast<uint32_t>(remote_window_));
+  if (!send_queue_.empty() && send_buffer_.size() < limit) return 0;
+  auto ping = 0 == remote_window_ && !send_queue_.empty() ?
+              rto_ : static_cast<uint32_t>(NET_UDP_PING_TIME);
+  int32_t result = sequence_diff(last_send_ + ping, now);
+  result = min(result, sequence_diff(last_receive_ + NET_UDP_TIMEOUT, now));
+  //Wait the input executed and the window opened.
+  if (0 == window_advertised_)
+    result = min(result, static_cast<int32_t>(NET_MANAGER_TIMER_PRECISION));
+  for (auto &segment : send_buffer_) {
+    if (segment.acked) continue;
+    if (segment.skipped >= NET_UDP_FAST_RESEND) return 0;
+    result = min(result, sequence_diff(segment.resend_time, now));
+  }
+  return result > 0 ? static_cast<uint32_t>(result) : 0;
+}
+
+bool Udp::input(const char *data, uint32_t size, uint32_t now) {
+  if (session(data, size) != session_ || 0 == session_) return true;
+  //The service ask the cookie, connect again with it now.
+  if (challenging(data, size)) {
+    if (client_ && !connected_) {
+      cookie_ = cookie(data, size);
+      connect_time_ = now;
+    }
+    return true;
+  }
+  last_receive_ = now;
+  set_alive(true);
+  //Any datagram of the session say the peer accepted.
+  connected_ = true;
+  delivered_ = false;
+  bool acked{false};
+  const char *pointer = data + NET_UDP_SESSION_SIZE;
+  const char *end = data + size;
+  bool valid{true};
+  while (valid && pointer < end) {
+    uint8_t type = static_cast<uint8_t>(*pointer++);
+    switch (type) {
+      case kUdpFrameConnect:
+        if (end - pointer < NET_UDP_CONNECT_SIZE - 1) {
+          valid = false;
+          break;
+        }
+        pointer += NET_UDP_CONNECT_SIZE - 1;
+        //The accept lost, send again.
+        if (!client_) accept_pending_ = true;
+        break;
+      case kUdpFrameAccept:
+        break;
+      case kUdpFramePing:
+        ack_pending_ = true;
+        break;
+      case kUdpFrameClose:
+        return false;
+      case kUdpFrameAck: {
+        if (end - pointer < NET_UDP_ACK_SIZE - 1) {
+          valid = false;
+          break;
+        }
+        uint32_t una{0};
+        uint16_t window{0};
+        uint8_t count{0};
+        pointer = get(pointer, una);
+        pointer = get(pointer, window);
+        pointer = get(pointer, count);
+        if (end - pointer < count * NET_UDP_ACK_BLOCK_SIZE) {
+          valid = false;
+          break;
+        }
+        ack_input(una, window, pointer, count, now);
+        pointer += count * NET_UDP_ACK_BLOCK_SIZE;
+        acked = true;
+        break;
+      }
+      case kUdpFrameData: {
+        if (end - pointer < NET_UDP_DATA_SIZE - 1) {
+          valid = false;
+          break;
+        }
+        uint8_t channel{0};
+        uint32_t sequence{0};
+        uint32_t message{0};
+        uint16_t fragment{0};
+        uint16_t fragments{0};
+        uint16_t length{0};
+        pointer = get(pointer, channel);
+        pointer = get(pointer, sequence);
+        pointer = get(pointer, message);
+        pointer = get(pointer, fragment);
+        pointer = get(pointer, fragments);
+        pointer = get(pointer, length);
+        //The fragments over the limit never sent by the peer, drop them.
+        if (end - pointer < length || channel >= kUdpChannelMax ||
+            0 == fragments || fragment >= fragments ||
+            fragments > NET_UDP_FRAGMENTS_MAX) {
+          valid = false;
+          break;
+        }
+        if (!data_input(channel,
+                        sequence,
+                        message,
+                        fragment,
+                        fragments,
+                        pointer,
+                        length)) return false;
+        pointer += length;
+        break;
+      }
+      default: //Unknown, ignore the rest.
+        valid = false;
+        break;
+    }
+  }
+  auto manager = get_manager();
+  if (manager) {
+    if (delivered_) manager->input_dirty(this);
+    if (ack_pending_ || accept_pending_ ||
+        (acked && (!send_queue_.empty() || output_pending())))
+      manager->output_dirty(this);
+  }
+  return true;
+}
+
+void Udp::ack_input(uint32_t una,
+                    uint16_t window,
+                    const char *blocks,
+                    uint8_t count,
+                    uint32_t now) {
+  remote_window_ = window;
+  while (!send_buffer_.empty() &&
+         sequence_diff(una, send_buffer_.front().sequence) > 0) {
+    auto &segment = send_buffer_.front();
+    if (!segment.acked) acked(segment, now);
+    send_buffer_.pop_front();
+  }
+  if (sequence_diff(una, send_una_) > 0) send_una_ = una;
+  if (send_buffer_.empty()) return;
+  //The selective blocks, the segments before the highest are skipped.
+  uint32_t highest = una;
+  for (uint8_t i = 0; i < count; ++i) {
+    uint32_t start{0};
+    uint16_t length{0};
+    blocks = get(blocks, start);
+    blocks = get(blocks, length);
+    if (length > NET_UDP_WINDOW) length = NET_UDP_WINDOW;
+    for (uint16_t k = 0; k < length; ++k) {
+      auto offset = sequence_diff(start + k, send_buffer_.front().sequence);
+      if (offset < 0) continue;
+      if (offset >= static_cast<int32_t>(send_buffer_.size())) break;
+      auto &segment = send_buffer_[offset];
+      if (!segment.acked) acked(segment, now);
+    }
+    if (length > 0 && sequence_diff(start + length - 1, highest) > 0)
+      highest = start + length - 1;
+  }
+  for (auto &segment : send_buffer_) {
+    if (sequence_diff(segment.sequence, highest) >= 0) break;
+    if (!segment.acked && segment.transmits > 0) ++segment.skipped;
+  }
+  while (!send_buffer_.empty() && send_buffer_.front().acked) {
+    send_una_ = send_buffer_.front().sequence + 1;
+    send_buffer_.pop_front();
+  }
+}
+
+void Udp::acked(segment_t &segment, uint32_t now) {
+  segment.acked = true;
+  segment.data.clear();
+  //Only the segment not resend have the right sample.
+  if (segment.transmits != 1) return;
+  uint32_t rtt = now - segment.send_time;
+  if (0 == srtt_) {
+    srtt_ = max(rtt, static_cast<uint32_t>(1));
+    rttvar_ = rtt / 2;
+  } else {
+    uint32_t delta = rtt > srtt_ ? rtt - srtt_ : srtt_ - rtt;
+    rttvar_ = (3 * rttvar_ + delta) / 4;
+    srtt_ = max((7 * srtt_ + rtt) / 8, static_cast<uint32_t>(1));
+  }
+  uint32_t rto = srtt_ + max(static_cast<uint32_t>(NET_MANAGER_TIMER_PRECISION),
+                             4 * rttvar_);
+  rto_ = min(max(rto, static_cast<uint32_t>(NET_UDP_RTO_MIN)),
+             static_cast<uint32_t>(NET_UDP_RTO_MAX));
+}
+
+bool Udp::data_input(uint8_t channel,
+                     uint32_t sequence,
+                     uint32_t message,
+                     uint16_t fragment,
+                     uint16_t fragments,
+                     const char *data,
+                     uint16_t length) {
+  if (kUdpChannelUnreliable == channel) {
+    if (!deliver(unreliable_, message, fragment, fragments, data, length, 
+                 false)) return false;
+    //The incomplete(lost fragments) drop the oldest.
+    if (unreliable_.size() > NET_UDP_UNRELIABLE_HOLD)
+      release(unreliable_, unreliable_.begin());
+    return true;
+  }
+  ack_pending_ = true;
+  auto offset = sequence_diff(sequence, receive_next_);
+  if (offset < 0 || offset >= NET_UDP_WINDOW) return true; //Repeated or out.
+  auto &flag = received_[sequence % NET_UDP_WINDOW];
+  if (flag) return true;
+  flag = 1;
+  while (received_[receive_next_ % NET_UDP_WINDOW]) {
+    received_[receive_next_ % NET_UDP_WINDOW] = 0;
+    ++receive_next_;
+  }
+  if (kUdpChannelUnordered == channel) {
+    if (unordered_.size() >= NET_UDP_WINDOW &&
+        unordered_.find(message) == unordered_.end()) return false;
+    return deliver(unordered_, message, fragment, fragments, data, length, 
+                   true);
+  }
+  //The ordered messages deliver from the next.
+  if (sequence_diff(message, ordered_next_) < 0) return true;
+  if (ordered_.size() >= NET_UDP_WINDOW &&
+      ordered_.find(message) == ordered_.end()) return false;
+  auto &item = ordered_[message];
+  if (item.fragments.empty()) item.count = fragments;
+  if (item.count != fragments || !keep(item, fragment, data, length))
+    return false;
+  for (auto it = ordered_.find(ordered_next_);
+       it != ordered_.end() && it->second.fragments.size() == it->second.count;
+       it = ordered_.find(ordered_next_)) {
+    std::string whole{""};
+    for (auto &part : it->second.fragments) whole.append(part.second);
+    release(ordered_, it);
+    ++ordered_next_;
+    if (!receive(whole.data(), static_cast<uint32_t>(whole.size())))
+      return false;
+    delivered_ = true;
+  }
+  return true;
+}
+
+bool Udp::deliver(std::map<uint32_t, message_t> &messages,
+                  uint32_t message,
+                  uint16_t fragment,
+                  uint16_t fragments,
+                  const char *data,
+                  uint16_t length,
+                  bool reliable) {
+  auto it = messages.find(message);
+  if (it == messages.end()) {
+    it = messages.emplace(message, message_t()).first;
+    it->second.count = fragments;
+  }
+  auto &item = it->second;
+  if (item.count != fragments) return false;
+  if (!keep(item, fragment, data, length)) {
+    //The unreliable only drop it, the reliable can't continue without it.
+    if (item.fragments.empty()) messages.erase(it);
+    return !reliable;
+  }
+  if (item.fragments.size() != item.count) return true;
+  std::string whole{""};
+  for (auto &part : item.fragments) whole.append(part.second);
+  release(messages, it);
+  if (!receive(whole.data(), static_cast<uint32_t>(whole.size())))
+    return false;
+  delivered_ = true;
+  return true;
+}
+
+bool Udp::keep(message_t &item,
+               uint16_t fragment,
+               const char *data,
+               uint16_t length) {
+  if (item.fragments.find(fragment) != item.fragments.end()) return true;
+  if (reassembly_size_ + length > NET_UDP_REASSEMBLY_MAX) {
+    SLOW_WARNINGLOG(NET_MODULENAME,
+                    "[net.connection] (Udp::keep)"
+                    " the reassembly over limit, id: %d, size: %u",
+                    get_id(),
+                    reassembly_size_);
+    return false;
+  }
+  item.fragments[fragment].assign(data, length);
+  item.size += length;
+  reassembly_size_ += length;
+  return true;
+}
+
+void Udp::release(std::map<uint32_t, message_t> &messages,
+                  std::map<uint32_t, message_t>::iterator it) {
+  reassembly_size_ -= it->second.size;
+  messages.erase(it);
+}
+
+uint16_t Udp::window() {
+  return istream().size() >= NET_UDP_INPUT_LIMIT ? 0 : NET_UDP_WINDOW;
+}
+
+char *Udp::frame(uint32_t size) {
+  if (datagram_size_ + size > NET_UDP_MTU) flush();
+  if (0 == datagram_size_) {
+    put(datagram_, session_);
+    datagram_size_ = NET_UDP_SESSION_SIZE;
+  }
+  char *result = datagram_ + datagram_size_;
+  datagram_size_ += size;
+  return result;
+}
+
+void Udp::frame_ack() {
+  //The received blocks after the next sequence.
+  uint32_t starts[NET_UDP_ACK_BLOCKS];
+  uint16_t lengths[NET_UDP_ACK_BLOCKS];
+  uint8_t count{0};
+  for (uint32_t offset = 1;
+       offset < NET_UDP_WINDOW && count < NET_UDP_ACK_BLOCKS;
+       ++offset) {
+    uint32_t sequence = receive_next_ + offset;
+    if (!received_[sequence % NET_UDP_WINDOW]) continue;
+    if (count > 0 && starts[count - 1] + lengths[count - 1] == sequence) {
+      ++lengths[count - 1];
+    } else {
+      starts[count] = sequence;
+      lengths[count] = 1;
+      ++count;
+    }
+  }
+  window_advertised_ = window();
+  char *pointer = frame(NET_UDP_ACK_SIZE + count * NET_UDP_ACK_BLOCK_SIZE);
+  pointer = put(pointer, static_cast<uint8_t>(kUdpFrameAck));
+  pointer = put(pointer, receive_next_);
+  pointer = put(pointer, window_advertised_);
+  pointer = put(pointer, count);
+  for (uint8_t i = 0; i < count; ++i) {
+    pointer = put(pointer, starts[i]);
+    pointer = put(pointer, lengths[i]);
+  }
+  ack_pending_ = false;
+}
+
+void Udp::frame_segment(const segment_t &segment) {
+  auto length = static_cast<uint16_t>(segment.data.size());
+  char *pointer = frame(NET_UDP_DATA_SIZE + length);
+  pointer = put(pointer, static_cast<uint8_t>(kUdpFrameData));
+  pointer = put(pointer, segment.channel);
+  pointer = put(pointer, segment.sequence);
+  pointer = put(pointer, segment.message);
+  pointer = put(pointer, segment.fragment);
+  pointer = put(pointer, segment.fragments);
+  pointer = put(pointer, length);
+  if (length > 0) memcpy(pointer, segment.data.data(), length);
+}
+
+void Udp::flush() {
+  if (datagram_size_ > NET_UDP_SESSION_SIZE && !is_null(output_)) {
+    output_(address_, datagram_, datagram_size_);
+    sent_ = true;
+  }
+  datagram_size_ = 0;
+}
+
+} //namespace connection
+
+} //namespace pf_net
@@ -30,6 +30,7 @@ Dynamic::~Dynamic() {
 }
 
 void Dynamic::clear() {
+  Interface::clear();
   allocator_.malloc(2048);
   offset_ = 0;
   size_ = 0;
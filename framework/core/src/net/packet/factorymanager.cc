@@ -15,6 +15,35 @@ namespace pf_net {
 
 namespace packet {
 
+//The packets cache of every thread, no lock in steady state.
+struct thread_cache_t {
+  uint64_t owner;
+  std::vector< std::vector<Interface *> > lists;
+  thread_cache_t() : owner{0} {}
+  ~thread_cache_t() { clear(); }
+  void clear() {
+    for (auto &list : lists) {
+      for (auto packet : list) safe_delete(packet);
+    }
+    lists.clear();
+  }
+};
+
+static std::atomic<uint64_t> g_factorymanager_serial{0};
+static thread_local thread_cache_t g_thread_cache;
+
+static std::vector<Interface *> &thread_cache_list(uint64_t owner, 
+                                                   uint16_t index,
+                                                   size_t count) {
+  auto &cache = g_thread_cache;
+  if (cache.owner != owner) { //Manager recreated, the old packets no use.
+    cache.clear();
+    cache.owner = owner;
+  }
+  if (cache.lists.size() < count) cache.lists.resize(count);
+  return cache.lists[index];
+}
+
 FactoryManager *FactoryManager::getsingleton_pointer() {
   return singleton_;
 }
@@ -34,6 +63,9 @@ FactoryManager::FactoryManager() :
   function_is_valid_dynamic_packet_id_{nullptr},
   //function_is_encrypt_packet_id_{nullptr},
   function_packet_execute_{nullptr} {
+  serial_ = ++g_factorymanager_serial;
+  frozen_ = false;
+  track_ = false;
   alloc_packets_.init(NET_PACKET_FACTORYMANAGER_ALLOCMAX);
 }
 
@@ -46,6 +78,11 @@ FactoryManager::~FactoryManager() {
        ++_iterator) {
     safe_delete(_iterator->second);
   }
+  //Other threads cache will free when thread exit or used next.
+  if (g_thread_cache.owner == serial_) g_thread_cache.clear();
+  for (auto &list : pools_) {
+    for (auto packet : list) safe_delete(packet);
+  }
   for (i = 0; i < size_; ++i) {
     safe_delete(factories_[i]);
   }
@@ -71,6 +108,7 @@ bool FactoryManager::init() {
   packet_alloc_size_ = new uint32_t[size_];
   Assert(packet_alloc_size_);
   id_indexs_.init(size_); //ID索引数组初始化
+  pools_.resize(size_ + 1);
   uint16_t i;
   for (i = 0; i < size_; ++i) {
     factories_[i] = nullptr;
@@ -80,26 +118,85 @@ bool FactoryManager::init() {
       !(*function_register_factories_)()) return false;
   //Handshake.
   add_factory(new HandshakeFactory);
+  std::unique_ptr<dispatch_t[]> dispatches(
+      new dispatch_t[NET_PACKET_ID_MAX + 1]);
+  dispatches_ = std::move(dispatches);
   ready_ = true;
+  dispatch_build();
+  return true;
+}
+
+void FactoryManager::dispatch_build() {
+  if (!ready()) return;
+  if (frozen()) {
+    SLOW_WARNINGLOG(NET_MODULENAME, 
+                    "[net.packet] (FactoryManager::dispatch_build)"
+                    " the dispatch table is frozen");
+    return;
+  }
+  for (uint32_t id = 0; id <= NET_PACKET_ID_MAX; ++id)
+    dispatch_set(static_cast<uint16_t>(id));
+}
+
+void FactoryManager::dispatch_set(uint16_t id) {
+  dispatch_t &dispatch = dispatches_[id];
+  uint8_t flags{0};
+  bool normal = function_is_valid_packet_id_ ? 
+                (*function_is_valid_packet_id_)(id) :
+                NET_PACKET_ID_NORMAL_BEGIN <= id && 
+                id <= NET_PACKET_ID_NORMAL_END;
+  bool dynamic = function_is_valid_dynamic_packet_id_ ? 
+                 (*function_is_valid_dynamic_packet_id_)(id) :
+                 NET_PACKET_ID_DYNAMIC_BEGIN <= id && 
+                 id <= NET_PACKET_ID_DYNAMIC_END;
+  if (normal) flags |= kPacketDispatchFlagNormal;
+  if (dynamic) flags |= kPacketDispatchFlagDynamic;
+  if (id >= NET_PACKET_HANDSHAKE && id < NET_PACKET_ID_MAX) 
+    flags |= kPacketDispatchFlagEncrypt;
+  dispatch.flags = flags;
+  dispatch.factory = nullptr;
+  dispatch.max_size = 0;
+  dispatch.index = size_; //The dynamic packets use the last pool.
+  if (!dynamic && id_indexs_.isfind(id)) {
+    dispatch.index = id_indexs_.get(id);
+    dispatch.factory = factories_[dispatch.index];
+    if (dispatch.factory) 
+      dispatch.max_size = dispatch.factory->packet_max_size();
+  }
+}
+
+bool FactoryManager::set_packet_handler(uint16_t id, 
+                                        function_packet_execute handler) {
+  if (!ready() || frozen()) return false;
+  dispatches_[id].handler = handler;
   return true;
 }
 
 Interface *FactoryManager::packet_create(uint16_t packet_id) {
   Interface *packet = nullptr;
-  std::unique_lock<std::mutex> autolock(mutex_);
-  if (is_valid_dynamic_packet_id(packet_id)) {
-    packet = new Dynamic(packet_id);
-  } else {
-    bool is_find = id_indexs_.isfind(packet_id);
-    uint16_t index = id_indexs_.get(packet_id);
-    if (!is_find || nullptr == factories_[index]) {
-      Assert(false);
-      return nullptr;
+  const dispatch_t &dispatch = dispatches_[packet_id];
+  bool dynamic = (dispatch.flags & kPacketDispatchFlagDynamic) != 0;
+  uint16_t index = dispatch.index;
+  if (!dynamic && nullptr == dispatch.factory) {
+    Assert(false);
+    return nullptr;
+  }
+  auto &list = thread_cache_list(serial_, index, pools_.size());
+  if (list.empty()) pool_fetch(index, list);
+  if (!list.empty()) {
+    packet = list.back();
+    list.pop_back();
+    if (dynamic) {
+      packet->set_id(packet_id);
+      static_cast<Dynamic *>(packet)->set_writeable(true);
     }
-    packet = factories_[index]->packet_create();
-    ++(packet_alloc_size_[index]);
+  } else {
+    packet = dynamic ? new Dynamic(packet_id) : 
+                       dispatch.factory->packet_create();
   }
-  if (packet) { //Memory safe.
+  if (packet && track_) { //Memory safe.
+    std::unique_lock<std::mutex> autolock(mutex_);
+    if (!dynamic) ++(packet_alloc_size_[index]);
     int64_t pointer = POINTER_TOINT64(packet);
     alloc_packets_.add(pointer, packet);
   }
@@ -108,10 +205,8 @@ Interface *FactoryManager::packet_create(uint16_t packet_id) {
 
 uint32_t FactoryManager::packet_max_size(uint16_t packet_id) {
   uint32_t result = 0;
-  std::unique_lock<std::mutex> autolock(mutex_);
-  bool find_it = id_indexs_.isfind(packet_id);
-  uint16_t index = id_indexs_.get(packet_id);
-  if (!find_it || nullptr == factories_[index]) {
+  const dispatch_t &dispatch = dispatches_[packet_id];
+  if (nullptr == dispatch.factory) {
     char temp[FILENAME_MAX] = {0};
     snprintf(temp, 
              sizeof(temp) - 1, 
@@ -120,37 +215,72 @@ uint32_t FactoryManager::packet_max_size(uint16_t packet_id) {
     AssertEx(false, temp);
     return result;
   }
-  result = factories_[index]->packet_max_size();
+  result = dispatch.max_size;
   return result;
 }
 
 void FactoryManager::packet_remove(Interface *packet) {
-  std::unique_lock<std::mutex> autolock(mutex_);
   if (nullptr == packet) {
     Assert(false);
     return;
   }
   uint16_t packet_id = packet->get_id();
-  if (is_valid_dynamic_packet_id(packet_id)) {
-      int64_t pointer = POINTER_TOINT64(packet);
-      alloc_packets_.remove(pointer);
-      safe_delete(packet);
-  } else {
-    bool is_find = id_indexs_.isfind(packet_id);
-    uint16_t index = id_indexs_.get(packet_id);
-    int64_t pointer = POINTER_TOINT64(packet);
-    alloc_packets_.remove(pointer);
-    safe_delete(packet);
-    if (!is_find) {
+  const dispatch_t &dispatch = dispatches_[packet_id];
+  bool dynamic = (dispatch.flags & kPacketDispatchFlagDynamic) != 0;
+  uint16_t index = dispatch.index;
+  if (!dynamic) {
+    if (nullptr == dispatch.factory) {
       SLOW_ERRORLOG(
           NET_MODULENAME, 
           "[net.packet] (FactoryManager::packet_remove) error,"
           " can't find id index for packeid: %d",
           packet_id);
-    } else {
-      --(packet_alloc_size_[index]);
+      if (track_) {
+        std::unique_lock<std::mutex> autolock(mutex_);
+        alloc_packets_.remove(POINTER_TOINT64(packet));
+      }
+      safe_delete(packet);
+      return;
+    }
+  }
+  if (track_) {
+    std::unique_lock<std::mutex> autolock(mutex_);
+    if (!dynamic) --(packet_alloc_size_[index]);
+    int64_t pointer = POINTER_TOINT64(packet);
+    alloc_packets_.remove(pointer);
+  }
+  packet->clear();
+  auto &list = thread_cache_list(serial_, index, pools_.size());
+  list.push_back(packet);
+  if (list.size() > NET_PACKET_POOL_CACHE_SIZE) pool_put(index, list);
+}
+
+void FactoryManager::pool_fetch(uint16_t index, 
+                                std::vector<Interface *> &list) {
+  std::unique_lock<std::mutex> autolock(pool_mutex_);
+  auto &pool = pools_[index];
+  size_t count = min(pool.size(), 
+                     static_cast<size_t>(NET_PACKET_POOL_CACHE_SIZE / 2));
+  list.insert(list.end(), pool.end() - count, pool.end());
+  pool.resize(pool.size() - count);
+}
+
+void FactoryManager::pool_put(uint16_t index, std::vector<Interface *> &list) {
+  size_t count = list.size() / 2;
+  {
+    std::unique_lock<std::mutex> autolock(pool_mutex_);
+    auto &pool = pools_[index];
+    while (count > 0 && pool.size() < NET_PACKET_POOL_SIZE_MAX) {
+      pool.push_back(list.back());
+      list.pop_back();
+      --count;
     }
   }
+  //The global list is full.
+  for (; count > 0; --count) {
+    safe_delete(list.back());
+    list.pop_back();
+  }
 }
 
 void FactoryManager::add_factory(Factory *factory) {
@@ -163,9 +293,18 @@ void FactoryManager::add_factory(Factory *factory) {
     return;
   }
   if (!is_find) {
+    if (frozen()) {
+      SLOW_ERRORLOG(NET_MODULENAME, 
+                    "[net.packet] (FactoryManager::add_factory) frozen"
+                    " packet id: %d",
+                    factory->packet_id());
+      safe_delete(factory);
+      return;
+    }
     ++factory_size_;
     id_indexs_.add(factory->packet_id(), index);
     factories_[index] = factory;
+    if (ready()) dispatch_set(factory->packet_id());
   } else {
     SLOW_WARNINGLOG(NET_MODULENAME, 
                     "[net.packet] (FactoryManager::add_factory) repeat add"
@@ -175,6 +314,7 @@ void FactoryManager::add_factory(Factory *factory) {
 }
 
 bool FactoryManager::is_valid_packet_id(uint16_t id) {
+  if (ready()) return (dispatches_[id].flags & kPacketDispatchFlagNormal) != 0;
   bool result = false;
   if (!function_is_valid_packet_id_)
     return NET_PACKET_ID_NORMAL_BEGIN <= id && id <= NET_PACKET_ID_NORMAL_END;
@@ -183,10 +323,13 @@ bool FactoryManager::is_valid_packet_id(uint16_t id) {
 }
 
 bool FactoryManager::is_encrypt_packet_id(uint16_t id) {
+  if (ready()) return (dispatches_[id].flags & kPacketDispatchFlagEncrypt) != 0;
   return id >= NET_PACKET_HANDSHAKE && id < 0xffff;
 }
 
 bool FactoryManager::is_valid_dynamic_packet_id(uint16_t id) {
+  if (ready()) 
+    return (dispatches_[id].flags & kPacketDispatchFlagDynamic) != 0;
   bool result = false;
   if (!function_is_valid_dynamic_packet_id_) 
     return NET_PACKET_ID_DYNAMIC_BEGIN <= id && id <= NET_PACKET_ID_DYNAMIC_END;
@@ -196,9 +339,7 @@ bool FactoryManager::is_valid_dynamic_packet_id(uint16_t id) {
 
 uint32_t FactoryManager::packet_execute(
   connection::Basic *connection, Interface *packet) {
-  std::cout << "packet_execute 0" << std::endl;
   if (!function_packet_execute_) return kPacketExecuteStatusError;
-  std::cout << "packet_execute 1" << std::endl;
   uint32_t result = (*function_packet_execute_)(connection, packet);
   return result;
 }
@@ -59,6 +59,11 @@ uint32_t Handshake::execute(pf_net::connection::Basic *connection) {
   }
   if (encrypt_str == decode_key_1) {
     connection->set_safe_encrypt(true);
+    //Not pending, the listener can accept more.
+    auto manager = connection->get_manager();
+    if (!is_null(manager))
+      manager->timer_cancel(
+          connection, pf_net::connection::kConnectionTimerHandshake);
     return kPacketExecuteStatusContinue;
   }
   std::string decode_key_2;
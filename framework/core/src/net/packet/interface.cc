@@ -6,6 +6,16 @@ namespace pf_net {
 
 namespace packet {
 
+queue_struct &queue_struct::operator = (queue_struct &&object) {
+  if (this == &object) return *this;
+  safe_delete(packet);
+  packet = object.packet;
+  connectionid = object.connectionid;
+  flag = object.flag;
+  object.packet = nullptr;
+  return *this;
+}
+
 queue_struct::~queue_struct() {
   safe_delete(packet);
 }
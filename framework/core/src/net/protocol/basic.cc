@@ -5,6 +5,8 @@
 #include "pf/basic/io.tcc"
 #include "pf/sys/assert.h"
 #include "pf/basic/logger.h"
+#include "pf/net/connection/executor.h"
+#include "pf/net/connection/manager/interface.h"
 #include "pf/net/protocol/basic.h"
 
 namespace pf_net {
@@ -26,32 +28,36 @@ bool Basic::command(connection::Basic *connection, uint16_t count) {
   stream::Input *istream = &connection->istream();
   uint32_t packetcheck, packetsize, packetindex;
   packet::Interface *packet = nullptr;
+  //The packets execute in workers, only decode here.
+  auto manager = connection->get_manager();
+  auto executor = is_null(manager) ? nullptr : manager->executor();
   //if (isdisconnect()) return true; leave this to connection.
   try {
     uint32_t i;
     for (i = 0; i < count; ++i) {
-      memset(packetheader, 0, sizeof(packetheader));
       if (!istream) return true;
-      if (!istream->peek(&packetheader[0], NET_PACKET_HEADERSIZE)) {
-        //数据不能填充消息头
-        break;
+      //The worker resume it when the queue drained.
+      if (executor && executor->full(connection)) break;
+      //Read the header from the buffer directly if can.
+      const char *header = istream->view(NET_PACKET_HEADERSIZE);
+      if (is_null(header)) {
+        if (!istream->peek(&packetheader[0], NET_PACKET_HEADERSIZE)) {
+          //数据不能填充消息头
+          break;
+        }
+        header = &packetheader[0];
       }
-      memcpy(&packetid, &packetheader[0], sizeof(packetid));
-      memcpy(&packetcheck, 
-             &packetheader[sizeof(packetid)], 
-             sizeof(packetcheck));
+      memcpy(&packetid, header, sizeof(packetid));
+      memcpy(&packetcheck, header + sizeof(packetid), sizeof(packetcheck));
       packetsize = NET_PACKET_GETLENGTH(packetcheck);
       packetindex = NET_PACKET_GETINDEX(packetcheck);
-      if (!NET_PACKET_FACTORYMANAGER_POINTER->
-          is_valid_packet_id(packetid) &&
-          !NET_PACKET_FACTORYMANAGER_POINTER->
-          is_valid_dynamic_packet_id(packetid) &&
-          !NET_PACKET_FACTORYMANAGER_POINTER->
-          is_encrypt_packet_id(packetid)) {
+      const packet::dispatch_t &dispatch = 
+        NET_PACKET_FACTORYMANAGER_POINTER->dispatch(packetid);
+      if (0 == dispatch.flags) {
         pf_basic::io_cerr("packet id error: %d", packetid);
         return false;
       }
-      if (!NET_PACKET_FACTORYMANAGER_POINTER->is_encrypt_packet_id(packetid) &&
+      if (!(dispatch.flags & kPacketDispatchFlagEncrypt) &&
           !connection->check_safe_encrypt())
         return false;
       try {
@@ -62,10 +68,8 @@ bool Basic::command(connection::Basic *connection, uint16_t count) {
           break;
         }
         //check packet size
-        if (!NET_PACKET_FACTORYMANAGER_POINTER->
-            is_valid_dynamic_packet_id(packetid)) {
-          if (packetsize > 
-            NET_PACKET_FACTORYMANAGER_POINTER->packet_max_size(packetid)) {
+        if (!(dispatch.flags & kPacketDispatchFlagDynamic)) {
+          if (packetsize > dispatch.max_size) {
             char temp[FILENAME_MAX] = {0};
             snprintf(temp, 
                      sizeof(temp) - 1, 
@@ -91,13 +95,23 @@ bool Basic::command(connection::Basic *connection, uint16_t count) {
           NET_PACKET_FACTORYMANAGER_POINTER->packet_remove(packet);
           return result;
         }
+        //The handshake change the connection, execute it in net thread.
+        if (executor && !(dispatch.flags & kPacketDispatchFlagEncrypt)) {
+          if (!executor->post(connection, packet, dispatch.handler)) {
+            NET_PACKET_FACTORYMANAGER_POINTER->packet_remove(packet);
+            return false;
+          }
+          continue;
+        }
         bool needremove = true;
         bool exception = false;
         uint32_t executestatus = 0;
         try {
           //connection->resetkick();
           try {
-            executestatus = packet->execute(connection);
+            executestatus = dispatch.handler ? 
+                            (*dispatch.handler)(connection, packet) :
+                            packet->execute(connection);
           } catch(...) {
             SaveErrorLog();
             executestatus = kPacketExecuteStatusError;
@@ -132,6 +146,7 @@ bool Basic::command(connection::Basic *connection, uint16_t count) {
         return false;
       }
     }
+    connection->set_command_pending(i >= count);
   } catch(...) {
     SaveErrorLog();
     return false;
@@ -205,9 +220,10 @@ bool Basic::compress(connection::Basic * connection,
       memcpy(&packetcheck, 
              &packetheader[sizeof(packetid)], 
              sizeof(packetcheck));
-      if (!NET_PACKET_FACTORYMANAGER_POINTER->is_valid_packet_id(packetid) &&
-          !NET_PACKET_FACTORYMANAGER_POINTER
-          ->is_valid_dynamic_packet_id(packetid)) {
+      const packet::dispatch_t &dispatch = 
+        NET_PACKET_FACTORYMANAGER_POINTER->dispatch(packetid);
+      if (!(dispatch.flags & 
+            (kPacketDispatchFlagNormal | kPacketDispatchFlagDynamic))) {
         SLOW_ERRORLOG(
             NET_MODULENAME,
             "[net.connection] (Basic::process_compressinput)"
@@ -217,10 +233,8 @@ bool Basic::compress(connection::Basic * connection,
       }
       packetsize = NET_PACKET_GETLENGTH(packetcheck);
       size = istream_compress.size();
-      if (!NET_PACKET_FACTORYMANAGER_POINTER
-          ->is_valid_dynamic_packet_id(packetid)) {
-        uint32_t sizemax = 
-          NET_PACKET_FACTORYMANAGER_POINTER->packet_max_size(packetid);
+      if (!(dispatch.flags & kPacketDispatchFlagDynamic)) {
+        uint32_t sizemax = dispatch.max_size;
         if (packetsize > sizemax) {
           SLOW_ERRORLOG(
               NET_MODULENAME,
@@ -249,7 +263,7 @@ bool Basic::compress(connection::Basic * connection,
             result);
         return false;
       }
-      if (NET_PACKET_FACTORYMANAGER_POINTER->is_encrypt_packet_id(packetid))
+      if (dispatch.flags & kPacketDispatchFlagEncrypt)
         break;
     }
   } while(true);
@@ -260,38 +274,83 @@ bool Basic::send(connection::Basic * connection, packet::Interface *packet) {
   bool result = false;
   stream::Output &ostream = connection->ostream();
   if (&ostream) {
-    if (!ostream.use(NET_PACKET_HEADERSIZE + packet->size())) {
-      return false;
-    }
+    uint32_t packetsize = packet->size();
+    uint32_t totalsize = NET_PACKET_HEADERSIZE + packetsize;
+    //Write the header and body into the reserved region one pass.
+    if (is_null(ostream.reserve(totalsize))) return false;
     packet->set_index(connection->packet_index());
-    uint32_t before_writesize = ostream.size();
     uint16_t packetid = packet->get_id();
 
     uint32_t packetcheck{0}; //index and size(if diffrent then have error) 
-    ostream.write(reinterpret_cast<const char *>(&packetid), sizeof(packetid));
-    uint32_t packetsize = packet->size();
     uint32_t packetindex = packet->get_index();
     NET_PACKET_SETINDEX(packetcheck, packetindex);
     NET_PACKET_SETLENGTH(packetcheck, packetsize);
+    ostream.write(reinterpret_cast<const char *>(&packetid), sizeof(packetid));
     ostream.write(reinterpret_cast<const char *>(&packetcheck), 
                   sizeof(packetcheck));
     result = packet->write(ostream);
-    Assert(result);
-    uint32_t after_writesize = ostream.size();
-    if (packet->size() != 
-        after_writesize - before_writesize - NET_PACKET_HEADERSIZE) {
+    if (!result || ostream.reserved_size() != totalsize) {
       FAST_ERRORLOG(NET_MODULENAME,
-                    "[net.protocol] (Basic::send) size error,"
+                    "[net.protocol] (Basic::send) write error,"
                     " id = %d(write: %d, should: %d)",
-                    packet->get_id(),
-                    after_writesize - before_writesize - 6,
-                    packet->size());
-      result = false;
+                    packetid,
+                    ostream.reserved_size(),
+                    totalsize);
+      ostream.commit(0); //Roll back, the stream not changed.
+      return false;
     }
+    result = ostream.commit(totalsize);
   }
   return result;
 }
 
+bool Basic::encode(packet::Interface *packet, std::string &buffer) {
+  uint32_t packetsize = packet->size();
+  uint32_t totalsize = NET_PACKET_HEADERSIZE + packetsize;
+  stream::Output ostream(nullptr, totalsize + 1, totalsize + 1);
+  ostream.init();
+  char *region = ostream.reserve(totalsize);
+  if (is_null(region)) return false;
+  uint16_t packetid = packet->get_id();
+  uint32_t packetcheck{0};
+  NET_PACKET_SETINDEX(packetcheck, 0);
+  NET_PACKET_SETLENGTH(packetcheck, packetsize);
+  ostream.write(reinterpret_cast<const char *>(&packetid), sizeof(packetid));
+  ostream.write(reinterpret_cast<const char *>(&packetcheck), 
+                sizeof(packetcheck));
+  bool result = packet->write(ostream);
+  if (!result || ostream.reserved_size() != totalsize) {
+    FAST_ERRORLOG(NET_MODULENAME,
+                  "[net.protocol] (Basic::encode) size error,"
+                  " id = %d(write: %d, should: %d)",
+                  packetid,
+                  ostream.reserved_size(),
+                  totalsize);
+    ostream.commit(0);
+    return false;
+  }
+  buffer.assign(region, totalsize);
+  ostream.commit(0);
+  return true;
+}
+
+bool Basic::send(connection::Basic *connection, 
+                 const char *data, 
+                 uint32_t size) {
+  if (size < NET_PACKET_HEADERSIZE) return false;
+  stream::Output &ostream = connection->ostream();
+  char *region = ostream.reserve(size);
+  if (is_null(region)) return false;
+  memcpy(region, data, size);
+  //The index is diffrent in every connection.
+  uint32_t packetcheck{0};
+  memcpy(&packetcheck, region + sizeof(uint16_t), sizeof(packetcheck));
+  uint32_t packetindex = static_cast<uint8_t>(connection->packet_index());
+  NET_PACKET_SETINDEX(packetcheck, packetindex);
+  memcpy(region + sizeof(uint16_t), &packetcheck, sizeof(packetcheck));
+  return ostream.commit(size);
+}
+
 } //namespace protocol
 
 } //namespace pf_net
@@ -328,7 +328,9 @@ int32_t acceptex(int32_t socketid,
                  struct sockaddr *addr, 
                  uint32_t *addrlength) {
   int32_t client = SOCKET_INVALID;
-#if OS_UNIX
+#if OS_UNIX && SOCKET_ACCEPT_NONBLOCK
+  client = accept4(socketid, addr, addrlength, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#elif OS_UNIX
   client = accept(socketid, addr, addrlength);
 #elif OS_WIN
   client = static_cast<int32_t>(accept(socketid, addr, (int32_t *)addrlength));
@@ -789,7 +791,7 @@ int32_t sendex(int32_t socketid,
   return result;
 }
 
-int32_t sendtoex(int32_t socketid, 
+int32_t sendto_ex(int32_t socketid, 
                  const void *buffer, 
                  int32_t length, 
                  uint32_t flag, 
@@ -938,6 +940,169 @@ int32_t recvex(int32_t socketid,
   return result;
 }
 
+#if OS_UNIX
+#define NET_SOCKET_IOBUFFER_MAX 8
+#endif
+
+int32_t sendvex(int32_t socketid, 
+                const iobuffer_t *buffers, 
+                uint32_t count, 
+                uint32_t flag) {
+  int32_t result = 0;
+#if OS_UNIX
+  struct iovec vectors[NET_SOCKET_IOBUFFER_MAX];
+  if (count > NET_SOCKET_IOBUFFER_MAX) count = NET_SOCKET_IOBUFFER_MAX;
+  for (uint32_t i = 0; i < count; ++i) {
+    vectors[i].iov_base = buffers[i].data;
+    vectors[i].iov_len = buffers[i].length;
+  }
+  struct msghdr message;
+  memset(&message, 0, sizeof(message));
+  message.msg_iov = vectors;
+  message.msg_iovlen = count;
+  result = static_cast<int32_t>(sendmsg(socketid, &message, flag));
+  if (SOCKET_ERROR == result && (EWOULDBLOCK == errno || EAGAIN == errno))
+    result = SOCKET_ERROR_WOULD_BLOCK;
+#elif OS_WIN
+  //No vectored api in winsock 1, send the buffers one by one.
+  for (uint32_t i = 0; i < count; ++i) {
+    int32_t sendcount = 
+      sendex(socketid, buffers[i].data, buffers[i].length, flag);
+    if (sendcount < 0) return 0 == result ? sendcount : result;
+    result += sendcount;
+    if (static_cast<uint32_t>(sendcount) < buffers[i].length) break;
+  }
+#endif
+  return result;
+}
+
+int32_t recvvex(int32_t socketid, 
+                iobuffer_t *buffers, 
+                uint32_t count, 
+                uint32_t flag) {
+  int32_t result = 0;
+#if OS_UNIX
+  struct iovec vectors[NET_SOCKET_IOBUFFER_MAX];
+  if (count > NET_SOCKET_IOBUFFER_MAX) count = NET_SOCKET_IOBUFFER_MAX;
+  for (uint32_t i = 0; i < count; ++i) {
+    vectors[i].iov_base = buffers[i].data;
+    vectors[i].iov_len = buffers[i].length;
+  }
+  struct msghdr message;
+  memset(&message, 0, sizeof(message));
+  message.msg_iov = vectors;
+  message.msg_iovlen = count;
+  result = static_cast<int32_t>(recvmsg(socketid, &message, flag));
+  if (SOCKET_ERROR == result && (EWOULDBLOCK == errno || EAGAIN == errno))
+    result = SOCKET_ERROR_WOULD_BLOCK;
+#elif OS_WIN
+  for (uint32_t i = 0; i < count; ++i) {
+    int32_t receivecount = 
+      recvex(socketid, buffers[i].data, buffers[i].length, flag);
+    if (receivecount < 0) return 0 == result ? receivecount : result;
+    result += receivecount;
+    if (static_cast<uint32_t>(receivecount) < buffers[i].length) break;
+  }
+#endif
+  return result;
+}
+
+int32_t sendfd_ex(int32_t socketid, 
+                  int32_t fd, 
+                  const void *buffer, 
+                  uint32_t length, 
+                  uint32_t flag) {
+  int32_t result = SOCKET_ERROR;
+#if OS_UNIX
+  struct iovec vector;
+  vector.iov_base = const_cast<void *>(buffer);
+  vector.iov_len = length;
+  union {
+    struct cmsghdr header;
+    char data[CMSG_SPACE(sizeof(int32_t))];
+  } control;
+  memset(&control, 0, sizeof(control));
+  struct msghdr message;
+  memset(&message, 0, sizeof(message));
+  message.msg_iov = &vector;
+  message.msg_iovlen = 1;
+  message.msg_control = control.data;
+  message.msg_controllen = sizeof(control.data);
+  struct cmsghdr *header = CMSG_FIRSTHDR(&message);
+  header->cmsg_level = SOL_SOCKET;
+  header->cmsg_type = SCM_RIGHTS;
+  header->cmsg_len = CMSG_LEN(sizeof(int32_t));
+  memcpy(CMSG_DATA(header), &fd, sizeof(int32_t));
+  result = static_cast<int32_t>(sendmsg(socketid, &message, flag));
+  if (SOCKET_ERROR == result && (EWOULDBLOCK == errno || EAGAIN == errno))
+    result = SOCKET_ERROR_WOULD_BLOCK;
+#else
+  UNUSED(socketid);
+  UNUSED(fd);
+  UNUSED(buffer);
+  UNUSED(length);
+  UNUSED(flag);
+#endif
+  return result;
+}
+
+int32_t recvfd_ex(int32_t socketid, 
+                  int32_t *fd, 
+                  void *buffer, 
+                  uint32_t length, 
+                  uint32_t flag) {
+  int32_t result = SOCKET_ERROR;
+  if (fd != nullptr) *fd = SOCKET_INVALID;
+#if OS_UNIX
+  struct iovec vector;
+  vector.iov_base = buffer;
+  vector.iov_len = length;
+  union {
+    struct cmsghdr header;
+    char data[CMSG_SPACE(sizeof(int32_t))];
+  } control;
+  struct msghdr message;
+  memset(&message, 0, sizeof(message));
+  message.msg_iov = &vector;
+  message.msg_iovlen = 1;
+  message.msg_control = control.data;
+  message.msg_controllen = sizeof(control.data);
+#if defined(MSG_CMSG_CLOEXEC)
+  flag |= MSG_CMSG_CLOEXEC;
+#endif
+  result = static_cast<int32_t>(recvmsg(socketid, &message, flag));
+  if (SOCKET_ERROR == result) {
+    if (EWOULDBLOCK == errno || EAGAIN == errno)
+      result = SOCKET_ERROR_WOULD_BLOCK;
+    return result;
+  }
+  for (struct cmsghdr *header = CMSG_FIRSTHDR(&message); 
+       header != nullptr; 
+       header = CMSG_NXTHDR(&message, header)) {
+    if (header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS)
+      continue;
+    //Only one descriptor sent by sendfd_ex, close the others.
+    auto count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int32_t);
+    auto data = reinterpret_cast<int32_t *>(CMSG_DATA(header));
+    for (size_t i = 0; i < count; ++i) {
+      int32_t value;
+      memcpy(&value, data + i, sizeof(value));
+      if (fd != nullptr && SOCKET_INVALID == *fd) {
+        *fd = value;
+      } else {
+        closeex(value);
+      }
+    }
+  }
+#else
+  UNUSED(socketid);
+  UNUSED(buffer);
+  UNUSED(length);
+  UNUSED(flag);
+#endif
+  return result;
+}
+
 int32_t recvfrom_ex(int32_t socketid, 
                     void *buffer, 
                     int32_t length, 
@@ -975,6 +1140,22 @@ int32_t result = 0;
   return result;
 }
 
+bool socketpair_ex(int32_t type, int32_t *socketids) {
+  bool result = false;
+  socketids[0] = socketids[1] = SOCKET_INVALID;
+#if OS_UNIX
+  int sockets[2];
+  if (0 == socketpair(AF_UNIX, type, 0, sockets)) {
+    socketids[0] = sockets[0];
+    socketids[1] = sockets[1];
+    result = true;
+  }
+#else
+  UNUSED(type);
+#endif
+  return result;
+}
+
 bool closeex(int32_t socketid) {
   bool result = true;
 #if OS_UNIX
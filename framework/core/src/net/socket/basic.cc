@@ -25,9 +25,9 @@ Basic::~Basic() {
   close();
 }
 
-bool Basic::create() {
+bool Basic::create(int32_t family) {
   bool result = true;
-  id_ = api::socketex(AF_INET, SOCK_STREAM, 0);
+  id_ = api::socketex(family, SOCK_STREAM, 0);
   result = is_valid();
   return result;
 }
@@ -62,6 +62,7 @@ if (0 == strcmp(host_, "0.0.0.0")) {
 bool Basic::connect(const char *_host, uint16_t _port) {
   using namespace pf_basic;
   bool result = true;
+  if (0 == _port && _host != nullptr) return connect_unix(_host);
   if (_host != nullptr)
     string::safecopy(host_, _host, sizeof(host_));
   port_ = _port;
@@ -93,6 +94,20 @@ int32_t Basic::receive(void *buffer, uint32_t length, uint32_t flag) {
   return result;
 }
 
+int32_t Basic::send(const iobuffer_t *buffers, 
+                    uint32_t count, 
+                    uint32_t flag) {
+  int32_t result = 0;
+  result = api::sendvex(id_, buffers, count, flag);
+  return result;
+}
+
+int32_t Basic::receive(iobuffer_t *buffers, uint32_t count, uint32_t flag) {
+  int32_t result = 0;
+  result = api::recvvex(id_, buffers, count, flag);
+  return result;
+}
+
 uint32_t Basic::available() const {
     uint32_t result = 0;
     result = api::availableex(id_);
@@ -155,6 +170,70 @@ bool Basic::listen(uint32_t backlog) {
   return result;
 }
 
+bool Basic::bind_unix(const char *path) {
+#if OS_UNIX
+  using namespace pf_basic;
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (is_null(path) || strlen(path) >= sizeof(address.sun_path)) {
+    io_cerr("[net.socket] (socket::Basic::bind_unix) error path: %s", 
+            is_null(path) ? "" : path);
+    return false;
+  }
+  string::safecopy(address.sun_path, path, sizeof(address.sun_path));
+  //The last process exited without unlink.
+  struct stat info;
+  if (0 == stat(path, &info) && S_ISSOCK(info.st_mode)) unlink(path);
+  bool result = api::bindex(
+      id_, 
+      reinterpret_cast<const struct sockaddr*>(&address), 
+      sizeof(address));
+  if (result) {
+    set_host(SOCKET_UNIX_HOST);
+    port_ = 0;
+  }
+  return result;
+#else
+  UNUSED(path);
+  return false;
+#endif
+}
+
+bool Basic::connect_unix(const char *path) {
+#if OS_UNIX
+  using namespace pf_basic;
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (is_null(path) || strlen(path) >= sizeof(address.sun_path)) return false;
+  string::safecopy(address.sun_path, path, sizeof(address.sun_path));
+  set_host(SOCKET_UNIX_HOST);
+  port_ = 0;
+  return api::connectex(
+      id_, 
+      reinterpret_cast<const struct sockaddr*>(&address), 
+      sizeof(address));
+#else
+  UNUSED(path);
+  return false;
+#endif
+}
+
+int32_t Basic::send_fd(int32_t fd, 
+                       const void *buffer, 
+                       uint32_t length, 
+                       uint32_t flag) {
+  return api::sendfd_ex(id_, fd, buffer, length, flag);
+}
+
+int32_t Basic::receive_fd(int32_t &fd, 
+                          void *buffer, 
+                          uint32_t length, 
+                          uint32_t flag) {
+  return api::recvfd_ex(id_, &fd, buffer, length, flag);
+}
+
 int32_t Basic::select(int32_t maxfdp, 
                      fd_set *readset, 
                      fd_set *writeset, 
@@ -210,6 +289,20 @@ bool Basic::set_reuseaddr(bool on) {
   return result;
 }
 
+bool Basic::set_reuseport(bool on) {
+#if defined(SO_REUSEPORT)
+  int32_t option = true == on ? 1 : 0;
+  return api::setsockopt_ex(id_, 
+                            SOL_SOCKET, 
+                            SO_REUSEPORT, 
+                            &option, 
+                            sizeof(option));
+#else
+  UNUSED(on);
+  return false;
+#endif
+}
+
 uint32_t Basic::get_last_error_code() const {
   uint32_t result = 0;
   result = api::getlast_errorcode();
@@ -6,7 +6,10 @@ namespace pf_net {
 
 namespace socket {
 
-bool Listener::init(uint16_t _port, const std::string &ip, uint32_t backlog) {
+bool Listener::init(uint16_t _port, 
+                    const std::string &ip, 
+                    uint32_t backlog, 
+                    bool reuseport) {
   using namespace pf_basic;
   bool result = false;
   std::unique_ptr< Basic > __socket(new pf_net::socket::Basic());
@@ -32,6 +35,12 @@ bool Listener::init(uint16_t _port, const std::string &ip, uint32_t backlog) {
             socket_->get_last_error_code());
     return false;
   }
+  if (reuseport && !socket_->set_reuseport()) {
+    io_cerr("[net.socket] (Listener::Listener)"
+            " socket_->set_reuseport() failed, errorcode: %d",
+            socket_->get_last_error_code());
+    return false;
+  }
   result = socket_->bind(_port, ip.c_str());
   if (false == result) {
     io_cerr("[net.socket] (Listener::Listener)"
@@ -52,23 +61,59 @@ bool Listener::init(uint16_t _port, const std::string &ip, uint32_t backlog) {
   return true;
 }
 
-Listener::~Listener() {
-  if (socket_ != nullptr) {
-    socket_->close();
+bool Listener::init_unix(const std::string &path, uint32_t backlog) {
+  using namespace pf_basic;
+  std::unique_ptr< Basic > __socket(new pf_net::socket::Basic());
+  socket_ = std::move(__socket);
+  if (!socket_->create(AF_UNIX)) {
+    io_cerr("[net.socket] (Listener::init_unix)"
+            " socket_->create() failed, errorcode: %d",
+            socket_->get_last_error_code()); 
+    return false;
+  }
+  if (!socket_->bind_unix(path.c_str())) {
+    io_cerr("[net.socket] (Listener::init_unix)"
+            " socket_->bind_unix(%s) failed, errorcode: %d", 
+            path.c_str(),
+            socket_->get_last_error_code());
+    return false;
+  }
+  path_ = path;
+  if (!socket_->listen(backlog)) {
+    io_cerr("[net.socket] (Listener::init_unix)"
+            " socket_->listen(%d) failed, errorcode: %d",
+            backlog,
+            socket_->get_last_error_code());
+    return false;
   }
+  return true;
+}
+
+Listener::~Listener() {
+  close();
 }
 
 void Listener::close() {
   if (socket_ != nullptr) socket_->close();
+#if OS_UNIX
+  if (path_ != "") unlink(path_.c_str());
+#endif
+  path_ = "";
 }
 
 bool Listener::accept(pf_net::socket::Basic *socket) {
   using namespace pf_basic;
   if (nullptr == socket) return false;
   struct sockaddr_in accept_sockaddr_in;
+  memset(&accept_sockaddr_in, 0, sizeof(accept_sockaddr_in));
   socket->close();
   socket->set_id(socket_->accept(&accept_sockaddr_in));
   if (SOCKET_INVALID == socket->get_id()) return false;
+  if (accept_sockaddr_in.sin_family != AF_INET) { //The unix domain socket.
+    socket->set_port(0);
+    socket->set_host(SOCKET_UNIX_HOST);
+    return true;
+  }
   socket->set_port(ntohs(accept_sockaddr_in.sin_port));
   socket->set_host(inet_ntoa(accept_sockaddr_in.sin_addr));
   return true;
@@ -1,4 +1,5 @@
 #include "pf/sys/assert.h"
+#include "pf/net/stream/buffer.h"
 #include "pf/net/stream/basic.h"
 
 namespace pf_net {
@@ -9,10 +10,13 @@ Basic::Basic(socket::Basic *_socket,
              uint32_t bufferlength, 
              uint32_t bufferlength_max) : 
               socket_{_socket},
+              bufferlength_default_{bufferlength},
               encrypt_isenable_{false},
+              mirrored_{false},
+              decrypt_once_{false},
               isinit_{false} {
   streamdata_.buffer = nullptr;
-  streamdata_.bufferlength = bufferlength;
+  streamdata_.bufferlength = 0;
   streamdata_.bufferlength_max = bufferlength_max;
   compressor_.sethead(NET_STREAM_COMPRESSOR_HEADER_SIZE);
   compressor_.settail(NET_STREAM_COMPRESSOR_HEADER_SIZE);
@@ -20,15 +24,13 @@ Basic::Basic(socket::Basic *_socket,
 }
 
 Basic::~Basic() {
-  safe_delete_array(streamdata_.buffer);
+  buffer::free(streamdata_.buffer, streamdata_.bufferlength, mirrored_);
+  streamdata_.buffer = nullptr;
 }
 
 void Basic::init() {
   if (isinit()) return;
-  auto buffersize = sizeof(char) * streamdata_.bufferlength;
-  streamdata_.buffer = new char[buffersize];
-  Assert(streamdata_.buffer);
-  memset(streamdata_.buffer, 0, buffersize);
+  //The buffer alloc when use it, see alloc.
   streamdata_.head = 0;
   streamdata_.tail = 0;
   encrypt_isenable_ = false;
@@ -38,7 +40,31 @@ void Basic::init() {
   set_isinit(true);
 }
 
+bool Basic::alloc(uint32_t length) {
+  if (!is_null(streamdata_.buffer)) return true;
+  uint32_t bufferlength = max(length, bufferlength_default_);
+  streamdata_.buffer = buffer::alloc(bufferlength, mirrored_);
+  if (is_null(streamdata_.buffer)) return false;
+  streamdata_.bufferlength = bufferlength;
+  streamdata_.head = 0;
+  streamdata_.tail = 0;
+  return true;
+}
+
+bool Basic::release() {
+  if (is_null(streamdata_.buffer) || !empty()) return false;
+  buffer::free(streamdata_.buffer, streamdata_.bufferlength, mirrored_);
+  streamdata_.buffer = nullptr;
+  streamdata_.bufferlength = 0;
+  streamdata_.head = 0;
+  streamdata_.tail = 0;
+  mirrored_ = false;
+  return true;
+}
+
 bool Basic::resize(int32_t _size) {
+  if (is_null(streamdata_.buffer)) 
+    return _size > 0 && alloc(bufferlength_default_ + _size);
   uint32_t bufferlength = streamdata_.bufferlength;
   uint32_t head = streamdata_.head;
   uint32_t tail = streamdata_.tail;
@@ -51,18 +77,21 @@ bool Basic::resize(int32_t _size) {
         newbuffer_length < static_cast<int32_t>(_reallength)))
     return false;
   char *oldbuffer = streamdata_.buffer;
-  char *newbuffer = new char[sizeof(char) * newbuffer_length];
+  bool old_mirrored = mirrored_;
+  uint32_t length = static_cast<uint32_t>(newbuffer_length);
+  bool new_mirrored = false;
+  char *newbuffer = buffer::alloc(length, new_mirrored);
   if (!newbuffer) return false;
-  memset(newbuffer, 0, sizeof(char) * newbuffer_length);
-  if (head < tail) {
-    memcpy(newbuffer, &oldbuffer[head], tail - head);
+  if (old_mirrored || head <= tail) {
+    memcpy(newbuffer, &oldbuffer[head], _reallength);
   } else {
     memcpy(newbuffer, &oldbuffer[head], bufferlength - head);
     memcpy(&newbuffer[bufferlength - head], oldbuffer, tail);
   }
-  safe_delete_array(oldbuffer);
+  buffer::free(oldbuffer, bufferlength, old_mirrored);
   streamdata_.buffer = newbuffer;
-  streamdata_.bufferlength = newbuffer_length;
+  streamdata_.bufferlength = length;
+  mirrored_ = new_mirrored;
   streamdata_.head = 0;
   streamdata_.tail = _reallength;
   return true;
@@ -81,6 +110,82 @@ size_t Basic::size() const {
   return result;
 }
 
+void Basic::copyout(char *buffer, uint32_t length) {
+  const char *source = &streamdata_.buffer[streamdata_.head];
+  uint32_t rightlength = contiguous_size();
+  if (length < rightlength) rightlength = length;
+  if (encrypt_isenable() && !decrypt_once_) {
+    encryptor_.decrypt(buffer, source, rightlength);
+    if (length > rightlength) {
+      encryptor_.decrypt(
+          &buffer[rightlength], streamdata_.buffer, length - rightlength);
+    }
+  } else {
+    memcpy(buffer, source, rightlength);
+    if (length > rightlength)
+      memcpy(&buffer[rightlength], streamdata_.buffer, length - rightlength);
+  }
+}
+
+void Basic::copyin(const char *buffer, uint32_t length) {
+  char *dest = &streamdata_.buffer[streamdata_.tail];
+  uint32_t rightlength = mirrored_ ? 
+                         length : 
+                         streamdata_.bufferlength - streamdata_.tail;
+  if (length < rightlength) rightlength = length;
+  if (encrypt_isenable() && !decrypt_once_) {
+    encryptor_.encrypt(dest, buffer, rightlength);
+    if (length > rightlength) {
+      encryptor_.encrypt(
+          streamdata_.buffer, &buffer[rightlength], length - rightlength);
+    }
+  } else {
+    memcpy(dest, buffer, rightlength);
+    if (length > rightlength)
+      memcpy(streamdata_.buffer, &buffer[rightlength], length - rightlength);
+  }
+}
+
+void Basic::crypt_inplace(uint32_t position, uint32_t length, bool decrypt) {
+  if (0 == length) return;
+  char *data = &streamdata_.buffer[position];
+  uint32_t rightlength = mirrored_ ? 
+                         length : 
+                         streamdata_.bufferlength - position;
+  if (length < rightlength) rightlength = length;
+  if (decrypt) {
+    encryptor_.decrypt(data, data, rightlength);
+    if (length > rightlength) {
+      encryptor_.decrypt(
+          streamdata_.buffer, streamdata_.buffer, length - rightlength);
+    }
+  } else {
+    encryptor_.encrypt(data, data, rightlength);
+    if (length > rightlength) {
+      encryptor_.encrypt(
+          streamdata_.buffer, streamdata_.buffer, length - rightlength);
+    }
+  }
+}
+
+void Basic::encryptenable(bool enable) {
+  if (enable == encrypt_isenable_) return;
+  //The data received before enable is cipher, decrypt it now.
+  if (decrypt_once_ && !empty())
+    crypt_inplace(streamdata_.head, static_cast<uint32_t>(size()), enable);
+  encrypt_isenable_ = enable;
+}
+
+void Basic::encrypt_setkey(const char *key) {
+  //The decrypted once buffer data decrypt with the new key.
+  bool recrypt = encrypt_isenable_ && decrypt_once_ && !empty();
+  if (recrypt) 
+    crypt_inplace(streamdata_.head, static_cast<uint32_t>(size()), false);
+  encryptor_.setkey(key);
+  if (recrypt) 
+    crypt_inplace(streamdata_.head, static_cast<uint32_t>(size()), true);
+}
+
 void Basic::clear() {
   streamdata_.head = 0;
   streamdata_.tail = 0;
@@ -0,0 +1,200 @@
+#include "pf/net/stream/buffer.h"
+#if NET_STREAM_MIRROR_ENABLE
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace pf_net {
+
+namespace stream {
+
+namespace buffer {
+
+#if NET_STREAM_MIRROR_ENABLE
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+
+static char *mirror_alloc(uint32_t length) {
+  int32_t fd = static_cast<int32_t>(
+      syscall(SYS_memfd_create, "pf_net_stream", MFD_CLOEXEC));
+  if (fd < 0) return nullptr;
+  char *result = nullptr;
+  if (0 == ftruncate(fd, length)) {
+    //Reserve the address space first, then replace the two halves.
+    void *address = mmap(nullptr, 
+                         static_cast<size_t>(length) * 2, 
+                         PROT_NONE, 
+                         MAP_PRIVATE | MAP_ANONYMOUS, 
+                         -1, 
+                         0);
+    if (address != MAP_FAILED) {
+      char *first = reinterpret_cast<char *>(address);
+      char *second = first + length;
+      if (mmap(first, 
+               length, 
+               PROT_READ | PROT_WRITE, 
+               MAP_SHARED | MAP_FIXED, 
+               fd, 
+               0) != MAP_FAILED &&
+          mmap(second, 
+               length, 
+               PROT_READ | PROT_WRITE, 
+               MAP_SHARED | MAP_FIXED, 
+               fd, 
+               0) != MAP_FAILED) {
+        result = first;
+      } else {
+        munmap(address, static_cast<size_t>(length) * 2);
+      }
+    }
+  }
+  close(fd); //The mappings keep the memory.
+  return result;
+}
+
+#endif
+
+//Alloc the memory from system, the length is the final length.
+static char *system_alloc(uint32_t length, bool &mirrored) {
+  mirrored = false;
+#if NET_STREAM_MIRROR_ENABLE
+  char *result = mirror_alloc(length);
+  if (!is_null(result)) {
+    mirrored = true;
+    return result;
+  }
+#endif
+  return new char[length];
+}
+
+static void system_free(char *buffer, uint32_t length, bool mirrored) {
+#if NET_STREAM_MIRROR_ENABLE
+  if (mirrored) {
+    munmap(buffer, static_cast<size_t>(length) * 2);
+    return;
+  }
+#else
+  UNUSED(length); UNUSED(mirrored);
+#endif
+  delete[] buffer;
+}
+
+typedef struct pooldata_struct {
+  std::mutex mutex;
+  std::vector< std::pair<char *, bool> > lists[NET_STREAM_BUFFER_CLASS_COUNT];
+  uint64_t size;
+  std::atomic<uint64_t> max_size; //Set by any thread.
+  std::atomic<uint32_t> idle_time;
+  pooldata_struct() : 
+    size{0}, 
+    max_size{NET_STREAM_BUFFER_POOL_MAXSIZE},
+    idle_time{NET_STREAM_BUFFER_IDLE_TIME} {}
+} pooldata_t;
+
+//Never destroy, the streams in static objects maybe free after exit.
+static pooldata_t &pooldata() {
+  static pooldata_t *data = new pooldata_t;
+  return *data;
+}
+
+//The size class index, NET_STREAM_BUFFER_CLASS_COUNT if too large.
+static uint8_t class_index(uint32_t length) {
+  uint8_t result = 0;
+  uint64_t classsize = pagesize();
+  while (result < NET_STREAM_BUFFER_CLASS_COUNT && classsize < length) {
+    ++result;
+    classsize <<= 1;
+  }
+  return result;
+}
+
+uint32_t pagesize() {
+#if OS_UNIX
+  static uint32_t result = static_cast<uint32_t>(sysconf(_SC_PAGESIZE));
+#else
+  static uint32_t result = 4096;
+#endif
+  return result;
+}
+
+char *alloc(uint32_t &length, bool &mirrored) {
+  mirrored = false;
+  if (0 == length) return nullptr;
+  auto index = class_index(length);
+  if (index < NET_STREAM_BUFFER_CLASS_COUNT) {
+    length = pagesize() << index;
+    auto &data = pooldata();
+    std::unique_lock<std::mutex> autolock(data.mutex);
+    auto &list = data.lists[index];
+    if (!list.empty()) {
+      auto item = list.back();
+      list.pop_back();
+      data.size -= length;
+      mirrored = item.second;
+      return item.first;
+    }
+  } else {
+    auto _pagesize = pagesize();
+    length = (length + _pagesize - 1) / _pagesize * _pagesize;
+  }
+  return system_alloc(length, mirrored);
+}
+
+void free(char *buffer, uint32_t length, bool mirrored) {
+  if (is_null(buffer)) return;
+  auto index = class_index(length);
+  if (index < NET_STREAM_BUFFER_CLASS_COUNT && pagesize() << index == length) {
+    auto &data = pooldata();
+    std::unique_lock<std::mutex> autolock(data.mutex);
+    if (data.size + length <= data.max_size) {
+      data.lists[index].emplace_back(buffer, mirrored);
+      data.size += length;
+      return;
+    }
+  }
+  system_free(buffer, length, mirrored);
+}
+
+uint64_t pool_size() {
+  auto &data = pooldata();
+  std::unique_lock<std::mutex> autolock(data.mutex);
+  return data.size;
+}
+
+void set_pool_max_size(uint64_t size) {
+  auto &data = pooldata();
+  //Trim the cached from the large class, free them after unlock.
+  std::vector< std::tuple<char *, uint32_t, bool> > frees;
+  {
+    std::unique_lock<std::mutex> autolock(data.mutex);
+    data.max_size = size;
+    for (uint8_t i = NET_STREAM_BUFFER_CLASS_COUNT; i > 0 && data.size > size; 
+         --i) {
+      auto &list = data.lists[i - 1];
+      uint32_t length = pagesize() << (i - 1);
+      while (!list.empty() && data.size > size) {
+        frees.emplace_back(list.back().first, length, list.back().second);
+        list.pop_back();
+        data.size -= length;
+      }
+    }
+  }
+  for (auto &item : frees)
+    system_free(std::get<0>(item), std::get<1>(item), std::get<2>(item));
+}
+
+uint32_t idle_time() {
+  return pooldata().idle_time;
+}
+
+void set_idle_time(uint32_t time) {
+  pooldata().idle_time = time;
+}
+
+} //namespace buffer
+
+} //namespace stream
+
+} //namespace pf_net
@@ -1,11 +1,332 @@
 #include "pf/basic/string.h"
 #include "pf/net/stream/encryptor.h"
 
+#if (defined(__GNUC__) || defined(__clang__)) && \
+  (defined(__x86_64__) || defined(__i386__))
+#define NET_STREAM_ENCRYPTOR_X86 1
+#include <immintrin.h>
+#elif defined(_MSC_VER) && defined(_M_X64)
+#define NET_STREAM_ENCRYPTOR_X86 0
+#define NET_STREAM_ENCRYPTOR_SSE2 1
+#include <emmintrin.h>
+#else
+#define NET_STREAM_ENCRYPTOR_X86 0
+#endif
+
+#if NET_STREAM_ENCRYPTOR_X86 && (defined(__SSE2__) || defined(__x86_64__))
+#define NET_STREAM_ENCRYPTOR_SSE2 1
+#endif
+
+#ifndef NET_STREAM_ENCRYPTOR_SSE2
+#define NET_STREAM_ENCRYPTOR_SSE2 0
+#endif
+
 using namespace pf_net::stream;
 
+//The byte kernels, the tail bytes of vector kernels also use them.
+static void invert_scalar(uint8_t *out, const uint8_t *in, uint32_t count) {
+  for (uint32_t i = 0; i < count; ++i)
+    out[i] = in[i] ^ 0xFF;
+}
+
+static void encrypt_scalar(const uint8_t *keyhigh, 
+                           uint8_t keylow,
+                           uint8_t *out, 
+                           const uint8_t *in, 
+                           uint32_t count) {
+  for (uint32_t i = 0; i < count; ++i) {
+    uint8_t low = in[i] & 0x0F;
+    uint8_t high = in[i] & 0xF0;
+    high = high ^ keyhigh[low];
+    low = (((low ^ 0x0F) & 0x0F) + keylow) & 0x0F;
+    out[i] = high + low;
+  }
+}
+
+static void decrypt_scalar(const uint8_t *keyhigh, 
+                           uint8_t keylow,
+                           uint8_t *out, 
+                           const uint8_t *in, 
+                           uint32_t count) {
+  for (uint32_t i = 0; i < count; ++i) {
+    uint8_t low = in[i] & 0x0F;
+    uint8_t high = in[i] & 0xF0;
+    low = ((low - keylow) & 0x0F) ^ 0x0F;
+    high = high ^ keyhigh[low];
+    out[i] = high + low;
+  }
+}
+
+#if NET_STREAM_ENCRYPTOR_SSE2
+
+static void invert_sse2(uint8_t *out, const uint8_t *in, uint32_t count) {
+  const __m128i ones = _mm_set1_epi8(static_cast<char>(0xFF));
+  uint32_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), 
+                     _mm_xor_si128(value, ones));
+  }
+  invert_scalar(out + i, in + i, count - i);
+}
+
+//No byte shuffle in SSE2, select the 16 key entries with compare.
+static inline __m128i lookup_sse2(const uint8_t *keyhigh, __m128i index) {
+  __m128i result = _mm_setzero_si128();
+  for (uint8_t i = 0; i < 16; ++i) {
+    __m128i mask = _mm_cmpeq_epi8(index, _mm_set1_epi8(static_cast<char>(i)));
+    result = _mm_or_si128(
+        result, 
+        _mm_and_si128(mask, _mm_set1_epi8(static_cast<char>(keyhigh[i]))));
+  }
+  return result;
+}
+
+static void encrypt_sse2(const uint8_t *keyhigh, 
+                         uint8_t keylow,
+                         uint8_t *out, 
+                         const uint8_t *in, 
+                         uint32_t count) {
+  const __m128i lowmask = _mm_set1_epi8(0x0F);
+  const __m128i highmask = _mm_set1_epi8(static_cast<char>(0xF0));
+  const __m128i keylows = _mm_set1_epi8(static_cast<char>(keylow));
+  uint32_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+    __m128i low = _mm_and_si128(value, lowmask);
+    __m128i high = _mm_and_si128(value, highmask);
+    high = _mm_xor_si128(high, lookup_sse2(keyhigh, low));
+    low = _mm_and_si128(
+        _mm_add_epi8(_mm_xor_si128(low, lowmask), keylows), lowmask);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), 
+                     _mm_or_si128(high, low));
+  }
+  encrypt_scalar(keyhigh, keylow, out + i, in + i, count - i);
+}
+
+static void decrypt_sse2(const uint8_t *keyhigh, 
+                         uint8_t keylow,
+                         uint8_t *out, 
+                         const uint8_t *in, 
+                         uint32_t count) {
+  const __m128i lowmask = _mm_set1_epi8(0x0F);
+  const __m128i highmask = _mm_set1_epi8(static_cast<char>(0xF0));
+  const __m128i keylows = _mm_set1_epi8(static_cast<char>(keylow));
+  uint32_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+    __m128i low = _mm_and_si128(value, lowmask);
+    __m128i high = _mm_and_si128(value, highmask);
+    low = _mm_xor_si128(
+        _mm_and_si128(_mm_sub_epi8(low, keylows), lowmask), lowmask);
+    high = _mm_xor_si128(high, lookup_sse2(keyhigh, low));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), 
+                     _mm_or_si128(high, low));
+  }
+  decrypt_scalar(keyhigh, keylow, out + i, in + i, count - i);
+}
+
+#endif //NET_STREAM_ENCRYPTOR_SSE2
+
+#if NET_STREAM_ENCRYPTOR_X86
+
+__attribute__((target("ssse3")))
+static void encrypt_ssse3(const uint8_t *keyhigh, 
+                          uint8_t keylow,
+                          uint8_t *out, 
+                          const uint8_t *in, 
+                          uint32_t count) {
+  const __m128i table = 
+    _mm_loadu_si128(reinterpret_cast<const __m128i *>(keyhigh));
+  const __m128i lowmask = _mm_set1_epi8(0x0F);
+  const __m128i highmask = _mm_set1_epi8(static_cast<char>(0xF0));
+  const __m128i keylows = _mm_set1_epi8(static_cast<char>(keylow));
+  uint32_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+    __m128i low = _mm_and_si128(value, lowmask);
+    __m128i high = _mm_and_si128(value, highmask);
+    high = _mm_xor_si128(high, _mm_shuffle_epi8(table, low));
+    low = _mm_and_si128(
+        _mm_add_epi8(_mm_xor_si128(low, lowmask), keylows), lowmask);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), 
+                     _mm_or_si128(high, low));
+  }
+  encrypt_scalar(keyhigh, keylow, out + i, in + i, count - i);
+}
+
+__attribute__((target("ssse3")))
+static void decrypt_ssse3(const uint8_t *keyhigh, 
+                          uint8_t keylow,
+                          uint8_t *out, 
+                          const uint8_t *in, 
+                          uint32_t count) {
+  const __m128i table = 
+    _mm_loadu_si128(reinterpret_cast<const __m128i *>(keyhigh));
+  const __m128i lowmask = _mm_set1_epi8(0x0F);
+  const __m128i highmask = _mm_set1_epi8(static_cast<char>(0xF0));
+  const __m128i keylows = _mm_set1_epi8(static_cast<char>(keylow));
+  uint32_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+    __m128i low = _mm_and_si128(value, lowmask);
+    __m128i high = _mm_and_si128(value, highmask);
+    low = _mm_xor_si128(
+        _mm_and_si128(_mm_sub_epi8(low, keylows), lowmask), lowmask);
+    high = _mm_xor_si128(high, _mm_shuffle_epi8(table, low));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), 
+                     _mm_or_si128(high, low));
+  }
+  decrypt_scalar(keyhigh, keylow, out + i, in + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void invert_avx2(uint8_t *out, const uint8_t *in, uint32_t count) {
+  const __m256i ones = _mm256_set1_epi8(static_cast<char>(0xFF));
+  uint32_t i = 0;
+  for (; i + 32 <= count; i += 32) {
+    __m256i value = 
+      _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), 
+                        _mm256_xor_si256(value, ones));
+  }
+  invert_scalar(out + i, in + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void encrypt_avx2(const uint8_t *keyhigh, 
+                         uint8_t keylow,
+                         uint8_t *out, 
+                         const uint8_t *in, 
+                         uint32_t count) {
+  //The shuffle lookup in each 128 lane, so put the table in both.
+  const __m256i table = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(keyhigh)));
+  const __m256i lowmask = _mm256_set1_epi8(0x0F);
+  const __m256i highmask = _mm256_set1_epi8(static_cast<char>(0xF0));
+  const __m256i keylows = _mm256_set1_epi8(static_cast<char>(keylow));
+  uint32_t i = 0;
+  for (; i + 32 <= count; i += 32) {
+    __m256i value = 
+      _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+    __m256i low = _mm256_and_si256(value, lowmask);
+    __m256i high = _mm256_and_si256(value, highmask);
+    high = _mm256_xor_si256(high, _mm256_shuffle_epi8(table, low));
+    low = _mm256_and_si256(
+        _mm256_add_epi8(_mm256_xor_si256(low, lowmask), keylows), lowmask);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), 
+                        _mm256_or_si256(high, low));
+  }
+  encrypt_scalar(keyhigh, keylow, out + i, in + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void decrypt_avx2(const uint8_t *keyhigh, 
+                         uint8_t keylow,
+                         uint8_t *out, 
+                         const uint8_t *in, 
+                         uint32_t count) {
+  const __m256i table = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(keyhigh)));
+  const __m256i lowmask = _mm256_set1_epi8(0x0F);
+  const __m256i highmask = _mm256_set1_epi8(static_cast<char>(0xF0));
+  const __m256i keylows = _mm256_set1_epi8(static_cast<char>(keylow));
+  uint32_t i = 0;
+  for (; i + 32 <= count; i += 32) {
+    __m256i value = 
+      _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+    __m256i low = _mm256_and_si256(value, lowmask);
+    __m256i high = _mm256_and_si256(value, highmask);
+    low = _mm256_xor_si256(
+        _mm256_and_si256(_mm256_sub_epi8(low, keylows), lowmask), lowmask);
+    high = _mm256_xor_si256(high, _mm256_shuffle_epi8(table, low));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), 
+                        _mm256_or_si256(high, low));
+  }
+  decrypt_scalar(keyhigh, keylow, out + i, in + i, count - i);
+}
+
+#endif //NET_STREAM_ENCRYPTOR_X86
+
+typedef void (*function_invert)(uint8_t *, const uint8_t *, uint32_t);
+typedef void (*function_transform)(
+    const uint8_t *, uint8_t, uint8_t *, const uint8_t *, uint32_t);
+
+//The kernels chose once by the cpu features.
+typedef struct kernels_struct {
+  uint8_t kind;
+  function_invert invert;
+  function_transform encrypt;
+  function_transform decrypt;
+  kernels_struct() {
+    uint8_t best = Encryptor::kKernelScalar;
+    for (uint8_t i = Encryptor::kKernelSse2; i < Encryptor::kKernelMax; ++i)
+      if (supported(i)) best = i;
+    use(best);
+  }
+  static bool supported(uint8_t _kind) {
+    switch (_kind) {
+      case Encryptor::kKernelScalar:
+        return true;
+      case Encryptor::kKernelSse2:
+        return NET_STREAM_ENCRYPTOR_SSE2 != 0;
+#if NET_STREAM_ENCRYPTOR_X86
+      case Encryptor::kKernelSsse3:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("ssse3");
+      case Encryptor::kKernelAvx2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+      default:
+        return false;
+    }
+  }
+  void use(uint8_t _kind) {
+    kind = _kind;
+    invert = invert_scalar;
+    encrypt = encrypt_scalar;
+    decrypt = decrypt_scalar;
+#if NET_STREAM_ENCRYPTOR_SSE2
+    if (_kind >= Encryptor::kKernelSse2) {
+      invert = invert_sse2;
+      encrypt = encrypt_sse2;
+      decrypt = decrypt_sse2;
+    }
+#endif
+#if NET_STREAM_ENCRYPTOR_X86
+    if (_kind >= Encryptor::kKernelSsse3) {
+      encrypt = encrypt_ssse3;
+      decrypt = decrypt_ssse3;
+    }
+    if (_kind >= Encryptor::kKernelAvx2) {
+      invert = invert_avx2;
+      encrypt = encrypt_avx2;
+      decrypt = decrypt_avx2;
+    }
+#endif
+  }
+} kernels_t;
+
+static kernels_t &kernels() {
+  static kernels_t result;
+  return result;
+}
+
+bool Encryptor::set_kernel(uint8_t kernel) {
+  if (!kernels_t::supported(kernel)) return false;
+  kernels().use(kernel);
+  return true;
+}
+
+uint8_t Encryptor::kernel() {
+  return kernels().kind;
+}
+
 Encryptor::Encryptor() {
   isenable_ = false;
   memset(key_, 0, sizeof(key_));
+  memset(keyhigh_, 0, sizeof(keyhigh_));
 }
 
 Encryptor::~Encryptor() {
@@ -13,45 +334,25 @@ Encryptor::~Encryptor() {
 }
 
 void *Encryptor::encrypt(void *out, const void *in, uint32_t count) {
-  void *result = out;
-  while (count--) {
-    *reinterpret_cast<char *>(out) = 
-      *reinterpret_cast<char *>(const_cast<void *>(in));
-    if (isenable()) { //enable with key
-      uint8_t low = 0;
-      uint8_t high = 0;
-      low = (*reinterpret_cast<char *>(out)) & 0x0F;
-      high = (*reinterpret_cast<char *>(out)) & 0xF0;
-      high = high ^ (key_[low] & 0xF0);
-      low = (((low ^ 0x0F) & 0x0F) + (key_[0] & 0x0F)) & 0x0F;
-      *reinterpret_cast<char *>(out) = high + low;
-    } else {
-      *reinterpret_cast<char *>(out) = *reinterpret_cast<char *>(out) ^ 0xFF;
-    }
-    out = reinterpret_cast<char *>(out) + 1;
-    in = reinterpret_cast<char *>(const_cast<void *>(in)) + 1;
+  auto _out = reinterpret_cast<uint8_t *>(out);
+  auto _in = reinterpret_cast<const uint8_t *>(in);
+  if (isenable()) { //enable with key
+    kernels().encrypt(
+        keyhigh_, static_cast<uint8_t>(key_[0] & 0x0F), _out, _in, count);
+  } else {
+    kernels().invert(_out, _in, count);
   }
-  return result;
+  return out;
 }
 
 void *Encryptor::decrypt(void *out, const void *in, uint32_t count) {
-  void *result = out;
-  while (count--) {
-    *reinterpret_cast<char *>(out) = 
-      *reinterpret_cast<char *>(const_cast<void *>(in));
-    if (isenable()) { //enable with key
-      uint8_t low = 0;
-      uint8_t high = 0;
-      low = (*reinterpret_cast<char *>(out)) & 0x0F;
-      high = (*reinterpret_cast<char *>(out)) & 0xF0;
-      low = ((low - (key_[0] & 0x0F)) & 0x0F) ^ 0x0F;
-      high = high ^ (key_[low] & 0xF0);
-      *reinterpret_cast<char *>(out) = high + low;
-    } else {
-      *reinterpret_cast<char *>(out) = *reinterpret_cast<char *>(out) ^ 0xFF;
-    }
-    out = reinterpret_cast<char *>(out) + 1;
-    in = reinterpret_cast<char *>(const_cast<void *>(in)) + 1;
+  auto _out = reinterpret_cast<uint8_t *>(out);
+  auto _in = reinterpret_cast<const uint8_t *>(in);
+  if (isenable()) { //enable with key
+    kernels().decrypt(
+        keyhigh_, static_cast<uint8_t>(key_[0] & 0x0F), _out, _in, count);
+  } else {
+    kernels().invert(_out, _in, count);
   }
-  return result;
+  return out;
 }
@@ -12,42 +12,7 @@ uint32_t Input::read(char *buffer, uint32_t length) {
   if (0 == length || length > size()) {
     return 0;
   }
-  if (streamdata_.head < streamdata_.tail) {
-    if (encrypt_isenable()) {
-      encryptor_.decrypt(buffer, 
-                         &(streamdata_.buffer[streamdata_.head]), 
-                         length);
-    } else {
-      memcpy(buffer, &(streamdata_.buffer[streamdata_.head]), length);
-    }
-  } else {
-    uint32_t rightlength = streamdata_.bufferlength - streamdata_.head;
-    if (length < rightlength) {
-      if (encrypt_isenable()) {
-        encryptor_.decrypt(&buffer[0], 
-                           &(streamdata_.buffer[streamdata_.head]), 
-                           length);
-      } else {
-        memcpy(&buffer[0], &(streamdata_.buffer[streamdata_.head]), length);
-      }
-    } else {
-      if (encrypt_isenable()) {
-        encryptor_.decrypt(&buffer[0], 
-                           &(streamdata_.buffer[streamdata_.head]), 
-                           rightlength);
-        encryptor_.decrypt(&buffer[rightlength], 
-                           &(streamdata_.buffer[0]), 
-                           length - rightlength);
-      } else {
-        memcpy(&buffer[0], 
-               &(streamdata_.buffer[streamdata_.head]), 
-               rightlength);
-        memcpy(&buffer[rightlength], 
-               &(streamdata_.buffer[0]), 
-               length - rightlength);
-      }
-    }
-  }
+  copyout(buffer, length);
   streamdata_.head = (streamdata_.head + length) % streamdata_.bufferlength;
   return result;
 }
@@ -56,41 +21,7 @@ bool Input::peek(char *buffer, uint32_t length) {
   if (0 == length || length > size()) {
     return false;
   }
-  if (streamdata_.head < streamdata_.tail) {
-    if (encrypt_isenable()) {
-      encryptor_.decrypt(buffer, 
-                         &(streamdata_.buffer[streamdata_.head]), length);
-    } else {
-      memcpy(buffer, &(streamdata_.buffer[streamdata_.head]), length);
-    }
-  } else {
-    uint32_t rightlength = streamdata_.bufferlength - streamdata_.head;
-    if (length < rightlength) {
-      if (encrypt_isenable()) {
-        encryptor_.decrypt(&buffer[0], 
-                           &(streamdata_.buffer[streamdata_.head]), 
-                           length);
-      } else {
-        memcpy(&buffer[0], &(streamdata_.buffer[streamdata_.head]), length);
-      }
-    } else {
-      if (encrypt_isenable()) {
-        encryptor_.decrypt(&buffer[0], 
-                           &(streamdata_.buffer[streamdata_.head]), 
-                           rightlength);
-        encryptor_.decrypt(&buffer[rightlength], 
-                           &(streamdata_.buffer[0]), 
-                           length - rightlength);
-      } else {
-        memcpy(&buffer[0], 
-               &(streamdata_.buffer[streamdata_.head]), 
-               rightlength);
-        memcpy(&buffer[rightlength], 
-               &(streamdata_.buffer[0]), 
-               length - rightlength);
-      }
-    }
-  }
+  copyout(buffer, length);
   return true;
 }
 
@@ -103,119 +34,111 @@ bool Input::skip(uint32_t length) {
   return result;
 }
 
+const char *Input::view(uint32_t length) {
+  if (0 == length || length > size()) return nullptr;
+  if (encrypt_isenable() && !decrypt_once_) return nullptr;
+  //The heap buffer data maybe wrapped, move it to the front.
+  if (length > contiguous_size() && !resize(0)) return nullptr;
+  return &streamdata_.buffer[streamdata_.head];
+}
+
+void Input::set_decrypt_once(bool flag) {
+  if (flag == decrypt_once_) return;
+  //Change the buffer data to the new mode.
+  if (encrypt_isenable() && !empty())
+    crypt_inplace(streamdata_.head, static_cast<uint32_t>(size()), flag);
+  decrypt_once_ = flag;
+}
+
 int32_t Input::fill() {
   if (!socket_->is_valid()) return 0;
   uint32_t fillcount = 0;
   int32_t receivecount = 0;
   uint32_t freecount = 0;
-  if (is_null(streamdata_.buffer)) return -1;
+  if (!alloc()) return -1;
   // head tail length=10
   // 0123456789
   // abcd......
-  if (streamdata_.head <= streamdata_.tail) {
-    if (0 == streamdata_.head) {
-      receivecount = 0;
-      freecount = streamdata_.bufferlength - streamdata_.tail - 1;
-      if (freecount != 0) {
-        receivecount = socket_->receive(
-            &streamdata_.buffer[streamdata_.tail], freecount);
-        if (SOCKET_ERROR_WOULD_BLOCK == receivecount) return 0;
-        if (SOCKET_ERROR == receivecount) return SOCKET_ERROR - 1;
-        if (0 == receivecount) return SOCKET_ERROR - 2;
-        streamdata_.tail += receivecount;
-        fillcount += receivecount;
-        if (static_cast<uint32_t>(receivecount) == freecount) {
-          uint32_t available = socket_->available();
-          if (available <= 0) return fillcount;
-          if ((streamdata_.bufferlength + available + 1) > 
-              streamdata_.bufferlength_max) {
-            init();
-            return SOCKET_ERROR - 3;
-          }
-          if (!resize(available + 1)) return 0;
-          receivecount = socket_->receive(
-              &streamdata_.buffer[streamdata_.tail], available);
-          if (SOCKET_ERROR_WOULD_BLOCK == receivecount) return 0;
-          if (SOCKET_ERROR == receivecount) return SOCKET_ERROR - 4;
-          if (0 == receivecount) return SOCKET_ERROR - 5;
-          streamdata_.tail += receivecount;
-          fillcount += receivecount; 
-        }
-      }
-    } else { // 0 == head
-      freecount = streamdata_.bufferlength - streamdata_.tail;
-      receivecount = socket_->receive(
-          &streamdata_.buffer[streamdata_.tail], freecount);
-      if (SOCKET_ERROR_WOULD_BLOCK == receivecount) return 0;
-      if (SOCKET_ERROR == receivecount) return SOCKET_ERROR - 6;
-      if (0 == receivecount) return SOCKET_ERROR - 7;
-      streamdata_.tail = 
-        (streamdata_.tail + receivecount) % streamdata_.bufferlength;
-      fillcount += receivecount;
-      if (static_cast<uint32_t>(receivecount) == freecount) {
-        receivecount = 0;
-        freecount = streamdata_.head - 1;
-        if (freecount != 0) {
-          receivecount = socket_->receive(
-              &streamdata_.buffer[0], freecount);
-          if (SOCKET_ERROR_WOULD_BLOCK == receivecount) return 0;
-          if (SOCKET_ERROR == receivecount) return SOCKET_ERROR - 8;
-          if (0 == receivecount) return SOCKET_ERROR - 9;
-          streamdata_.tail += receivecount;
-          fillcount += receivecount;
-        }
-        if (static_cast<uint32_t>(receivecount) == freecount) {
-          uint32_t available = socket_->available();
-          if (available <= 0) return fillcount;
-          if ((streamdata_.bufferlength + available + 1) > 
-              streamdata_.bufferlength_max) {
-            init();
-            return SOCKET_ERROR - 10;
-          }
-          if (!resize(available + 1)) return 0;
-          receivecount = socket_->receive(
-              &streamdata_.buffer[streamdata_.tail], available);
-          if (SOCKET_ERROR_WOULD_BLOCK == receivecount) return 0;
-          if (SOCKET_ERROR == receivecount) return SOCKET_ERROR - 11;
-          if (0 == receivecount) return SOCKET_ERROR - 12;
-          streamdata_.tail += receivecount;
-          fillcount += receivecount; 
-        }
-      }
+  // Receive to the free spans of the ring(the mirrored buffer just one) and 
+  // a stack buffer with one syscall, so the full ring not need the 
+  // available ioctl, just extend it with the stack buffer data.
+  char extra[NETINPUT_FILL_EXTRASIZE];
+  uint32_t capacity = 0;
+  do {
+    socket::iobuffer_t buffers[3];
+    uint32_t count = 0;
+    freecount = static_cast<uint32_t>(unused());
+    uint32_t rightlength = contiguous_unused();
+    if (rightlength > 0) {
+      buffers[count].data = &streamdata_.buffer[streamdata_.tail];
+      buffers[count].length = rightlength;
+      ++count;
     }
-  } else { //streamdata_.head <= streamdata_.tail
-    receivecount = 0;
-    freecount = streamdata_.head - streamdata_.tail - 1;
-    if (freecount != 0) {
-      receivecount = socket_->receive(
-          &streamdata_.buffer[streamdata_.tail], freecount);
-      if (SOCKET_ERROR_WOULD_BLOCK == receivecount) return 0;
-      if (SOCKET_ERROR == receivecount) return SOCKET_ERROR - 13;
-      if (0 == receivecount) return SOCKET_ERROR - 14;
-      streamdata_.tail += receivecount;
-      fillcount += receivecount;
+    if (freecount > rightlength) {
+      buffers[count].data = streamdata_.buffer;
+      buffers[count].length = freecount - rightlength;
+      ++count;
     }
-    if (static_cast<uint32_t>(receivecount) == freecount) {
-      uint32_t available = socket_->available();
-      if (available <= 0) return fillcount;
-      if ((streamdata_.bufferlength + available + 1) > 
+    buffers[count].data = extra;
+    buffers[count].length = sizeof(extra);
+    ++count;
+    capacity = freecount + static_cast<uint32_t>(sizeof(extra));
+    receivecount = socket_->receive(buffers, count);
+    if (SOCKET_ERROR_WOULD_BLOCK == receivecount) return fillcount;
+    if (SOCKET_ERROR == receivecount) return SOCKET_ERROR - 1;
+    if (0 == receivecount) return SOCKET_ERROR - 2;
+    fillcount += receivecount;
+    uint32_t ringcount = 
+      min(static_cast<uint32_t>(receivecount), freecount);
+    bool decrypt = decrypt_once_ && encrypt_isenable();
+    if (decrypt) crypt_inplace(streamdata_.tail, ringcount, true);
+    streamdata_.tail = 
+      (streamdata_.tail + ringcount) % streamdata_.bufferlength;
+    uint32_t extracount = receivecount - ringcount;
+    if (extracount > 0) {
+      if ((streamdata_.bufferlength + extracount + 1) > 
           streamdata_.bufferlength_max) {
-        init();
-        return SOCKET_ERROR - 15;
+        return SOCKET_ERROR - 3;
       }
-      if (!resize(available + 1)) return 0;
-      receivecount = socket_->receive(
-          &streamdata_.buffer[streamdata_.tail], available);
-      if (SOCKET_ERROR_WOULD_BLOCK == receivecount) return 0;
-      if (SOCKET_ERROR == receivecount) return SOCKET_ERROR - 16;
-      if (0 == receivecount) return SOCKET_ERROR - 17;
-      streamdata_.tail += receivecount;
-      fillcount += receivecount; 
+      if (!resize(extracount + 1)) return SOCKET_ERROR - 4;
+      if (decrypt) {
+        encryptor_.decrypt(
+            &streamdata_.buffer[streamdata_.tail], extra, extracount);
+      } else {
+        memcpy(&streamdata_.buffer[streamdata_.tail], extra, extracount);
+      }
+      streamdata_.tail = 
+        (streamdata_.tail + extracount) % streamdata_.bufferlength;
     }
-  }
+  } while (static_cast<uint32_t>(receivecount) == capacity);
   return fillcount;
 }
 
+int32_t Input::fill(const char *buffer, uint32_t length) {
+  if (0 == length) return 0;
+  if (!alloc()) return -1;
+  if (size() + length + 1 > streamdata_.bufferlength_max) 
+    return SOCKET_ERROR - 3;
+  if (!use(length)) return SOCKET_ERROR - 4;
+  uint32_t position = streamdata_.tail;
+  uint32_t rightlength = contiguous_unused();
+  if (length < rightlength) rightlength = length;
+  if (decrypt_once_ && encrypt_isenable()) {
+    encryptor_.decrypt(&streamdata_.buffer[position], buffer, rightlength);
+    if (length > rightlength) {
+      encryptor_.decrypt(
+          streamdata_.buffer, buffer + rightlength, length - rightlength);
+    }
+  } else {
+    memcpy(&streamdata_.buffer[position], buffer, rightlength);
+    if (length > rightlength) {
+      memcpy(streamdata_.buffer, buffer + rightlength, length - rightlength);
+    }
+  }
+  streamdata_.tail = (position + length) % streamdata_.bufferlength;
+  return static_cast<int32_t>(length);
+}
+
 int8_t Input::read_int8() {
     int8_t result = 0;
     read((char*)&result, sizeof(result));
@@ -305,56 +228,13 @@ void Input::compressenable(bool enable) {
 
 uint32_t Input::write(const char *buffer, uint32_t length) {
   //this function diffrent from OutputStream::write is the streamdata_.bufferlength not resize
-  uint32_t freecount = 0;
-  uint32_t fillcount = 0;
-  if (streamdata_.head <= streamdata_.tail) {
-    if (0 == streamdata_.head) {
-      freecount = streamdata_.bufferlength - streamdata_.tail - 1;
-      uint32_t copysize = freecount > length ? length : freecount;
-      if (encrypt_isenable()) {
-        encryptor_.encrypt(
-            &streamdata_.buffer[streamdata_.tail], buffer, copysize);
-      } else {
-        memcpy(&streamdata_.buffer[streamdata_.tail], buffer, copysize);
-      }
-    } else {
-      freecount = streamdata_.bufferlength - streamdata_.tail;
-      uint32_t copysize1 = freecount > length ? length : freecount;
-      if (encrypt_isenable()) {
-        encryptor_.encrypt(
-            &streamdata_.buffer[streamdata_.tail], buffer, copysize1);
-      } else {
-        memcpy(&streamdata_.buffer[streamdata_.tail], buffer, copysize1);
-      }
-      fillcount += copysize1;
-      streamdata_.tail = 
-        (streamdata_.tail + copysize1) % streamdata_.bufferlength;
-      buffer += copysize1;
-      freecount = streamdata_.head - 1;
-      uint32_t copysize2 = freecount > length - copysize1 ? 
-                           length - copysize1 : 
-                           freecount;
-      if (encrypt_isenable()) {
-        encryptor_.encrypt(
-            &streamdata_.buffer[streamdata_.tail], buffer, copysize2);
-      } else {
-        memcpy(&streamdata_.buffer[streamdata_.tail], buffer, copysize2);
-      }
-      fillcount += copysize2;
-      streamdata_.tail += copysize2;
-    }
-  } else {
-    freecount = streamdata_.head - streamdata_.tail - 1;
-    uint32_t copysize = freecount > length ? length : freecount;
-    if (encrypt_isenable()) {
-      encryptor_.encrypt(
-          &streamdata_.buffer[streamdata_.tail], buffer, copysize);
-    } else {
-      memcpy(&streamdata_.buffer[streamdata_.tail], buffer, copysize);
-    }
-    fillcount += copysize;
-    streamdata_.tail += copysize;
-  }
+  if (!alloc(length + 1)) return 0;
+  uint32_t freecount = static_cast<uint32_t>(unused());
+  uint32_t fillcount = freecount > length ? length : freecount;
+  if (0 == fillcount) return 0;
+  copyin(buffer, fillcount);
+  streamdata_.tail = 
+    (streamdata_.tail + fillcount) % streamdata_.bufferlength;
   return fillcount;
 }
 
@@ -1,3 +1,4 @@
+#include <atomic>
 #include "pf/net/socket/basic.h"
 #include "pf/net/stream/output.h"
 
@@ -8,6 +9,16 @@ namespace stream {
 void Output::clear() {
   Basic::clear();
   tail_ = 0;
+  reserved_ = nullptr;
+  reserved_length_ = reserved_size_ = 0;
+  coalesce_reset();
+}
+
+bool Output::release() {
+  if (!is_null(reserved_)) return false;
+  if (compressor_.getsize() != 0 || !Basic::release()) return false;
+  tail_ = 0;
+  return true;
 }
 
 uint32_t Output::write(const char *buffer, uint32_t length) {
@@ -16,44 +27,52 @@ uint32_t Output::write(const char *buffer, uint32_t length) {
    * 0123456789      0123456789
    * abcd...efg      ...abcd...
    */
-  auto &head = streamdata_.head;
-  auto &tail = streamdata_.tail;
-  auto &bufferlength = streamdata_.bufferlength;
-  size_t freecount{0};
-  if (!use(length)) return 0;
-  if (head <= tail) {
-    freecount = bufferlength - tail - 1;
-    if (length <= freecount) {
-      if (encrypt_isenable()) {
-        encryptor_.encrypt(&(streamdata_.buffer[tail]), buffer, length);
-      } else {
-        memcpy(&(streamdata_.buffer[tail]), buffer, length);
-      }
-    } else {
-      if (encrypt_isenable()) {
-        encryptor_.encrypt(&(streamdata_.buffer[tail]), buffer, freecount);
-        encryptor_.encrypt(streamdata_.buffer, 
-                           &buffer[freecount], 
-                           bufferlength - freecount);
-      } else {
-        memcpy(&(streamdata_.buffer[tail]), buffer, freecount);
-        memcpy(streamdata_.buffer, &buffer[freecount], length - freecount);
-      }
-    }
-  } else {
-    if (encrypt_isenable()) {
-      encryptor_.encrypt(&(streamdata_.buffer[tail]), buffer, length);
-    } else {
-      memcpy(&(streamdata_.buffer[tail]), buffer, length);
+  if (coalesce_size_ > 0 && 0 == coalesce_start_) 
+    coalesce_start_ = coalesce_now();
+  if (!is_null(reserved_)) {
+    if (reserved_size_ + length <= reserved_length_) {
+      memcpy(reserved_ + reserved_size_, buffer, length);
+      reserved_size_ += length;
+      return length;
     }
+    //More than reserved, keep the written and write as normal.
+    commit(reserved_size_);
   }
-  streamdata_.tail = (tail + length) % bufferlength;
+  if (!use(length)) return 0;
+  copyin(buffer, length);
+  streamdata_.tail = (streamdata_.tail + length) % streamdata_.bufferlength;
   return length;
 }
 
+char *Output::reserve(uint32_t length) {
+  if (!is_null(reserved_) || 0 == length) return nullptr;
+  if (!use(length)) return nullptr;
+  if (coalesce_size_ > 0 && 0 == coalesce_start_) 
+    coalesce_start_ = coalesce_now();
+  if (empty()) streamdata_.head = streamdata_.tail = 0;
+  //The heap buffer free space maybe wrapped, move the data to the front.
+  if (contiguous_unused() < length && !resize(0)) return nullptr;
+  reserved_ = &streamdata_.buffer[streamdata_.tail];
+  reserved_length_ = length;
+  reserved_size_ = 0;
+  return reserved_;
+}
+
+bool Output::commit(uint32_t length) {
+  if (is_null(reserved_) || length > reserved_length_) return false;
+  if (encrypt_isenable()) crypt_inplace(streamdata_.tail, length, false);
+  streamdata_.tail = (streamdata_.tail + length) % streamdata_.bufferlength;
+  reserved_ = nullptr;
+  reserved_length_ = reserved_size_ = 0;
+  return true;
+}
+
 int32_t Output::flush() {
   if (!socket_->is_valid()) return 0;
-  if (0 == size()) return 0;
+  if (0 == size()) {
+    coalesce_reset();
+    return 0;
+  }
   if (compressor_.getassistant()->isenable()) { //compress is enable
     uint32_t result = 0;
     uint32_t sendcount = 0;
@@ -69,6 +88,7 @@ int32_t Output::flush() {
     sendcount += result;
     if (static_cast<int32_t>(result) <= SOCKET_ERROR) 
       return static_cast<int32_t>(result);
+    if (empty() && 0 == compressor_.getsize()) coalesce_reset();
     return sendcount;
   }
   uint32_t flushcount = 0;
@@ -84,51 +104,85 @@ int32_t Output::flush() {
 #elif OS_WIN
   flag = MSG_DONTROUTE;
 #endif
-  leftcount = streamdata_.head < streamdata_.tail ? 
-              streamdata_.tail - streamdata_.head : 
-              streamdata_.bufferlength - streamdata_.head;
-  while (leftcount > 0) {
-    sendcount = 
-      socket_->send(&streamdata_.buffer[streamdata_.head], leftcount, flag);
-    if (SOCKET_ERROR_WOULD_BLOCK == sendcount) {
-      return flushcount;
-    }
-    if (SOCKET_ERROR == sendcount) {
-      return SOCKET_ERROR - 2;
-    }
-    if (0 == sendcount) {
-      return flushcount;
-    }
-    flushcount += sendcount;
-    leftcount -= sendcount;
-    streamdata_.head += sendcount;
+  //The mirrored buffer data is one span, the heap buffer maybe two, send 
+  //them with one syscall.
+  socket::iobuffer_t buffers[2];
+  uint32_t count = 0;
+  leftcount = static_cast<uint32_t>(size());
+  uint32_t rightlength = contiguous_size();
+  buffers[count].data = &streamdata_.buffer[streamdata_.head];
+  buffers[count].length = rightlength;
+  ++count;
+  if (leftcount > rightlength) {
+    buffers[count].data = streamdata_.buffer;
+    buffers[count].length = leftcount - rightlength;
+    ++count;
   }
-  if (streamdata_.head > streamdata_.tail) {
-    streamdata_.head = 0;
-    leftcount = streamdata_.tail;
-    while (leftcount > 0) {
-      sendcount = socket_->send(
-          &(streamdata_.buffer[streamdata_.head]), leftcount, flag);
-      if (SOCKET_ERROR_WOULD_BLOCK == sendcount) {
-        return flushcount;
-      }
-      if (SOCKET_ERROR == sendcount) {
-        return SOCKET_ERROR - 3;
-      }
-      if (0 == sendcount) {
-        return flushcount;
-      }
-      flushcount += sendcount;
-      leftcount -= sendcount;
-      streamdata_.head += sendcount;
-    }
+  sendcount = socket_->send(buffers, count, flag);
+  if (SOCKET_ERROR_WOULD_BLOCK == sendcount) {
+    return flushcount;
   }
-  if (streamdata_.head == streamdata_.tail)
+  if (SOCKET_ERROR == sendcount) {
+    return SOCKET_ERROR - 2;
+  }
+  if (0 == sendcount) {
+    return flushcount;
+  }
+  flushcount += sendcount;
+  streamdata_.head = 
+    (streamdata_.head + sendcount) % streamdata_.bufferlength;
+  if (streamdata_.head == streamdata_.tail) {
     streamdata_.head = streamdata_.tail = 0;
+    coalesce_reset();
+  }
   int32_t result = static_cast<int32_t>(flushcount);
   return result;
 }
 
+uint32_t Output::drain(char *buffer, uint32_t length) {
+  if (!is_null(reserved_) || 0 == length || empty()) return 0;
+  uint32_t count = static_cast<uint32_t>(size());
+  if (length < count) count = length;
+  uint32_t rightlength = contiguous_size();
+  if (count < rightlength) rightlength = count;
+  memcpy(buffer, &streamdata_.buffer[streamdata_.head], rightlength);
+  if (count > rightlength) 
+    memcpy(buffer + rightlength, streamdata_.buffer, count - rightlength);
+  streamdata_.head = (streamdata_.head + count) % streamdata_.bufferlength;
+  if (streamdata_.head == streamdata_.tail) {
+    streamdata_.head = streamdata_.tail = 0;
+    coalesce_reset();
+  }
+  return count;
+}
+
+uint32_t Output::coalesce_wait(uint64_t now) const {
+  if (0 == coalesce_size_ || 0 == coalesce_start_ || coalesce_full()) 
+    return 0;
+  uint64_t passed = now > coalesce_start_ ? now - coalesce_start_ : 0;
+  if (passed >= coalesce_delay_) return 0;
+  return static_cast<uint32_t>(coalesce_delay_ - passed);
+}
+
+static std::atomic<function_coalesce_clock> g_coalesce_clock{nullptr};
+
+uint64_t Output::coalesce_now() {
+  auto clock = g_coalesce_clock.load(std::memory_order_relaxed);
+  if (clock) return clock();
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void Output::set_coalesce_clock(function_coalesce_clock function) {
+  g_coalesce_clock = function;
+}
+
+void Output::coalesce_reset() {
+  coalesce_start_ = 0;
+  urgent_ = false;
+}
+
 bool Output::write_int8(int8_t value) {
   uint32_t count = write((char*)&value, sizeof(value));
   bool result = count == sizeof(value) ? true : false;
@@ -0,0 +1,97 @@
+#include <thread>
+#include "gtest/gtest.h"
+#include "pf/basic/mpsc_queue.tcc"
+#include "env.h"
+
+using namespace pf_basic;
+
+class BasicMpscQueue : public testing::Test {
+
+ public:
+   virtual void SetUp() {
+     //do nothing
+   }
+
+   virtual void TearDown() {
+     //do nothing
+   }
+
+ protected:
+   //The value is [producer:32][sequence:32].
+   static uint64_t value(uint32_t producer, uint32_t sequence) {
+     return (static_cast<uint64_t>(producer) << 32) | sequence;
+   }
+
+   //Run the producers and check the items on the consumer.
+   void produce_consume(uint32_t producers, uint32_t count, size_t capacity) {
+     MpscQueue<uint64_t> queue;
+     ASSERT_TRUE(queue.init(capacity));
+     std::vector<std::thread> threads;
+     for (uint32_t producer = 0; producer < producers; ++producer) {
+       threads.emplace_back([&queue, producer, count]() {
+         for (uint32_t i = 0; i < count; ++i) {
+           //Full is back pressure, retry it.
+           while (!queue.push(value(producer, i))) std::this_thread::yield();
+         }
+       });
+     }
+     std::vector<uint32_t> nexts(producers, 0);
+     uint64_t total = static_cast<uint64_t>(producers) * count;
+     uint64_t received{0};
+     uint64_t item{0};
+     while (received < total) {
+       if (!queue.pop(item)) {
+         std::this_thread::yield();
+         continue;
+       }
+       auto producer = static_cast<uint32_t>(item >> 32);
+       auto sequence = static_cast<uint32_t>(item & 0xffffffff);
+       ASSERT_LT(producer, producers);
+       //In order and no lost or duplicate for each producer.
+       ASSERT_EQ(sequence, nexts[producer]) << "producer: " << producer;
+       ++nexts[producer];
+       ++received;
+     }
+     for (auto &thread : threads) thread.join();
+     ASSERT_FALSE(queue.pop(item));
+     ASSERT_TRUE(queue.empty());
+     for (uint32_t producer = 0; producer < producers; ++producer)
+       ASSERT_EQ(nexts[producer], count);
+     ASSERT_LE(queue.high_water(), queue.capacity());
+   }
+
+};
+
+TEST_F(BasicMpscQueue, testSingleThread) {
+  MpscQueue<std::string> queue;
+  std::string value{"a"};
+  ASSERT_FALSE(queue.push(std::move(value)));
+  ASSERT_TRUE(queue.init(3));
+  ASSERT_EQ(queue.capacity(), static_cast<size_t>(4));
+  for (uint32_t i = 0; i < 4; ++i) {
+    value = std::to_string(i);
+    ASSERT_TRUE(queue.push(std::move(value)));
+  }
+  //The value is kept if full.
+  value = "full";
+  ASSERT_FALSE(queue.push(std::move(value)));
+  ASSERT_EQ(value, "full");
+  ASSERT_EQ(queue.full_count(), static_cast<uint64_t>(1));
+  ASSERT_EQ(queue.size(), static_cast<size_t>(4));
+  ASSERT_EQ(queue.high_water(), static_cast<size_t>(4));
+  for (uint32_t i = 0; i < 4; ++i) {
+    ASSERT_TRUE(queue.pop(value));
+    ASSERT_EQ(value, std::to_string(i));
+  }
+  ASSERT_FALSE(queue.pop(value));
+  ASSERT_TRUE(queue.empty());
+}
+
+TEST_F(BasicMpscQueue, testMultiProducers) {
+  produce_consume(4, 200000, 1024);
+}
+
+TEST_F(BasicMpscQueue, testMultiProducersSmallQueue) {
+  //The queue is full often and the positions wrap many times.
+  produce_consume(8, 50000, 8);
+}
@@ -0,0 +1,147 @@
+#include "gtest/gtest.h"
+#include "pf/basic/timing_wheel.h"
+#include "env.h"
+
+using namespace pf_basic;
+
+class BasicTimingWheel : public testing::Test {
+
+ public:
+   virtual void SetUp() {
+     wheel_.init(1, kStart);
+     fired_.clear();
+   }
+
+   virtual void TearDown() {
+     //do nothing
+   }
+
+ protected:
+   //The time near the uint32 wrap.
+   static const uint32_t kStart = 0xffffff00;
+
+ protected:
+   //Advance to the time and record the data with the time.
+   void advance(uint32_t now) {
+     wheel_.advance(now, [this, now](uint64_t data) {
+       fired_.push_back(std::make_pair(data, now));
+     });
+   }
+
+   //Advance to the time one by one.
+   void step(uint32_t from, uint32_t to) {
+     for (uint32_t now = from; now != to + 1; ++now) advance(now);
+   }
+
+ protected:
+   TimingWheel wheel_;
+   std::vector< std::pair<uint64_t, uint32_t> > fired_;
+
+};
+
+TEST_F(BasicTimingWheel, testExpireInTime) {
+  //Each level and the boundaries.
+  std::vector<uint32_t> delays = {
+    0, 1, 2, 255, 256, 257, 1000, 16383, 16384, 16385, 
+    100000, 1048575, 1048576, 1048577, 3000000,
+  };
+  for (size_t i = 0; i < delays.size(); ++i)
+    ASSERT_NE(wheel_.add(delays[i], i), static_cast<uint64_t>(0));
+  ASSERT_EQ(wheel_.size(), delays.size());
+  step(kStart, kStart + 3000000);
+  ASSERT_EQ(fired_.size(), delays.size());
+  ASSERT_EQ(wheel_.size(), static_cast<size_t>(0));
+  for (auto &item : fired_) {
+    auto delay = delays[static_cast<size_t>(item.first)];
+    ASSERT_EQ(item.second, kStart + delay) << "delay: " << delay;
+  }
+}
+
+TEST_F(BasicTimingWheel, testCascadeInOneAdvance) {
+  //The timers cascade from the upper levels in one advance.
+  std::vector<uint32_t> delays = {300, 20000, 2000000};
+  for (size_t i = 0; i < delays.size(); ++i) wheel_.add(delays[i], i);
+  advance(kStart + 299);
+  ASSERT_TRUE(fired_.empty());
+  advance(kStart + 19999);
+  ASSERT_EQ(fired_.size(), static_cast<size_t>(1));
+  advance(kStart + 1999999);
+  ASSERT_EQ(fired_.size(), static_cast<size_t>(2));
+  advance(kStart + 2000000);
+  ASSERT_EQ(fired_.size(), static_cast<size_t>(3));
+  ASSERT_EQ(fired_[2].first, static_cast<uint64_t>(2));
+}
+
+TEST_F(BasicTimingWheel, testCancelAndRearm) {
+  auto id1 = wheel_.add(100, 1);
+  auto id2 = wheel_.add(70000, 2);
+  ASSERT_TRUE(wheel_.cancel(id1));
+  ASSERT_FALSE(wheel_.cancel(id1));
+  //The node is reused, the old id is invalid.
+  auto id3 = wheel_.add(200, 3);
+  ASSERT_FALSE(wheel_.cancel(id1));
+  advance(kStart + 150);
+  ASSERT_TRUE(fired_.empty());
+  //Re-arm the cascading one.
+  ASSERT_TRUE(wheel_.cancel(id2));
+  wheel_.add(500, 2);
+  advance(kStart + 200);
+  ASSERT_EQ(fired_.size(), static_cast<size_t>(1));
+  ASSERT_EQ(fired_[0].first, static_cast<uint64_t>(3));
+  //The expired id can not cancel.
+  ASSERT_FALSE(wheel_.cancel(id3));
+  //Added after advance, the time is in the next slot(never early).
+  advance(kStart + 649);
+  ASSERT_EQ(fired_.size(), static_cast<size_t>(1));
+  advance(kStart + 651);
+  ASSERT_EQ(fired_.size(), static_cast<size_t>(2));
+  ASSERT_EQ(wheel_.size(), static_cast<size_t>(0));
+}
+
+TEST_F(BasicTimingWheel, testRearmInCallback) {
+  uint32_t count{0};
+  uint64_t cancel_id{0};
+  cancel_id = wheel_.add(10, 2);
+  wheel_.add(10, 1);
+  //Cancel the pending one and re-arm self in the callback.
+  std::function<void (uint64_t)> function = [&](uint64_t data) {
+    ++count;
+    if (1 == data) {
+      wheel_.cancel(cancel_id);
+      if (count < 5) wheel_.add(10, 1);
+    }
+  };
+  for (uint32_t now = kStart; now != kStart + 100; ++now)
+    wheel_.advance(now, function);
+  ASSERT_EQ(count, static_cast<uint32_t>(5));
+  ASSERT_EQ(wheel_.size(), static_cast<size_t>(0));
+}
+
+TEST_F(BasicTimingWheel, testLongerThanWheel) {
+  //The wheel has 2^26 slots, the longer timers must not expire early.
+  const uint32_t range = 1 << 26;
+  std::vector<uint32_t> delays = {range - 1, range, range + 12345, range * 3};
+  for (size_t i = 0; i < delays.size(); ++i) wheel_.add(delays[i], i);
+  for (auto delay : delays) {
+    advance(kStart + delay - 1);
+    ASSERT_EQ(wheel_.size() + fired_.size(), delays.size());
+    advance(kStart + delay);
+    ASSERT_FALSE(fired_.empty());
+    ASSERT_EQ(fired_.back().second, kStart + delay) << "delay: " << delay;
+  }
+  ASSERT_EQ(fired_.size(), delays.size());
+}
+
+TEST_F(BasicTimingWheel, testPrecision) {
+  wheel_.init(10, kStart);
+  wheel_.add(25, 1); //Round up to 30.
+  advance(kStart + 29);
+  ASSERT_TRUE(fired_.empty());
+  advance(kStart + 30);
+  ASSERT_EQ(fired_.size(), static_cast<size_t>(1));
+  //The timeout to the next slot has timers.
+  wheel_.add(100, 2);
+  auto timeout = wheel_.timeout(kStart + 30);
+  ASSERT_GT(timeout, static_cast<uint32_t>(0));
+  ASSERT_LE(timeout, static_cast<uint32_t>(110));
+}
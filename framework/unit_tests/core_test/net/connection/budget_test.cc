@@ -0,0 +1,225 @@
+#include <chrono>
+#include <functional>
+#include "gtest/gtest.h"
+#include "pf/net/socket/api.h"
+#include "pf/net/packet/dynamic.h"
+#include "pf/net/connection/budget.h"
+#include "pf/net/connection/manager/listener.h"
+#include "env.h"
+
+using namespace pf_net;
+
+class NetConnectionBudget : public testing::Test {
+
+ public:
+   virtual void SetUp() {
+     using namespace connection;
+     ASSERT_TRUE(manager_.init(16, 0, "127.0.0.1"));
+     budget::set_soft_limit(1024);
+     budget::set_hard_limit(0);
+     budget::set_soft_time(0);
+     budget::set_global_limit(0);
+     budget::set_policy(kOutputPolicyNone);
+     budget::set_droppable(kDroppableId);
+     budget::set_droppable(kDroppableOtherId);
+     global_ = budget::global_size();
+   }
+
+   virtual void TearDown() {
+     using namespace connection;
+     for (auto &client : clients_) client->close();
+     for (uint8_t i = 0; i < 4; ++i) manager_.tick();
+     budget::set_soft_limit(NET_CONNECTION_OUTPUT_SOFT_LIMIT);
+     budget::set_hard_limit(NET_CONNECTION_OUTPUT_HARD_LIMIT);
+     budget::set_soft_time(NET_CONNECTION_OUTPUT_SOFT_TIME);
+     budget::set_global_limit(NET_CONNECTION_OUTPUT_GLOBAL_LIMIT);
+     budget::set_policy(kOutputPolicyNone);
+     budget::set_droppable(kDroppableId, false);
+     budget::set_droppable(kDroppableOtherId, false);
+   }
+
+ protected:
+   static const uint16_t kPacketId = 30001;
+   static const uint16_t kDroppableId = 30002;
+   static const uint16_t kDroppableOtherId = 30003;
+
+ protected:
+   //The accepted connection of a new client(the manager not flush it).
+   connection::Basic *connection_new() {
+     std::unique_ptr<socket::Basic> client{new socket::Basic()};
+     if (!client->create() ||
+         !client->connect("127.0.0.1", manager_.port())) return nullptr;
+     auto size = manager_.size() + 1;
+     if (!run([&]() { return manager_.size() == size; }, 5000)) return nullptr;
+     clients_.push_back(std::move(client));
+     return manager_.get(manager_.get_idset()[size - 1]);
+   }
+
+   static bool send(connection::Basic *connection,
+                    uint16_t packet_id,
+                    uint32_t size,
+                    char value = 'a') {
+     packet::Dynamic packet(packet_id);
+     std::string data(size, value);
+     packet.write(data.data(), size);
+     return connection->send(&packet);
+   }
+
+   //Tick and read the clients until the condition or timeout(milliseconds).
+   bool run(std::function<bool ()> condition, uint32_t timeout) {
+     auto deadline =
+       std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+     while (!condition()) {
+       if (std::chrono::steady_clock::now() > deadline) return false;
+       manager_.tick();
+       for (auto &client : clients_) {
+         char buffer[4096];
+         socket::api::set_nonblocking_ex(client->get_id(), true);
+         while (::recv(client->get_id(), buffer, sizeof(buffer), 0) > 0) {}
+       }
+     }
+     return true;
+   }
+
+ protected:
+   connection::manager::Listener manager_;
+   std::vector< std::unique_ptr<socket::Basic> > clients_;
+   uint64_t global_;
+
+};
+
+TEST_F(NetConnectionBudget, testHoldAndDrop) {
+  using namespace connection;
+  budget::set_policy(kOutputPolicyDrop);
+  auto connection = connection_new();
+  ASSERT_TRUE(!is_null(connection));
+  auto stat = budget::stat();
+  //Over the soft limit, the droppable held and the others written.
+  ASSERT_TRUE(send(connection, kPacketId, 2000));
+  auto written = connection->ostream().size();
+  ASSERT_TRUE(send(connection, kDroppableId, 10));
+  ASSERT_TRUE(send(connection, kPacketId, 10));
+  ASSERT_EQ(connection->ostream().size(),
+            written + NET_PACKET_HEADERSIZE + 10);
+  ASSERT_EQ(budget::stat().held, stat.held + 1);
+  //The held count limited, the oldest dropped.
+  for (uint32_t i = 0; i < NET_CONNECTION_OUTPUT_HOLD_MAX; ++i)
+    ASSERT_TRUE(send(connection, kDroppableId, 10));
+  ASSERT_EQ(budget::stat().held, stat.held + 1 + NET_CONNECTION_OUTPUT_HOLD_MAX);
+  ASSERT_EQ(budget::stat().dropped, stat.dropped + 1);
+  uint32_t held = NET_CONNECTION_OUTPUT_HOLD_MAX * (NET_PACKET_HEADERSIZE + 10);
+  ASSERT_EQ(connection->output_size(), connection->ostream().size() + held);
+  ASSERT_EQ(budget::global_size(), global_ + connection->output_size());
+  ASSERT_FALSE(connection->output_overflow());
+  //Under the soft limit, the held written.
+  ASSERT_TRUE(run([&]() { return 0 == connection->output_size(); }, 5000));
+  ASSERT_EQ(budget::global_size(), global_);
+}
+
+TEST_F(NetConnectionBudget, testCoalesce) {
+  using namespace connection;
+  budget::set_policy(kOutputPolicyCoalesce);
+  auto connection = connection_new();
+  ASSERT_TRUE(!is_null(connection));
+  auto stat = budget::stat();
+  ASSERT_TRUE(send(connection, kPacketId, 2000));
+  auto written = connection->ostream().size();
+  //The newer replace the held of same id.
+  ASSERT_TRUE(send(connection, kDroppableId, 10, 'a'));
+  ASSERT_TRUE(send(connection, kDroppableOtherId, 20));
+  ASSERT_TRUE(send(connection, kDroppableId, 30, 'b'));
+  ASSERT_TRUE(send(connection, kDroppableId, 40, 'c'));
+  ASSERT_EQ(connection->ostream().size(), written);
+  ASSERT_EQ(budget::stat().held, stat.held + 2);
+  ASSERT_EQ(budget::stat().coalesced, stat.coalesced + 2);
+  ASSERT_EQ(connection->output_size(),
+            written + NET_PACKET_HEADERSIZE * 2 + 20 + 40);
+  ASSERT_EQ(budget::global_size(), global_ + connection->output_size());
+  ASSERT_TRUE(run([&]() { return 0 == connection->output_size(); }, 5000));
+  ASSERT_EQ(budget::global_size(), global_);
+}
+
+TEST_F(NetConnectionBudget, testThrottle) {
+  using namespace connection;
+  budget::set_policy(kOutputPolicyThrottle);
+  auto connection = connection_new();
+  ASSERT_TRUE(!is_null(connection));
+  auto stat = budget::stat();
+  ASSERT_TRUE(send(connection, kPacketId, 1000));
+  ASSERT_FALSE(connection->output_throttled());
+  //The write over the soft limit pause the input.
+  ASSERT_TRUE(send(connection, kPacketId, 100));
+  ASSERT_TRUE(connection->output_throttled());
+  ASSERT_TRUE(send(connection, kPacketId, 10));
+  ASSERT_EQ(budget::stat().throttled, stat.throttled + 1);
+  ASSERT_FALSE(connection->output_overflow());
+  //Resume after the output under half of the soft limit.
+  ASSERT_TRUE(run([&]() { return !connection->output_throttled(); }, 5000));
+  ASSERT_TRUE(run([&]() { return 0 == connection->output_size(); }, 5000));
+  ASSERT_EQ(budget::global_size(), global_);
+}
+
+TEST_F(NetConnectionBudget, testDisconnect) {
+  using namespace connection;
+  budget::set_policy(kOutputPolicyDisconnect);
+  auto connection = connection_new();
+  ASSERT_TRUE(!is_null(connection));
+  auto stat = budget::stat();
+  ASSERT_TRUE(send(connection, kPacketId, 1000));
+  ASSERT_FALSE(send(connection, kPacketId, 100));
+  ASSERT_TRUE(connection->output_overflow());
+  ASSERT_EQ(budget::stat().overflow_soft, stat.overflow_soft + 1);
+  //The droppable not written after the overflow.
+  ASSERT_FALSE(send(connection, kDroppableId, 10));
+  ASSERT_NE(budget::global_size(), global_);
+  //The manager remove it, the output bytes given back.
+  ASSERT_TRUE(run([&]() { return 0 == manager_.size(); }, 5000));
+  ASSERT_EQ(budget::global_size(), global_);
+}
+
+TEST_F(NetConnectionBudget, testHardLimit) {
+  using namespace connection;
+  budget::set_hard_limit(4096);
+  auto connection = connection_new();
+  ASSERT_TRUE(!is_null(connection));
+  auto stat = budget::stat();
+  //The policy none write all until the hard limit.
+  ASSERT_TRUE(send(connection, kPacketId, 2000));
+  ASSERT_TRUE(send(connection, kPacketId, 2000));
+  ASSERT_FALSE(connection->output_overflow());
+  ASSERT_FALSE(send(connection, kPacketId, 200));
+  ASSERT_TRUE(connection->output_overflow());
+  ASSERT_EQ(budget::stat().overflow_hard, stat.overflow_hard + 1);
+  ASSERT_TRUE(run([&]() { return 0 == manager_.size(); }, 5000));
+  ASSERT_EQ(budget::global_size(), global_);
+}
+
+TEST_F(NetConnectionBudget, testGlobalLimit) {
+  using namespace connection;
+  auto first = connection_new();
+  ASSERT_TRUE(!is_null(first));
+  auto second = connection_new();
+  ASSERT_TRUE(!is_null(second));
+  budget::set_global_limit(global_ + 2010);
+  auto stat = budget::stat();
+  ASSERT_TRUE(send(first, kPacketId, 2000));
+  ASSERT_EQ(budget::global_size(), global_ + first->output_size());
+  //Over the global, the droppable dropped and the under soft written.
+  ASSERT_TRUE(send(second, kDroppableId, 10));
+  ASSERT_EQ(budget::stat().dropped, stat.dropped + 1);
+  ASSERT_EQ(second->output_size(), static_cast<uint32_t>(0));
+  ASSERT_TRUE(send(second, kPacketId, 1000));
+  ASSERT_FALSE(second->output_overflow());
+  //The slow one over the soft limit disconnect.
+  ASSERT_FALSE(send(second, kPacketId, 100));
+  ASSERT_TRUE(second->output_overflow());
+  ASSERT_EQ(budget::stat().overflow_global, stat.overflow_global + 1);
+  ASSERT_FALSE(first->output_overflow());
+  auto size = first->output_size() + second->output_size();
+  ASSERT_EQ(budget::global_size(), global_ + size);
+  //The counter go back down when the connection removed.
+  manager_.remove(first);
+  ASSERT_EQ(budget::global_size(), global_ + size - 2000 - NET_PACKET_HEADERSIZE);
+  ASSERT_TRUE(run([&]() { return 0 == manager_.size(); }, 5000));
+  ASSERT_EQ(budget::global_size(), global_);
+}
@@ -0,0 +1,142 @@
+#include "gtest/gtest.h"
+#include "pf/net/socket/api.h"
+#include "pf/net/packet/dynamic.h"
+#include "pf/net/connection/budget.h"
+#include "pf/net/connection/manager/listener.h"
+#include "env.h"
+
+using namespace pf_net;
+
+//The coalescing timeout of manager.
+class CoalesceListener : public connection::manager::Listener {
+
+ public:
+   using connection::manager::Listener::coalesce_timeout;
+
+};
+
+class NetConnectionCoalesce : public testing::Test {
+
+ public:
+   virtual void SetUp() {
+     now_ = 1000000;
+     stream::Output::set_coalesce_clock(clock);
+     ASSERT_TRUE(manager_.init(16, 0, "127.0.0.1"));
+     manager_.set_wait_time(1);
+     ASSERT_TRUE(client_.create());
+     ASSERT_TRUE(client_.connect("127.0.0.1", manager_.port()));
+     socket::api::set_nonblocking_ex(client_.get_id(), true);
+     for (uint32_t i = 0; i < 1000 && 0 == manager_.size(); ++i)
+       manager_.tick();
+     ASSERT_EQ(manager_.size(), static_cast<uint32_t>(1));
+     connection_ = manager_.get(manager_.get_idset()[0]);
+     connection_->ostream().set_coalesce(kSize, kDelay);
+   }
+
+   virtual void TearDown() {
+     client_.close();
+     stream::Output::set_coalesce_clock(nullptr);
+     connection::budget::set_urgent(kUrgentId, false);
+   }
+
+ protected:
+   static const uint16_t kPacketId = 30001;
+   static const uint16_t kUrgentId = 30002;
+   static const uint32_t kSize = 1024;
+   static const uint32_t kDelay = 5000;
+
+ protected:
+   static uint64_t __stdcall clock() { return now_; }
+
+   bool send(uint16_t packet_id, uint32_t size) {
+     packet::Dynamic packet(packet_id);
+     std::string data(size, 'a');
+     packet.write(data.data(), size);
+     return connection_->send(&packet);
+   }
+
+   //The bytes the client received after the ticks.
+   size_t received(uint8_t ticks = 4) {
+     for (uint8_t i = 0; i < ticks; ++i) manager_.tick();
+     size_t result{0};
+     char buffer[4096];
+     for (uint32_t i = 0; i < 100; ++i) {
+       auto size = ::recv(client_.get_id(), buffer, sizeof(buffer), 0);
+       if (size > 0) {
+         result += size;
+       } else if (result > 0) {
+         break;
+       } else {
+         pf_basic::util::sleep(1);
+       }
+     }
+     return result;
+   }
+
+ protected:
+   static uint64_t now_;
+   CoalesceListener manager_;
+   socket::Basic client_;
+   connection::Basic *connection_;
+
+};
+
+uint64_t NetConnectionCoalesce::now_{0};
+
+TEST_F(NetConnectionCoalesce, testDeadline) {
+  auto size = NET_PACKET_HEADERSIZE + 10;
+  ASSERT_TRUE(send(kPacketId, 10));
+  //Held until the microseconds deadline.
+  ASSERT_EQ(received(), static_cast<size_t>(0));
+  ASSERT_EQ(connection_->ostream().size(), size);
+  ASSERT_EQ(manager_.coalesce_timeout(), kDelay / 1000);
+  now_ += 2500;
+  ASSERT_TRUE(send(kPacketId, 10));
+  ASSERT_EQ(received(), static_cast<size_t>(0));
+  //The deadline from the first byte, round up to milliseconds.
+  ASSERT_EQ(manager_.coalesce_timeout(), static_cast<uint32_t>(3));
+  now_ += 2499;
+  ASSERT_EQ(received(), static_cast<size_t>(0));
+  ASSERT_EQ(manager_.coalesce_timeout(), static_cast<uint32_t>(1));
+  now_ += 1;
+  ASSERT_EQ(received(), static_cast<size_t>(size * 2));
+  ASSERT_EQ(connection_->ostream().size(), static_cast<uint32_t>(0));
+  ASSERT_EQ(manager_.coalesce_timeout(), static_cast<uint32_t>(-1));
+  //The deadline start again from the next write.
+  now_ += 100000;
+  ASSERT_TRUE(send(kPacketId, 10));
+  ASSERT_EQ(received(), static_cast<size_t>(0));
+  now_ += kDelay;
+  ASSERT_EQ(received(), static_cast<size_t>(size));
+}
+
+TEST_F(NetConnectionCoalesce, testSize) {
+  auto size = NET_PACKET_HEADERSIZE + 100;
+  uint32_t count{0};
+  //The clock not move, the size threshold flush it.
+  while ((count + 1) * size < kSize) {
+    ASSERT_TRUE(send(kPacketId, 100));
+    ++count;
+  }
+  ASSERT_EQ(received(), static_cast<size_t>(0));
+  ASSERT_TRUE(send(kPacketId, 100));
+  ++count;
+  ASSERT_EQ(received(), static_cast<size_t>(size * count));
+  ASSERT_EQ(connection_->ostream().size(), static_cast<uint32_t>(0));
+}
+
+TEST_F(NetConnectionCoalesce, testUrgent) {
+  connection::budget::set_urgent(kUrgentId);
+  auto size = NET_PACKET_HEADERSIZE + 10;
+  ASSERT_TRUE(send(kPacketId, 10));
+  ASSERT_EQ(received(), static_cast<size_t>(0));
+  //The urgent skip the coalescing, the held before it flushed too.
+  ASSERT_TRUE(send(kUrgentId, 10));
+  ASSERT_EQ(received(), static_cast<size_t>(size * 2));
+  ASSERT_EQ(connection_->ostream().size(), static_cast<uint32_t>(0));
+  //The next coalesced again.
+  ASSERT_TRUE(send(kPacketId, 10));
+  ASSERT_EQ(received(), static_cast<size_t>(0));
+  connection_->flush();
+  ASSERT_EQ(received(), static_cast<size_t>(size));
+}
@@ -0,0 +1,285 @@
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "gtest/gtest.h"
+#include "pf/net/socket/api.h"
+#include "pf/net/packet/dynamic.h"
+#include "pf/net/packet/factorymanager.h"
+#include "pf/net/connection/executor.h"
+#include "pf/net/connection/manager/listener.h"
+#include "env.h"
+
+using namespace pf_net;
+
+class NetConnectionExecutor : public testing::Test {
+
+ public:
+   virtual void SetUp() {
+     //The factory manager created by the first manager.
+     ASSERT_TRUE(manager_.init(16, 0, "127.0.0.1"));
+     NET_PACKET_FACTORYMANAGER_POINTER->set_function_packet_execute(execute);
+     ASSERT_TRUE(executor_.init(4, 1024));
+     std::unique_lock<std::mutex> lock(mutex_);
+     packets_.clear();
+     sequences_.clear();
+     running_.clear();
+     errors_ = 0;
+     error_sequence_ = UINT32_MAX;
+     gate_ = true;
+     reply_ = false;
+   }
+
+   virtual void TearDown() {
+     executor_.detach(&manager_);
+     executor_.stop();
+     NET_PACKET_FACTORYMANAGER_POINTER->set_function_packet_execute(nullptr);
+   }
+
+ protected:
+   static const uint16_t kPacketId = 30001;
+
+ protected:
+   //The dynamic packet not rewind, keep the sequence by the pointer.
+   static packet::Interface *packet_new(uint32_t sequence) {
+     auto packet = NET_PACKET_FACTORYMANAGER_POINTER->packet_create(kPacketId);
+     std::unique_lock<std::mutex> lock(mutex_);
+     packets_[packet] = sequence;
+     return packet;
+   }
+
+   //Record the sequence of connection, check not run in two workers.
+   static uint32_t __stdcall execute(connection::Basic *connection,
+                                     packet::Interface *packet) {
+     uint32_t sequence{0};
+     auto id = connection->get_id();
+     {
+       std::unique_lock<std::mutex> lock(mutex_);
+       auto it = packets_.find(packet);
+       if (it != packets_.end()) {
+         sequence = it->second;
+       } else { //The decoded from the net.
+         auto dynamic = static_cast<packet::Dynamic *>(packet);
+         dynamic->set_readable(true);
+         dynamic->read(reinterpret_cast<char *>(&sequence), sizeof(sequence));
+       }
+       if (running_[id]) ++errors_;
+       running_[id] = true;
+       condition_.notify_all();
+       //Wait the gate opened(the cancel test).
+       condition_.wait(lock, []() { return gate_; });
+     }
+     if (reply_) {
+       //The proxy send in the net thread.
+       packet::Dynamic response(kPacketId);
+       response.write(reinterpret_cast<const char *>(&sequence),
+                      sizeof(sequence));
+       if (!connection->send(&response)) ++errors_;
+     }
+     std::this_thread::yield();
+     std::unique_lock<std::mutex> lock(mutex_);
+     running_[id] = false;
+     sequences_[id].push_back(sequence);
+     condition_.notify_all();
+     return sequence == error_sequence_ ?
+            kPacketExecuteStatusError : kPacketExecuteStatusContinue;
+   }
+
+   //The connection of the manager and id(not in pool).
+   std::unique_ptr<connection::Basic> connection_new(int32_t id) {
+     std::unique_ptr<connection::Basic> result{new connection::Basic()};
+     result->set_id(id);
+     result->set_manager(&manager_);
+     return result;
+   }
+
+   //Wait all posted executed or dropped.
+   bool drain(uint32_t timeout) {
+     auto deadline =
+       std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+     while (executor_.pending() > 0) {
+       if (std::chrono::steady_clock::now() > deadline) return false;
+       std::this_thread::sleep_for(std::chrono::milliseconds(1));
+     }
+     //The last handler may still running.
+     std::unique_lock<std::mutex> lock(mutex_);
+     return condition_.wait_for(lock,
+                                std::chrono::milliseconds(timeout),
+                                []() {
+       for (auto &it : running_) {
+         if (it.second) return false;
+       }
+       return true;
+     });
+   }
+
+ protected:
+   static std::mutex mutex_;
+   static std::condition_variable condition_;
+   static std::map<packet::Interface *, uint32_t> packets_;
+   static std::map< int32_t, std::vector<uint32_t> > sequences_;
+   static std::map<int32_t, bool> running_;
+   static uint32_t errors_;
+   static uint32_t error_sequence_;
+   static bool gate_;
+   static bool reply_;
+   connection::manager::Listener manager_;
+   connection::Executor executor_;
+
+};
+
+std::mutex NetConnectionExecutor::mutex_;
+std::condition_variable NetConnectionExecutor::condition_;
+std::map<packet::Interface *, uint32_t> NetConnectionExecutor::packets_;
+std::map< int32_t, std::vector<uint32_t> > NetConnectionExecutor::sequences_;
+std::map<int32_t, bool> NetConnectionExecutor::running_;
+uint32_t NetConnectionExecutor::errors_{0};
+uint32_t NetConnectionExecutor::error_sequence_{UINT32_MAX};
+bool NetConnectionExecutor::gate_{true};
+bool NetConnectionExecutor::reply_{false};
+
+TEST_F(NetConnectionExecutor, testStrandOrder) {
+  const int32_t connections = 16;
+  const uint32_t count = 2000;
+  std::vector< std::unique_ptr<connection::Basic> > list;
+  for (int32_t i = 0; i < connections; ++i) list.push_back(connection_new(i + 1));
+  //The connections interleaved, every connection in order.
+  for (uint32_t sequence = 0; sequence < count; ++sequence) {
+    for (auto &connection : list) {
+      ASSERT_TRUE(executor_.post(connection.get(), packet_new(sequence), nullptr));
+    }
+  }
+  ASSERT_TRUE(drain(10000));
+  ASSERT_EQ(executor_.executed(), static_cast<uint64_t>(connections * count));
+  std::unique_lock<std::mutex> lock(mutex_);
+  ASSERT_EQ(errors_, static_cast<uint32_t>(0));
+  for (int32_t i = 0; i < connections; ++i) {
+    auto &sequences = sequences_[i + 1];
+    ASSERT_EQ(sequences.size(), static_cast<size_t>(count));
+    for (uint32_t k = 0; k < count; ++k) ASSERT_EQ(sequences[k], k);
+  }
+}
+
+TEST_F(NetConnectionExecutor, testCancel) {
+  auto connection = connection_new(1);
+  auto other = connection_new(2);
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    gate_ = false;
+  }
+  for (uint32_t i = 0; i < 100; ++i)
+    ASSERT_TRUE(executor_.post(connection.get(), packet_new(i), nullptr));
+  //The first packet running, the others waiting.
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, []() { return running_[1]; });
+  }
+  executor_.cancel(&manager_, 1);
+  ASSERT_EQ(executor_.pending(), static_cast<uint64_t>(0));
+  //The posted after cancel dropped too(the running not finish).
+  ASSERT_TRUE(executor_.post(connection.get(), packet_new(100), nullptr));
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    gate_ = true;
+    condition_.notify_all();
+  }
+  ASSERT_TRUE(drain(10000));
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ASSERT_EQ(sequences_[1].size(), static_cast<size_t>(1));
+    ASSERT_EQ(sequences_[1][0], static_cast<uint32_t>(0));
+    gate_ = false;
+  }
+  //The detach drop all of the manager and wait the running one.
+  for (uint32_t i = 0; i < 10; ++i)
+    ASSERT_TRUE(executor_.post(other.get(), packet_new(i), nullptr));
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, []() { return running_[2]; });
+  }
+  std::thread opener([]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::unique_lock<std::mutex> lock(mutex_);
+    gate_ = true;
+    condition_.notify_all();
+  });
+  executor_.detach(&manager_);
+  opener.join();
+  ASSERT_EQ(executor_.pending(), static_cast<uint64_t>(0));
+  std::unique_lock<std::mutex> lock(mutex_);
+  ASSERT_FALSE(running_[2]);
+  ASSERT_EQ(sequences_[2].size(), static_cast<size_t>(1));
+  ASSERT_EQ(errors_, static_cast<uint32_t>(0));
+}
+
+TEST_F(NetConnectionExecutor, testErrorClose) {
+  auto connection = connection_new(1);
+  error_sequence_ = 5;
+  for (uint32_t i = 0; i < 50; ++i)
+    ASSERT_TRUE(executor_.post(connection.get(), packet_new(i), nullptr));
+  ASSERT_TRUE(drain(10000));
+  //The posted before the remove dropped too.
+  ASSERT_TRUE(executor_.post(connection.get(), packet_new(50), nullptr));
+  ASSERT_TRUE(drain(10000));
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ASSERT_EQ(sequences_[1].size(), static_cast<size_t>(6));
+    ASSERT_EQ(sequences_[1].back(), static_cast<uint32_t>(5));
+  }
+  ASSERT_EQ(executor_.pending(), static_cast<uint64_t>(0));
+  //The id reused after the remove(cancel).
+  executor_.cancel(&manager_, 1);
+  error_sequence_ = UINT32_MAX;
+  ASSERT_TRUE(executor_.post(connection.get(), packet_new(51), nullptr));
+  ASSERT_TRUE(drain(10000));
+  std::unique_lock<std::mutex> lock(mutex_);
+  ASSERT_EQ(sequences_[1].size(), static_cast<size_t>(7));
+  ASSERT_EQ(sequences_[1].back(), static_cast<uint32_t>(51));
+}
+
+TEST_F(NetConnectionExecutor, testProxySend) {
+  manager_.set_executor(&executor_);
+  reply_ = true;
+  socket::Basic client;
+  ASSERT_TRUE(client.create());
+  ASSERT_TRUE(client.connect("127.0.0.1", manager_.port()));
+  const uint32_t count = 100;
+  std::string data{""};
+  std::string frame{""};
+  for (uint32_t i = 0; i < count; ++i) {
+    packet::Dynamic packet(kPacketId);
+    packet.write(reinterpret_cast<const char *>(&i), sizeof(i));
+    frame.clear();
+    ASSERT_TRUE(manager_.protocol()->encode(&packet, frame));
+    data += frame;
+  }
+  ASSERT_EQ(::send(client.get_id(), data.data(), data.size(), 0),
+            static_cast<ssize_t>(data.size()));
+  //The replies in order, written by the net thread.
+  std::string received{""};
+  socket::api::set_nonblocking_ex(client.get_id(), true);
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (received.size() < data.size() &&
+         std::chrono::steady_clock::now() < deadline) {
+    manager_.tick();
+    char buffer[4096];
+    auto result = ::recv(client.get_id(), buffer, sizeof(buffer), 0);
+    if (result > 0) received.append(buffer, result);
+  }
+  //The header index of every frame counted by the sender.
+  ASSERT_EQ(received.size(), data.size());
+  auto header = frame.size() - sizeof(uint32_t);
+  for (uint32_t i = 0; i < count; ++i) {
+    uint32_t sequence{0};
+    memcpy(&sequence, received.data() + i * frame.size() + header,
+           sizeof(sequence));
+    ASSERT_EQ(sequence, i);
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  ASSERT_EQ(errors_, static_cast<uint32_t>(0));
+  ASSERT_EQ(sequences_.size(), static_cast<size_t>(1));
+  lock.unlock();
+  client.close();
+  manager_.set_executor(nullptr);
+}
@@ -0,0 +1,89 @@
+#include <chrono>
+#include <functional>
+#include "gtest/gtest.h"
+#include "pf/net/socket/api.h"
+#include "pf/net/connection/manager/listener.h"
+#include "env.h"
+
+using namespace pf_net;
+
+class NetConnectionListener : public testing::Test {
+
+ protected:
+   //Tick the managers until the condition or timeout(milliseconds).
+   bool run(std::vector<connection::manager::Listener *> managers,
+            std::function<bool ()> condition,
+            uint32_t timeout) {
+     auto deadline =
+       std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+     while (!condition()) {
+       if (std::chrono::steady_clock::now() > deadline) return false;
+       for (auto manager : managers) manager->tick();
+     }
+     return true;
+   }
+
+};
+
+TEST_F(NetConnectionListener, testForward) {
+  using namespace connection::manager;
+  int32_t front_id{SOCKET_INVALID};
+  int32_t worker_id{SOCKET_INVALID};
+  ASSERT_TRUE(Listener::forward_channel(front_id, worker_id));
+  Listener front;
+  ASSERT_TRUE(front.init(16, 0, "127.0.0.1"));
+  ASSERT_TRUE(front.forward_add(front_id));
+  ASSERT_EQ(front.forward_size(), static_cast<size_t>(1));
+  Listener worker;
+  ASSERT_TRUE(worker.init_forward(16, worker_id));
+  ASSERT_TRUE(worker.is_forward());
+  ASSERT_EQ(worker.listener_socket_id(), worker_id);
+  //The socket accepted by front attached in the worker.
+  socket::Basic client;
+  ASSERT_TRUE(client.create());
+  ASSERT_TRUE(client.connect("127.0.0.1", front.port()));
+  ASSERT_TRUE(run({&front, &worker},
+                  [&]() { return worker.size() == 1; },
+                  5000));
+  ASSERT_EQ(front.size(), static_cast<uint32_t>(0));
+  ASSERT_EQ(front.accept_stat().forwarded, static_cast<uint64_t>(1));
+  auto connection = worker.get(worker.get_idset()[0]);
+  ASSERT_TRUE(!is_null(connection));
+  ASSERT_STREQ(connection->socket()->host(), "127.0.0.1");
+  //The same socket of the client.
+  struct sockaddr_in local;
+  struct sockaddr_in peer;
+  socklen_t length = sizeof(local);
+  ASSERT_EQ(getsockname(
+        client.get_id(), reinterpret_cast<struct sockaddr *>(&local), &length),
+      0);
+  length = sizeof(peer);
+  ASSERT_EQ(getpeername(connection->socket()->get_id(),
+                        reinterpret_cast<struct sockaddr *>(&peer),
+                        &length),
+            0);
+  ASSERT_EQ(local.sin_port, peer.sin_port);
+  ASSERT_EQ(connection->socket()->port(), ntohs(local.sin_port));
+  //The worker serve it, the client see the close.
+  worker.remove(connection);
+  char buffer[8];
+  ASSERT_LE(::recv(client.get_id(), buffer, sizeof(buffer), 0), 0);
+  client.close();
+  //The front closed, the worker stop watch the channel.
+  socket::api::closeex(front_id);
+  for (uint8_t i = 0; i < 4; ++i) worker.tick();
+  ASSERT_EQ(worker.size(), static_cast<uint32_t>(0));
+  socket::api::closeex(worker_id);
+}
+
+TEST_F(NetConnectionListener, testForwardAddStream) {
+  int32_t socketids[2];
+  ASSERT_TRUE(socket::api::socketpair_ex(SOCK_STREAM, socketids));
+  connection::manager::Listener front;
+  ASSERT_TRUE(front.init(16, 0, "127.0.0.1"));
+  //The stream not keep the message boundaries.
+  ASSERT_FALSE(front.forward_add(socketids[0]));
+  ASSERT_EQ(front.forward_size(), static_cast<size_t>(0));
+  socket::api::closeex(socketids[0]);
+  socket::api::closeex(socketids[1]);
+}
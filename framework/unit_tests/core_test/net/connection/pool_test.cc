@@ -0,0 +1,118 @@
+#include "gtest/gtest.h"
+#include "pf/net/connection/pool.h"
+#include "env.h"
+
+using namespace pf_net;
+
+class NetConnectionPool : public testing::Test {
+
+ public:
+   virtual void SetUp() {
+     constructed_ = 0;
+     pool_.set_constructor([this]() {
+       ++constructed_;
+       return new connection::Basic();
+     });
+     ASSERT_TRUE(pool_.init(kMaxSize));
+   }
+
+ protected:
+   static const uint32_t kMaxSize = 8;
+
+ protected:
+   connection::Pool pool_;
+   uint32_t constructed_;
+
+};
+
+TEST_F(NetConnectionPool, testGeneration) {
+  auto connection = pool_.create();
+  ASSERT_TRUE(!is_null(connection));
+  auto id = connection->get_id();
+  ASSERT_EQ(NET_CONNECTION_ID_GENERATION(id), static_cast<uint32_t>(0));
+  ASSERT_EQ(pool_.get(id), connection);
+  //The old handle not get the connection after the slot recycled.
+  pool_.remove(id);
+  ASSERT_TRUE(is_null(pool_.get(id)));
+  auto again = pool_.create();
+  ASSERT_EQ(again, connection);
+  auto again_id = again->get_id();
+  ASSERT_NE(again_id, id);
+  ASSERT_EQ(NET_CONNECTION_ID_INDEX(again_id), NET_CONNECTION_ID_INDEX(id));
+  ASSERT_EQ(NET_CONNECTION_ID_GENERATION(again_id), static_cast<uint32_t>(1));
+  ASSERT_TRUE(is_null(pool_.get(id)));
+  ASSERT_EQ(pool_.get(again_id), again);
+  //The invalid handles.
+  ASSERT_TRUE(is_null(pool_.get(ID_INVALID)));
+  ASSERT_TRUE(is_null(pool_.get(NET_CONNECTION_ID(kMaxSize, 0))));
+  ASSERT_TRUE(is_null(pool_.get(NET_CONNECTION_ID(kMaxSize - 1, 0))));
+}
+
+TEST_F(NetConnectionPool, testGenerationWrap) {
+  auto connection = pool_.create();
+  ASSERT_TRUE(!is_null(connection));
+  auto first = connection->get_id();
+  //The handle keep positive, the generation wrap by the mask.
+  for (uint32_t i = 0; i < NET_CONNECTION_GENERATION_MASK; ++i) {
+    auto id = connection->get_id();
+    pool_.remove(id);
+    connection = pool_.create();
+    ASSERT_TRUE(!is_null(connection));
+    ASSERT_GE(connection->get_id(), 0);
+    ASSERT_NE(connection->get_id(), id);
+    ASSERT_TRUE(is_null(pool_.get(id)));
+  }
+  ASSERT_EQ(NET_CONNECTION_ID_GENERATION(connection->get_id()),
+            static_cast<uint32_t>(NET_CONNECTION_GENERATION_MASK));
+  pool_.remove(connection->get_id());
+  connection = pool_.create();
+  ASSERT_EQ(connection->get_id(), first);
+}
+
+TEST_F(NetConnectionPool, testLazyConstruct) {
+  ASSERT_EQ(constructed_, static_cast<uint32_t>(0));
+  auto first = pool_.create();
+  auto second = pool_.create();
+  ASSERT_TRUE(!is_null(first) && !is_null(second));
+  ASSERT_EQ(constructed_, static_cast<uint32_t>(2));
+  ASSERT_EQ(pool_.size(), kMaxSize - 2);
+  //Construct all at once, the used not constructed again.
+  ASSERT_TRUE(pool_.create_default_connections());
+  ASSERT_EQ(constructed_, static_cast<uint32_t>(kMaxSize));
+  ASSERT_EQ(pool_.get(first->get_id()), first);
+  ASSERT_EQ(pool_.get(second->get_id()), second);
+}
+
+TEST_F(NetConnectionPool, testFreeListReuse) {
+  std::vector<connection::Basic *> connections;
+  for (uint32_t i = 0; i < kMaxSize; ++i) {
+    auto connection = pool_.create();
+    ASSERT_TRUE(!is_null(connection));
+    connections.push_back(connection);
+  }
+  ASSERT_EQ(constructed_, static_cast<uint32_t>(kMaxSize));
+  ASSERT_EQ(pool_.size(), static_cast<uint32_t>(0));
+  ASSERT_TRUE(is_null(pool_.create()));
+  //The last removed create first, not construct the new.
+  pool_.remove(connections[2]->get_id());
+  pool_.remove(connections[5]->get_id());
+  pool_.remove(connections[0]->get_id());
+  ASSERT_EQ(pool_.size(), static_cast<uint32_t>(3));
+  ASSERT_EQ(pool_.create(), connections[0]);
+  ASSERT_EQ(pool_.create(), connections[5]);
+  ASSERT_EQ(pool_.create(), connections[2]);
+  ASSERT_TRUE(is_null(pool_.create()));
+  ASSERT_EQ(constructed_, static_cast<uint32_t>(kMaxSize));
+  ASSERT_EQ(pool_.size(), static_cast<uint32_t>(0));
+  //The free slot used before the next not constructed.
+  connection::Pool pool;
+  ASSERT_TRUE(pool.init(kMaxSize));
+  auto connection = pool.create();
+  ASSERT_TRUE(!is_null(connection));
+  auto index = NET_CONNECTION_ID_INDEX(connection->get_id());
+  pool.remove(connection->get_id());
+  connection = pool.create();
+  ASSERT_EQ(NET_CONNECTION_ID_INDEX(connection->get_id()), index);
+  connection = pool.create();
+  ASSERT_EQ(NET_CONNECTION_ID_INDEX(connection->get_id()), index + 1);
+}
@@ -0,0 +1,65 @@
+#include "gtest/gtest.h"
+#include "pf/net/connection/manager/listener.h"
+#include "env.h"
+
+using namespace pf_net;
+
+//The packet count the alive instances(the normal id not registered, removed
+//by delete).
+class CountPacket : public packet::Interface {
+
+ public:
+   CountPacket() { ++alive_; }
+   virtual ~CountPacket() { --alive_; }
+
+ public:
+   virtual bool read(stream::Input &) { return true; }
+   virtual bool write(stream::Output &) { return true; }
+   virtual uint32_t execute(connection::Basic *) {
+     ++executed_;
+     return kPacketExecuteStatusContinue;
+   }
+   virtual uint16_t get_id() const { return 19999; }
+   virtual uint32_t size() const { return 0; }
+
+ public:
+   static int32_t alive_;
+   static int32_t executed_;
+
+};
+
+int32_t CountPacket::alive_{0};
+int32_t CountPacket::executed_{0};
+
+class NetConnectionQueue : public testing::Test {
+
+ public:
+   virtual void SetUp() {
+     CountPacket::alive_ = 0;
+     CountPacket::executed_ = 0;
+     ASSERT_TRUE(manager_.init(4, 0, "127.0.0.1"));
+   }
+
+ protected:
+   connection::manager::Listener manager_;
+
+};
+
+TEST_F(NetConnectionQueue, testSendFull) {
+  auto capacity = static_cast<int32_t>(manager_.cache_capacity());
+  for (int32_t i = 0; i < capacity; ++i)
+    ASSERT_TRUE(manager_.send(new CountPacket(), ID_INVALID));
+  ASSERT_TRUE(manager_.cache_pressure());
+  //The manager own the packet, the full queue drop it.
+  ASSERT_FALSE(manager_.send(new CountPacket(), ID_INVALID));
+  ASSERT_EQ(CountPacket::alive_, capacity);
+  ASSERT_EQ(manager_.cache_full_count(), static_cast<uint64_t>(1));
+  //The queued executed and removed in the tick.
+  manager_.tick();
+  ASSERT_EQ(CountPacket::executed_, capacity);
+  ASSERT_EQ(CountPacket::alive_, 0);
+  ASSERT_EQ(manager_.cache_size(), static_cast<size_t>(0));
+  ASSERT_TRUE(manager_.send(new CountPacket(), ID_INVALID));
+  manager_.tick();
+  ASSERT_EQ(CountPacket::alive_, 0);
+}
@@ -0,0 +1,155 @@
+#include <chrono>
+#include <functional>
+#include <poll.h>
+#include <unistd.h>
+#include "gtest/gtest.h"
+#include "pf/net/packet/dynamic.h"
+#include "pf/net/packet/factorymanager.h"
+#include "pf/net/connection/manager/share.h"
+#include "env.h"
+
+using namespace pf_net;
+
+class NetConnectionShare : public testing::Test {
+
+ public:
+   virtual void SetUp() {
+     key_ = 0x6e00 + static_cast<uint32_t>(getpid() % 4096);
+     ASSERT_TRUE(service_.init(4));
+     ASSERT_TRUE(client_.init(4));
+     service_.set_wait_time(0);
+     client_.set_wait_time(0);
+     NET_PACKET_FACTORYMANAGER_POINTER->set_function_packet_execute(execute);
+     received_.clear();
+   }
+
+   virtual void TearDown() {
+     NET_PACKET_FACTORYMANAGER_POINTER->set_function_packet_execute(nullptr);
+   }
+
+ protected:
+   static const uint16_t kPacketId = 30001;
+
+ protected:
+   static uint32_t __stdcall execute(connection::Basic *,
+                                     packet::Interface *packet) {
+     std::string data(packet->size(), '\0');
+     auto dynamic = static_cast<packet::Dynamic *>(packet);
+     dynamic->set_readable(true);
+     if (!data.empty()) dynamic->read(&data[0], packet->size());
+     received_.push_back(data);
+     return kPacketExecuteStatusContinue;
+   }
+
+   //The payload of sequence, the size changed to cross the ring end.
+   static std::string payload(uint32_t sequence) {
+     std::string result(2 + (sequence * 37) % 200, '\0');
+     for (size_t i = 0; i < result.size(); ++i)
+       result[i] = static_cast<char>(sequence + i);
+     return result;
+   }
+
+   static bool send(connection::Basic *connection, const std::string &data) {
+     packet::Dynamic packet(kPacketId);
+     packet.write(data.data(), static_cast<uint32_t>(data.size()));
+     return connection->send(&packet);
+   }
+
+   //Tick the managers until the condition or timeout(milliseconds).
+   bool run(std::function<bool ()> condition, uint32_t timeout) {
+     auto deadline =
+       std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+     while (!condition()) {
+       if (std::chrono::steady_clock::now() > deadline) return false;
+       client_.tick();
+       service_.tick();
+     }
+     return true;
+   }
+
+   //The doorbell readable now.
+   static bool rang(connection::Share *connection) {
+     struct pollfd fd{connection->doorbell(), POLLIN, 0};
+     return 1 == ::poll(&fd, 1, 0);
+   }
+
+ protected:
+   static std::vector<std::string> received_;
+   uint32_t key_;
+   connection::manager::Share service_;
+   connection::manager::Share client_;
+
+};
+
+std::vector<std::string> NetConnectionShare::received_;
+
+TEST_F(NetConnectionShare, testRingWrap) {
+  auto service = service_.open(key_, 256);
+  ASSERT_TRUE(!is_null(service));
+  auto client = client_.attach(key_, 256);
+  ASSERT_TRUE(!is_null(client));
+  //The bytes of all packets many times of the ring.
+  const uint32_t count = 500;
+  uint32_t sent = 0;
+  ASSERT_TRUE(run([&]() {
+    while (sent < count && client->ostream().size() < 1024)
+      if (!send(client, payload(sent++))) return true;
+    return received_.size() == count;
+  }, 10000));
+  ASSERT_EQ(received_.size(), static_cast<size_t>(count));
+  for (uint32_t i = 0; i < count; ++i) ASSERT_EQ(received_[i], payload(i));
+}
+
+TEST_F(NetConnectionShare, testRingFull) {
+  auto service = static_cast<connection::Share *>(service_.open(key_, 256));
+  ASSERT_TRUE(!is_null(service));
+  auto client = static_cast<connection::Share *>(client_.attach(key_, 256));
+  ASSERT_TRUE(!is_null(client));
+  ASSERT_TRUE(run([&]() { return 0 == service_.ready_size(); }, 5000));
+  //The service not read, the left bytes keep in the output stream.
+  const uint32_t count = 20;
+  for (uint32_t i = 0; i < count; ++i) ASSERT_TRUE(send(client, payload(i)));
+  for (uint8_t i = 0; i < 4; ++i) client_.tick();
+  ASSERT_GT(client->ostream().size(), static_cast<uint32_t>(0));
+  ASSERT_FALSE(client->output_writable());
+  ASSERT_TRUE(rang(service));
+  //The client sleep and the service read ring the client after it.
+  ASSERT_EQ(client_.ready_size(), static_cast<size_t>(0));
+  service_.tick();
+  ASSERT_FALSE(received_.empty());
+  ASSERT_TRUE(rang(client));
+  ASSERT_TRUE(run([&]() { return received_.size() == count; }, 5000));
+  ASSERT_EQ(client->ostream().size(), static_cast<uint32_t>(0));
+  for (uint32_t i = 0; i < count; ++i) ASSERT_EQ(received_[i], payload(i));
+}
+
+TEST_F(NetConnectionShare, testSleepWake) {
+  auto service = static_cast<connection::Share *>(service_.open(key_, 256));
+  ASSERT_TRUE(!is_null(service));
+  auto client = static_cast<connection::Share *>(client_.attach(key_, 256));
+  ASSERT_TRUE(!is_null(client));
+  //The attach rang the service.
+  ASSERT_TRUE(run([&]() {
+    return 0 == service_.ready_size() && 0 == client_.ready_size();
+  }, 5000));
+  ASSERT_FALSE(rang(service));
+  //The sleeping reader rang once by the writer.
+  ASSERT_TRUE(send(client, payload(1)));
+  client_.tick();
+  ASSERT_TRUE(rang(service));
+  ASSERT_FALSE(service->sleep());
+  ASSERT_TRUE(send(client, payload(2)));
+  client_.tick();
+  //The select wait the doorbell and poll the service in the tick.
+  service_.set_wait_time(1000);
+  auto start = std::chrono::steady_clock::now();
+  service_.tick();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  ASSERT_LT(elapsed, std::chrono::milliseconds(500));
+  ASSERT_EQ(received_.size(), static_cast<size_t>(2));
+  ASSERT_FALSE(rang(service));
+  //The peer closed, the doorbell wake the service and remove it.
+  client_.remove(client);
+  ASSERT_TRUE(rang(service));
+  ASSERT_TRUE(run([&]() { return 0 == service_.size(); }, 5000));
+}
@@ -0,0 +1,351 @@
+#include <chrono>
+#include <thread>
+#include "gtest/gtest.h"
+#include "pf/net/socket/api.h"
+#include "pf/net/packet/dynamic.h"
+#include "pf/net/packet/factorymanager.h"
+#include "pf/net/connection/manager/udp.h"
+#include "env.h"
+
+using namespace pf_net;
+
+class NetConnectionUdp : public testing::Test {
+
+ public:
+   virtual void SetUp() {
+     received_ = 0;
+     errors_ = 0;
+     //The factory manager created by the first manager.
+     ASSERT_TRUE(server_.init(16, 0, "127.0.0.1"));
+     NET_PACKET_FACTORYMANAGER_POINTER->set_function_packet_execute(execute);
+     server_.set_wait_time(2);
+   }
+
+   virtual void TearDown() {
+     NET_PACKET_FACTORYMANAGER_POINTER->set_function_packet_execute(nullptr);
+   }
+
+ protected:
+   static const uint16_t kPacketId = 30000;
+
+ protected:
+   //The payload of sequence, the size cover the fragments.
+   static std::string payload(uint32_t sequence) {
+     std::string result(4 + (sequence * 7919) % 5000, '\0');
+     memcpy(&result[0], &sequence, sizeof(sequence));
+     for (size_t i = 4; i < result.size(); ++i)
+       result[i] = static_cast<char>(sequence * 31 + i);
+     return result;
+   }
+
+   //Check the payloads arrive in order and whole.
+   static uint32_t __stdcall execute(connection::Basic *,
+                                     packet::Interface *packet) {
+     auto dynamic = static_cast<packet::Dynamic *>(packet);
+     std::string data(packet->size(), '\0');
+     dynamic->set_readable(true);
+     dynamic->read(&data[0], packet->size());
+     if (data != payload(received_)) ++errors_;
+     ++received_;
+     return kPacketExecuteStatusContinue;
+   }
+
+   //Tick the managers until the condition or timeout(milliseconds).
+   bool run(std::vector<connection::manager::Udp *> managers,
+            std::function<bool ()> condition,
+            uint32_t timeout) {
+     auto deadline = 
+       std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+     while (!condition()) {
+       if (std::chrono::steady_clock::now() > deadline) return false;
+       for (auto manager : managers) manager->tick();
+     }
+     return true;
+   }
+
+   //Connect the server by the client.
+   connection::Basic *connect(connection::manager::Udp &client) {
+     connection::Basic *result{nullptr};
+     bool finished{false};
+     client.connect_async("127.0.0.1", 
+                          server_.port(), 
+                          [&](connection::Basic *connection) {
+       result = connection;
+       finished = true;
+     });
+     run({&client, &server_}, [&]() { return finished; }, 5000);
+     return result;
+   }
+
+   //The session of the only server connection.
+   uint32_t server_session() {
+     if (server_.size() != 1) return 0;
+     auto connection = server_.get(server_.get_idset()[0]);
+     if (is_null(connection)) return 0;
+     return static_cast<connection::Udp *>(connection)->session();
+   }
+
+ protected:
+   static uint32_t received_;
+   static uint32_t errors_;
+   connection::manager::Udp server_;
+
+};
+
+uint32_t NetConnectionUdp::received_{0};
+uint32_t NetConnectionUdp::errors_{0};
+
+TEST_F(NetConnectionUdp, testReliableWithLoss) {
+  connection::manager::Udp client;
+  ASSERT_TRUE(client.init(4, 0, "127.0.0.1", false));
+  client.set_wait_time(2);
+  server_.set_simulate(20, 2, 5);
+  client.set_simulate(20, 2, 5);
+  auto connection = connect(client);
+  ASSERT_TRUE(!is_null(connection));
+  const uint32_t count = 600;
+  uint32_t sent{0};
+  auto done = run({&client, &server_}, [&]() {
+    for (uint32_t i = 0; i < 20 && sent < count; ++i, ++sent) {
+      auto data = payload(sent);
+      packet::Dynamic packet(kPacketId);
+      packet.write(data.data(), static_cast<uint32_t>(data.size()));
+      if (!connection->send(&packet)) ++errors_;
+    }
+    return received_ >= count;
+  }, 60000);
+  ASSERT_TRUE(done) << "received: " << received_;
+  ASSERT_EQ(received_, count);
+  ASSERT_EQ(errors_, static_cast<uint32_t>(0));
+  ASSERT_GT(client.udp_stat().simulate_lost, static_cast<uint64_t>(0));
+  ASSERT_GT(static_cast<connection::Udp *>(connection)->retransmits(),
+            static_cast<uint64_t>(0));
+}
+
+TEST_F(NetConnectionUdp, testReplacePeerByCookie) {
+  uint16_t port{0};
+  uint32_t session{0};
+  {
+    connection::manager::Udp client;
+    ASSERT_TRUE(client.init(4, 0, "127.0.0.1", false));
+    client.set_wait_time(2);
+    ASSERT_TRUE(!is_null(connect(client)));
+    ASSERT_TRUE(run({&client, &server_}, 
+                    [&]() { return server_.size() == 1; }, 
+                    5000));
+    port = client.port();
+    session = server_session();
+    //The new session challenged once.
+    ASSERT_EQ(server_.udp_stat().challenged, static_cast<uint64_t>(1));
+    //Gone without the close.
+    client.set_simulate(100);
+  }
+  //The connect of the new session from the same address.
+  socket::Basic socket;
+  socket.set_id(socket::api::socketex(AF_INET, SOCK_DGRAM, 0));
+  ASSERT_TRUE(socket.bind(port, "127.0.0.1"));
+  struct sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(server_.port());
+  address.sin_addr.s_addr = inet_addr("127.0.0.1");
+  auto connect_send = [&](uint32_t new_session, uint32_t cookie) {
+    char datagram[9];
+    memcpy(datagram, &new_session, 4);
+    datagram[4] = 1;
+    memcpy(datagram + 5, &cookie, 4);
+    ASSERT_TRUE(connection::Udp::connecting(datagram, sizeof(datagram)));
+    socket::api::sendto_ex(socket.get_id(), 
+                           datagram, 
+                           sizeof(datagram), 
+                           0,
+                           reinterpret_cast<struct sockaddr *>(&address),
+                           sizeof(address));
+  };
+  //Not replaced without the cookie or the wrong one.
+  uint32_t new_session = session + 1;
+  connect_send(new_session, 0);
+  ASSERT_TRUE(run({&server_}, 
+                  [&]() { return 2 == server_.udp_stat().challenged; }, 
+                  5000));
+  connect_send(new_session, 12345);
+  ASSERT_TRUE(run({&server_}, 
+                  [&]() { return 3 == server_.udp_stat().challenged; }, 
+                  5000));
+  ASSERT_EQ(server_session(), session);
+  //The owner of the address received the challenge, echo it.
+  char buffer[NET_UDP_MTU];
+  uint32_t cookie{0};
+  ASSERT_TRUE(socket.set_nonblocking());
+  ASSERT_TRUE(run({&server_}, [&]() {
+    auto result = socket::api::recvfrom_ex(
+        socket.get_id(), buffer, sizeof(buffer), 0, nullptr, nullptr);
+    if (result <= 0) return false;
+    auto size = static_cast<uint32_t>(result);
+    if (!connection::Udp::challenging(buffer, size) ||
+        connection::Udp::session(buffer, size) != new_session) return false;
+    cookie = connection::Udp::cookie(buffer, size);
+    return true;
+  }, 5000));
+  ASSERT_NE(cookie, static_cast<uint32_t>(0));
+  connect_send(new_session, cookie);
+  ASSERT_TRUE(run({&server_}, 
+                  [&]() { return server_session() == new_session; }, 
+                  5000));
+  socket.close();
+  //The client restarted in the same address connect by the challenge.
+  connection::manager::Udp client;
+  ASSERT_TRUE(client.init(4, port, "127.0.0.1", false));
+  client.set_wait_time(2);
+  ASSERT_TRUE(!is_null(connect(client)));
+  ASSERT_TRUE(run({&client, &server_}, [&]() { 
+    return server_session() != new_session && server_session() != 0;
+  }, 5000));
+  ASSERT_EQ(server_.size(), static_cast<uint32_t>(1));
+  ASSERT_EQ(server_.udp_stat().challenged, static_cast<uint64_t>(4));
+}
+
+TEST_F(NetConnectionUdp, testNewSessionByCookie) {
+  struct sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(server_.port());
+  address.sin_addr.s_addr = inet_addr("127.0.0.1");
+  //The sources never echo the cookie(the spoofed addresses).
+  const uint32_t count = 32;
+  std::vector<std::unique_ptr<socket::Basic>> sockets;
+  for (uint32_t i = 0; i < count; ++i) {
+    std::unique_ptr<socket::Basic> socket{new socket::Basic()};
+    socket->set_id(socket::api::socketex(AF_INET, SOCK_DGRAM, 0));
+    ASSERT_TRUE(socket->bind(0, "127.0.0.1"));
+    ASSERT_TRUE(socket->set_nonblocking());
+    uint32_t session = i + 1;
+    uint32_t cookie = i * 7;
+    char datagram[9];
+    memcpy(datagram, &session, 4);
+    datagram[4] = 1;
+    memcpy(datagram + 5, &cookie, 4);
+    //The half is short(no cookie field).
+    uint32_t size = i % 2 ? sizeof(datagram) : 5;
+    socket::api::sendto_ex(socket->get_id(),
+                           datagram,
+                           size,
+                           0,
+                           reinterpret_cast<struct sockaddr *>(&address),
+                           sizeof(address));
+    sockets.emplace_back(std::move(socket));
+  }
+  ASSERT_TRUE(run({&server_},
+                  [&]() { return count == server_.udp_stat().challenged; },
+                  5000));
+  ASSERT_EQ(server_.size(), static_cast<uint32_t>(0));
+  //Only the full connects challenged back, and not larger than them.
+  char buffer[NET_UDP_MTU];
+  for (uint32_t i = 0; i < count; ++i) {
+    auto result = socket::api::recvfrom_ex(
+        sockets[i]->get_id(), buffer, sizeof(buffer), 0, nullptr, nullptr);
+    if (0 == i % 2) {
+      ASSERT_LT(result, 0);
+      continue;
+    }
+    ASSERT_EQ(result, 9);
+    ASSERT_TRUE(connection::Udp::challenging(buffer, 9));
+    ASSERT_NE(connection::Udp::cookie(buffer, 9), i * 7);
+  }
+  for (auto &socket : sockets) socket->close();
+  //The client echo the cookie.
+  connection::manager::Udp client;
+  ASSERT_TRUE(client.init(4, 0, "127.0.0.1", false));
+  client.set_wait_time(2);
+  ASSERT_TRUE(!is_null(connect(client)));
+  ASSERT_TRUE(run({&client, &server_},
+                  [&]() { return server_.size() == 1; },
+                  5000));
+  ASSERT_EQ(server_.udp_stat().challenged, static_cast<uint64_t>(count + 1));
+}
+
+TEST_F(NetConnectionUdp, testReassemblyLimit) {
+  socket::Basic socket;
+  socket.set_id(socket::api::socketex(AF_INET, SOCK_DGRAM, 0));
+  ASSERT_TRUE(socket.bind(0, "127.0.0.1"));
+  ASSERT_TRUE(socket.set_nonblocking());
+  struct sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(server_.port());
+  address.sin_addr.s_addr = inet_addr("127.0.0.1");
+  auto datagram_send = [&](const char *data, uint32_t size) {
+    socket::api::sendto_ex(socket.get_id(),
+                           data,
+                           size,
+                           0,
+                           reinterpret_cast<struct sockaddr *>(&address),
+                           sizeof(address));
+  };
+  //Connect by the cookie of challenge.
+  uint32_t session{1234};
+  char datagram[NET_UDP_MTU];
+  auto connect_send = [&](uint32_t cookie) {
+    memcpy(datagram, &session, 4);
+    datagram[4] = 1;
+    memcpy(datagram + 5, &cookie, 4);
+    datagram_send(datagram, 9);
+  };
+  connect_send(0);
+  uint32_t cookie{0};
+  ASSERT_TRUE(run({&server_}, [&]() {
+    auto result = socket::api::recvfrom_ex(
+        socket.get_id(), datagram, sizeof(datagram), 0, nullptr, nullptr);
+    if (result <= 0) return false;
+    cookie = connection::Udp::cookie(datagram, static_cast<uint32_t>(result));
+    return true;
+  }, 5000));
+  connect_send(cookie);
+  ASSERT_TRUE(run({&server_}, [&]() { return server_.size() == 1; }, 5000));
+  auto connection = static_cast<connection::Udp *>(
+      server_.get(server_.get_idset()[0]));
+  ASSERT_TRUE(!is_null(connection));
+  //The unreliable data frame.
+  const uint16_t length{1300};
+  auto data_send = [&](uint32_t message, uint16_t fragment, uint16_t count) {
+    char *pointer = datagram;
+    memcpy(pointer, &session, 4); pointer += 4;
+    *pointer++ = 6;
+    *pointer++ = static_cast<char>(connection::kUdpChannelUnreliable);
+    uint32_t sequence{0};
+    memcpy(pointer, &sequence, 4); pointer += 4;
+    memcpy(pointer, &message, 4); pointer += 4;
+    memcpy(pointer, &fragment, 2); pointer += 2;
+    memcpy(pointer, &count, 2); pointer += 2;
+    memcpy(pointer, &length, 2); pointer += 2;
+    memset(pointer, 'x', length);
+    datagram_send(datagram, static_cast<uint32_t>(pointer - datagram) + length);
+  };
+  //Too many fragments dropped.
+  auto received = server_.udp_stat().received;
+  data_send(0, 0, NET_UDP_FRAGMENTS_MAX + 1);
+  data_send(0, 1, 0xffff);
+  ASSERT_TRUE(run({&server_}, 
+                  [&]() { return server_.udp_stat().received == received + 2; },
+                  5000));
+  ASSERT_EQ(connection->reassembly_size(), static_cast<uint32_t>(0));
+  //The incomplete messages not over the bytes limit.
+  uint32_t count = NET_UDP_REASSEMBLY_MAX / length + 200;
+  for (uint32_t i = 0; i < count; ++i) {
+    data_send(i % NET_UDP_UNRELIABLE_HOLD, 
+              static_cast<uint16_t>(i / NET_UDP_UNRELIABLE_HOLD),
+              NET_UDP_FRAGMENTS_MAX);
+    if (i % 32 == 31) server_.tick();
+  }
+  //Until all received.
+  do {
+    received = server_.udp_stat().received;
+    for (uint32_t i = 0; i < 10; ++i) server_.tick();
+  } while (server_.udp_stat().received != received);
+  ASSERT_EQ(server_.size(), static_cast<uint32_t>(1));
+  ASSERT_LE(connection->reassembly_size(), 
+            static_cast<uint32_t>(NET_UDP_REASSEMBLY_MAX));
+  ASSERT_GT(connection->reassembly_size(), 
+            static_cast<uint32_t>(NET_UDP_REASSEMBLY_MAX - length));
+  socket.close();
+}
@@ -0,0 +1,219 @@
+#include "gtest/gtest.h"
+#include "pf/net/stream/buffer.h"
+#include "pf/net/stream/input.h"
+#include "pf/net/stream/output.h"
+#include "env.h"
+
+using namespace pf_net::stream;
+
+class NetStreamBuffer : public testing::Test {
+
+ public:
+   virtual void SetUp() {
+     pagesize_ = buffer::pagesize();
+     buffer::set_pool_max_size(NET_STREAM_BUFFER_POOL_MAXSIZE);
+   }
+
+   virtual void TearDown() {
+     buffer::set_pool_max_size(NET_STREAM_BUFFER_POOL_MAXSIZE);
+   }
+
+ protected:
+   //The bytes of the sequence, not same in every position.
+   static std::string data(uint32_t sequence, uint32_t size) {
+     std::string result(size, '\0');
+     for (uint32_t i = 0; i < size; ++i)
+       result[i] = static_cast<char>((sequence * 31 + i * 7) & 0xFF);
+     return result;
+   }
+
+ protected:
+   uint32_t pagesize_;
+
+};
+
+TEST_F(NetStreamBuffer, testMirrorAlias) {
+  uint32_t length{1};
+  bool mirrored{false};
+  auto memory = buffer::alloc(length, mirrored);
+  ASSERT_TRUE(!is_null(memory));
+  ASSERT_EQ(length, pagesize_);
+  if (mirrored) {
+    //The second mapping is the same pages of the first.
+    memory[length + 10] = 'a';
+    ASSERT_EQ(memory[10], 'a');
+    memory[20] = 'b';
+    ASSERT_EQ(memory[length + 20], 'b');
+    //The range from the end is contiguous.
+    auto bytes = data(1, 64);
+    memcpy(memory + length - 32, bytes.data(), bytes.size());
+    ASSERT_EQ(std::string(memory + length - 32, 32), bytes.substr(0, 32));
+    ASSERT_EQ(std::string(memory, 32), bytes.substr(32));
+  }
+  buffer::free(memory, length, mirrored);
+}
+
+TEST_F(NetStreamBuffer, testOutputWrap) {
+  Output ostream(nullptr, pagesize_, pagesize_);
+  ostream.init();
+  std::string expect;
+  std::string result;
+  uint32_t tail{0};
+  uint32_t wraps{0};
+  for (uint32_t i = 0; i < 500; ++i) {
+    auto bytes = data(i, 1 + (i * 131) % (pagesize_ / 3));
+    auto size = static_cast<uint32_t>(bytes.size());
+    if (ostream.mirrored() && tail + size > ostream.max_size()) ++wraps;
+    if (i % 2) {
+      ASSERT_EQ(ostream.write(bytes.data(), size), size);
+    } else { //The reserved region is contiguous cross the end.
+      auto region = ostream.reserve(size);
+      ASSERT_TRUE(!is_null(region));
+      memcpy(region, bytes.data(), size);
+      ASSERT_TRUE(ostream.commit(size));
+    }
+    tail = (tail + size) % static_cast<uint32_t>(ostream.max_size());
+    expect += bytes;
+    //Keep some bytes, the head not go back to the start.
+    uint32_t keep = 1 + i % 64;
+    if (ostream.size() > keep) {
+      std::string out(ostream.size() - keep, '\0');
+      ASSERT_EQ(ostream.drain(&out[0], static_cast<uint32_t>(out.size())),
+                out.size());
+      result += out;
+    }
+  }
+  std::string out(ostream.size(), '\0');
+  ostream.drain(&out[0], static_cast<uint32_t>(out.size()));
+  result += out;
+  ASSERT_EQ(result, expect);
+  if (ostream.mirrored()) {
+    ASSERT_GT(wraps, static_cast<uint32_t>(0));
+    ASSERT_EQ(ostream.max_size(), pagesize_); //Not moved by resize.
+  }
+}
+
+TEST_F(NetStreamBuffer, testInputWrap) {
+  Input istream(nullptr, pagesize_, pagesize_);
+  istream.init();
+  std::string expect;
+  std::string result;
+  uint32_t head{0};
+  uint32_t wraps{0};
+  for (uint32_t i = 0; i < 500; ++i) {
+    auto bytes = data(i, 1 + (i * 97) % (pagesize_ / 3));
+    auto size = static_cast<uint32_t>(bytes.size());
+    ASSERT_EQ(istream.fill(bytes.data(), size), static_cast<int32_t>(size));
+    expect += bytes;
+    uint32_t keep = 1 + i % 64;
+    if (istream.size() <= keep) continue;
+    auto length = static_cast<uint32_t>(istream.size()) - keep;
+    if (i % 2) {
+      std::string in(length, '\0');
+      ASSERT_EQ(istream.read(&in[0], length), length);
+      result += in;
+    } else { //The view is contiguous cross the end.
+      if (istream.mirrored() && head + length > istream.max_size()) ++wraps;
+      auto view = istream.view(length);
+      ASSERT_TRUE(!is_null(view));
+      result.append(view, length);
+      ASSERT_TRUE(istream.skip(length));
+    }
+    head = (head + length) % static_cast<uint32_t>(istream.max_size());
+  }
+  std::string in(istream.size(), '\0');
+  istream.read(&in[0], static_cast<uint32_t>(in.size()));
+  result += in;
+  ASSERT_EQ(result, expect);
+  if (istream.mirrored()) {
+    ASSERT_GT(wraps, static_cast<uint32_t>(0));
+    ASSERT_EQ(istream.max_size(), pagesize_);
+  }
+}
+
+TEST_F(NetStreamBuffer, testPoolReuse) {
+  //The length round up to the size class.
+  uint32_t length = pagesize_ * 2 + 1;
+  bool mirrored{false};
+  auto memory = buffer::alloc(length, mirrored);
+  ASSERT_TRUE(!is_null(memory));
+  ASSERT_EQ(length, pagesize_ * 4);
+  auto size = buffer::pool_size();
+  buffer::free(memory, length, mirrored);
+  ASSERT_EQ(buffer::pool_size(), size + length);
+  //The same class get the cached one.
+  uint32_t again_length = pagesize_ * 3;
+  bool again_mirrored{!mirrored};
+  auto again = buffer::alloc(again_length, again_mirrored);
+  ASSERT_EQ(again, memory);
+  ASSERT_EQ(again_length, length);
+  ASSERT_EQ(again_mirrored, mirrored);
+  ASSERT_EQ(buffer::pool_size(), size);
+  //Over the max size free to the system.
+  buffer::set_pool_max_size(size);
+  buffer::free(again, again_length, again_mirrored);
+  ASSERT_EQ(buffer::pool_size(), size);
+}
+
+TEST_F(NetStreamBuffer, testStreamRelease) {
+  Output ostream(nullptr, pagesize_, pagesize_);
+  ostream.init();
+  ASSERT_FALSE(ostream.allocated());
+  auto bytes = data(1, 100);
+  ASSERT_EQ(ostream.write(bytes.data(), 100), static_cast<uint32_t>(100));
+  ASSERT_TRUE(ostream.allocated());
+  //Only the empty stream return the buffer.
+  ASSERT_FALSE(ostream.release());
+  char out[100];
+  ASSERT_EQ(ostream.drain(out, sizeof(out)), sizeof(out));
+  auto size = buffer::pool_size();
+  ASSERT_TRUE(ostream.release());
+  ASSERT_FALSE(ostream.allocated());
+  ASSERT_EQ(buffer::pool_size(), size + pagesize_);
+  //Used again from the pool.
+  ASSERT_EQ(ostream.write(bytes.data(), 100), static_cast<uint32_t>(100));
+  ASSERT_EQ(buffer::pool_size(), size);
+  ASSERT_EQ(ostream.drain(out, sizeof(out)), sizeof(out));
+  ASSERT_EQ(std::string(out, sizeof(out)), bytes);
+}
+
+TEST_F(NetStreamBuffer, testPoolTrim) {
+  //Empty the pool, the cached of other tests freed.
+  buffer::set_pool_max_size(0);
+  ASSERT_EQ(buffer::pool_size(), static_cast<uint64_t>(0));
+  buffer::set_pool_max_size(NET_STREAM_BUFFER_POOL_MAXSIZE);
+  std::vector< std::pair<char *, uint32_t> > memories;
+  std::vector<bool> mirrors;
+  for (uint32_t i = 0; i < 4; ++i) {
+    uint32_t length = pagesize_ << i;
+    bool mirrored{false};
+    auto memory = buffer::alloc(length, mirrored);
+    ASSERT_TRUE(!is_null(memory));
+    memories.emplace_back(memory, length);
+    mirrors.push_back(mirrored);
+  }
+  for (size_t i = 0; i < memories.size(); ++i)
+    buffer::free(memories[i].first, memories[i].second, mirrors[i]);
+  auto cached = buffer::pool_size();
+  ASSERT_EQ(cached, static_cast<uint64_t>(pagesize_ * 15));
+  //Lower the max size trim the cached at once, the large first.
+  buffer::set_pool_max_size(cached - pagesize_);
+  ASSERT_EQ(buffer::pool_size(), cached - pagesize_ * 8);
+  buffer::set_pool_max_size(pagesize_ * 4);
+  ASSERT_EQ(buffer::pool_size(), static_cast<uint64_t>(pagesize_ * 3));
+  buffer::set_pool_max_size(0);
+  ASSERT_EQ(buffer::pool_size(), static_cast<uint64_t>(0));
+  //Not cache more than the max.
+  uint32_t length{pagesize_};
+  bool mirrored{false};
+  auto memory = buffer::alloc(length, mirrored);
+  buffer::free(memory, length, mirrored);
+  ASSERT_EQ(buffer::pool_size(), static_cast<uint64_t>(0));
+}
+
+TEST_F(NetStreamBuffer, testIdleTime) {
+  auto time = buffer::idle_time();
+  buffer::set_idle_time(1234);
+  ASSERT_EQ(buffer::idle_time(), static_cast<uint32_t>(1234));
+  buffer::set_idle_time(time);
+}
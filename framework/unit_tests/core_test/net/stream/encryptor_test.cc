@@ -0,0 +1,121 @@
+#include "gtest/gtest.h"
+#include "pf/net/socket/basic.h"
+#include "pf/net/stream/encryptor.h"
+#include "pf/net/stream/input.h"
+#include "env.h"
+
+using namespace pf_net::stream;
+
+class NetStreamEncryptor : public testing::Test {
+
+ public:
+   virtual void SetUp() {
+     kernel_ = Encryptor::kernel();
+     for (size_t i = 0; i < sizeof(data_); ++i)
+       data_[i] = static_cast<char>((i * 131 + 7) & 0xFF);
+   }
+
+   virtual void TearDown() {
+     Encryptor::set_kernel(kernel_);
+   }
+
+ protected:
+   //The result of the kernel for the data from offset with count bytes.
+   void transform(uint8_t kernel, 
+                  const char *key, 
+                  bool decrypt, 
+                  uint32_t offset, 
+                  uint32_t count,
+                  char *out) {
+     Encryptor::set_kernel(kernel);
+     Encryptor encryptor;
+     if (!is_null(key)) {
+       encryptor.setkey(key);
+       encryptor.enable(true);
+     }
+     if (decrypt) {
+       encryptor.decrypt(out, data_ + offset, count);
+     } else {
+       encryptor.encrypt(out, data_ + offset, count);
+     }
+   }
+
+ protected:
+   uint8_t kernel_;
+   char data_[256];
+
+};
+
+TEST_F(NetStreamEncryptor, testKernelsSameAsScalar) {
+  const char *keys[] = {nullptr, "0123456789abcde", "\x7f\x13\xe5kQ!z9"};
+  char expect[sizeof(data_)];
+  char result[sizeof(data_) + 1];
+  for (uint8_t kernel = Encryptor::kKernelSse2; 
+       kernel < Encryptor::kKernelMax; 
+       ++kernel) {
+    if (!Encryptor::set_kernel(kernel)) continue;
+    for (auto key : keys) {
+      for (int32_t decrypt = 0; decrypt < 2; ++decrypt) {
+        //The unaligned heads and the tails not full a vector.
+        for (uint32_t offset = 0; offset < 33; ++offset) {
+          for (uint32_t count = 0; offset + count <= 200; count += 7) {
+            transform(Encryptor::kKernelScalar, 
+                      key, decrypt != 0, offset, count, expect);
+            //The output unaligned too.
+            transform(kernel, key, decrypt != 0, offset, count, result + 1);
+            ASSERT_EQ(0, memcmp(expect, result + 1, count)) 
+              << "kernel: " << static_cast<int32_t>(kernel) 
+              << " offset: " << offset << " count: " << count;
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST_F(NetStreamEncryptor, testDecryptAfterEncrypt) {
+  const char *key = "0123456789abcde";
+  char cipher[sizeof(data_)];
+  char plain[sizeof(data_)];
+  for (uint8_t kernel = Encryptor::kKernelScalar; 
+       kernel < Encryptor::kKernelMax; 
+       ++kernel) {
+    if (!Encryptor::set_kernel(kernel)) continue;
+    Encryptor encryptor;
+    encryptor.setkey(key);
+    encryptor.enable(true);
+    encryptor.encrypt(cipher, data_, sizeof(data_));
+    encryptor.decrypt(plain, cipher, sizeof(data_));
+    ASSERT_EQ(0, memcmp(data_, plain, sizeof(data_)));
+  }
+}
+
+TEST_F(NetStreamEncryptor, testDecryptOnceEnableWithData) {
+  const char *key = "0123456789abcde";
+  Encryptor encryptor;
+  encryptor.setkey(key);
+  encryptor.enable(true);
+  char cipher[64];
+  encryptor.encrypt(cipher, data_, sizeof(cipher));
+  pf_net::socket::Basic socket;
+  Input input(&socket);
+  input.init();
+  input.set_decrypt_once(true);
+  //The plain head(handshake) and the cipher received before enable.
+  ASSERT_EQ(16, input.fill(data_, 16));
+  ASSERT_EQ(static_cast<int32_t>(sizeof(cipher)), 
+            input.fill(cipher, sizeof(cipher)));
+  char buffer[64];
+  ASSERT_EQ(16u, input.read(buffer, 16));
+  ASSERT_EQ(0, memcmp(data_, buffer, 16));
+  input.encrypt_setkey(key);
+  input.getencryptor()->enable(true);
+  input.encryptenable(true);
+  ASSERT_EQ(static_cast<uint32_t>(sizeof(cipher)), 
+            input.read(buffer, sizeof(cipher)));
+  ASSERT_EQ(0, memcmp(data_, buffer, sizeof(cipher)));
+  //The data after enable decrypt when it in.
+  ASSERT_EQ(16, input.fill(cipher, 16));
+  ASSERT_EQ(16u, input.read(buffer, 16));
+  ASSERT_EQ(0, memcmp(data_, buffer, 16));
+}